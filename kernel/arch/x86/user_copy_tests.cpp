@@ -0,0 +1,74 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <arch/x86/user_copy.h>
+#include <lib/unittest/unittest.h>
+#include <stddef.h>
+#include <string.h>
+#include <zircon/types.h>
+
+// Copies |len| bytes between kernel buffers at every combination of
+// alignments relative to 8 bytes, checking that nothing outside the
+// destination range is written.
+static bool copy_len(size_t len) {
+    BEGIN_TEST;
+
+    // These are too large for the kernel stack.
+    constexpr size_t kPad = 16;
+    static uint8_t src[4096 + kPad];
+    static uint8_t dst[4096 + 2 * kPad];
+    ASSERT_LE(len, sizeof(src) - kPad, "copy too large");
+
+    for (size_t i = 0; i < sizeof(src); ++i) {
+        src[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+
+    for (size_t src_offset = 0; src_offset < 8; ++src_offset) {
+        for (size_t dst_offset = 0; dst_offset < 8; ++dst_offset) {
+            memset(dst, 0, sizeof(dst));
+            void* fault_return = nullptr;
+            zx_status_t status = _x86_copy_to_or_from_user(
+                dst + kPad + dst_offset, src + src_offset, len, &fault_return);
+            ASSERT_EQ(ZX_OK, status, "copy failed");
+            EXPECT_NULL(fault_return, "fault return not reset");
+
+            for (size_t i = 0; i < kPad + dst_offset; ++i) {
+                ASSERT_EQ(0, dst[i], "overwrote before buffer");
+            }
+            ASSERT_EQ(0, memcmp(dst + kPad + dst_offset, src + src_offset, len),
+                      "buffer mismatch");
+            for (size_t i = kPad + dst_offset + len; i < sizeof(dst); ++i) {
+                ASSERT_EQ(0, dst[i], "overwrote after buffer");
+            }
+        }
+    }
+
+    END_TEST;
+}
+
+// Copies below 16 bytes use plain moves, and larger ones use string
+// instructions.
+static bool small_copy_test() {
+    BEGIN_TEST;
+    for (size_t len = 0; len < 32; ++len) {
+        EXPECT_TRUE(copy_len(len), "");
+    }
+    END_TEST;
+}
+
+static bool large_copy_test() {
+    BEGIN_TEST;
+    static const size_t kLens[] = {63, 64, 65, 255, 1000, 4095, 4096};
+    for (size_t len : kLens) {
+        EXPECT_TRUE(copy_len(len), "");
+    }
+    END_TEST;
+}
+
+UNITTEST_START_TESTCASE(x86_user_copy_tests)
+UNITTEST("small copy tests", small_copy_test)
+UNITTEST("large copy tests", large_copy_test)
+UNITTEST_END_TESTCASE(x86_user_copy_tests, "x86_user_copy", "x86 user copy tests");
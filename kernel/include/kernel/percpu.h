@@ -19,7 +19,7 @@ __BEGIN_CDECLS
 
 struct percpu {
     // per cpu timer queue
-    struct list_node timer_queue;
+    TimerQueue timer_queue;
 
     // per cpu preemption timer; ZX_TIME_INFINITE means not set
     zx_time_t preempt_timer_deadline;
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <fbl/intrusive_wavl_tree.h>
 #include <kernel/spinlock.h>
 #include <kernel/timer_slack.h>
 #include <list.h>
@@ -25,7 +26,9 @@ typedef void (*timer_callback)(struct timer*, zx_time_t now, void* arg);
 
 typedef struct timer {
     int magic;
-    struct list_node node;
+    fbl::WAVLTreeNodeState<struct timer*> node;
+    // The cpu whose queue holds this timer, while it is queued.
+    uint queue_cpu;
 
     zx_time_t scheduled_time;
     zx_duration_t slack; // Stores the applied slack adjustment from
@@ -40,7 +43,8 @@ typedef struct timer {
 #define TIMER_INITIAL_VALUE(t)              \
     {                                       \
         .magic = TIMER_MAGIC,               \
-        .node = LIST_INITIAL_CLEARED_VALUE, \
+        .node = {},                         \
+        .queue_cpu = 0,                     \
         .scheduled_time = 0,                \
         .slack = 0,                         \
         .callback = NULL,                   \
@@ -49,6 +53,35 @@ typedef struct timer {
         .cancel = false,                    \
     }
 
+__END_CDECLS
+
+// Each cpu's queue of pending timers, ordered by scheduled time. Timers which
+// have been coalesced share a scheduled time, and are ordered by address.
+struct TimerQueueKey {
+    zx_time_t scheduled_time;
+    uintptr_t address;
+};
+
+struct TimerQueueTraits {
+    static TimerQueueKey GetKey(const timer_t& timer) {
+        return {timer.scheduled_time, reinterpret_cast<uintptr_t>(&timer)};
+    }
+    static bool LessThan(const TimerQueueKey& a, const TimerQueueKey& b) {
+        return (a.scheduled_time < b.scheduled_time) ||
+               ((a.scheduled_time == b.scheduled_time) && (a.address < b.address));
+    }
+    static bool EqualTo(const TimerQueueKey& a, const TimerQueueKey& b) {
+        return (a.scheduled_time == b.scheduled_time) && (a.address == b.address);
+    }
+    static fbl::WAVLTreeNodeState<timer_t*>& node_state(timer_t& timer) {
+        return timer.node;
+    }
+};
+
+using TimerQueue = fbl::WAVLTree<TimerQueueKey, timer_t*, TimerQueueTraits, TimerQueueTraits>;
+
+__BEGIN_CDECLS
+
 // Rules for Timers:
 // - Timer callbacks occur from interrupt context
 // - Timers may be programmed or canceled from interrupt or thread context
@@ -11,7 +11,10 @@
 
 #include <arch/ops.h>
 #include <arch/user_copy.h>
+#include <fbl/algorithm.h>
 #include <hypervisor/ktrace.h>
+#include <kernel/align.h>
+#include <kernel/auto_lock.h>
 #include <kernel/cmdline.h>
 #include <lib/ktrace.h>
 #include <lk/init.h>
@@ -19,6 +22,8 @@
 #include <vm/vm_aspace.h>
 #include <zircon/thread_annotations.h>
 
+#include "ktrace_private.h"
+
 #define ktrace_timestamp() current_ticks();
 #define ktrace_ticks_per_ms() (ticks_per_second() / 1000)
 
@@ -76,87 +81,486 @@ static void ktrace_report_probes(void) {
 }
 
 typedef struct ktrace_state {
-    // where the next record will be written
-    int offset;
-
     // mask of groups we allow, 0 == tracing disabled
     int grpmask;
 
-    // total size of the trace buffer
-    uint32_t bufsize;
+    // true if the oldest records are overwritten when a cpu's ring is full,
+    // rather than tracing being stopped
+    bool circular;
 
-    // offset where tracing was stopped, 0 if tracing active
-    uint32_t marker;
+    // true once tracing has been stopped: reads return the records held at
+    // that point without consuming them
+    bool stopped;
 
-    // raw trace buffer
-    uint8_t* buffer;
+    // true if the rings are to be emptied when tracing is next started
+    bool rewind_pending;
+
+    // true if reads made while tracing consume the records they return,
+    // rather than addressing them by offset
+    bool draining;
+
+    // number of cpus with a ring
+    uint32_t num_cpus;
+
+    // the version and clock records which start every trace
+    ktrace_rec_32b_t metadata[2];
+
+    ktrace_cpu_buffer_t cpus[SMP_MAX_CPUS];
 } ktrace_state_t;
 
 static ktrace_state_t KTRACE_STATE;
 
-ssize_t ktrace_read_user(void* ptr, uint32_t off, size_t len) {
-    ktrace_state_t* ks = &KTRACE_STATE;
+// serializes readers, and guards |read_buffer| and |read_cursor|
+static fbl::Mutex read_lock;
+
+// records are copied out of a ring under its lock, so that they cannot be
+// overwritten while they are copied to userspace
+static uint8_t read_buffer[PAGE_SIZE] TA_GUARDED(read_lock);
+
+// the longest record there can be
+constexpr uint32_t kMaxRecordLen = KTRACE_LEN(0xF);
+
+// Reads by offset see the metadata followed by the records of every cpu,
+// merged in timestamp order. Finding the record at an offset means merging
+// the rings from their tails, so the point reached by the last read is kept,
+// and a reader moving forward through the trace carries on from there.
+struct ktrace_read_cursor {
+    bool valid;
+
+    // the offset of |rec| in the trace
+    size_t off;
+
+    // the record at which the last read ended
+    uint8_t rec[kMaxRecordLen];
+    uint32_t rec_len;
+
+    // the rings' positions after |rec|
+    ktrace_merge_t merge;
+};
 
-    // Buffer size is limited by the marker if set,
-    // otherwise limited by offset (last written point).
-    // Offset can end up pointing past the end, so clip
-    // it to the actual buffer size to be safe.
-    uint32_t max;
-    if (ks->marker) {
-        max = ks->marker;
+static ktrace_read_cursor read_cursor TA_GUARDED(read_lock);
+
+// the rings' positions for draining reads
+static ktrace_merge_t drain_merge TA_GUARDED(read_lock);
+
+// The parts of |buffer| holding the records between |tail| and |head|.
+struct ktrace_segment {
+    uint32_t offset;
+    uint32_t len;
+};
+
+static size_t ktrace_segments(const ktrace_cpu_buffer_t* cb, uint64_t head, uint64_t tail,
+                              uint32_t wrap_offset, ktrace_segment segs[2]) {
+    if (head == tail) {
+        return 0;
+    }
+    uint32_t t = static_cast<uint32_t>(tail % cb->size);
+    uint32_t h = static_cast<uint32_t>(head % cb->size);
+    if (tail / cb->size == head / cb->size) {
+        segs[0] = {t, h - t};
+        return 1;
+    }
+    if (t >= wrap_offset) {
+        segs[0] = {0, h};
+        return 1;
+    }
+    segs[0] = {t, wrap_offset - t};
+    segs[1] = {0, h};
+    return 2;
+}
+// Moves |tail| past the oldest record in the ring.
+static void ktrace_evict(ktrace_cpu_buffer_t* cb) TA_REQ(cb->lock) {
+    uint32_t t = static_cast<uint32_t>(cb->tail % cb->size);
+    if (cb->tail / cb->size != cb->head / cb->size && t >= cb->wrap_offset) {
+        cb->tail += cb->size - t;
+    } else {
+        uint32_t tag = *reinterpret_cast<uint32_t*>(cb->buffer + t);
+        cb->tail += KTRACE_LEN(tag);
+    }
+}
+
+zx_status_t ktrace_ring_reserve(ktrace_cpu_buffer_t* cb, uint32_t len, bool overwrite,
+                                void** out) {
+    // Evicting a record moves |tail| by its length, so a record without even
+    // a header would never be evicted, and one longer than the ring never fit.
+    if (len < KTRACE_HDRSIZE || len > cb->size) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    uint32_t h = static_cast<uint32_t>(cb->head % cb->size);
+    uint32_t skip = (h + len > cb->size) ? cb->size - h : 0;
+    while (cb->head + skip + len - cb->tail > cb->size) {
+        if (cb->tail == cb->head) {
+            // The ring is empty, so the space skipped at its end holds no
+            // records either.
+            cb->tail += skip;
+            continue;
+        }
+        if (!overwrite) {
+            return ZX_ERR_NO_RESOURCES;
+        }
+        ktrace_evict(cb);
+    }
+    uint8_t* ptr;
+    if (skip) {
+        cb->wrap_offset = h;
+        ptr = cb->buffer;
     } else {
-        max = ks->offset;
-        if (max > ks->bufsize) {
-            max = ks->bufsize;
+        if (h + len == cb->size) {
+            cb->wrap_offset = cb->size;
         }
+        ptr = cb->buffer + h;
+    }
+    cb->head += skip + len;
+    *out = ptr;
+    return ZX_OK;
+}
+
+// Writes a record with |tag| to the current cpu's ring, calling |fill| to
+// write everything after the tag. The ring's lock is held, with interrupts
+// disabled, until the record is complete, so that it is never read or evicted
+// while partly written. Returns false if the record was not written.
+template <typename Fill>
+static bool ktrace_write_record(ktrace_state_t* ks, uint32_t tag, Fill fill) {
+    if (ks->num_cpus == 0) {
+        return false;
+    }
+    ktrace_cpu_buffer_t* cb = &ks->cpus[arch_curr_cpu_num() % ks->num_cpus];
+
+    AutoSpinLock lock(&cb->lock);
+    // Records are only overwritten while tracing, so that a stopped trace
+    // can be read in full.
+    bool overwrite = ks->circular && atomic_load(&ks->grpmask);
+    void* ptr;
+    zx_status_t status = ktrace_ring_reserve(cb, KTRACE_LEN(tag), overwrite, &ptr);
+    if (status == ZX_ERR_NO_RESOURCES) {
+        // if we arrive at the end, stop
+        atomic_store(&ks->grpmask, 0);
+    }
+    if (status != ZX_OK) {
+        return false;
+    }
+    *static_cast<uint32_t*>(ptr) = tag;
+    fill(ptr);
+    return true;
+}
+
+static void ktrace_rewind(ktrace_state_t* ks) TA_REQ(read_lock) {
+    for (uint32_t cpu = 0; cpu < ks->num_cpus; cpu++) {
+        ktrace_cpu_buffer_t* cb = &ks->cpus[cpu];
+        AutoSpinLock lock(&cb->lock);
+        cb->head = 0;
+        cb->tail = 0;
+        cb->wrap_offset = 0;
+    }
+    ks->rewind_pending = false;
+    read_cursor.valid = false;
+    memset(&drain_merge, 0, sizeof(drain_merge));
+    ktrace_report_syscalls(kt_syscall_info);
+    ktrace_report_probes();
+    ktrace_report_vcpu_meta();
+}
+
+// The records of a ring which a reader may see: while tracing, those it
+// holds, with its lock held for as long as the view exists; once tracing is
+// stopped, those it held then, which are no longer written.
+class ktrace_ring_view {
+public:
+    ktrace_ring_view(ktrace_cpu_buffer_t* cb, bool stopped) TA_NO_THREAD_SAFETY_ANALYSIS
+        : cb_(cb), locked_(!stopped) {
+        if (locked_) {
+            spin_lock_irqsave(&cb->lock, state_);
+            head_ = cb->head;
+            tail_ = cb->tail;
+            wrap_offset_ = cb->wrap_offset;
+        } else {
+            head_ = cb->stop_head;
+            tail_ = cb->stop_tail;
+            wrap_offset_ = cb->stop_wrap_offset;
+        }
+    }
+
+    ~ktrace_ring_view() TA_NO_THREAD_SAFETY_ANALYSIS {
+        if (locked_) {
+            spin_unlock_irqrestore(&cb_->lock, state_);
+        }
+    }
+
+    // Returns the first record at or after |*pos|, and moves |*pos| to its
+    // start, or returns nullptr if there is none.
+    const ktrace_header_t* Peek(uint64_t* pos) const {
+        if (*pos < tail_) {
+            // the records before |tail_| have been evicted or drained
+            *pos = tail_;
+        }
+        if (*pos >= head_) {
+            return nullptr;
+        }
+        uint32_t p = static_cast<uint32_t>(*pos % cb_->size);
+        if (*pos / cb_->size != head_ / cb_->size && p >= wrap_offset_) {
+            // skip the space left at the end of the ring when it wrapped
+            *pos += cb_->size - p;
+            if (*pos >= head_) {
+                return nullptr;
+            }
+            p = 0;
+        }
+        return reinterpret_cast<const ktrace_header_t*>(cb_->buffer + p);
+    }
+
+    // Removes the records before |pos| from the ring.
+    void Drain(uint64_t pos) TA_NO_THREAD_SAFETY_ANALYSIS {
+        DEBUG_ASSERT(locked_);
+        cb_->tail = pos;
     }
 
+    size_t Segments(ktrace_segment segs[2]) const {
+        return ktrace_segments(cb_, head_, tail_, wrap_offset_, segs);
+    }
+
+private:
+    ktrace_cpu_buffer_t* cb_;
+    bool locked_;
+    spin_lock_saved_state_t state_;
+    uint64_t head_;
+    uint64_t tail_;
+    uint32_t wrap_offset_;
+};
+
+// Name records are written without a timestamp, and are ordered as if they
+// had that of the record before them in their ring.
+static uint64_t ktrace_record_ts(const ktrace_header_t* hdr, uint64_t prev_ts) {
+    if (KTRACE_GROUP(hdr->tag) & KTRACE_GRP_META) {
+        return prev_ts;
+    }
+    return hdr->ts;
+}
+
+uint32_t ktrace_merge_next(ktrace_cpu_buffer_t* cpus, uint32_t num_cpus, bool stopped,
+                           bool drain, ktrace_merge_t* m, void* dst, size_t len) {
+    DEBUG_ASSERT(!(stopped && drain));
+    for (;;) {
+        // Each ring is in timestamp order, as records are stamped with its
+        // lock held, so the earliest record is at the front of one of them.
+        uint32_t next = num_cpus;
+        uint64_t next_pos = 0;
+        uint64_t next_ts = 0;
+        for (uint32_t cpu = 0; cpu < num_cpus; cpu++) {
+            ktrace_ring_view ring(&cpus[cpu], stopped);
+            uint64_t pos = m->pos[cpu];
+            const ktrace_header_t* hdr = ring.Peek(&pos);
+            if (hdr == nullptr) {
+                continue;
+            }
+            uint64_t ts = ktrace_record_ts(hdr, m->ts[cpu]);
+            if (next == num_cpus || ts < next_ts) {
+                next = cpu;
+                next_pos = pos;
+                next_ts = ts;
+            }
+        }
+        if (next == num_cpus) {
+            return 0;
+        }
+
+        // The record may have been evicted while its ring was unlocked.
+        ktrace_ring_view ring(&cpus[next], stopped);
+        uint64_t pos = m->pos[next];
+        const ktrace_header_t* hdr = ring.Peek(&pos);
+        if (hdr == nullptr || pos != next_pos) {
+            continue;
+        }
+        uint32_t rec_len = KTRACE_LEN(hdr->tag);
+        if (rec_len <= len) {
+            memcpy(dst, hdr, rec_len);
+            m->pos[next] = pos + rec_len;
+            m->ts[next] = next_ts;
+            if (drain) {
+                ring.Drain(m->pos[next]);
+            }
+        }
+        return rec_len;
+    }
+}
+
+// The length of the trace seen by reads by offset.
+static size_t ktrace_read_size(ktrace_state_t* ks) {
+    size_t size = sizeof(ks->metadata);
+    for (uint32_t cpu = 0; cpu < ks->num_cpus; cpu++) {
+        ktrace_ring_view ring(&ks->cpus[cpu], ks->stopped);
+        ktrace_segment segs[2];
+        size_t num_segs = ring.Segments(segs);
+        for (size_t i = 0; i < num_segs; i++) {
+            size += segs[i].len;
+        }
+    }
+    return size;
+}
+
+// Copies up to |len| bytes of the trace from |off| into |read_buffer|, and
+// returns their number.
+static size_t ktrace_read_merged(ktrace_state_t* ks, size_t off, size_t len)
+    TA_REQ(read_lock) {
+    static_assert(sizeof(ks->metadata) <= kMaxRecordLen, "");
+    ktrace_read_cursor* c = &read_cursor;
+    if (!c->valid || off < c->off) {
+        // start again from the metadata, which begins the trace
+        c->valid = true;
+        c->off = 0;
+        memcpy(c->rec, ks->metadata, sizeof(ks->metadata));
+        c->rec_len = sizeof(ks->metadata);
+        memset(&c->merge, 0, sizeof(c->merge));
+    }
+    size_t copied = 0;
+    while (copied < len) {
+        size_t pos = off + copied;
+        if (pos >= c->off + c->rec_len) {
+            uint32_t n = ktrace_merge_next(ks->cpus, ks->num_cpus, ks->stopped, false,
+                                           &c->merge, c->rec, sizeof(c->rec));
+            if (n == 0) {
+                break;
+            }
+            c->off += c->rec_len;
+            c->rec_len = n;
+            continue;
+        }
+        size_t skip = pos - c->off;
+        size_t n = fbl::min(len - copied, c->rec_len - skip);
+        memcpy(read_buffer + copied, c->rec + skip, n);
+        copied += n;
+    }
+    return copied;
+}
+
+// By default reads address the trace by offset and leave the records in
+// place, whether or not tracing is running. Offsets are stable once tracing
+// is stopped, and while it runs until a circular trace wraps.
+static ssize_t ktrace_read_offset(ktrace_state_t* ks, void* ptr, uint32_t off, size_t len)
+    TA_REQ(read_lock) {
     // null read is a query for trace buffer size
     if (ptr == nullptr) {
-        return max;
+        return ktrace_read_size(ks);
     }
 
-    // constrain read to available buffer
-    if (off >= max) {
-        return 0;
+    size_t copied = 0;
+    while (copied < len) {
+        size_t n = ktrace_read_merged(ks, off + copied, fbl::min(len - copied, sizeof(read_buffer)));
+        if (n == 0) {
+            break;
+        }
+        if (arch_copy_to_user(static_cast<uint8_t*>(ptr) + copied, read_buffer, n) != ZX_OK) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        copied += n;
     }
-    if (len > (max - off)) {
-        len = max - off;
+    return copied;
+}
+
+// Once draining is enabled, reads made while tracing consume the records
+// they return, so that a reader can empty the rings continuously. The
+// metadata records are returned by a read at offset zero.
+static ssize_t ktrace_read_draining(ktrace_state_t* ks, void* ptr, uint32_t off, size_t len)
+    TA_REQ(read_lock) {
+    // null read is a query for the number of bytes available
+    if (ptr == nullptr) {
+        return ktrace_read_size(ks) - (off == 0 ? 0 : sizeof(ks->metadata));
     }
 
-    if (arch_copy_to_user(ptr, ks->buffer + off, len) != ZX_OK) {
-        return ZX_ERR_INVALID_ARGS;
+    // The records after the cursor are no longer where it expects.
+    read_cursor.valid = false;
+
+    size_t copied = 0;
+    if (off == 0) {
+        if (len < sizeof(ks->metadata)) {
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        }
+        if (arch_copy_to_user(ptr, ks->metadata, sizeof(ks->metadata)) != ZX_OK) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        copied = sizeof(ks->metadata);
+    }
+    size_t staged = 0;
+    for (;;) {
+        size_t room = fbl::min(len - copied, sizeof(read_buffer)) - staged;
+        uint32_t n = ktrace_merge_next(ks->cpus, ks->num_cpus, false, true, &drain_merge,
+                                       read_buffer + staged, room);
+        if (n > 0 && n <= room) {
+            staged += n;
+            continue;
+        }
+        // |read_buffer| is full, or the rings are empty
+        if (staged == 0) {
+            break;
+        }
+        if (arch_copy_to_user(static_cast<uint8_t*>(ptr) + copied, read_buffer, staged) != ZX_OK) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        copied += staged;
+        staged = 0;
+        if (n == 0) {
+            break;
+        }
     }
-    return len;
+    return copied;
+}
+
+ssize_t ktrace_read_user(void* ptr, uint32_t off, size_t len) {
+    ktrace_state_t* ks = &KTRACE_STATE;
+    fbl::AutoLock lock(&read_lock);
+    if (ks->draining && !ks->stopped) {
+        return ktrace_read_draining(ks, ptr, off, len);
+    }
+    return ktrace_read_offset(ks, ptr, off, len);
 }
 
 zx_status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
     ktrace_state_t* ks = &KTRACE_STATE;
     switch (action) {
     case KTRACE_ACTION_START:
+    case KTRACE_ACTION_START_CIRCULAR: {
         options = KTRACE_GRP_TO_MASK(options);
-        ks->marker = 0;
+        fbl::AutoLock lock(&read_lock);
+        ks->stopped = false;
+        read_cursor.valid = false;
+        if (ks->rewind_pending) {
+            ktrace_rewind(ks);
+        }
+        ks->circular = (action == KTRACE_ACTION_START_CIRCULAR);
         atomic_store(&ks->grpmask, options ? options : KTRACE_GRP_TO_MASK(KTRACE_GRP_ALL));
         ktrace_report_live_processes();
         ktrace_report_live_threads();
         break;
+    }
     case KTRACE_ACTION_STOP: {
         atomic_store(&ks->grpmask, 0);
-        uint32_t n = ks->offset;
-        if (n > ks->bufsize) {
-            ks->marker = ks->bufsize;
+        fbl::AutoLock lock(&read_lock);
+        for (uint32_t cpu = 0; cpu < ks->num_cpus; cpu++) {
+            ktrace_cpu_buffer_t* cb = &ks->cpus[cpu];
+            AutoSpinLock cpu_lock(&cb->lock);
+            cb->stop_head = cb->head;
+            cb->stop_tail = cb->tail;
+            cb->stop_wrap_offset = cb->wrap_offset;
+        }
+        ks->stopped = true;
+        read_cursor.valid = false;
+        break;
+    }
+    case KTRACE_ACTION_REWIND: {
+        // Roll back to just after the metadata. Once stopped, the records
+        // are kept for reading until tracing is started again.
+        fbl::AutoLock lock(&read_lock);
+        if (ks->stopped) {
+            ks->rewind_pending = true;
         } else {
-            ks->marker = n;
+            ktrace_rewind(ks);
         }
         break;
     }
-    case KTRACE_ACTION_REWIND:
-        // roll back to just after the metadata
-        atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
-        ktrace_report_syscalls(kt_syscall_info);
-        ktrace_report_probes();
-        ktrace_report_vcpu_meta();
+    case KTRACE_ACTION_SET_DRAINING: {
+        fbl::AutoLock lock(&read_lock);
+        ks->draining = (options != 0);
+        read_cursor.valid = false;
         break;
+    }
     case KTRACE_ACTION_NEW_PROBE: {
         fbl::AutoLock lock(&probe_list_lock);
         ktrace_probe_info_t* probe;
@@ -194,18 +598,23 @@ void ktrace_init(unsigned level) {
     mb *= (1024*1024);
 
     zx_status_t status;
+    uint8_t* buffer;
     VmAspace* aspace = VmAspace::kernel_aspace();
-    if ((status = aspace->Alloc("ktrace", mb, (void**)&ks->buffer, 0, VmAspace::VMM_FLAG_COMMIT,
+    if ((status = aspace->Alloc("ktrace", mb, (void**)&buffer, 0, VmAspace::VMM_FLAG_COMMIT,
                                 ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE)) < 0) {
         dprintf(INFO, "ktrace: cannot alloc buffer %d\n", status);
         return;
     }
 
-    // The last packet written can overhang the end of the buffer,
-    // so we reduce the reported size by the max size of a record
-    ks->bufsize = mb - 256;
+    // split the buffer between the cpus
+    uint32_t num_cpus = arch_max_num_cpus();
+    uint32_t cpu_size = (mb / num_cpus) & ~(KTRACE_RECSIZE - 1);
+    for (uint32_t cpu = 0; cpu < num_cpus; cpu++) {
+        ks->cpus[cpu].buffer = buffer + cpu * cpu_size;
+        ks->cpus[cpu].size = cpu_size;
+    }
 
-    dprintf(INFO, "ktrace: buffer at %p (%u bytes)\n", ks->buffer, mb);
+    dprintf(INFO, "ktrace: buffer at %p (%u bytes, %u per cpu)\n", buffer, mb, cpu_size);
 
     // register all static probes
     {
@@ -217,9 +626,9 @@ void ktrace_init(unsigned level) {
         }
     }
 
-    // write metadata to the first two event slots
+    // metadata for the first two event slots
     uint64_t n = ktrace_ticks_per_ms();
-    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->buffer;
+    ktrace_rec_32b_t* rec = ks->metadata;
     rec[0].tag = TAG_VERSION;
     rec[0].a = KTRACE_VERSION;
     rec[1].tag = TAG_TICKS_PER_MS;
@@ -227,7 +636,7 @@ void ktrace_init(unsigned level) {
     rec[1].b = (uint32_t)(n >> 32);
 
     // enable tracing
-    atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
+    ks->num_cpus = num_cpus;
     ktrace_report_syscalls(kt_syscall_info);
     ktrace_report_probes();
     atomic_store(&ks->grpmask, KTRACE_GRP_TO_MASK(grpmask));
@@ -249,37 +658,34 @@ void ktrace_tiny(uint32_t tag, uint32_t arg) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (tag & atomic_load(&ks->grpmask)) {
         tag = (tag & 0xFFFFFFF0) | 2;
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_HDRSIZE)) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
+        ktrace_write_record(ks, tag, [arg](void* ptr) {
+            ktrace_header_t* hdr = static_cast<ktrace_header_t*>(ptr);
             hdr->ts = ktrace_timestamp();
-            hdr->tag = tag;
             hdr->tid = arg;
-        }
+        });
     }
 }
 
-void* ktrace_open(uint32_t tag) {
+bool ktrace_write(uint32_t tag, const void* payload, size_t len) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (!(tag & atomic_load(&ks->grpmask))) {
-        return nullptr;
+        return false;
     }
 
-    int off;
-    if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-        // if we arrive at the end, stop
-        atomic_store(&ks->grpmask, 0);
-        return nullptr;
-    }
-
-    ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
-    hdr->ts = ktrace_timestamp();
-    hdr->tag = tag;
-    hdr->tid = (uint32_t)get_current_thread()->user_tid;
-    return hdr + 1;
+    uint32_t tid = (uint32_t)get_current_thread()->user_tid;
+    return ktrace_write_record(ks, tag, [tag, tid, payload, len](void* ptr) {
+        ktrace_header_t* hdr = static_cast<ktrace_header_t*>(ptr);
+        hdr->ts = ktrace_timestamp();
+        hdr->tid = tid;
+        // the payload is truncated or zero-filled to the record's length
+        uint8_t* data = reinterpret_cast<uint8_t*>(hdr + 1);
+        size_t room = KTRACE_LEN(tag) - sizeof(*hdr);
+        size_t n = fbl::min(len, room);
+        if (n > 0) {
+            memcpy(data, payload, n);
+        }
+        memset(data + n, 0, room - n);
+    });
 }
 
 void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char* name, bool always) {
@@ -290,18 +696,13 @@ void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char* name,
         // set size to: sizeof(hdr) + len + 1, round up to multiple of 8
         tag = (tag & 0xFFFFFFF0) | ((KTRACE_NAMESIZE + len + 1 + 7) >> 3);
 
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_rec_name_t* rec = (ktrace_rec_name_t*) (ks->buffer + off);
-            rec->tag = tag;
+        ktrace_write_record(ks, tag, [id, arg, name, len](void* ptr) {
+            ktrace_rec_name_t* rec = static_cast<ktrace_rec_name_t*>(ptr);
             rec->id = id;
             rec->arg = arg;
             memcpy(rec->name, name, len);
             rec->name[len] = 0;
-        }
+        });
     }
 }
 
@@ -0,0 +1,71 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// These are the per-cpu ring buffers that ktrace records into, exposed
+// here only for testing purposes. See the implementation for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <kernel/align.h>
+#include <kernel/spinlock.h>
+#include <zircon/thread_annotations.h>
+#include <zircon/types.h>
+
+// Each cpu writes records into a ring buffer of its own, so that cpus do not
+// contend on a shared write offset. Positions in a ring count the bytes
+// written to it since it was last rewound: |head| is where the next record
+// will be written, and |tail| is where the oldest record still held begins.
+// A record never straddles the end of the ring: when one does not fit, the
+// ring's data ends at |wrap_offset| and the record is written at its start.
+//
+// Records are written in full with |lock| held, so that everything between
+// |tail| and |head| is a complete record whenever the lock is free.
+typedef struct ktrace_cpu_buffer {
+    spin_lock_t lock;
+
+    // this cpu's part of the trace buffer
+    uint8_t* buffer;
+    uint32_t size;
+
+    uint64_t head TA_GUARDED(lock);
+    uint64_t tail TA_GUARDED(lock);
+    uint32_t wrap_offset TA_GUARDED(lock);
+
+    // the records which may be read once tracing is stopped
+    uint64_t stop_head;
+    uint64_t stop_tail;
+    uint32_t stop_wrap_offset;
+} __CPU_ALIGN ktrace_cpu_buffer_t;
+
+// Reserves |len| bytes at the head of |cb| for a record, and returns them in
+// |out|. The oldest records are evicted to make room if |overwrite| is true;
+// otherwise ZX_ERR_NO_RESOURCES is returned once the ring is full. Records
+// shorter than a header or longer than the ring are ZX_ERR_OUT_OF_RANGE. The
+// record must be written in full before |cb->lock| is released.
+zx_status_t ktrace_ring_reserve(ktrace_cpu_buffer_t* cb, uint32_t len, bool overwrite,
+                                void** out) TA_REQ(cb->lock);
+
+// A reader's position in each of a set of rings, from which records are
+// taken in timestamp order. Name records carry no timestamp of their own, and
+// are ordered as if they had that of the record before them in their ring.
+typedef struct ktrace_merge {
+    // where the next record to read begins in each ring
+    uint64_t pos[SMP_MAX_CPUS];
+    // the timestamp of the last record read from each ring
+    uint64_t ts[SMP_MAX_CPUS];
+} ktrace_merge_t;
+
+// Takes the earliest of the records at |m|'s positions in |cpus| and returns
+// its length, or 0 if every ring has been read to its head. If the record is
+// no longer than |len| bytes, it is copied to |dst| and |m| moves past it, and
+// with |drain| it is also removed from its ring; otherwise nothing changes.
+// With |stopped|, the records held when tracing stopped are read, without
+// taking the rings' locks; these cannot be drained.
+uint32_t ktrace_merge_next(ktrace_cpu_buffer_t* cpus, uint32_t num_cpus, bool stopped,
+                           bool drain, ktrace_merge_t* m, void* dst, size_t len);
@@ -0,0 +1,264 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <string.h>
+
+#include <fbl/algorithm.h>
+#include <kernel/auto_lock.h>
+#include <lib/ktrace.h>
+#include <lib/unittest/unittest.h>
+
+#include "ktrace_private.h"
+
+namespace {
+
+// Small enough that a record can span the whole ring.
+constexpr uint32_t kRingSize = 3 * KTRACE_RECSIZE;
+static_assert(kRingSize <= KTRACE_LEN(0xF), "a record must be able to fill the ring");
+
+void init_ring(ktrace_cpu_buffer_t* cb, uint8_t* buffer) {
+    memset(buffer, 0, kRingSize);
+    memset(cb, 0, sizeof(*cb));
+    spin_lock_init(&cb->lock);
+    cb->buffer = buffer;
+    cb->size = kRingSize;
+}
+
+// A ring of three 32 byte records.
+struct TestRing {
+    uint8_t buffer[kRingSize];
+    ktrace_cpu_buffer_t cb;
+
+    TestRing() {
+        init_ring(&cb, buffer);
+    }
+};
+
+// Writes a record of |len| bytes, holding |seq| in its tid and every
+// remaining byte.
+zx_status_t write_record(ktrace_cpu_buffer_t* cb, uint32_t len, uint32_t seq, bool overwrite) {
+    AutoSpinLock lock(&cb->lock);
+    void* ptr;
+    zx_status_t status = ktrace_ring_reserve(cb, len, overwrite, &ptr);
+    if (status != ZX_OK) {
+        return status;
+    }
+    ktrace_header_t* hdr = static_cast<ktrace_header_t*>(ptr);
+    hdr->tag = KTRACE_TAG(1, KTRACE_GRP_PROBE, len);
+    hdr->tid = seq;
+    hdr->ts = seq;
+    memset(hdr + 1, static_cast<int>(seq), len - sizeof(*hdr));
+    return ZX_OK;
+}
+
+// Writes a name record for |id|, whose name fills the bytes where other
+// records hold their timestamp.
+zx_status_t write_name(ktrace_cpu_buffer_t* cb, uint32_t id) {
+    AutoSpinLock lock(&cb->lock);
+    void* ptr;
+    zx_status_t status = ktrace_ring_reserve(cb, KTRACE_RECSIZE, false, &ptr);
+    if (status != ZX_OK) {
+        return status;
+    }
+    ktrace_rec_name_t* rec = static_cast<ktrace_rec_name_t*>(ptr);
+    rec->tag = KTRACE_TAG(0x25, KTRACE_GRP_META, KTRACE_RECSIZE);
+    rec->id = id;
+    rec->arg = 0;
+    memset(rec->name, 0xff, KTRACE_RECSIZE - KTRACE_NAMEOFF);
+    return ZX_OK;
+}
+
+// Copies as many whole records as fit in |len| bytes out of |cb|, and
+// removes them from the ring.
+size_t drain(ktrace_cpu_buffer_t* cb, uint8_t* dst, size_t len) {
+    ktrace_merge_t m = {};
+    size_t copied = 0;
+    for (;;) {
+        uint32_t n = ktrace_merge_next(cb, 1, false, true, &m, dst + copied, len - copied);
+        if (n == 0 || n > len - copied) {
+            break;
+        }
+        copied += n;
+    }
+    return copied;
+}
+
+// Checks that |data| holds whole records with consecutive sequence numbers
+// from |first|, and returns their number in |count|.
+bool check_records(const uint8_t* data, size_t len, uint32_t first, uint32_t* count) {
+    BEGIN_TEST;
+    uint32_t seq = first;
+    size_t off = 0;
+    while (off < len) {
+        ktrace_header_t hdr;
+        memcpy(&hdr, data + off, sizeof(hdr));
+        uint32_t rec_len = KTRACE_LEN(hdr.tag);
+        ASSERT_GE(rec_len, (uint32_t)KTRACE_HDRSIZE, "record too short");
+        ASSERT_LE(off + rec_len, len, "record split across reads");
+        EXPECT_EQ(hdr.tid, seq, "records out of order");
+        EXPECT_EQ(hdr.ts, (uint64_t)seq, "");
+        for (uint32_t i = KTRACE_HDRSIZE; i < rec_len; i++) {
+            EXPECT_EQ(data[off + i], (uint8_t)seq, "record partly overwritten");
+        }
+        off += rec_len;
+        seq++;
+    }
+    *count = seq - first;
+    END_TEST;
+}
+
+bool reject_bad_lengths() {
+    BEGIN_TEST;
+
+    TestRing ring;
+
+    // A record without a header could never be evicted, nor one longer than
+    // the ring be written.
+    EXPECT_EQ(write_record(&ring.cb, 0, 0, true), ZX_ERR_OUT_OF_RANGE, "");
+    EXPECT_EQ(write_record(&ring.cb, KTRACE_HDRSIZE - 8, 0, true), ZX_ERR_OUT_OF_RANGE, "");
+    EXPECT_EQ(write_record(&ring.cb, kRingSize + 8, 0, true), ZX_ERR_OUT_OF_RANGE, "");
+
+    uint8_t out[kRingSize];
+    EXPECT_EQ(drain(&ring.cb, out, sizeof(out)), 0u, "");
+
+    // A record as long as the ring replaces everything in it.
+    EXPECT_EQ(write_record(&ring.cb, KTRACE_RECSIZE, 0, true), ZX_OK, "");
+    EXPECT_EQ(write_record(&ring.cb, kRingSize, 1, true), ZX_OK, "");
+    size_t n = drain(&ring.cb, out, sizeof(out));
+    EXPECT_EQ(n, (size_t)kRingSize, "");
+    uint32_t count;
+    EXPECT_TRUE(check_records(out, n, 1, &count), "");
+    EXPECT_EQ(count, 1u, "");
+
+    END_TEST;
+}
+
+bool one_shot_stops_when_full() {
+    BEGIN_TEST;
+
+    TestRing ring;
+
+    for (uint32_t seq = 0; seq < 3; seq++) {
+        EXPECT_EQ(write_record(&ring.cb, KTRACE_RECSIZE, seq, false), ZX_OK, "");
+    }
+    EXPECT_EQ(write_record(&ring.cb, KTRACE_HDRSIZE, 3, false), ZX_ERR_NO_RESOURCES, "");
+
+    uint8_t out[kRingSize];
+    size_t n = drain(&ring.cb, out, sizeof(out));
+    EXPECT_EQ(n, (size_t)kRingSize, "");
+    uint32_t count;
+    EXPECT_TRUE(check_records(out, n, 0, &count), "");
+    EXPECT_EQ(count, 3u, "");
+
+    END_TEST;
+}
+
+// Records of mixed lengths wrap around the ring many times, each evicting
+// the oldest whole records, and drains always return whole records in order.
+bool circular_wraps_whole_records() {
+    BEGIN_TEST;
+
+    TestRing ring;
+
+    static const uint32_t lens[] = {KTRACE_HDRSIZE, 24, KTRACE_RECSIZE, 48};
+    uint8_t out[kRingSize];
+    uint32_t next_read = 0;
+    for (uint32_t seq = 0; seq < 64; seq++) {
+        uint32_t len = lens[seq % fbl::count_of(lens)];
+        ASSERT_EQ(write_record(&ring.cb, len, seq, true), ZX_OK, "");
+
+        if (seq % 5 == 4) {
+            // Read into a buffer too small for everything, as a reader
+            // draining continuously might.
+            size_t n = drain(&ring.cb, out, KTRACE_RECSIZE + 24);
+            ASSERT_GT(n, 0u, "");
+            ktrace_header_t hdr;
+            memcpy(&hdr, out, sizeof(hdr));
+            // Records older than the first returned have been evicted.
+            ASSERT_GE(hdr.tid, next_read, "");
+            uint32_t count;
+            ASSERT_TRUE(check_records(out, n, hdr.tid, &count), "");
+            next_read = hdr.tid + count;
+        }
+    }
+
+    size_t n = drain(&ring.cb, out, sizeof(out));
+    ASSERT_GT(n, 0u, "");
+    ktrace_header_t hdr;
+    memcpy(&hdr, out, sizeof(hdr));
+    uint32_t count;
+    EXPECT_TRUE(check_records(out, n, hdr.tid, &count), "");
+    EXPECT_EQ(hdr.tid + count, 64u, "the newest record was lost");
+    EXPECT_EQ(drain(&ring.cb, out, sizeof(out)), 0u, "");
+
+    END_TEST;
+}
+
+// Records from several rings are taken in timestamp order, with a name
+// record following the record before it in its ring.
+bool merge_orders_by_timestamp() {
+    BEGIN_TEST;
+
+    uint8_t buffers[2][kRingSize];
+    ktrace_cpu_buffer_t cpus[2];
+    for (uint32_t cpu = 0; cpu < 2; cpu++) {
+        init_ring(&cpus[cpu], buffers[cpu]);
+    }
+    constexpr uint32_t kNameId = 100;
+    ASSERT_EQ(write_record(&cpus[0], KTRACE_HDRSIZE, 1, false), ZX_OK, "");
+    ASSERT_EQ(write_name(&cpus[0], kNameId), ZX_OK, "");
+    ASSERT_EQ(write_record(&cpus[0], KTRACE_HDRSIZE, 4, false), ZX_OK, "");
+    for (uint32_t seq : {2, 3, 5}) {
+        ASSERT_EQ(write_record(&cpus[1], KTRACE_HDRSIZE, seq, false), ZX_OK, "");
+    }
+    static const uint32_t order[] = {1, kNameId, 2, 3, 4, 5};
+
+    // Once tracing is stopped, the records are read in place.
+    for (uint32_t cpu = 0; cpu < 2; cpu++) {
+        ktrace_cpu_buffer_t* cb = &cpus[cpu];
+        AutoSpinLock lock(&cb->lock);
+        cb->stop_head = cb->head;
+        cb->stop_tail = cb->tail;
+        cb->stop_wrap_offset = cb->wrap_offset;
+    }
+    uint8_t rec[KTRACE_LEN(0xF)];
+    ktrace_header_t hdr;
+    ktrace_merge_t m = {};
+    for (uint32_t id : order) {
+        ASSERT_GT(ktrace_merge_next(cpus, 2, true, false, &m, rec, sizeof(rec)), 0u, "");
+        memcpy(&hdr, rec, sizeof(hdr));
+        EXPECT_EQ(hdr.tid, id, "records out of order");
+    }
+    EXPECT_EQ(ktrace_merge_next(cpus, 2, true, false, &m, rec, sizeof(rec)), 0u, "");
+
+    // Draining returns them in the same order, except that a record too long
+    // for the space given is left in its ring.
+    m = {};
+    EXPECT_EQ(ktrace_merge_next(cpus, 2, false, true, &m, rec, KTRACE_HDRSIZE - 8),
+              (uint32_t)KTRACE_HDRSIZE, "");
+    for (uint32_t id : order) {
+        ASSERT_GT(ktrace_merge_next(cpus, 2, false, true, &m, rec, sizeof(rec)), 0u, "");
+        memcpy(&hdr, rec, sizeof(hdr));
+        EXPECT_EQ(hdr.tid, id, "records out of order");
+    }
+    EXPECT_EQ(ktrace_merge_next(cpus, 2, false, true, &m, rec, sizeof(rec)), 0u, "");
+    for (uint32_t cpu = 0; cpu < 2; cpu++) {
+        ktrace_cpu_buffer_t* cb = &cpus[cpu];
+        AutoSpinLock lock(&cb->lock);
+        EXPECT_EQ(cb->tail, cb->head, "drained records left in the ring");
+    }
+
+    END_TEST;
+}
+
+} // namespace
+
+UNITTEST_START_TESTCASE(ktrace_tests)
+UNITTEST("reject bad lengths", reject_bad_lengths)
+UNITTEST("one-shot stops when full", one_shot_stops_when_full)
+UNITTEST("circular wraps whole records", circular_wraps_whole_records)
+UNITTEST("merge orders by timestamp", merge_orders_by_timestamp)
+UNITTEST_END_TESTCASE(ktrace_tests, "ktrace", "ktrace ring buffer tests");
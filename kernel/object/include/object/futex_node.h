@@ -11,14 +11,14 @@
 #include <kernel/wait.h>
 #include <list.h>
 #include <zircon/types.h>
-#include <fbl/intrusive_hash_table.h>
+#include <fbl/intrusive_resizable_hash_table.h>
 #include <fbl/mutex.h>
 
 // Node for linked list of threads blocked on a futex
 // Intended to be embedded within a ThreadDispatcher Instance
 class FutexNode : public fbl::SinglyLinkedListable<FutexNode*> {
 public:
-    using HashTable = fbl::HashTable<uintptr_t, FutexNode*>;
+    using HashTable = fbl::ResizableHashTable<uintptr_t, FutexNode*>;
 
     FutexNode();
     ~FutexNode();
@@ -50,7 +50,7 @@ public:
         hash_key_ = key;
     }
 
-    // Trait implementation for fbl::HashTable
+    // Trait implementation for fbl::ResizableHashTable
     uintptr_t GetKey() const { return hash_key_; }
     static size_t GetHash(uintptr_t key) { return (key >> 3); }
 
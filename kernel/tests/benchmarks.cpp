@@ -14,6 +14,7 @@
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/timer.h>
 #include <platform.h>
 #include <rand.h>
 #include <stdio.h>
@@ -21,6 +22,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <trace.h>
+#include <zircon/time.h>
 
 const size_t BUFSIZE = (3 * 1024 * 1024); // must be smaller than max allowed heap allocation
 const size_t ITER = (1UL * 1024 * 1024 * 1024 / BUFSIZE); // enough iterations to have to copy/set 1GB of memory
@@ -270,6 +272,67 @@ __NO_INLINE static void bench_mutex() {
     printf("%" PRIu64 " cycles to acquire/release uncontended mutex %u times (%" PRIu64 " cycles per)\n", c, count, c / count);
 }
 
+static void bench_timer_cb(timer_t*, zx_time_t, void*) {}
+
+// Sets, then cancels, a large number of timers with deadlines spread across an hour, so that
+// each timer_set must search a deep queue for a timer to coalesce with.
+__NO_INLINE static void bench_timers() {
+    static const size_t chunk_count = 100;
+    static const size_t timers_per_chunk = 1000; // keep each allocation well below the heap max
+    static const size_t count = chunk_count * timers_per_chunk;
+
+    timer_t* chunks[chunk_count] = {};
+    for (size_t i = 0; i < chunk_count; i++) {
+        chunks[i] = (timer_t*)malloc(timers_per_chunk * sizeof(timer_t));
+        if (chunks[i] == nullptr) {
+            TRACEF("error: malloc failed\n");
+            for (size_t j = 0; j < i; j++) {
+                free(chunks[j]);
+            }
+            return;
+        }
+        for (size_t j = 0; j < timers_per_chunk; j++) {
+            timer_init(&chunks[i][j]);
+        }
+    }
+
+    cpu_mask_t old_affinity = get_current_thread()->cpu_affinity;
+
+    for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if (!mp_is_cpu_online(cpu)) {
+            continue;
+        }
+        thread_set_cpu_affinity(get_current_thread(), cpu_num_to_mask(cpu));
+
+        const zx_time_t base = zx_time_add_duration(current_time(), ZX_HOUR(1));
+        const TimerSlack slack(ZX_USEC(50), TIMER_SLACK_CENTER);
+
+        uint64_t set_cycles = arch_cycle_count();
+        for (size_t i = 0; i < count; i++) {
+            zx_duration_t offset = (zx_duration_mul_int64(ZX_HOUR(1), rand())) / RAND_MAX;
+            timer_set(&chunks[i / timers_per_chunk][i % timers_per_chunk],
+                      zx_time_add_duration(base, offset), slack, bench_timer_cb, nullptr);
+        }
+        set_cycles = arch_cycle_count() - set_cycles;
+
+        uint64_t cancel_cycles = arch_cycle_count();
+        for (size_t i = 0; i < count; i++) {
+            timer_cancel(&chunks[i / timers_per_chunk][i % timers_per_chunk]);
+        }
+        cancel_cycles = arch_cycle_count() - cancel_cycles;
+
+        printf("cpu %u: %" PRIu64 " cycles to set %zu timers (%" PRIu64 " cycles per), "
+               "%" PRIu64 " cycles to cancel them (%" PRIu64 " cycles per)\n",
+               cpu, set_cycles, count, set_cycles / count, cancel_cycles, cancel_cycles / count);
+    }
+
+    thread_set_cpu_affinity(get_current_thread(), old_affinity);
+
+    for (size_t i = 0; i < chunk_count; i++) {
+        free(chunks[i]);
+    }
+}
+
 int benchmarks(int, const cmd_args*, uint32_t) {
     bench_set_overhead();
     bench_memcpy();
@@ -287,5 +350,7 @@ int benchmarks(int, const cmd_args*, uint32_t) {
     bench_spinlock();
     bench_mutex();
 
+    bench_timers();
+
     return 0;
 }
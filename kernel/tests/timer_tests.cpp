@@ -475,6 +475,57 @@ static bool trylock_or_cancel_get_lock() {
     END_TEST;
 }
 
+static void timer_noop_cb(struct timer*, zx_time_t, void*) {}
+
+// See that timers with slack are coalesced with the closest overlapping timer.
+static bool coalesce_with_slack() {
+    BEGIN_TEST;
+
+    timer_t a = TIMER_INITIAL_VALUE(a);
+    timer_t b = TIMER_INITIAL_VALUE(b);
+    timer_t c = TIMER_INITIAL_VALUE(c);
+    timer_t d = TIMER_INITIAL_VALUE(d);
+    timer_t e = TIMER_INITIAL_VALUE(e);
+
+    // Keep every timer on the same cpu's queue.
+    arch_disable_ints();
+
+    const zx_time_t base = zx_time_add_duration(current_time(), ZX_HOUR(5));
+    timer_set(&a, base, kNoSlack, timer_noop_cb, nullptr);
+    timer_set(&c, base + ZX_MSEC(1), kNoSlack, timer_noop_cb, nullptr);
+
+    // Overlaps only |a|, so fires early with it.
+    timer_set(&b, base + ZX_USEC(10), TimerSlack(ZX_USEC(20), TIMER_SLACK_CENTER),
+              timer_noop_cb, nullptr);
+    // Overlaps only |c|, so fires late with it.
+    timer_set(&d, base + ZX_USEC(600), TimerSlack(ZX_USEC(500), TIMER_SLACK_CENTER),
+              timer_noop_cb, nullptr);
+    // Overlaps both |a| and |c|, but is closer to |c|.
+    timer_set(&e, base + ZX_USEC(700), TimerSlack(ZX_USEC(700), TIMER_SLACK_CENTER),
+              timer_noop_cb, nullptr);
+
+    arch_enable_ints();
+
+    EXPECT_EQ(a.scheduled_time, base, "");
+    EXPECT_EQ(a.slack, 0, "");
+    EXPECT_EQ(b.scheduled_time, base, "");
+    EXPECT_EQ(b.slack, -ZX_USEC(10), "");
+    EXPECT_EQ(c.scheduled_time, base + ZX_MSEC(1), "");
+    EXPECT_EQ(c.slack, 0, "");
+    EXPECT_EQ(d.scheduled_time, base + ZX_MSEC(1), "");
+    EXPECT_EQ(d.slack, ZX_USEC(400), "");
+    EXPECT_EQ(e.scheduled_time, base + ZX_MSEC(1), "");
+    EXPECT_EQ(e.slack, ZX_USEC(300), "");
+
+    EXPECT_TRUE(timer_cancel(&a), "");
+    EXPECT_TRUE(timer_cancel(&b), "");
+    EXPECT_TRUE(timer_cancel(&c), "");
+    EXPECT_TRUE(timer_cancel(&d), "");
+    EXPECT_TRUE(timer_cancel(&e), "");
+
+    END_TEST;
+}
+
 UNITTEST_START_TESTCASE(timer_tests)
 UNITTEST("cancel_before_deadline", cancel_before_deadline)
 UNITTEST("cancel_after_fired", cancel_after_fired)
@@ -482,4 +533,5 @@ UNITTEST("cancel_from_callback", cancel_from_callback)
 UNITTEST("set_from_callback", set_from_callback)
 UNITTEST("trylock_or_cancel_canceled", trylock_or_cancel_canceled)
 UNITTEST("trylock_or_cancel_get_lock", trylock_or_cancel_get_lock)
+UNITTEST("coalesce_with_slack", coalesce_with_slack)
 UNITTEST_END_TESTCASE(timer_tests, "timer", "timer tests");
@@ -12,6 +12,7 @@ MODULE_FIDL_RSP := $(MODULE_GENDIR)/fidl.rsp
 MODULE_FIDL_LIB_PATH := $(subst .,/,$(MODULE_FIDL_LIBRARY))
 MODULE_FIDL_INCLUDE := $(MODULE_GENDIR)/include
 MODULE_FIDL_H := $(MODULE_FIDL_INCLUDE)/$(MODULE_FIDL_LIB_PATH)/c/fidl.h
+MODULE_FIDL_CODING_H := $(MODULE_FIDL_INCLUDE)/$(MODULE_FIDL_LIB_PATH)/c/coding.h
 MODULE_FIDL_CPP := $(MODULE_GENDIR)/src/tables.cpp
 MODULE_FIDL_CLIENT_C := $(MODULE_GENDIR)/src/client.c
 MODULE_FIDL_SERVER_C := $(MODULE_GENDIR)/src/server.c
@@ -20,7 +21,7 @@ MODULE_FIDL_COBJS :=  $(MODULE_GENDIR)/obj/client.c.o $(MODULE_GENDIR)/obj/serve
 MODULE_FIDL_OBJS := $(MODULE_FIDL_CPPOBJS) $(MODULE_FIDL_COBJS)
 
 MODULE_SRCDEPS += $(MODULE_FIDL_H) $(MODULE_FIDL_CPP)
-MODULE_GEN_HDR += $(MODULE_FIDL_H)
+MODULE_GEN_HDR += $(MODULE_FIDL_H) $(MODULE_FIDL_CODING_H)
 
 # There is probably a more correct way to express this dependency, but having
 # this dependency here makes the build non-flakey.
@@ -54,29 +55,31 @@ $(MODULE_FIDL_FILE_LIST):
 $(MODULE_FIDL_RSP): FIDL_DEPS:=$(MODULE_FIDL_DEPS)
 $(MODULE_FIDL_RSP): FIDL_NAME:=$(MODULE_FIDL_LIBRARY)
 $(MODULE_FIDL_RSP): FIDL_H:=$(MODULE_FIDL_H)
+$(MODULE_FIDL_RSP): FIDL_CODING_H:=$(MODULE_FIDL_CODING_H)
 $(MODULE_FIDL_RSP): FIDL_CPP:=$(MODULE_FIDL_CPP)
 $(MODULE_FIDL_RSP): FIDL_CLIENT_C:=$(MODULE_FIDL_CLIENT_C)
 $(MODULE_FIDL_RSP): FIDL_SERVER_C:=$(MODULE_FIDL_SERVER_C)
 $(MODULE_FIDL_RSP): FIDL_SRCS:=$(MODULE_FIDLSRCS)
 $(MODULE_FIDL_RSP): $(foreach dep,$(MODULE_FIDL_DEPS),$(call TOBUILDDIR,$(dep))/gen/fidl-files) $(MODULE_FIDLSRCS) make/fcompile.mk
 	@$(MKDIR)
-	$(NOECHO)echo --name $(FIDL_NAME) --c-header $(FIDL_H) --c-client $(FIDL_CLIENT_C) --c-server $(FIDL_SERVER_C) --tables $(FIDL_CPP) $(foreach dep,$(FIDL_DEPS),--files $(shell cat $(call TOBUILDDIR,$(dep))/gen/fidl-files)) --files $(FIDL_SRCS) > $@
+	$(NOECHO)echo --name $(FIDL_NAME) --c-header $(FIDL_H) --c-client $(FIDL_CLIENT_C) --c-server $(FIDL_SERVER_C) --c-coding $(FIDL_CODING_H) --tables $(FIDL_CPP) $(foreach dep,$(FIDL_DEPS),--files $(shell cat $(call TOBUILDDIR,$(dep))/gen/fidl-files)) --files $(FIDL_SRCS) > $@
 
 # $@ only lists one of the multiple targets, so we use $< (first dep) to
 # compute the (related) destination directories to create
-%/gen/include/$(MODULE_FIDL_LIB_PATH)/c/fidl.h %/gen/src/tables.cpp %/gen/src/client.c %/gen/src/server.c: %/gen/fidl.rsp $(FIDL)
+%/gen/include/$(MODULE_FIDL_LIB_PATH)/c/fidl.h %/gen/include/$(MODULE_FIDL_LIB_PATH)/c/coding.h %/gen/src/tables.cpp %/gen/src/client.c %/gen/src/server.c: %/gen/fidl.rsp $(FIDL)
 	$(call BUILDECHO, generating fidl from $<)
 	@mkdir -p $(<D)/include $(<D)/src
 	$(NOECHO)$(FIDL) @$<
 
 EXTRA_BUILDDEPS += make/fcompile.mk
-GENERATED += $(MODULE_FIDL_H) $(MODULE_FIDL_CPP) $(MODULE_FIDL_CLIENT_C) $(MODULE_FIDL_SERVER_C)
+GENERATED += $(MODULE_FIDL_H) $(MODULE_FIDL_CODING_H) $(MODULE_FIDL_CPP) $(MODULE_FIDL_CLIENT_C) $(MODULE_FIDL_SERVER_C)
 
 # clear some variables we set here
 MODULE_FIDLSRCS :=
 MODULE_FIDL_LIB_PATH :=
 MODULE_FIDL_INCLUDE :=
 MODULE_FIDL_H :=
+MODULE_FIDL_CODING_H :=
 MODULE_FIDL_CPP :=
 MODULE_FIDL_CLIENT_C :=
 MODULE_FIDL_SERVER_C :=
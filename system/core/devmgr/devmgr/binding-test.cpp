@@ -0,0 +1,203 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <ddk/binding.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <string.h>
+#include <unittest/unittest.h>
+
+#include "coordinator.h"
+
+namespace devmgr {
+namespace {
+
+constexpr uint32_t kPci = 10;
+constexpr uint32_t kUsb = 20;
+constexpr uint32_t kBlock = 30;
+
+constexpr size_t kMaxInstructions = 8;
+constexpr size_t kMaxProtocols = 4;
+
+// A bind program, and the protocols dc_get_bind_protocols should find it may
+// bind to.
+struct ProtocolCase {
+    const char* name;
+    size_t count;
+    zx_bind_inst_t binding[kMaxInstructions];
+    // true if the program may bind to devices of any protocol
+    bool any;
+    size_t protocol_count;
+    uint32_t protocols[kMaxProtocols];
+};
+
+const ProtocolCase kProtocolCases[] = {
+    {"empty program", 0, {}, false, 0, {}},
+    {"abort unless protocol", 2, {
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kPci),
+        BI_MATCH(),
+    }, false, 1, {kPci}},
+    {"match one of protocols", 3, {
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kUsb),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kPci),
+        BI_ABORT(),
+    }, false, 2, {kPci, kUsb}},
+    {"other properties take both branches", 3, {
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kPci),
+        BI_ABORT_IF(NE, BIND_PCI_VID, 0x8086),
+        BI_MATCH(),
+    }, false, 1, {kPci}},
+    {"autobind takes both branches", 3, {
+        BI_ABORT_IF_AUTOBIND,
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kUsb),
+        BI_MATCH(),
+    }, false, 1, {kUsb}},
+    {"goto label", 6, {
+        BI_GOTO_IF(EQ, BIND_PROTOCOL, kUsb, 1),
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kPci),
+        BI_MATCH(),
+        BI_LABEL(1),
+        BI_MATCH_IF(EQ, BIND_PCI_VID, 1),
+        BI_ABORT(),
+    }, false, 2, {kPci, kUsb}},
+    {"goto missing label", 3, {
+        BI_GOTO_IF(EQ, BIND_PROTOCOL, kUsb, 2),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kPci),
+        BI_LABEL(1),
+    }, false, 1, {kPci}},
+    {"abort before a later match", 3, {
+        BI_ABORT_IF(EQ, BIND_PROTOCOL, kPci),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kUsb),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kPci),
+    }, false, 1, {kUsb}},
+    {"unconditional abort", 3, {
+        BI_ABORT_IF(EQ, BIND_PROTOCOL, kPci),
+        BI_ABORT(),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kPci),
+    }, false, 0, {}},
+    {"flags set by protocol", 4, {
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kUsb),
+        BI_SET_IF(EQ, BIND_PROTOCOL, kBlock, 1),
+        BI_MATCH_IF(EQ, BIND_FLAGS, 1),
+        BI_ABORT(),
+    }, false, 2, {kUsb, kBlock}},
+    {"flags cleared", 5, {
+        BI_SET(1),
+        BI_CLEAR_IF(EQ, BIND_PROTOCOL, kPci, 1),
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kPci),
+        BI_MATCH_IF(EQ, BIND_FLAGS, 1),
+        BI_ABORT(),
+    }, false, 0, {}},
+    {"no protocol test matches any", 1, {
+        BI_MATCH_IF(EQ, BIND_PCI_VID, 1),
+    }, true, 0, {}},
+    {"goto around protocol test matches any", 5, {
+        BI_GOTO_IF(EQ, BIND_PCI_VID, 1, 1),
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kPci),
+        BI_MATCH(),
+        BI_LABEL(1),
+        BI_MATCH(),
+    }, true, 0, {}},
+    {"protocol range matches any", 2, {
+        BI_ABORT_IF(LT, BIND_PROTOCOL, kPci),
+        BI_MATCH(),
+    }, true, 0, {}},
+    {"protocol excluded matches any", 2, {
+        BI_ABORT_IF(EQ, BIND_PROTOCOL, kPci),
+        BI_MATCH(),
+    }, true, 0, {}},
+};
+
+bool InitDriver(const ProtocolCase& test, Driver* drv) {
+    BEGIN_HELPER;
+    drv->name = test.name;
+    drv->binding_size = static_cast<uint32_t>(test.count * sizeof(zx_bind_inst_t));
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<zx_bind_inst_t[]> binding(new (&ac) zx_bind_inst_t[test.count]);
+    ASSERT_TRUE(ac.check());
+    memcpy(binding.get(), test.binding, drv->binding_size);
+    drv->binding.reset(binding.release());
+    drv->bind_any_protocol = !dc_get_bind_protocols(drv, &drv->bind_protocols);
+    END_HELPER;
+}
+
+bool TestGetBindProtocols() {
+    BEGIN_TEST;
+    for (const ProtocolCase& test : kProtocolCases) {
+        unittest_printf("%s\n", test.name);
+        Driver drv;
+        ASSERT_TRUE(InitDriver(test, &drv));
+        EXPECT_EQ(test.any, drv.bind_any_protocol, test.name);
+        if (test.any) {
+            continue;
+        }
+        ASSERT_EQ(test.protocol_count, drv.bind_protocols.size(), test.name);
+        for (size_t i = 0; i < test.protocol_count; i++) {
+            EXPECT_EQ(test.protocols[i], drv.bind_protocols[i], test.name);
+        }
+    }
+    END_TEST;
+}
+
+// Every device which a program binds to must have a protocol in the index,
+// whether it comes from a BIND_PROTOCOL property or, failing that, from the
+// device's protocol_id.
+bool TestIndexCoversBindableDevices() {
+    BEGIN_TEST;
+    const uint32_t protocols[] = {0, kPci, kUsb, kBlock, kBlock + 1};
+    const uint32_t vids[] = {0, 1, 0x8086};
+    for (const ProtocolCase& test : kProtocolCases) {
+        Driver drv;
+        ASSERT_TRUE(InitDriver(test, &drv));
+        for (uint32_t protocol : protocols) {
+            for (uint32_t vid : vids) {
+                for (bool autobind : {false, true}) {
+                    zx_device_prop_t props[] = {
+                        {BIND_PCI_VID, 0, vid},
+                        {BIND_PROTOCOL, 0, protocol},
+                    };
+                    // Without a BIND_PROTOCOL property, the protocol_id is used.
+                    if (dc_is_bindable(&drv, protocol, props, 1, autobind)) {
+                        EXPECT_TRUE(dc_may_bind_protocol(&drv, protocol), test.name);
+                    }
+                    if (dc_is_bindable(&drv, kBlock + 2, props, countof(props), autobind)) {
+                        EXPECT_TRUE(dc_may_bind_protocol(&drv, protocol), test.name);
+                    }
+                }
+            }
+        }
+    }
+    END_TEST;
+}
+
+bool TestProtocolProperty() {
+    BEGIN_TEST;
+    const ProtocolCase& test = kProtocolCases[1];
+    Driver drv;
+    ASSERT_TRUE(InitDriver(test, &drv));
+
+    EXPECT_TRUE(dc_is_bindable(&drv, kPci, nullptr, 0, false));
+    EXPECT_FALSE(dc_is_bindable(&drv, kUsb, nullptr, 0, false));
+
+    // A BIND_PROTOCOL property takes precedence over the protocol_id.
+    zx_device_prop_t pci_props[] = {{BIND_PROTOCOL, 0, kPci}};
+    EXPECT_TRUE(dc_is_bindable(&drv, kUsb, pci_props, countof(pci_props), false));
+    zx_device_prop_t usb_props[] = {{BIND_PROTOCOL, 0, kUsb}};
+    EXPECT_FALSE(dc_is_bindable(&drv, kPci, usb_props, countof(usb_props), false));
+    END_TEST;
+}
+
+} // namespace
+} // namespace devmgr
+
+BEGIN_TEST_CASE(binding_tests)
+RUN_TEST(devmgr::TestGetBindProtocols)
+RUN_TEST(devmgr::TestIndexCoversBindableDevices)
+RUN_TEST(devmgr::TestProtocolProperty)
+END_TEST_CASE(binding_tests)
+
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
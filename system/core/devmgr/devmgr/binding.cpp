@@ -6,6 +6,8 @@
 #include <ddk/driver.h>
 #include <ddk/binding.h>
 
+#include <fbl/alloc_checker.h>
+#include <fbl/vector.h>
 #include <stdio.h>
 
 #include "coordinator.h"
@@ -45,6 +47,39 @@ uint32_t dev_get_prop(BindProgramContext* ctx, uint32_t id) {
     }
 }
 
+// Evaluates the condition |cc| of a bind instruction against the property
+// value |pval|. Returns false if |cc| is not a valid condition.
+bool eval_cond(uint32_t cc, uint32_t pval, uint32_t value, bool* cond) {
+    switch (cc) {
+    case COND_EQ:
+        *cond = (pval == value);
+        return true;
+    case COND_NE:
+        *cond = (pval != value);
+        return true;
+    case COND_LT:
+        *cond = (pval < value);
+        return true;
+    case COND_GT:
+        *cond = (pval > value);
+        return true;
+    case COND_LE:
+        *cond = (pval <= value);
+        return true;
+    case COND_GE:
+        *cond = (pval >= value);
+        return true;
+    case COND_MASK:
+        *cond = ((pval & value) != 0);
+        return true;
+    case COND_BITS:
+        *cond = ((pval & value) == value);
+        return true;
+    default:
+        return false;
+    }
+}
+
 bool is_bindable(BindProgramContext* ctx) {
     const zx_bind_inst_t* ip = ctx->binding;
     const zx_bind_inst_t* end = ip + (ctx->binding_size / sizeof(zx_bind_inst_t));
@@ -65,32 +100,7 @@ bool is_bindable(BindProgramContext* ctx) {
             }
 
             // evaluate condition
-            switch (BINDINST_CC(inst)) {
-            case COND_EQ:
-                cond = (pval == value);
-                break;
-            case COND_NE:
-                cond = (pval != value);
-                break;
-            case COND_LT:
-                cond = (pval < value);
-                break;
-            case COND_GT:
-                cond = (pval > value);
-                break;
-            case COND_LE:
-                cond = (pval <= value);
-                break;
-            case COND_GE:
-                cond = (pval >= value);
-                break;
-            case COND_MASK:
-                cond = ((pval & value) != 0);
-                break;
-            case COND_BITS:
-                cond = ((pval & value) == value);
-                break;
-            default:
+            if (!eval_cond(BINDINST_CC(inst), pval, value, &cond)) {
                 // illegal instruction: abort
                 printf("devmgr: driver '%s' illegal bindinst 0x%08x\n", ctx->name, inst);
                 return false;
@@ -140,10 +150,197 @@ next_instruction:
     return false;
 }
 
+// A point on a path through a bind program: the instruction about to be
+// executed and the value of the flags register.
+struct BindState {
+    size_t ip;
+    uint32_t flags;
+};
+
+// Bounds the number of states explored by may_match_protocol, beyond which
+// a program is assumed to match.
+constexpr size_t kMaxBindStates = 256;
+
+bool push_bind_state(fbl::Vector<BindState>* visited, fbl::Vector<BindState>* pending,
+                     BindState state) {
+    for (const BindState& s : *visited) {
+        if (s.ip == state.ip && s.flags == state.flags) {
+            return true;
+        }
+    }
+    if (visited->size() == kMaxBindStates) {
+        return false;
+    }
+    fbl::AllocChecker ac;
+    visited->push_back(state, &ac);
+    if (!ac.check()) {
+        return false;
+    }
+    pending->push_back(state, &ac);
+    return ac.check();
+}
+
+// Returns true if the bind program may match a device whose BIND_PROTOCOL is
+// |protocol|. Every other property, and autobind, may take any value, so
+// conditions on them follow both branches. Returns true if the search is
+// abandoned.
+bool may_match_protocol(const zx_bind_inst_t* binding, size_t count, uint32_t protocol) {
+    fbl::Vector<BindState> visited;
+    fbl::Vector<BindState> pending;
+    if (!push_bind_state(&visited, &pending, BindState{0, 0})) {
+        return true;
+    }
+
+    while (!pending.is_empty()) {
+        BindState state = pending.erase(pending.size() - 1);
+        while (state.ip < count) {
+            uint32_t inst = binding[state.ip].op;
+            bool cond = true;
+
+            if (BINDINST_CC(inst) != COND_AL) {
+                uint32_t pid = BINDINST_PB(inst);
+                if (pid == BIND_FLAGS || pid == BIND_PROTOCOL) {
+                    uint32_t pval = (pid == BIND_FLAGS) ? state.flags : protocol;
+                    if (!eval_cond(BINDINST_CC(inst), pval, binding[state.ip].arg, &cond)) {
+                        break;
+                    }
+                } else {
+                    // Follow the branch where the condition is false later.
+                    if (!push_bind_state(&visited, &pending,
+                                         BindState{state.ip + 1, state.flags})) {
+                        return true;
+                    }
+                }
+            }
+
+            if (cond) {
+                switch (BINDINST_OP(inst)) {
+                case OP_ABORT:
+                    state.ip = count + 1;
+                    continue;
+                case OP_MATCH:
+                    return true;
+                case OP_GOTO: {
+                    uint32_t label = BINDINST_PA(inst);
+                    size_t ip = state.ip;
+                    while (++ip < count) {
+                        if ((BINDINST_OP(binding[ip].op) == OP_LABEL) &&
+                            (BINDINST_PA(binding[ip].op) == label)) {
+                            break;
+                        }
+                    }
+                    state.ip = ip;
+                    break;
+                }
+                case OP_SET:
+                    state.flags |= BINDINST_PA(inst);
+                    break;
+                case OP_CLEAR:
+                    state.flags &= ~(BINDINST_PA(inst));
+                    break;
+                case OP_LABEL:
+                    break;
+                default:
+                    state.ip = count + 1;
+                    continue;
+                }
+            }
+            state.ip++;
+        }
+    }
+    return false;
+}
+
 } // namespace
 
 namespace devmgr {
 
+bool dc_get_bind_protocols(const Driver* drv, fbl::Vector<uint32_t>* protocols) {
+    protocols->reset();
+    if (drv->binding_size == 0) {
+        return true;
+    }
+    const zx_bind_inst_t* binding = drv->binding.get();
+    size_t count = drv->binding_size / sizeof(zx_bind_inst_t);
+
+    // Only equality tests are understood, so that every protocol not named
+    // by the program behaves the same way.
+    fbl::Vector<uint32_t> values;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t inst = binding[i].op;
+        if (BINDINST_CC(inst) == COND_AL || BINDINST_PB(inst) != BIND_PROTOCOL) {
+            continue;
+        }
+        if (BINDINST_CC(inst) != COND_EQ && BINDINST_CC(inst) != COND_NE) {
+            return false;
+        }
+        uint32_t value = binding[i].arg;
+        size_t pos = 0;
+        while (pos < values.size() && values[pos] < value) {
+            pos++;
+        }
+        if (pos < values.size() && values[pos] == value) {
+            continue;
+        }
+        fbl::AllocChecker ac;
+        values.insert(pos, value, &ac);
+        if (!ac.check()) {
+            return false;
+        }
+    }
+    if (values.is_empty()) {
+        return false;
+    }
+
+    uint32_t other = 0;
+    for (uint32_t value : values) {
+        if (value != other) {
+            break;
+        }
+        other++;
+    }
+    if (may_match_protocol(binding, count, other)) {
+        return false;
+    }
+
+    for (uint32_t value : values) {
+        if (may_match_protocol(binding, count, value)) {
+            fbl::AllocChecker ac;
+            protocols->push_back(value, &ac);
+            if (!ac.check()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool dc_may_bind_protocol(const Driver* drv, uint32_t protocol) {
+    if (drv->bind_any_protocol) {
+        return true;
+    }
+    size_t lo = 0;
+    size_t hi = drv->bind_protocols.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (drv->bind_protocols[mid] < protocol) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < drv->bind_protocols.size() && drv->bind_protocols[lo] == protocol;
+}
+
+uint32_t dc_device_protocol(const Device* dev) {
+    for (uint32_t i = 0; i < dev->prop_count; i++) {
+        if (dev->props[i].id == BIND_PROTOCOL) {
+            return dev->props[i].value;
+        }
+    }
+    return dev->protocol_id;
+}
+
 bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
                     zx_device_prop_t* props, size_t prop_count,
                     bool autobind) {
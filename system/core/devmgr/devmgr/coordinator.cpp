@@ -119,6 +119,10 @@ public:
     void DriverAddedInit(Driver* drv, const char* version);
     void DriverAddedSys(Driver* drv, const char* version);
 
+    // Adds |drv| to the front or back of the list of drivers offered new
+    // devices, and to the bind index.
+    void InsertDriver(Driver* drv, bool first);
+
     void set_running(bool running) { running_ = running; }
 
     fbl::DoublyLinkedList<Driver*, Driver::Node>& drivers() { return drivers_; };
@@ -147,6 +151,27 @@ private:
     // All Drivers
     fbl::DoublyLinkedList<Driver*, Driver::Node> drivers_;
 
+    // Index of All Drivers by the protocols they may bind to, ordered by
+    // protocol and then bind_order.
+    struct DriverIndexEntry {
+        uint32_t protocol;
+        int64_t order;
+        const Driver* drv;
+    };
+    fbl::Vector<DriverIndexEntry> driver_index_;
+
+    // Drivers in All Drivers which may bind to any protocol, ordered by
+    // bind_order.
+    fbl::Vector<const Driver*> any_protocol_drivers_;
+
+    int64_t first_driver_order_ = 0;
+    int64_t last_driver_order_ = 0;
+
+    // Calls |func| on each driver which may bind to devices of |protocol|,
+    // in the order of All Drivers, until it returns false.
+    template <typename Func>
+    void ForEachBindCandidate(uint32_t protocol, Func func) const;
+
     // Drivers to add to All Drivers
     fbl::DoublyLinkedList<Driver*, Driver::Node> new_drivers_;
 
@@ -1077,6 +1102,39 @@ zx_status_t Coordinator::RemoveDevice(Device* dev, bool forced) {
     return ZX_OK;
 }
 
+template <typename Func>
+void Coordinator::ForEachBindCandidate(uint32_t protocol, Func func) const {
+    // Find the drivers indexed under |protocol|, and merge them with the
+    // drivers which may bind to any protocol.
+    size_t lo = 0;
+    size_t hi = driver_index_.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (driver_index_[mid].protocol < protocol) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    size_t i = lo;
+    size_t j = 0;
+    for (;;) {
+        bool indexed = (i < driver_index_.size()) && (driver_index_[i].protocol == protocol);
+        bool any = (j < any_protocol_drivers_.size());
+        const Driver* drv;
+        if (indexed && (!any || driver_index_[i].order < any_protocol_drivers_[j]->bind_order)) {
+            drv = driver_index_[i++].drv;
+        } else if (any) {
+            drv = any_protocol_drivers_[j++];
+        } else {
+            return;
+        }
+        if (!func(drv)) {
+            return;
+        }
+    }
+}
+
 zx_status_t Coordinator::BindDevice(Device* dev, fbl::StringPiece drvlibname) {
      log(INFO, "devcoord: dc_bind_device() '%.*s'\n", static_cast<int>(drvlibname.size()),
          drvlibname.data());
@@ -1091,16 +1149,22 @@ zx_status_t Coordinator::BindDevice(Device* dev, fbl::StringPiece drvlibname) {
     bool autobind = (drvlibname.size() == 0);
 
     //TODO: disallow if we're in the middle of enumeration, etc
-    for (const auto& drv : drivers_) {
-        if (autobind || !drvlibname.compare(drv.libname)) {
-            if (dc_is_bindable(&drv, dev->protocol_id,
+    bool bound = false;
+    ForEachBindCandidate(dc_device_protocol(dev), [&](const Driver* drv) {
+        if (autobind || !drvlibname.compare(drv->libname)) {
+            if (dc_is_bindable(drv, dev->protocol_id,
                                dev->props.get(), dev->prop_count, autobind)) {
                 log(SPEW, "devcoord: drv='%s' bindable to dev='%s'\n",
-                    drv.name.c_str(), dev->name);
-                AttemptBind(&drv, dev);
-                return ZX_OK;
+                    drv->name.c_str(), dev->name);
+                AttemptBind(drv, dev);
+                bound = true;
+                return false;
             }
         }
+        return true;
+    });
+    if (bound) {
+        return ZX_OK;
     }
 
     // Notify observers that this device is available again
@@ -1801,18 +1865,19 @@ zx_status_t Coordinator::AttemptBind(const Driver* drv, Device* dev) {
 }
 
 void Coordinator::HandleNewDevice(Device* dev) {
-    for (auto& drv : drivers_) {
-        if (dc_is_bindable(&drv, dev->protocol_id,
+    ForEachBindCandidate(dc_device_protocol(dev), [&](const Driver* drv) {
+        if (dc_is_bindable(drv, dev->protocol_id,
                            dev->props.get(), dev->prop_count, true)) {
             log(SPEW, "devcoord: drv='%s' bindable to dev='%s'\n",
-                drv.name.c_str(), dev->name);
+                drv->name.c_str(), dev->name);
 
-            AttemptBind(&drv, dev);
+            AttemptBind(drv, dev);
             if (!(dev->flags & DEV_CTX_MULTI_BIND)) {
-                break;
+                return false;
             }
         }
-    }
+        return true;
+    });
 }
 
 static void dc_suspend_fallback(uint32_t flags) {
@@ -2083,6 +2148,40 @@ static bool is_root_driver(Driver* drv) {
         (memcmp(&root_device_binding, drv->binding.get(), sizeof(root_device_binding)) == 0);
 }
 
+// InsertDriver analyzes the binding of a driver added to the
+// all-drivers list, so that new devices are only offered to the
+// drivers which may bind to their protocol.
+void Coordinator::InsertDriver(Driver* drv, bool first) {
+    if (first) {
+        drivers_.push_front(drv);
+        drv->bind_order = --first_driver_order_;
+    } else {
+        drivers_.push_back(drv);
+        drv->bind_order = ++last_driver_order_;
+    }
+
+    drv->bind_any_protocol = !dc_get_bind_protocols(drv, &drv->bind_protocols);
+    if (drv->bind_any_protocol) {
+        any_protocol_drivers_.insert(first ? 0 : any_protocol_drivers_.size(), drv);
+        return;
+    }
+    for (uint32_t protocol : drv->bind_protocols) {
+        size_t lo = 0;
+        size_t hi = driver_index_.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            const DriverIndexEntry& entry = driver_index_[mid];
+            if (entry.protocol < protocol ||
+                (entry.protocol == protocol && entry.order < drv->bind_order)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        driver_index_.insert(lo, DriverIndexEntry{protocol, drv->bind_order, drv});
+    }
+}
+
 // DriverAddedInit is called from driver enumeration during
 // startup and before the devcoordinator starts running.  Enumerated
 // drivers are added directly to the all-drivers or fallback list.
@@ -2095,9 +2194,9 @@ void Coordinator::DriverAddedInit(Driver* drv, const char* version) {
     } else if (version[0] == '!') {
         // debugging / development hack
         // prioritize drivers with version "!..." over others
-        drivers_.push_front(drv);
+        InsertDriver(drv, true);
     } else {
-        drivers_.push_back(drv);
+        InsertDriver(drv, false);
     }
 }
 
@@ -2151,6 +2250,9 @@ void Coordinator::BindDriver(Driver* drv) {
                 // if device is already bound or being destroyed or invisible, skip it
                 continue;
             }
+            if (!dc_may_bind_protocol(drv, dc_device_protocol(&dev))) {
+                continue;
+            }
             if (dc_is_bindable(drv, dev.protocol_id,
                                dev.props.get(), dev.prop_count, true)) {
                 log(INFO, "devcoord: drv='%s' bindable to dev='%s'\n",
@@ -2165,7 +2267,7 @@ void Coordinator::BindDriver(Driver* drv) {
 void Coordinator::HandleNewDriver() {
     Driver* drv;
     while ((drv = new_drivers_.pop_front()) != nullptr) {
-        drivers_.push_back(drv);
+        InsertDriver(drv, false);
         BindDriver(drv);
     }
 }
@@ -2320,7 +2422,7 @@ void coordinator(DevmgrArgs args) {
     } else {
         Driver* drv;
         while ((drv = g_coordinator.fallback_drivers().pop_back()) != nullptr) {
-            g_coordinator.drivers().push_back(drv);
+            g_coordinator.InsertDriver(drv, false);
         }
     }
 
@@ -395,6 +395,15 @@ struct Driver {
     };
 
     fbl::String libname;
+
+    // Protocols of the devices the binding may match, in ascending order,
+    // unless it may match devices of any protocol.
+    fbl::Vector<uint32_t> bind_protocols;
+    bool bind_any_protocol = true;
+
+    // Position in the coordinator's list of drivers, used to order the
+    // drivers in its bind index.
+    int64_t bind_order = 0;
 };
 
 #define DRIVER_NAME_LEN_MAX 64
@@ -434,6 +443,17 @@ bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
                     zx_device_prop_t* props, size_t prop_count,
                     bool autobind);
 
+// Places the protocols of the devices |drv| may bind to in |protocols|, in
+// ascending order. Returns false if |drv| may bind to devices of any
+// protocol.
+bool dc_get_bind_protocols(const Driver* drv, fbl::Vector<uint32_t>* protocols);
+
+// Returns false if |drv| cannot bind to devices of |protocol|.
+bool dc_may_bind_protocol(const Driver* drv, uint32_t protocol);
+
+// Returns the protocol a device presents to bind programs.
+uint32_t dc_device_protocol(const Device* dev);
+
 extern bool dc_asan_drivers;
 extern bool dc_launched_first_devhost;
 
@@ -175,3 +175,36 @@ MODULE_FIDL_LIBS := \
     system/fidl/fuchsia-device-manager \
 
 include make/module.mk
+
+
+# devmgr-test - unit tests for the coordinator's driver binding
+
+MODULE := $(LOCAL_DIR).test
+
+MODULE_NAME := devmgr-test
+MODULE_TYPE := usertest
+
+MODULE_SRCS := \
+    $(LOCAL_DIR)/devmgr/binding.cpp \
+    $(LOCAL_DIR)/devmgr/binding-test.cpp \
+
+MODULE_HEADER_DEPS := \
+    system/ulib/ddk \
+
+MODULE_STATIC_LIBS := \
+    system/ulib/async \
+    system/ulib/async.cpp \
+    system/ulib/async-loop \
+    system/ulib/async-loop.cpp \
+    system/ulib/fbl \
+    system/ulib/fit \
+    system/ulib/zx \
+    system/ulib/zxcpp \
+
+MODULE_LIBS := \
+    system/ulib/unittest \
+    system/ulib/fdio \
+    system/ulib/zircon \
+    system/ulib/c \
+
+include make/module.mk
@@ -65,12 +65,22 @@ static zx_status_t ktrace_ioctl(void* ctx, uint32_t op,
         *out_actual = sizeof(uint32_t);
         return ZX_OK;
     }
-    case IOCTL_KTRACE_START: {
+    case IOCTL_KTRACE_START:
+    case IOCTL_KTRACE_START_CIRCULAR: {
         if (cmdlen != sizeof(uint32_t)) {
             return ZX_ERR_INVALID_ARGS;
         }
         uint32_t group_mask = *(uint32_t *)cmd;
-        return zx_ktrace_control(get_root_resource(), KTRACE_ACTION_START, group_mask, NULL);
+        uint32_t action = (op == IOCTL_KTRACE_START) ? KTRACE_ACTION_START
+                                                     : KTRACE_ACTION_START_CIRCULAR;
+        return zx_ktrace_control(get_root_resource(), action, group_mask, NULL);
+    }
+    case IOCTL_KTRACE_SET_DRAINING: {
+        if (cmdlen != sizeof(uint32_t)) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        uint32_t draining = *(uint32_t *)cmd;
+        return zx_ktrace_control(get_root_resource(), KTRACE_ACTION_SET_DRAINING, draining, NULL);
     }
     case IOCTL_KTRACE_STOP: {
         zx_ktrace_control(get_root_resource(), KTRACE_ACTION_STOP, 0, NULL);
@@ -33,6 +33,7 @@ void Usage() {
         << "usage: fidlc [--c-header HEADER_PATH]\n"
            "             [--c-client CLIENT_PATH]\n"
            "             [--c-server SERVER_PATH]\n"
+           "             [--c-coding CODING_PATH]\n"
            "             [--tables TABLES_PATH]\n"
            "             [--json JSON_PATH]\n"
            "             [--name LIBRARY_NAME]\n"
@@ -48,6 +49,11 @@ void Usage() {
            " * `--c-server SERVER_PATH`. If present, this flag instructs `fidlc` to output\n"
            "   the simple C server implementation at the given path.\n"
            "\n"
+           " * `--c-coding CODING_PATH`. If present, this flag instructs `fidlc` to output\n"
+           "   a C header at the given path with encode, decode and validate functions\n"
+           "   specialized to each message. Messages without handles or out-of-line data\n"
+           "   are checked in place; all others are handed to the coding tables.\n"
+           "\n"
            " * `--tables TABLES_PATH`. If present, this flag instructs `fidlc` to output\n"
            "   coding tables at the given path. The coding tables are required to encode and\n"
            "   decode messages from the C and C++ bindings.\n"
@@ -222,6 +228,7 @@ enum struct Behavior {
     kCHeader,
     kCClient,
     kCServer,
+    kCCoding,
     kTables,
     kJSON,
 };
@@ -301,6 +308,8 @@ int main(int argc, char* argv[]) {
             outputs.emplace(Behavior::kCClient, Open(args->Claim(), std::ios::out));
         } else if (behavior_argument == "--c-server") {
             outputs.emplace(Behavior::kCServer, Open(args->Claim(), std::ios::out));
+        } else if (behavior_argument == "--c-coding") {
+            outputs.emplace(Behavior::kCCoding, Open(args->Claim(), std::ios::out));
         } else if (behavior_argument == "--tables") {
             outputs.emplace(Behavior::kTables, Open(args->Claim(), std::ios::out));
         } else if (behavior_argument == "--json") {
@@ -405,6 +414,11 @@ int compile(fidl::ErrorReporter* error_reporter,
             Write(generator.ProduceServer(), std::move(output_file));
             break;
         }
+        case Behavior::kCCoding: {
+            fidl::CGenerator generator(final_library);
+            Write(generator.ProduceCoding(), std::move(output_file));
+            break;
+        }
         case Behavior::kTables: {
             fidl::TablesGenerator generator(final_library);
             Write(generator.Produce(), std::move(output_file));
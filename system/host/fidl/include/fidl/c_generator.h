@@ -34,6 +34,7 @@ public:
     std::ostringstream ProduceHeader();
     std::ostringstream ProduceClient();
     std::ostringstream ProduceServer();
+    std::ostringstream ProduceCoding();
 
     enum class Transport {
         Channel,
@@ -160,6 +161,9 @@ private:
     void ProduceInterfaceServerDeclaration(const NamedInterface& named_interface);
     void ProduceInterfaceServerImplementation(const NamedInterface& named_interface);
 
+    void ProduceMessageCodingImplementation(const NamedMessage& named_message);
+    void ProduceInterfaceCodingImplementation(const NamedInterface& named_interface);
+
     const flat::Library* library_;
     std::ostringstream file_;
 };
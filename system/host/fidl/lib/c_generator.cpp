@@ -4,6 +4,8 @@
 
 #include "fidl/c_generator.h"
 
+#include <functional>
+
 #include "fidl/attributes.h"
 #include "fidl/names.h"
 
@@ -251,6 +253,44 @@ void EmitServerReplyDecl(std::ostream* file, StringView method_name,
     *file << ")";
 }
 
+void EmitEncodeDecl(std::ostream* file, StringView message_name) {
+    *file << "static inline zx_status_t " << message_name
+          << "Encode(void* bytes, uint32_t num_bytes, zx_handle_t* handles, uint32_t max_handles, "
+             "uint32_t* out_actual_handles, const char** out_error_msg)";
+}
+
+void EmitDecodeDecl(std::ostream* file, StringView message_name) {
+    *file << "static inline zx_status_t " << message_name
+          << "Decode(void* bytes, uint32_t num_bytes, const zx_handle_t* handles, "
+             "uint32_t num_handles, const char** out_error_msg)";
+}
+
+void EmitValidateDecl(std::ostream* file, StringView message_name) {
+    *file << "static inline zx_status_t " << message_name
+          << "Validate(const void* bytes, uint32_t num_bytes, uint32_t num_handles, "
+             "const char** out_error_msg)";
+}
+
+// Emits the checks made by the coding table walker on a message with no
+// handles or out-of-line data, assigning the walker's message for the first
+// which fails to error_msg. The checks continue a chain of "if" statements
+// begun by the caller when |continue_chain| is set.
+void EmitFlatMessageChecks(std::ostream* file, bool continue_chain, uint32_t size,
+                           bool check_handles) {
+    *file << kIndent << (continue_chain ? "} else if" : "if") << " (bytes == NULL) {\n";
+    *file << kIndent << kIndent << "error_msg = \"Cannot decode null bytes\";\n";
+    *file << kIndent << "} else if (num_bytes < " << size << "u) {\n";
+    *file << kIndent << kIndent << "error_msg = \"Message size is smaller than expected\";\n";
+    *file << kIndent << "} else if (num_bytes != " << size << "u) {\n";
+    *file << kIndent << kIndent << "error_msg = \"message did not decode all provided bytes\";\n";
+    if (check_handles) {
+        *file << kIndent << "} else if (num_handles != 0u) {\n";
+        *file << kIndent << kIndent
+              << "error_msg = \"message did not contain the specified number of handles\";\n";
+    }
+    *file << kIndent << "}\n";
+}
+
 bool IsStoredOutOfLine(const CGenerator::Member& member) {
     if (member.kind == flat::Type::Kind::kVector ||
         member.kind == flat::Type::Kind::kString)
@@ -491,6 +531,552 @@ void ArrayCountsAndElementTypeName(const flat::Library* library, const flat::Typ
     }
 }
 
+// Returns true if |type| holds a union inline, whose tag the coding tables
+// check even when the type has no handles or out-of-line data.
+bool ContainsInlineUnion(const flat::Library* library, const flat::Type* type) {
+    switch (type->kind) {
+    case flat::Type::Kind::kArray: {
+        auto array_type = static_cast<const flat::ArrayType*>(type);
+        return ContainsInlineUnion(library, array_type->element_type.get());
+    }
+    case flat::Type::Kind::kIdentifier: {
+        auto identifier_type = static_cast<const flat::IdentifierType*>(type);
+        if (identifier_type->nullability == types::Nullability::kNullable)
+            return false;
+        auto named_decl = library->LookupDeclByName(identifier_type->name);
+        assert(named_decl && "library must contain declaration");
+        switch (named_decl->kind) {
+        case flat::Decl::Kind::kUnion:
+            return true;
+        case flat::Decl::Kind::kStruct: {
+            auto struct_decl = static_cast<const flat::Struct*>(named_decl);
+            for (const auto& member : struct_decl->members) {
+                if (ContainsInlineUnion(library, member.type.get()))
+                    return true;
+            }
+            return false;
+        }
+        default:
+            return false;
+        }
+    }
+    default:
+        return false;
+    }
+}
+
+// The deepest nesting of types the specialized coding functions unroll.
+// This keeps them well within the FIDL_RECURSION_DEPTH frames of the coding
+// table walker, which rejects messages nested more deeply, and stops the
+// unrolling of recursive types.
+constexpr uint32_t kMaxUnrolledCodingDepth = 16u;
+
+// Returns true if a message of |type| needs more than its size checked by
+// the coding tables, i.e. holds handles, out-of-line data, or unions.
+bool NeedsCoding(const flat::Library* library, const flat::Type* type) {
+    switch (type->kind) {
+    case flat::Type::Kind::kPrimitive:
+        return false;
+    case flat::Type::Kind::kArray: {
+        auto array_type = static_cast<const flat::ArrayType*>(type);
+        return NeedsCoding(library, array_type->element_type.get());
+    }
+    case flat::Type::Kind::kIdentifier: {
+        auto identifier_type = static_cast<const flat::IdentifierType*>(type);
+        auto named_decl = library->LookupDeclByName(identifier_type->name);
+        assert(named_decl && "library must contain declaration");
+        if (named_decl->kind == flat::Decl::Kind::kEnum)
+            return false;
+        if (named_decl->kind == flat::Decl::Kind::kStruct &&
+            identifier_type->nullability != types::Nullability::kNullable) {
+            auto struct_decl = static_cast<const flat::Struct*>(named_decl);
+            for (const auto& member : struct_decl->members) {
+                if (NeedsCoding(library, member.type.get()))
+                    return true;
+            }
+            return false;
+        }
+        return true;
+    }
+    default:
+        return true;
+    }
+}
+
+// Returns true if the specialized coding functions can unroll |type|,
+// found |depth| types deep in a message. Tables, recursive types, and
+// types nested too deeply are left to the coding tables.
+bool CanUnrollCoding(const flat::Library* library, const flat::Type* type, uint32_t depth) {
+    if (depth > kMaxUnrolledCodingDepth)
+        return false;
+    switch (type->kind) {
+    case flat::Type::Kind::kArray: {
+        auto array_type = static_cast<const flat::ArrayType*>(type);
+        return CanUnrollCoding(library, array_type->element_type.get(), depth + 1);
+    }
+    case flat::Type::Kind::kVector: {
+        auto vector_type = static_cast<const flat::VectorType*>(type);
+        return CanUnrollCoding(library, vector_type->element_type.get(), depth + 1);
+    }
+    case flat::Type::Kind::kIdentifier: {
+        auto identifier_type = static_cast<const flat::IdentifierType*>(type);
+        auto named_decl = library->LookupDeclByName(identifier_type->name);
+        assert(named_decl && "library must contain declaration");
+        switch (named_decl->kind) {
+        case flat::Decl::Kind::kStruct: {
+            auto struct_decl = static_cast<const flat::Struct*>(named_decl);
+            if (struct_decl->recursive)
+                return false;
+            for (const auto& member : struct_decl->members) {
+                if (!CanUnrollCoding(library, member.type.get(), depth + 1))
+                    return false;
+            }
+            return true;
+        }
+        case flat::Decl::Kind::kUnion: {
+            auto union_decl = static_cast<const flat::Union*>(named_decl);
+            if (union_decl->recursive)
+                return false;
+            for (const auto& member : union_decl->members) {
+                if (!CanUnrollCoding(library, member.type.get(), depth + 1))
+                    return false;
+            }
+            return true;
+        }
+        case flat::Decl::Kind::kTable:
+            return false;
+        default:
+            return true;
+        }
+    }
+    default:
+        return true;
+    }
+}
+
+// Emits the body of a coding function specialized to one message. It makes
+// the same checks and changes to the message as the coding table walker
+// (see buffer_walker.h in the fidl library), in the same order, and reports
+// the same errors. Each type is unrolled in place, with loops over the
+// elements of arrays and vectors.
+//
+// Like the table walker, encoding carries on after an error so that it
+// reaches every handle of the message. The handles it reaches afterwards are
+// closed rather than moved to |handles|.
+class CodingFunctionEmitter {
+public:
+    enum class Mode {
+        kEncode,
+        kDecode,
+        kValidate,
+    };
+
+    CodingFunctionEmitter(const flat::Library* library, std::ostream* file, Mode mode)
+        : library_(library), file_(file), mode_(mode) {}
+
+    void EmitBody(const std::vector<flat::Struct::Member>& parameters, uint32_t size) {
+        Line(Const() + "uint8_t* const _bytes = (" + Const() + "uint8_t*)bytes;");
+        Line("uint32_t _next = " + Unsigned((size + 7u) & ~7u) + ";");
+        Line("uint32_t _handle_idx = 0u;");
+        Line("const char* error_msg = NULL;");
+        if (mode_ != Mode::kValidate) {
+            const char* handle_count = mode_ == Mode::kEncode ? "max_handles" : "num_handles";
+            EarlyCheck(std::string("handles == NULL && ") + handle_count + " != 0u",
+                       "Cannot provide non-zero handle count and null handle pointer");
+        }
+        if (mode_ == Mode::kEncode)
+            EarlyCheck("out_actual_handles == NULL", "Cannot encode with null out_actual_handles");
+        EarlyCheck("bytes == NULL", "Cannot decode null bytes");
+        EarlyCheck("num_bytes < " + Unsigned(size), "Message size is smaller than expected");
+
+        for (const auto& parameter : parameters) {
+            if (NeedsCoding(library_, parameter.type.get()))
+                EmitType(parameter.type.get(), "_bytes + " + Unsigned(parameter.fieldshape.Offset()));
+        }
+
+        Line("if (_next != num_bytes) {");
+        Indented([&] { Fail("message did not decode all provided bytes"); });
+        Line("}");
+        if (mode_ == Mode::kEncode) {
+            Line("if (error_msg != NULL)");
+            Indented([&] { Line("goto fail;"); });
+            Line("*out_actual_handles = _handle_idx;");
+        } else {
+            Line("if (_handle_idx != num_handles) {");
+            Indented([&] { Fail("message did not contain the specified number of handles"); });
+            Line("}");
+        }
+        Line("return ZX_OK;");
+        *file_ << "fail:\n";
+        Line("if (out_error_msg != NULL)");
+        Indented([&] { Line("*out_error_msg = error_msg;"); });
+        if (mode_ != Mode::kValidate) {
+            Line("if (handles != NULL)");
+            Indented([&] {
+                Line(std::string("zx_handle_close_many(handles, ") +
+                     (mode_ == Mode::kEncode ? "max_handles" : "num_handles") + ");");
+            });
+        }
+        Line("return ZX_ERR_INVALID_ARGS;");
+    }
+
+private:
+    void EmitType(const flat::Type* type, const std::string& at) {
+        switch (type->kind) {
+        case flat::Type::Kind::kPrimitive:
+            break;
+        case flat::Type::Kind::kArray: {
+            auto array_type = static_cast<const flat::ArrayType*>(type);
+            const flat::Type* element_type = array_type->element_type.get();
+            if (!NeedsCoding(library_, element_type))
+                break;
+            auto element_count = static_cast<const flat::Size&>(array_type->element_count->Value());
+            std::string i = Name("_i");
+            Line("for (uint32_t " + i + " = 0u; " + i + " < " + Unsigned(element_count.value) +
+                 "; " + i + "++) {");
+            Indented([&] {
+                EmitType(element_type, "(" + at + ") + " + i + " * " + Unsigned(element_type->size));
+            });
+            Line("}");
+            break;
+        }
+        case flat::Type::Kind::kVector:
+            EmitVector(static_cast<const flat::VectorType*>(type), at);
+            break;
+        case flat::Type::Kind::kString:
+            EmitString(static_cast<const flat::StringType*>(type), at);
+            break;
+        case flat::Type::Kind::kHandle:
+        case flat::Type::Kind::kRequestHandle:
+            EmitHandle(type->nullability, at);
+            break;
+        case flat::Type::Kind::kIdentifier: {
+            auto identifier_type = static_cast<const flat::IdentifierType*>(type);
+            auto named_decl = library_->LookupDeclByName(identifier_type->name);
+            assert(named_decl && "library must contain declaration");
+            bool nullable = identifier_type->nullability == types::Nullability::kNullable;
+            switch (named_decl->kind) {
+            case flat::Decl::Kind::kStruct: {
+                auto struct_decl = static_cast<const flat::Struct*>(named_decl);
+                if (!nullable) {
+                    EmitStruct(*struct_decl, at);
+                    break;
+                }
+                std::function<void(const std::string&)> emit_object;
+                for (const auto& member : struct_decl->members) {
+                    if (NeedsCoding(library_, member.type.get())) {
+                        emit_object = [&](const std::string& object) {
+                            EmitStruct(*struct_decl, object);
+                        };
+                    }
+                }
+                EmitPointer(at, struct_decl->typeshape.Size(), "Tried to decode a bad struct pointer",
+                            "message wanted to store too large of a nullable struct", emit_object);
+                break;
+            }
+            case flat::Decl::Kind::kUnion: {
+                auto union_decl = static_cast<const flat::Union*>(named_decl);
+                if (!nullable) {
+                    EmitUnion(*union_decl, at);
+                    break;
+                }
+                EmitPointer(at, union_decl->typeshape.Size(), "Tried to decode a bad union pointer",
+                            "message wanted to store too large of a nullable union",
+                            [&](const std::string& object) { EmitUnion(*union_decl, object); });
+                break;
+            }
+            case flat::Decl::Kind::kInterface:
+                EmitHandle(identifier_type->nullability, at);
+                break;
+            case flat::Decl::Kind::kEnum:
+                break;
+            default:
+                assert(false && "type cannot be unrolled");
+                break;
+            }
+            break;
+        }
+        }
+    }
+
+    void EmitStruct(const flat::Struct& struct_decl, const std::string& at) {
+        for (const auto& member : struct_decl.members) {
+            if (NeedsCoding(library_, member.type.get()))
+                EmitType(member.type.get(), "(" + at + ") + " + Unsigned(member.fieldshape.Offset()));
+        }
+    }
+
+    void EmitUnion(const flat::Union& union_decl, const std::string& at) {
+        std::string tag = Name("_tag");
+        Line("{");
+        Indented([&] {
+            Line("const fidl_union_tag_t " + tag + " = *(const fidl_union_tag_t*)(" + at + ");");
+            Line("if (" + tag + " >= " + Unsigned(static_cast<uint32_t>(union_decl.members.size())) + ") {");
+            Indented([&] { Fail("Tried to decode a bad union discriminant"); });
+            Line("}");
+            bool any_coded = false;
+            for (const auto& member : union_decl.members) {
+                if (NeedsCoding(library_, member.type.get()))
+                    any_coded = true;
+            }
+            if (!any_coded)
+                return;
+            Line("switch (" + tag + ") {");
+            uint32_t index = 0u;
+            for (const auto& member : union_decl.members) {
+                if (NeedsCoding(library_, member.type.get())) {
+                    Line("case " + Unsigned(index) + ":");
+                    Indented([&] {
+                        EmitType(member.type.get(),
+                                 "(" + at + ") + " + Unsigned(union_decl.membershape.Offset()));
+                        Line("break;");
+                    });
+                }
+                ++index;
+            }
+            Line("}");
+        });
+        Line("}");
+    }
+
+    void EmitHandle(types::Nullability nullability, const std::string& at) {
+        std::string h = Name("_h");
+        Line("{");
+        Indented([&] {
+            Line(Const() + "zx_handle_t* " + h + " = (" + Const() + "zx_handle_t*)(" + at + ");");
+            Line("if (*" + h + " == FIDL_HANDLE_ABSENT) {");
+            Indented([&] {
+                if (nullability == types::Nullability::kNullable)
+                    Line("// A nullable handle may be absent.");
+                else
+                    Fail("message tried to decode a non-present handle");
+            });
+            switch (mode_) {
+            case Mode::kEncode:
+                Line("} else if (error_msg != NULL) {");
+                Indented([&] { Line("zx_handle_close(*" + h + ");"); });
+                Line("} else if (_handle_idx == max_handles) {");
+                Indented([&] {
+                    Line("zx_handle_close(*" + h + ");");
+                    Fail("message decoded too many handles");
+                });
+                Line("} else {");
+                Indented([&] {
+                    Line("handles[_handle_idx++] = *" + h + ";");
+                    Line("*" + h + " = FIDL_HANDLE_PRESENT;");
+                });
+                break;
+            case Mode::kDecode:
+            case Mode::kValidate:
+                Line("} else if (*" + h + " != FIDL_HANDLE_PRESENT) {");
+                Indented([&] { Fail("message tried to decode a garbage handle"); });
+                Line("} else if (_handle_idx == num_handles) {");
+                Indented([&] { Fail("message decoded too many handles"); });
+                Line("} else {");
+                Indented([&] {
+                    if (mode_ == Mode::kDecode)
+                        Line("*" + h + " = handles[_handle_idx++];");
+                    else
+                        Line("_handle_idx++;");
+                });
+                break;
+            }
+            Line("}");
+        });
+        Line("}");
+    }
+
+    void EmitString(const flat::StringType* string_type, const std::string& at) {
+        auto max_size = static_cast<const flat::Size&>(string_type->max_size->Value());
+        std::string s = Name("_s");
+        Line("{");
+        Indented([&] {
+            Line(Const() + "fidl_string_t* " + s + " = (" + Const() + "fidl_string_t*)(" + at + ");");
+            EmitAbsentCheck(s + "->data", s + "->size", string_type->nullability,
+                            "message tried to decode an absent non-nullable string",
+                            "message tried to decode an absent string of non-zero length",
+                            "message tried to decode a string that is neither present nor absent");
+            Line("} else if (" + s + "->size > " + Unsigned(max_size.value) + ") {");
+            Indented([&] { Fail("message tried to decode too large of a bounded string"); });
+            Line("} else {");
+            Indented([&] {
+                EmitClaim(s + "->data", "char*", s + "->size", "decoding a string overflowed buffer",
+                          nullptr);
+            });
+            Line("}");
+        });
+        Line("}");
+    }
+
+    void EmitVector(const flat::VectorType* vector_type, const std::string& at) {
+        auto max_count = static_cast<const flat::Size&>(vector_type->element_count->Value());
+        const flat::Type* element_type = vector_type->element_type.get();
+        uint32_t element_size = element_type->size;
+        std::string v = Name("_v");
+        Line("{");
+        Indented([&] {
+            Line(Const() + "fidl_vector_t* " + v + " = (" + Const() + "fidl_vector_t*)(" + at + ");");
+            EmitAbsentCheck(v + "->data", v + "->count", vector_type->nullability,
+                            "message tried to decode an absent non-nullable vector",
+                            "message tried to decode an absent vector of non-zero elements",
+                            "message tried to decode a non-present vector");
+            Line("} else if (" + v + "->count > " + Unsigned(max_count.value) + ") {");
+            Indented([&] { Fail("message tried to decode too large of a bounded vector"); });
+            if (static_cast<uint64_t>(max_count.value) * element_size >
+                std::numeric_limits<uint32_t>::max()) {
+                Line("} else if (" + v + "->count * " + Unsigned(element_size) + " > UINT32_MAX) {");
+                Indented([&] { Fail("integer overflow calculating vector size"); });
+            }
+            Line("} else {");
+            Indented([&] {
+                std::function<void(const std::string&)> elements;
+                if (NeedsCoding(library_, element_type)) {
+                    elements = [&](const std::string& data) {
+                        std::string i = Name("_i");
+                        Line("for (uint64_t " + i + " = 0u; " + i + " < " + v + "->count; " + i +
+                             "++) {");
+                        Indented([&] {
+                            EmitType(element_type, data + " + " + i + " * " + Unsigned(element_size));
+                        });
+                        Line("}");
+                    };
+                }
+                EmitClaim(v + "->data", "void*", v + "->count * " + Unsigned(element_size),
+                          "message wanted to store too large of a vector", elements);
+            });
+            Line("}");
+        });
+        Line("}");
+    }
+
+    // Emits the checks on a pointer to a nullable struct or union, whose
+    // |size| bytes are then walked by |emit_object|.
+    void EmitPointer(const std::string& at, uint32_t size, const char* bad_pointer,
+                     const char* too_large,
+                     const std::function<void(const std::string&)>& emit_object) {
+        std::string p = Name("_p");
+        Line("{");
+        Indented([&] {
+            const char* pointer_type = mode_ == Mode::kValidate ? "void* const*" : "void**";
+            Line(std::string(pointer_type) + " " + p + " = (" + pointer_type + ")(" + at + ");");
+            if (mode_ == Mode::kEncode) {
+                Line("if (*" + p + " != NULL) {");
+            } else {
+                Line("if ((uintptr_t)*" + p + " == FIDL_ALLOC_ABSENT) {");
+                Indented([&] { Line("// A nullable pointer may be absent."); });
+                Line("} else if ((uintptr_t)*" + p + " != FIDL_ALLOC_PRESENT) {");
+                Indented([&] { Fail(bad_pointer); });
+                Line("} else {");
+            }
+            Indented([&] { EmitClaim("*" + p, "void*", Unsigned(size), too_large, emit_object); });
+            Line("}");
+        });
+        Line("}");
+    }
+
+    // Opens the chain of checks on a string or vector, handling the absent
+    // and invalid states of its |data| pointer. The caller continues the
+    // chain with the present state.
+    void EmitAbsentCheck(const std::string& data, const std::string& count,
+                         types::Nullability nullability, const char* absent_non_nullable,
+                         const char* absent_non_zero, const char* invalid) {
+        if (mode_ == Mode::kEncode)
+            Line("if (" + data + " == NULL) {");
+        else
+            Line("if ((uintptr_t)" + data + " == FIDL_ALLOC_ABSENT) {");
+        Indented([&] {
+            if (nullability != types::Nullability::kNullable) {
+                Fail(absent_non_nullable);
+                return;
+            }
+            Line("if (" + count + " != 0u) {");
+            Indented([&] { Fail(absent_non_zero); });
+            Line("}");
+        });
+        if (mode_ != Mode::kEncode) {
+            Line("} else if ((uintptr_t)" + data + " != FIDL_ALLOC_PRESENT) {");
+            Indented([&] { Fail(invalid); });
+        }
+    }
+
+    // Emits a claim of |size| bytes of out-of-line storage for the object
+    // |pointer| points at, and updates |pointer| to its encoded or decoded
+    // form. The object itself is then walked by |emit_object|, if set.
+    void EmitClaim(const std::string& pointer, const char* pointer_type, const std::string& size,
+                   const char* too_large,
+                   const std::function<void(const std::string&)>& emit_object) {
+        std::string end = Name("_end");
+        Line("uint64_t " + end + " = FIDL_ALIGN((uint64_t)_next + " + size + ");");
+        if (mode_ == Mode::kEncode)
+            Line("if ((uint8_t*)" + pointer + " != _bytes + _next || " + end + " > num_bytes) {");
+        else
+            Line("if (" + end + " > num_bytes) {");
+        Indented([&] { Fail(too_large); });
+        Line("} else {");
+        Indented([&] {
+            std::string object = "_bytes + _next";
+            if (emit_object) {
+                object = Name("_o");
+                Line(Const() + "uint8_t* " + object + " = _bytes + _next;");
+            }
+            if (mode_ == Mode::kEncode)
+                Line(pointer + " = (" + pointer_type + ")FIDL_ALLOC_PRESENT;");
+            else if (mode_ == Mode::kDecode)
+                Line(pointer + " = (" + pointer_type + ")(" + object + ");");
+            Line("_next = (uint32_t)" + end + ";");
+            if (emit_object)
+                emit_object(object);
+        });
+        Line("}");
+    }
+
+    void EarlyCheck(const std::string& condition, const char* error) {
+        Line("if (" + condition + ") {");
+        Indented([&] {
+            Line("error_msg = \"" + std::string(error) + "\";");
+            Line("goto fail;");
+        });
+        Line("}");
+    }
+
+    // Records |error|. Decoding and validating stop at the first error, and
+    // encoding carries on.
+    void Fail(const char* error) {
+        if (mode_ == Mode::kEncode) {
+            Line("if (error_msg == NULL)");
+            Indented([&] { Line("error_msg = \"" + std::string(error) + "\";"); });
+        } else {
+            Line("error_msg = \"" + std::string(error) + "\";");
+            Line("goto fail;");
+        }
+    }
+
+    std::string Const() const { return mode_ == Mode::kValidate ? "const " : ""; }
+
+    std::string Name(const char* prefix) { return prefix + std::to_string(next_name_++); }
+
+    static std::string Unsigned(uint32_t value) { return std::to_string(value) + "u"; }
+
+    void Line(const std::string& line) {
+        for (uint32_t i = 0; i < depth_; ++i)
+            *file_ << kIndent;
+        *file_ << line << "\n";
+    }
+
+    template <typename Callback>
+    void Indented(Callback callback) {
+        ++depth_;
+        callback();
+        --depth_;
+    }
+
+    const flat::Library* library_;
+    std::ostream* file_;
+    const Mode mode_;
+    uint32_t depth_ = 1u;
+    uint32_t next_name_ = 0u;
+};
+
 template <typename T>
 CGenerator::Member CreateMember(const flat::Library* library, const T& decl) {
     std::string name = NameIdentifier(decl.name);
@@ -1366,6 +1952,106 @@ void CGenerator::ProduceInterfaceServerImplementation(const NamedInterface& name
     }
 }
 
+void CGenerator::ProduceMessageCodingImplementation(const NamedMessage& named_message) {
+    // Messages which contain no handles or out-of-line data are already in
+    // their wire format, and only the checks the coding tables would make on
+    // their size are needed. The tables also check union tags, so messages
+    // holding a union are not flat. The coding of all other messages is
+    // unrolled, unless they hold types which are left to the coding tables.
+    bool flat = named_message.typeshape.MaxHandles() == 0u &&
+                named_message.typeshape.MaxOutOfLine() == 0u;
+    bool unrolled = true;
+    for (const auto& parameter : named_message.parameters) {
+        if (ContainsInlineUnion(library_, parameter.type.get()))
+            flat = false;
+        if (!CanUnrollCoding(library_, parameter.type.get(), 1u))
+            unrolled = false;
+    }
+    uint32_t size = named_message.typeshape.Size();
+
+    EmitEncodeDecl(&file_, named_message.c_name);
+    file_ << " {\n";
+    if (flat) {
+        file_ << kIndent << "const char* error_msg = NULL;\n";
+        file_ << kIndent << "if (handles == NULL && max_handles != 0u) {\n";
+        file_ << kIndent << kIndent
+              << "error_msg = \"Cannot provide non-zero handle count and null handle pointer\";\n";
+        file_ << kIndent << "} else if (out_actual_handles == NULL) {\n";
+        file_ << kIndent << kIndent << "error_msg = \"Cannot encode with null out_actual_handles\";\n";
+        EmitFlatMessageChecks(&file_, true, size, false);
+        file_ << kIndent << "if (error_msg != NULL) {\n";
+        file_ << kIndent << kIndent << "if (out_error_msg != NULL)\n";
+        file_ << kIndent << kIndent << kIndent << "*out_error_msg = error_msg;\n";
+        file_ << kIndent << kIndent << "if (handles != NULL)\n";
+        file_ << kIndent << kIndent << kIndent << "zx_handle_close_many(handles, max_handles);\n";
+        file_ << kIndent << kIndent << "return ZX_ERR_INVALID_ARGS;\n";
+        file_ << kIndent << "}\n";
+        file_ << kIndent << "*out_actual_handles = 0u;\n";
+        file_ << kIndent << "return ZX_OK;\n";
+    } else if (unrolled) {
+        CodingFunctionEmitter(library_, &file_, CodingFunctionEmitter::Mode::kEncode)
+            .EmitBody(named_message.parameters, size);
+    } else {
+        file_ << kIndent << "return fidl_encode(&" << named_message.coded_name
+              << ", bytes, num_bytes, handles, max_handles, out_actual_handles, out_error_msg);\n";
+    }
+    file_ << "}\n\n";
+
+    EmitDecodeDecl(&file_, named_message.c_name);
+    file_ << " {\n";
+    if (flat) {
+        file_ << kIndent << "const char* error_msg = NULL;\n";
+        file_ << kIndent << "if (handles == NULL && num_handles != 0u) {\n";
+        file_ << kIndent << kIndent
+              << "error_msg = \"Cannot provide non-zero handle count and null handle pointer\";\n";
+        EmitFlatMessageChecks(&file_, true, size, true);
+        file_ << kIndent << "if (error_msg != NULL) {\n";
+        file_ << kIndent << kIndent << "if (out_error_msg != NULL)\n";
+        file_ << kIndent << kIndent << kIndent << "*out_error_msg = error_msg;\n";
+        file_ << kIndent << kIndent << "if (handles != NULL)\n";
+        file_ << kIndent << kIndent << kIndent << "zx_handle_close_many(handles, num_handles);\n";
+        file_ << kIndent << kIndent << "return ZX_ERR_INVALID_ARGS;\n";
+        file_ << kIndent << "}\n";
+        file_ << kIndent << "return ZX_OK;\n";
+    } else if (unrolled) {
+        CodingFunctionEmitter(library_, &file_, CodingFunctionEmitter::Mode::kDecode)
+            .EmitBody(named_message.parameters, size);
+    } else {
+        file_ << kIndent << "return fidl_decode(&" << named_message.coded_name
+              << ", bytes, num_bytes, handles, num_handles, out_error_msg);\n";
+    }
+    file_ << "}\n\n";
+
+    EmitValidateDecl(&file_, named_message.c_name);
+    file_ << " {\n";
+    if (flat) {
+        file_ << kIndent << "const char* error_msg = NULL;\n";
+        EmitFlatMessageChecks(&file_, false, size, true);
+        file_ << kIndent << "if (error_msg != NULL) {\n";
+        file_ << kIndent << kIndent << "if (out_error_msg != NULL)\n";
+        file_ << kIndent << kIndent << kIndent << "*out_error_msg = error_msg;\n";
+        file_ << kIndent << kIndent << "return ZX_ERR_INVALID_ARGS;\n";
+        file_ << kIndent << "}\n";
+        file_ << kIndent << "return ZX_OK;\n";
+    } else if (unrolled) {
+        CodingFunctionEmitter(library_, &file_, CodingFunctionEmitter::Mode::kValidate)
+            .EmitBody(named_message.parameters, size);
+    } else {
+        file_ << kIndent << "return fidl_validate(&" << named_message.coded_name
+              << ", bytes, num_bytes, num_handles, out_error_msg);\n";
+    }
+    file_ << "}\n\n";
+}
+
+void CGenerator::ProduceInterfaceCodingImplementation(const NamedInterface& named_interface) {
+    for (const auto& method_info : named_interface.methods) {
+        if (method_info.request)
+            ProduceMessageCodingImplementation(*method_info.request);
+        if (method_info.response)
+            ProduceMessageCodingImplementation(*method_info.response);
+    }
+}
+
 std::ostringstream CGenerator::ProduceHeader() {
     GeneratePrologues();
 
@@ -1606,4 +2292,44 @@ std::ostringstream CGenerator::ProduceServer() {
     return std::move(file_);
 }
 
+std::ostringstream CGenerator::ProduceCoding() {
+    EmitFileComment(&file_);
+    EmitHeaderGuard(&file_);
+    EmitBlank(&file_);
+    EmitIncludeHeader(&file_, "<lib/fidl/coding.h>");
+    EmitIncludeHeader(&file_, "<zircon/syscalls.h>");
+    EmitIncludeHeader(&file_, "<" + NameLibraryCHeader(library_->name()) + ">");
+    EmitBlank(&file_);
+    EmitBeginExternC(&file_);
+    EmitBlank(&file_);
+
+    std::map<const flat::Decl*, NamedInterface> named_interfaces =
+        NameInterfaces(library_->interface_declarations_);
+
+    for (const auto* decl : library_->declaration_order_) {
+        switch (decl->kind) {
+        case flat::Decl::Kind::kConst:
+        case flat::Decl::Kind::kEnum:
+        case flat::Decl::Kind::kStruct:
+        case flat::Decl::Kind::kTable:
+        case flat::Decl::Kind::kUnion:
+            // Only messages are encoded and decoded on their own.
+            break;
+        case flat::Decl::Kind::kInterface: {
+            auto iter = named_interfaces.find(decl);
+            if (iter != named_interfaces.end()) {
+                ProduceInterfaceCodingImplementation(iter->second);
+            }
+            break;
+        }
+        default:
+            abort();
+        }
+    }
+
+    EmitEndExternC(&file_);
+
+    return std::move(file_);
+}
+
 } // namespace fidl
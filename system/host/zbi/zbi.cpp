@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cerrno>
 #include <climits>
@@ -26,6 +27,7 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
+#include <thread>
 #include <unistd.h>
 #include <utility>
 #include <vector>
@@ -415,7 +417,6 @@ constexpr const LZ4F_compressOptions_t kCompressOpt = {1, {}};
 class Compressor {
 public:
     DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(Compressor);
-    Compressor() = default;
 
 #define LZ4F_CALL(func, ...)                                               \
     [&]() {                                                                \
@@ -427,17 +428,14 @@ public:
         return result;                                                     \
     }()
 
-    void Init(OutputStream* out, const zbi_header_t& header) {
-        header_ = header;
+    // By default each payload is a single LZ4 frame.  With multiple
+    // frames, each holds kFrameSize bytes of the payload (the last may
+    // hold fewer), so a decompressor can expand them in parallel.
+    Compressor(const zbi_header_t& header, bool multiple_frames)
+        : header_(header), multiple_frames_(multiple_frames) {
         assert(header_.flags & ZBI_FLAG_STORAGE_COMPRESSED);
         assert(header_.flags & ZBI_FLAG_CRC32);
 
-        // Write a place-holder for the header, which we will go back
-        // and fill in once we know the payload length and CRC.
-        header_pos_ = out->PlaceHeader();
-
-        prefs_.frameInfo.contentSize = header_.length;
-
         prefs_.frameInfo.blockSizeID = LZ4F_max64KB;
         prefs_.frameInfo.blockMode = LZ4F_blockIndependent;
 
@@ -446,107 +444,210 @@ public:
         // 4 to 16 is not worth the extra time needed during compression.
         prefs_.compressionLevel = 4;
 
-        LZ4F_CALL(LZ4F_createCompressionContext, &ctx_, LZ4F_VERSION);
-
         // Record the original uncompressed size in header_.extra.
         // WriteBuffer will accumulate the compressed size in header_.length.
         header_.extra = header_.length;
         header_.length = 0;
-
-        // This might start writing compression format headers before it
-        // receives any data.
-        auto buffer = GetBuffer(kLZ4FMaxHeaderFrameSize);
-        size_t size = LZ4F_CALL(LZ4F_compressBegin, ctx_,
-                                buffer.data.get(), buffer.size, &prefs_);
-        assert(size <= buffer.size);
-        WriteBuffer(out, std::move(buffer), size);
-    }
-
-    ~Compressor() {
-        LZ4F_CALL(LZ4F_freeCompressionContext, ctx_);
     }
 
     // NOTE: Input buffer may be referenced for the life of the Compressor!
-    void Write(OutputStream* out, const iovec& input) {
-        auto buffer = GetBuffer(LZ4F_compressBound(input.iov_len, &prefs_));
-        size_t actual_size = LZ4F_CALL(LZ4F_compressUpdate,
-                                       ctx_, buffer.data.get(), buffer.size,
-                                       input.iov_base, input.iov_len,
-                                       &kCompressOpt);
-        WriteBuffer(out, std::move(buffer), actual_size);
+    void Write(const iovec& input) {
+        input_.push_back(input);
+    }
+
+    // Compress the payloads of all the compressors at once.  Each block is
+    // compressed independently of the others, so the blocks of all the
+    // payloads are spread across one thread per CPU.  The result is just
+    // what compressing each payload serially would produce.
+    static void CompressAll(const std::vector<Compressor*>& compressors) {
+        std::vector<Block*> blocks;
+        for (Compressor* compressor : compressors) {
+            compressor->blocks_ = compressor->SplitBlocks();
+            for (Block& block : compressor->blocks_) {
+                block.prefs = &compressor->prefs_;
+                blocks.push_back(&block);
+            }
+        }
+        CompressBlocks(blocks);
     }
 
+    // Write out the header and the payload compressed by CompressAll.
     uint32_t Finish(OutputStream* out) {
-        // Write the closing chunk from the compressor.
-        auto buffer = GetBuffer(LZ4F_compressBound(0, &prefs_));
-        size_t actual_size = LZ4F_CALL(LZ4F_compressEnd,
-                                       ctx_, buffer.data.get(), buffer.size,
-                                       &kCompressOpt);
+        // Write a place-holder for the header, which we will go back
+        // and fill in once we know the payload length and CRC.
+        const uint32_t header_pos = out->PlaceHeader();
 
-        WriteBuffer(out, std::move(buffer), actual_size);
+        std::vector<Block>& blocks = blocks_;
+        const size_t blocks_per_frame =
+            multiple_frames_ ? kFrameSize / kBlockSize : blocks.size();
+        size_t block = 0;
+        size_t remaining = header_.extra;
+        do {
+            const size_t frame_end =
+                std::min(blocks.size(), block + blocks_per_frame);
+            const size_t frame_size =
+                multiple_frames_ ? std::min(remaining, kFrameSize) : remaining;
+            WriteFrameHeader(out, frame_size);
+            for (; block < frame_end; ++block) {
+                WriteBuffer(out, std::move(blocks[block].compressed),
+                            blocks[block].compressed_size);
+            }
+            WriteFrameEnd(out);
+            remaining -= frame_size;
+        } while (block < blocks.size());
+        assert(remaining == 0);
 
         // Complete the checksum.
         crc_.FinalizeHeader(&header_);
 
         // Write the header back where its place was held.
-        out->PatchHeader(header_, header_pos_);
+        out->PatchHeader(header_, header_pos);
         return header_.length;
     }
 
 private:
-    struct Buffer {
-        // Move-only type: after moving, data is nullptr and size is 0.
-        Buffer() = default;
-        Buffer(std::unique_ptr<std::byte[]> buffer, size_t max_size)
-            : data(std::move(buffer)), size(max_size) {
-        }
-        Buffer(Buffer&& other) {
-            *this = std::move(other);
-        }
-        Buffer& operator=(Buffer&& other) {
-            data = std::move(other.data);
-            size = other.size;
-            other.size = 0;
-            return *this;
-        }
-        std::unique_ptr<std::byte[]> data;
+    static constexpr const size_t kBlockSize = 64 << 10;
+    static constexpr const size_t kFrameSize = 1 << 20;
+    static constexpr const uint32_t kFrameEndMark = 0;
+
+    struct Block {
+        // The uncompressed data, which is copied to |copy| when it spans
+        // input buffers.
+        const std::byte* data = nullptr;
         size_t size = 0;
-    } unused_buffer_;
+        std::unique_ptr<std::byte[]> copy;
+
+        // The preferences of the Compressor the block belongs to.
+        const LZ4F_preferences_t* prefs = nullptr;
+
+        // The block's header and compressed data.
+        std::unique_ptr<std::byte[]> compressed;
+        size_t compressed_size = 0;
+    };
+
     zbi_header_t header_;
     Checksummer crc_;
-    LZ4F_compressionContext_t ctx_;
     LZ4F_preferences_t prefs_{};
-    uint32_t header_pos_ = 0;
-    // IOV_MAX buffers might be live at once.
-    static constexpr const size_t kMinBufferSize = (128 << 20) / IOV_MAX;
-
-    Buffer GetBuffer(size_t max_size) {
-        if (unused_buffer_.size >= max_size) {
-            // We have an old buffer that will do fine.
-            return std::move(unused_buffer_);
-        } else {
-            // Get a new buffer.
-            max_size = std::max(max_size, kMinBufferSize);
-            return {std::make_unique<std::byte[]>(max_size), max_size};
+    bool multiple_frames_;
+    std::vector<iovec> input_;
+    std::vector<Block> blocks_;
+
+    // Cut the input into the blocks that LZ4F would compress.
+    std::vector<Block> SplitBlocks() {
+        std::vector<Block> blocks;
+        Block block;
+        for (const auto& iov : input_) {
+            auto data = static_cast<const std::byte*>(iov.iov_base);
+            size_t size = iov.iov_len;
+            while (size > 0) {
+                size_t chunk = std::min(size, kBlockSize - block.size);
+                if (block.size == 0 && chunk == kBlockSize) {
+                    // The whole block lies in this buffer.
+                    block.data = data;
+                    block.size = chunk;
+                } else {
+                    if (!block.copy) {
+                        block.copy = std::make_unique<std::byte[]>(kBlockSize);
+                        block.data = block.copy.get();
+                    }
+                    memcpy(block.copy.get() + block.size, data, chunk);
+                    block.size += chunk;
+                }
+                data += chunk;
+                size -= chunk;
+                if (block.size == kBlockSize) {
+                    blocks.push_back(std::move(block));
+                    block = Block();
+                }
+            }
+        }
+        if (block.size > 0) {
+            blocks.push_back(std::move(block));
+        }
+        return blocks;
+    }
+
+    static void CompressBlocks(const std::vector<Block*>& blocks) {
+        std::atomic<size_t> next_block{0};
+        auto compress = [&]() {
+            // Each block is compressed as the only block of a frame of its
+            // own; the frame's header and end mark are dropped.
+            LZ4F_compressionContext_t ctx;
+            LZ4F_CALL(LZ4F_createCompressionContext, &ctx, LZ4F_VERSION);
+            std::vector<std::byte> buffer;
+            std::byte header[kLZ4FMaxHeaderFrameSize];
+            size_t i;
+            while ((i = next_block++) < blocks.size()) {
+                Block& block = *blocks[i];
+                const size_t bound =
+                    LZ4F_compressBound(kBlockSize, block.prefs);
+                if (buffer.size() < bound) {
+                    buffer.resize(bound);
+                }
+                LZ4F_CALL(LZ4F_compressBegin, ctx,
+                          header, sizeof(header), block.prefs);
+                size_t size = LZ4F_CALL(LZ4F_compressUpdate, ctx,
+                                        buffer.data(), bound,
+                                        block.data, block.size,
+                                        &kCompressOpt);
+                size += LZ4F_CALL(LZ4F_compressEnd, ctx,
+                                  buffer.data() + size, bound - size,
+                                  &kCompressOpt);
+                assert(size >= sizeof(kFrameEndMark));
+                block.compressed_size = size - sizeof(kFrameEndMark);
+                block.compressed =
+                    std::make_unique<std::byte[]>(block.compressed_size);
+                memcpy(block.compressed.get(), buffer.data(),
+                       block.compressed_size);
+                block.copy.reset();
+            }
+            LZ4F_CALL(LZ4F_freeCompressionContext, ctx);
+        };
+
+        size_t num_threads = std::min<size_t>(
+            blocks.size(), std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::thread> threads;
+        while (threads.size() + 1 < num_threads) {
+            threads.emplace_back(compress);
+        }
+        compress();
+        for (auto& thread : threads) {
+            thread.join();
         }
     }
 
-    void WriteBuffer(OutputStream* out, Buffer buffer, size_t actual_size) {
-        if (actual_size > 0) {
-            header_.length += actual_size;
-            const iovec iov{buffer.data.get(), actual_size};
+    void WriteFrameHeader(OutputStream* out, size_t content_size) {
+        LZ4F_preferences_t prefs = prefs_;
+        prefs.frameInfo.contentSize = content_size;
+        LZ4F_compressionContext_t ctx;
+        LZ4F_CALL(LZ4F_createCompressionContext, &ctx, LZ4F_VERSION);
+        auto buffer = std::make_unique<std::byte[]>(kLZ4FMaxHeaderFrameSize);
+        size_t size = LZ4F_CALL(LZ4F_compressBegin, ctx, buffer.get(),
+                                kLZ4FMaxHeaderFrameSize, &prefs);
+        LZ4F_CALL(LZ4F_freeCompressionContext, ctx);
+        WriteBuffer(out, std::move(buffer), size);
+    }
+
+    void WriteFrameEnd(OutputStream* out) {
+        auto buffer = std::make_unique<std::byte[]>(sizeof(kFrameEndMark));
+        memcpy(buffer.get(), &kFrameEndMark, sizeof(kFrameEndMark));
+        WriteBuffer(out, std::move(buffer), sizeof(kFrameEndMark));
+    }
+
+    void WriteBuffer(OutputStream* out, std::unique_ptr<std::byte[]> buffer,
+                     size_t size) {
+        if (size > 0) {
+            header_.length += size;
+            const iovec iov{buffer.get(), size};
             crc_.Write(iov);
-            out->Write(iov, std::move(buffer.data));
-            buffer.size = 0;
-        } else {
-            // The compressor often delivers zero bytes for an input chunk.
-            // Stash the unused buffer for next time to cut down on new/delete.
-            unused_buffer_ = std::move(buffer);
+            out->Write(iov, std::move(buffer));
         }
     }
 };
 
-const size_t Compressor::kMinBufferSize;
+const size_t Compressor::kBlockSize;
+const size_t Compressor::kFrameSize;
+const uint32_t Compressor::kFrameEndMark;
 
 constexpr const LZ4F_decompressOptions_t kDecompressOpt{};
 
@@ -1323,12 +1424,13 @@ Extracted items use the file names shown below:\n\
             new BootFSInputFileGenerator(std::move(item)));
     }
 
-    void ExtractItem(FileWriter* writer, NameMatcher* matcher) {
+    void ExtractItem(FileWriter* writer, NameMatcher* matcher,
+                     bool multiple_frames) {
         std::string namestr = ExtractedFileName(writer->NextFileNumber(),
                                                 type(), false);
         auto name = namestr.c_str();
         if (matcher->Matches(name, true)) {
-            WriteZBI(writer, name, (Item* const[]){this});
+            WriteZBI(writer, name, (Item* const[]){this}, multiple_frames);
         }
     }
 
@@ -1361,7 +1463,18 @@ Extracted items use the file names shown below:\n\
 
     template <typename ItemList>
     static void WriteZBI(FileWriter* writer, const char* name,
-                         const ItemList& items) {
+                         const ItemList& items, bool multiple_frames) {
+        // Compress the payloads of all the items at once before any of
+        // them is written out.
+        std::vector<Compressor*> compressors;
+        for (const auto& item : items) {
+            if (item->compress_) {
+                compressors.push_back(
+                    item->StartCompression(multiple_frames));
+            }
+        }
+        Compressor::CompressAll(compressors);
+
         auto out = writer->RawFile(name);
 
         uint32_t header_start = out.PlaceHeader();
@@ -1400,6 +1513,7 @@ private:
     std::forward_list<FileContents> files_;
     std::forward_list<std::unique_ptr<std::byte[]>> buffers_;
     const bool compress_;
+    std::unique_ptr<Compressor> compressor_;
 
     struct ItemTypeInfo {
         uint32_t type;
@@ -1463,17 +1577,24 @@ private:
         return sizeof(header_) + header_.length;
     }
 
+    // The payload is compressed and checksummed by Compressor::CompressAll
+    // before the item is streamed.
+    Compressor* StartCompression(bool multiple_frames) {
+        assert(compress_);
+        compressor_ = std::make_unique<Compressor>(header_, multiple_frames);
+        for (const auto& iov : payload_) {
+            compressor_->Write(iov);
+        }
+        return compressor_.get();
+    }
+
     uint32_t StreamCompressed(OutputStream* out) {
-        // Compress and checksum the payload.
-        Compressor compressor;
-        compressor.Init(out, header_);
-        do {
-            // The compressor streams the header and compressed payload out.
-            compressor.Write(out, payload_.front());
-            payload_.pop_front();
-        } while (!payload_.empty());
-        // This writes the final header as well as the last of the payload.
-        return compressor.Finish(out);
+        assert(compressor_);
+        payload_.clear();
+        // This writes the final header as well as the compressed payload.
+        uint32_t wrote = compressor_->Finish(out);
+        compressor_.reset();
+        return wrote;
     }
 
     int ShowCmdline() const {
@@ -1719,7 +1840,7 @@ const char* IncompleteImage(const ItemList& items, const uint32_t image_arch) {
     return nullptr;
 }
 
-constexpr const char kOptString[] = "-B:cd:e:FxXRg:hto:p:sT:uv";
+constexpr const char kOptString[] = "-B:cd:e:FxXRg:hMto:p:sST:uv";
 constexpr const option kLongOpts[] = {
     {"complete", required_argument, nullptr, 'B'},
     {"compressed", no_argument, nullptr, 'c'},
@@ -1732,8 +1853,10 @@ constexpr const option kLongOpts[] = {
     {"groups", required_argument, nullptr, 'g'},
     {"help", no_argument, nullptr, 'h'},
     {"list", no_argument, nullptr, 't'},
+    {"multi-frame", no_argument, nullptr, 'M'},
     {"output", required_argument, nullptr, 'o'},
     {"prefix", required_argument, nullptr, 'p'},
+    {"single-frame", no_argument, nullptr, 'S'},
     {"sort", no_argument, nullptr, 's'},
     {"type", required_argument, nullptr, 'T'},
     {"uncompressed", no_argument, nullptr, 'u'},
@@ -1789,6 +1912,8 @@ Format control switches (last switch affects all output):\n\
     --complete=ARCH, -B ARCH       verify result is a complete boot image\n\
     --compressed, -c               compress BOOTFS images (default)\n\
     --uncompressed, -u             do not compress BOOTFS images\n\
+    --multi-frame, -M              compress in 1MiB frames, not one per item\n\
+    --single-frame, -S             compress each item in one frame (default)\n\
     --sort, -s                     sort BOOTFS entries by name\n\
 \n\
 In all cases there is only a single BOOTFS item (if any) written out.\n\
@@ -1830,6 +1955,7 @@ int main(int argc, char** argv) {
     bool input_manifest = true;
     uint32_t input_type = ZBI_TYPE_DISCARD;
     bool compressed = true;
+    bool multiple_frames = false;
     bool extract = false;
     bool extract_items = false;
     bool extract_raw = false;
@@ -1942,6 +2068,14 @@ int main(int argc, char** argv) {
             compressed = false;
             continue;
 
+        case 'M':
+            multiple_frames = true;
+            continue;
+
+        case 'S':
+            multiple_frames = false;
+            continue;
+
         case 's':
             sort = true;
             continue;
@@ -2177,7 +2311,8 @@ int main(int argc, char** argv) {
                 if (extract_raw) {
                     item->ExtractRaw(&writer, &name_matcher);
                 } else {
-                    item->ExtractItem(&writer, &name_matcher);
+                    item->ExtractItem(&writer, &name_matcher,
+                                      multiple_frames);
                 }
             } else if (extract && is_bootfs(item)) {
                 auto generator = Item::ReadBootFS(std::move(item));
@@ -2194,7 +2329,7 @@ int main(int argc, char** argv) {
             exit(status);
         }
     } else {
-        Item::WriteZBI(&writer, "boot.zbi", items);
+        Item::WriteZBI(&writer, "boot.zbi", items, multiple_frames);
     }
 
     name_matcher.Summary(extract ? "extracted" : "matched",
@@ -31,8 +31,13 @@
 
 namespace {
 
-int Mount(fbl::unique_fd fd, blobfs::MountOptions* options) {
-    if (!options->readonly) {
+struct Options {
+    blobfs::MountOptions mount;
+    blobfs::FsckOptions fsck;
+};
+
+int Mount(fbl::unique_fd fd, Options* options) {
+    if (!options->mount.readonly) {
         block_info_t block_info;
         zx_status_t status = static_cast<zx_status_t>(ioctl_block_get_info(fd.get(), &block_info));
         if (status < ZX_OK) {
@@ -40,7 +45,7 @@ int Mount(fbl::unique_fd fd, blobfs::MountOptions* options) {
                            fd.get(), status);
             return -1;
         }
-        options->readonly = block_info.flags & BLOCK_FLAG_READONLY;
+        options->mount.readonly = block_info.flags & BLOCK_FLAG_READONLY;
     }
 
     zx::channel root = zx::channel(zx_take_startup_handle(PA_HND(PA_USER0, 0)));
@@ -52,7 +57,7 @@ int Mount(fbl::unique_fd fd, blobfs::MountOptions* options) {
     async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
     trace::TraceProvider provider(loop.dispatcher());
     auto loop_quit = [&loop]() { loop.Quit(); };
-    if (blobfs::Mount(loop.dispatcher(), std::move(fd), *options,
+    if (blobfs::Mount(loop.dispatcher(), std::move(fd), options->mount,
                             std::move(root), std::move(loop_quit)) != ZX_OK) {
         return -1;
     }
@@ -60,7 +65,7 @@ int Mount(fbl::unique_fd fd, blobfs::MountOptions* options) {
     return ZX_OK;
 }
 
-int Mkfs(fbl::unique_fd fd, blobfs::MountOptions* options) {
+int Mkfs(fbl::unique_fd fd, Options* options) {
     uint64_t block_count;
     if (blobfs::GetBlockCount(fd.get(), &block_count)) {
         fprintf(stderr, "blobfs: cannot find end of underlying device\n");
@@ -70,16 +75,16 @@ int Mkfs(fbl::unique_fd fd, blobfs::MountOptions* options) {
     return blobfs::Mkfs(fd.get(), block_count);
 }
 
-int Fsck(fbl::unique_fd fd, blobfs::MountOptions* options) {
+int Fsck(fbl::unique_fd fd, Options* options) {
     fbl::unique_ptr<blobfs::Blobfs> blobfs;
-    if (blobfs::Initialize(std::move(fd), *options, &blobfs) != ZX_OK) {
+    if (blobfs::Initialize(std::move(fd), options->mount, &blobfs) != ZX_OK) {
         return -1;
     }
 
-    return blobfs::Fsck(std::move(blobfs));
+    return blobfs::Fsck(std::move(blobfs), options->fsck);
 }
 
-typedef int (*CommandFunction)(fbl::unique_fd fd, blobfs::MountOptions* options);
+typedef int (*CommandFunction)(fbl::unique_fd fd, Options* options);
 
 const struct {
     const char* name;
@@ -97,9 +102,11 @@ int usage() {
     fprintf(stderr,
             "usage: blobfs [ <options>* ] <command> [ <arg>* ]\n"
             "\n"
-            "options: -r|--readonly  Mount filesystem read-only\n"
-            "         -m|--metrics   Collect filesystem metrics\n"
-            "         -h|--help      Display this message\n"
+            "options: -r|--readonly       Mount filesystem read-only\n"
+            "         -m|--metrics        Collect filesystem metrics\n"
+            "         -q|--metadata-only  Check metadata only, skipping blob verification\n"
+            "         -v|--verify <count> Verify <count> blobs each minute while mounted\n"
+            "         -h|--help           Display this message\n"
             "\n"
             "On Fuchsia, blobfs takes the block device argument by handle.\n"
             "This can make 'blobfs' commands hard to invoke from command line.\n"
@@ -114,29 +121,37 @@ int usage() {
 }
 
 // Process options/commands and return open fd to device
-int ProcessArgs(int argc, char** argv, CommandFunction* func, blobfs::MountOptions* options) {
+int ProcessArgs(int argc, char** argv, CommandFunction* func, Options* options) {
     while (1) {
         static struct option opts[] = {
             {"readonly", no_argument, nullptr, 'r'},
             {"metrics", no_argument, nullptr, 'm'},
             {"journal", no_argument, nullptr, 'j'},
+            {"metadata-only", no_argument, nullptr, 'q'},
+            {"verify", required_argument, nullptr, 'v'},
             {"help", no_argument, nullptr, 'h'},
             {nullptr, 0, nullptr, 0},
         };
         int opt_index;
-        int c = getopt_long(argc, argv, "rmjh", opts, &opt_index);
+        int c = getopt_long(argc, argv, "rmjqv:h", opts, &opt_index);
         if (c < 0) {
             break;
         }
         switch (c) {
         case 'r':
-            options->readonly = true;
+            options->mount.readonly = true;
             break;
         case 'm':
-            options->metrics = true;
+            options->mount.metrics = true;
             break;
         case 'j':
-            options->journal = true;
+            options->mount.journal = true;
+            break;
+        case 'q':
+            options->fsck.verify_blobs = false;
+            break;
+        case 'v':
+            options->mount.verify_budget = static_cast<uint32_t>(strtoul(optarg, nullptr, 0));
             break;
         case 'h':
         default:
@@ -171,7 +186,7 @@ int ProcessArgs(int argc, char** argv, CommandFunction* func, blobfs::MountOptio
 
 int main(int argc, char** argv) {
     CommandFunction func = nullptr;
-    blobfs::MountOptions options;
+    Options options;
     fbl::unique_fd fd(ProcessArgs(argc, argv, &func, &options));
 
     if (!fd) {
@@ -784,7 +784,9 @@ zx_status_t FvmStreamPartitions(fbl::unique_fd partition_fd, fbl::unique_fd src_
 
     LOG("Partition space pre-allocated successfully.\n");
 
-    constexpr size_t vmo_size = 1 << 20;
+    // Write as much at once as the reader decompresses ahead of us, so that decompression of
+    // the next buffer overlaps with each write.
+    constexpr size_t vmo_size = SPARSE_READER_PIPELINE_DEPTH * LZ4_MAX_BLOCK_SIZE;
 
     fzl::VmoMapper mapping;
     zx::vmo vmo;
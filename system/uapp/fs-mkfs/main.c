@@ -36,6 +36,7 @@ int usage(void) {
             " -s|--fvm_data_slices SLICES   If block device is on top of a FVM,\n"
             "                               the filesystem will have at least SLICES slices "
             "                               allocated for data.\n");
+    fprintf(stderr, " -e|--extents                  MinFS only: map new files with extents\n");
     fprintf(stderr, " values for 'filesystem' include:\n");
     for (size_t i = 0; i < countof(FILESYSTEMS); i++) {
         fprintf(stderr, "  '%s'\n", FILESYSTEMS[i].name);
@@ -49,13 +50,14 @@ int parse_args(int argc, char** argv, mkfs_options_t* options, disk_format_t* df
         {"help", no_argument, NULL, 'h'},
         {"verbose", no_argument, NULL, 'v'},
         {"fvm_data_slices", required_argument, NULL, 's'},
+        {"extents", no_argument, NULL, 'e'},
         {0, 0, 0, 0},
     };
 
     int opt_index = -1;
     int c = -1;
 
-    while ((c = getopt_long(argc, argv, "hvs:", cmds, &opt_index)) >= 0) {
+    while ((c = getopt_long(argc, argv, "hves:", cmds, &opt_index)) >= 0) {
         switch (c) {
         case 'v':
             options->verbose = true;
@@ -67,6 +69,9 @@ int parse_args(int argc, char** argv, mkfs_options_t* options, disk_format_t* df
                 return usage();
             }
             break;
+        case 'e':
+            options->minfs_extents = true;
+            break;
         case 'h':
             return usage();
         default:
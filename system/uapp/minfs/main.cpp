@@ -29,7 +29,7 @@
 namespace {
 
 int Fsck(fbl::unique_ptr<minfs::Bcache> bc, const minfs::MountOptions& options) {
-    return Fsck(std::move(bc));
+    return Fsck(std::move(bc), options.repair);
 }
 
 int Mount(fbl::unique_ptr<minfs::Bcache> bc, const minfs::MountOptions& options) {
@@ -85,6 +85,8 @@ int usage() {
                     "    -m|--metrics                  Collect filesystem metrics\n"
                     "    -s|--fvm_data_slices SLICES   When mkfs on top of FVM,\n"
                     "                                  preallocate |SLICES| slices of data. \n"
+                    "    -e|--extents                  When mkfs, map new files with extents\n"
+                    "    -y|--repair                   When fsck, replay the journal first\n"
                     "    -h|--help                     Display this message\n"
                     "\n"
                     "On Fuchsia, MinFS takes the block device argument by handle.\n"
@@ -123,11 +125,13 @@ int main(int argc, char** argv) {
             {"journal", no_argument, nullptr, 'j'},
             {"verbose", no_argument, nullptr, 'v'},
             {"fvm_data_slices", required_argument, nullptr, 's'},
+            {"extents", no_argument, nullptr, 'e'},
+            {"repair", no_argument, nullptr, 'y'},
             {"help", no_argument, nullptr, 'h'},
             {nullptr, 0, nullptr, 0},
         };
         int opt_index;
-        int c = getopt_long(argc, argv, "rmjvhs:", opts, &opt_index);
+        int c = getopt_long(argc, argv, "rmjvheys:", opts, &opt_index);
         if (c < 0) {
             break;
         }
@@ -148,6 +152,12 @@ int main(int argc, char** argv) {
         case 's':
             options.fvm_data_slices = static_cast<uint32_t>(strtoul(optarg, NULL, 0));
             break;
+        case 'e':
+            options.use_extents = true;
+            break;
+        case 'y':
+            options.repair = true;
+            break;
         case 'h':
         default:
             return usage();
@@ -6,9 +6,11 @@
 
 #include <inttypes.h>
 #include <stdio.h>
+#include <threads.h>
 
 #include <fbl/function.h>
 #include <lib/async/cpp/task.h>
+#include <lib/zx/event.h>
 #include <trace-engine/buffer_internal.h>
 #include <trace-engine/instrumentation.h>
 #include <trace/event.h>
@@ -182,6 +184,74 @@ void RunBenchmarks(bool tracing_enabled, const BenchmarkSpec* spec) {
     }
 }
 
+// The numbers of threads which write records concurrently in
+// RunThreadedBenchmarks().
+constexpr unsigned kMaxThreadCount = 32;
+constexpr unsigned kThreadCounts[] = {1, 2, 4, 8, 16, kMaxThreadCount};
+
+struct ThreadedRun {
+    const zx::event* start;
+    unsigned iterations;
+    float run_time;
+};
+
+int RunThreadedIterations(void* arg) {
+    auto run = static_cast<ThreadedRun*>(arg);
+    run->start->wait_one(ZX_EVENT_SIGNALED, zx::time::infinite(), nullptr);
+    run->run_time = Measure(run->iterations, [] {
+        TRACE_DURATION_BEGIN("+enabled", "name");
+    });
+    return 0;
+}
+
+// Measures the cost of writing a record as the number of threads writing
+// records at the same time grows. The total number of records is the same
+// for each thread count so that the buffer doesn't fill in oneshot mode.
+void RunThreadedBenchmarks(const BenchmarkSpec* spec) {
+    for (unsigned num_threads : kThreadCounts) {
+        printf("\n* %s: TRACE_DURATION_BEGIN macro with 0 arguments, %u threads ...\n",
+               spec->name, num_threads);
+
+        async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+        BenchmarkHandler handler(&loop, spec->mode, spec->buffer_size);
+        loop.StartThread("trace-engine loop", nullptr);
+
+        zx::event start;
+        zx_status_t status = zx::event::create(0u, &start);
+        ZX_DEBUG_ASSERT(status == ZX_OK);
+
+        handler.Start();
+        ThreadedRun runs[kMaxThreadCount];
+        thrd_t threads[kMaxThreadCount];
+        for (unsigned i = 0; i < num_threads; ++i) {
+            runs[i] = {&start, spec->num_iterations / num_threads, 0.f};
+            int result = thrd_create(&threads[i], RunThreadedIterations, &runs[i]);
+            ZX_DEBUG_ASSERT(result == thrd_success);
+        }
+        start.signal(0u, ZX_EVENT_SIGNALED);
+        for (unsigned i = 0; i < num_threads; ++i) {
+            thrd_join(threads[i], nullptr);
+        }
+        handler.Stop();
+
+        loop.Quit();
+        loop.JoinThreads();
+
+        float cumulative = 0, max = 0;
+        for (unsigned i = 0; i < num_threads; ++i) {
+            cumulative += runs[i].run_time;
+            if (max < runs[i].run_time)
+                max = runs[i].run_time;
+        }
+        unsigned iterations = spec->num_iterations / num_threads;
+        printf("  - run: %u threads, %u iterations per thread\n",
+               num_threads, iterations);
+        printf("  - per-iteration (usec): ave: %.3f, max: %.3f\n",
+               cumulative / static_cast<float>(num_threads * iterations),
+               max / static_cast<float>(iterations));
+    }
+}
+
 } // namespace
 
 void RunTracingDisabledBenchmarks() {
@@ -198,4 +268,5 @@ void RunTracingEnabledBenchmarks(const BenchmarkSpec* spec) {
     // No trailing \n on purpose. The extra blank line is provided by
     // BenchmarkHandler.Start().
     RunBenchmarks(true, spec);
+    RunThreadedBenchmarks(spec);
 }
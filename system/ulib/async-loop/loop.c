@@ -64,6 +64,14 @@ static const async_ops_t async_loop_ops = {
     },
 };
 
+// An entry in the loop's task heap.  The deadline is copied out of the task
+// so that sifting entries through the heap need not touch the tasks.
+typedef struct task_heap_entry {
+    zx_time_t deadline;
+    uint64_t sequence;
+    async_task_t* task;
+} task_heap_entry_t;
+
 typedef struct thread_record {
     list_node_t node;
     thrd_t thread;
@@ -83,10 +91,13 @@ typedef struct async_loop {
     _Atomic async_loop_state_t state;
     atomic_uint active_threads; // number of active dispatch threads
 
-    mtx_t lock; // guards the lists and the dispatching tasks flag
+    mtx_t lock; // guards the lists, the task heap and the dispatching tasks flag
     bool dispatching_tasks; // true while the loop is busy dispatching tasks
     list_node_t wait_list; // most recently added first
-    list_node_t task_list; // pending tasks, earliest deadline first
+    task_heap_entry_t* task_heap; // pending tasks, a binary min-heap by deadline
+    size_t task_count; // number of entries in |task_heap|
+    size_t task_capacity; // number of entries allocated for |task_heap|
+    uint64_t task_sequence; // orders tasks with equal deadlines by posting order
     list_node_t due_list; // due tasks, earliest deadline first
     list_node_t thread_list; // earliest created thread first
     list_node_t exception_list; // most recently added first
@@ -109,7 +120,8 @@ static zx_status_t async_loop_dispatch_exception(async_loop_t* loop,
                                                  zx_status_t status,
                                                  const zx_port_packet_t* report);
 static void async_loop_wake_threads(async_loop_t* loop);
-static void async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task);
+static zx_status_t async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task);
+static void async_loop_remove_task_locked(async_loop_t* loop, size_t index);
 static void async_loop_restart_timer_locked(async_loop_t* loop);
 static void async_loop_invoke_prologue(async_loop_t* loop);
 static void async_loop_invoke_epilogue(async_loop_t* loop);
@@ -136,6 +148,22 @@ static inline async_task_t* node_to_task(list_node_t* node) {
     return FROM_NODE(async_task_t, node);
 }
 
+// While a task is pending in the loop's task heap, its state records its
+// position in the heap.  The |prev| pointer is null, which distinguishes it
+// from a task on the |due_list|, and |index| is one-based so that the state
+// never reads as all zeroes.
+typedef struct task_heap_node {
+    list_node_t* prev;
+    size_t index;
+} task_heap_node_t;
+
+static_assert(sizeof(task_heap_node_t) <= sizeof(async_state_t),
+              "async_state_t too small");
+
+static inline task_heap_node_t* task_to_heap_node(async_task_t* task) {
+    return (task_heap_node_t*)&task->state;
+}
+
 static inline list_node_t* exception_to_node(async_exception_t* exception) {
     return TO_NODE(async_exception_t, exception);
 }
@@ -158,7 +186,6 @@ zx_status_t async_loop_create(const async_loop_config_t* config, async_loop_t**
     loop->config = *config;
     mtx_init(&loop->lock, mtx_plain);
     list_initialize(&loop->wait_list);
-    list_initialize(&loop->task_list);
     list_initialize(&loop->due_list);
     list_initialize(&loop->thread_list);
     list_initialize(&loop->exception_list);
@@ -192,6 +219,7 @@ void async_loop_destroy(async_loop_t* loop) {
     zx_handle_close(loop->port);
     zx_handle_close(loop->timer);
     mtx_destroy(&loop->lock);
+    free(loop->task_heap);
     free(loop);
 }
 
@@ -216,8 +244,9 @@ void async_loop_shutdown(async_loop_t* loop) {
         async_task_t* task = node_to_task(node);
         async_loop_dispatch_task(loop, task, ZX_ERR_CANCELED);
     }
-    while ((node = list_remove_head(&loop->task_list))) {
-        async_task_t* task = node_to_task(node);
+    while (loop->task_count) {
+        async_task_t* task = loop->task_heap[0].task;
+        async_loop_remove_task_locked(loop, 0u);
         async_loop_dispatch_task(loop, task, ZX_ERR_CANCELED);
     }
     while ((node = list_remove_head(&loop->exception_list))) {
@@ -350,20 +379,10 @@ static zx_status_t async_loop_dispatch_tasks(async_loop_t* loop) {
         list_node_t* node;
         if (list_is_empty(&loop->due_list)) {
             zx_time_t due_time = async_loop_now((async_dispatcher_t*)loop);
-            list_node_t* tail = NULL;
-            list_for_every(&loop->task_list, node) {
-                if (node_to_task(node)->deadline > due_time)
-                    break;
-                tail = node;
-            }
-            if (tail) {
-                list_node_t* head = loop->task_list.next;
-                loop->task_list.next = tail->next;
-                tail->next->prev = &loop->task_list;
-                loop->due_list.next = head;
-                head->prev = &loop->due_list;
-                loop->due_list.prev = tail;
-                tail->next = &loop->due_list;
+            while (loop->task_count && loop->task_heap[0].deadline <= due_time) {
+                async_task_t* task = loop->task_heap[0].task;
+                async_loop_remove_task_locked(loop, 0u);
+                list_add_tail(&loop->due_list, task_to_node(task));
             }
         }
 
@@ -549,15 +568,15 @@ static zx_status_t async_loop_post_task(async_dispatcher_t* async, async_task_t*
 
     mtx_lock(&loop->lock);
 
-    async_loop_insert_task_locked(loop, task);
-    if (!loop->dispatching_tasks &&
-        task_to_node(task)->prev == &loop->task_list) {
+    zx_status_t status = async_loop_insert_task_locked(loop, task);
+    if (status == ZX_OK && !loop->dispatching_tasks &&
+        task_to_heap_node(task)->index == 1u) {
         // Task inserted at head.  Earliest deadline changed.
         async_loop_restart_timer_locked(loop);
     }
 
     mtx_unlock(&loop->lock);
-    return ZX_OK;
+    return status;
 }
 
 static zx_status_t async_loop_cancel_task(async_dispatcher_t* async, async_task_t* task) {
@@ -569,8 +588,7 @@ static zx_status_t async_loop_cancel_task(async_dispatcher_t* async, async_task_
     // destroyed in case the client is counting on the handler not being
     // invoked again past this point.  Also, the task we're removing here
     // might be present in the dispatcher's |due_list| if it is pending
-    // dispatch instead of in the loop's |task_list| as usual.  The same
-    // logic works in both cases.
+    // dispatch instead of in the loop's |task_heap| as usual.
 
     mtx_lock(&loop->lock);
     list_node_t* node = task_to_node(task);
@@ -578,15 +596,18 @@ static zx_status_t async_loop_cancel_task(async_dispatcher_t* async, async_task_
         mtx_unlock(&loop->lock);
         return ZX_ERR_NOT_FOUND;
     }
+    if (node->prev) {
+        list_delete(node);
+        mtx_unlock(&loop->lock);
+        return ZX_OK;
+    }
 
     // Determine whether the head task was canceled and following task has
     // a later deadline.  If so, we will bump the timer along to that deadline.
-    bool must_restart = !loop->dispatching_tasks &&
-                        node->prev == &loop->task_list &&
-                        node->next != &loop->task_list &&
-                        node_to_task(node->next)->deadline > task->deadline;
-    list_delete(node);
-    if (must_restart)
+    size_t index = task_to_heap_node(task)->index - 1u;
+    async_loop_remove_task_locked(loop, index);
+    if (!loop->dispatching_tasks && index == 0u && loop->task_count &&
+        loop->task_heap[0].deadline > task->deadline)
         async_loop_restart_timer_locked(loop);
 
     mtx_unlock(&loop->lock);
@@ -701,27 +722,86 @@ static zx_status_t async_loop_resume_from_exception(async_dispatcher_t* async,
     return zx_task_resume_from_exception(task, loop->port, options);
 }
 
-static void async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task) {
-    // TODO(ZX-976): We assume that tasks are inserted in quasi-monotonic order and
-    // that insertion into the task queue will typically take no more than a few steps.
-    // If this assumption proves false and the cost of insertion becomes a problem, we
-    // should consider using a more efficient representation for maintaining order.
-    list_node_t* node;
-    for (node = loop->task_list.prev; node != &loop->task_list; node = node->prev) {
-        if (task->deadline >= node_to_task(node)->deadline)
+static inline bool task_heap_entry_less(const task_heap_entry_t* a,
+                                        const task_heap_entry_t* b) {
+    return a->deadline < b->deadline ||
+           (a->deadline == b->deadline && a->sequence < b->sequence);
+}
+
+static inline void async_loop_place_task_locked(async_loop_t* loop, size_t index,
+                                                const task_heap_entry_t* entry) {
+    loop->task_heap[index] = *entry;
+    task_to_heap_node(entry->task)->index = index + 1u;
+}
+
+// Moves |entry| towards the root of the heap from the hole at |index|, then
+// towards the leaves, until the heap is ordered.
+static void async_loop_sift_task_locked(async_loop_t* loop, size_t index,
+                                        const task_heap_entry_t* entry) {
+    while (index > 0u) {
+        size_t parent = (index - 1u) / 2u;
+        if (!task_heap_entry_less(entry, &loop->task_heap[parent]))
             break;
+        async_loop_place_task_locked(loop, index, &loop->task_heap[parent]);
+        index = parent;
+    }
+    for (;;) {
+        size_t child = index * 2u + 1u;
+        if (child >= loop->task_count)
+            break;
+        if (child + 1u < loop->task_count &&
+            task_heap_entry_less(&loop->task_heap[child + 1u], &loop->task_heap[child]))
+            child++;
+        if (!task_heap_entry_less(&loop->task_heap[child], entry))
+            break;
+        async_loop_place_task_locked(loop, index, &loop->task_heap[child]);
+        index = child;
+    }
+    async_loop_place_task_locked(loop, index, entry);
+}
+
+static zx_status_t async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task) {
+    if (loop->task_count == loop->task_capacity) {
+        size_t capacity = loop->task_capacity ? loop->task_capacity * 2u : 16u;
+        task_heap_entry_t* heap = realloc(loop->task_heap, capacity * sizeof(*heap));
+        if (!heap)
+            return ZX_ERR_NO_MEMORY;
+        loop->task_heap = heap;
+        loop->task_capacity = capacity;
+    }
+
+    // Tasks with equal deadlines are dispatched in the order they were posted.
+    task_heap_entry_t entry = {
+        .deadline = task->deadline,
+        .sequence = loop->task_sequence++,
+        .task = task,
+    };
+    task_to_heap_node(task)->prev = NULL;
+    loop->task_count++;
+    async_loop_sift_task_locked(loop, loop->task_count - 1u, &entry);
+    return ZX_OK;
+}
+
+static void async_loop_remove_task_locked(async_loop_t* loop, size_t index) {
+    ZX_DEBUG_ASSERT(index < loop->task_count);
+
+    async_task_t* task = loop->task_heap[index].task;
+    task_to_heap_node(task)->index = 0u;
+
+    // Fill the hole with the last entry in the heap.
+    loop->task_count--;
+    if (index != loop->task_count) {
+        task_heap_entry_t last = loop->task_heap[loop->task_count];
+        async_loop_sift_task_locked(loop, index, &last);
     }
-    list_add_after(node, task_to_node(task));
 }
 
 static void async_loop_restart_timer_locked(async_loop_t* loop) {
     zx_time_t deadline;
     if (list_is_empty(&loop->due_list)) {
-        list_node_t* head = list_peek_head(&loop->task_list);
-        if (!head)
+        if (!loop->task_count)
             return;
-        async_task_t* task = node_to_task(head);
-        deadline = task->deadline;
+        deadline = loop->task_heap[0].deadline;
         if (deadline == ZX_TIME_INFINITE)
             return;
     } else {
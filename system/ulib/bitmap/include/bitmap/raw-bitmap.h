@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/array.h>
 #include <fbl/macros.h>
 #include <zircon/assert.h>
 #include <zircon/types.h>
@@ -80,11 +81,72 @@ public:
     // Clear all bits in the bitmap.
     void ClearAll() override;
 
+    // Enables a summary of the runs of unset bits in the bitmap, which lets
+    // Find locate a run of unset bits, and Scan locate the first unset bit,
+    // in time logarithmic in the size of the bitmap rather than linear.
+    //
+    // The summary costs roughly 5% of the size of the bitmap, and is kept
+    // up to date by Set and Clear. After the bitmap is reset or resized it
+    // is rebuilt by the next call to Set, Clear or RebuildSummary; until
+    // then Find and Scan read the bitmap directly. Callers which fill a
+    // freshly reset bitmap through its storage may call RebuildSummary once
+    // the storage is filled. Callers which otherwise modify the storage
+    // directly must call InvalidateSummary first.
+    //
+    // The const methods never modify the summary, so they may be called
+    // concurrently with each other, as for a bitmap without a summary.
+    //
+    // If memory for the summary can not be allocated, the bitmap continues
+    // to work without it.
+    void EnableSummary();
+
+    // Rebuilds the summary (if enabled) from the bitmap's storage.
+    void RebuildSummary();
+
+    // Stops the summary (if enabled) from being used until it is rebuilt.
+    void InvalidateSummary() { summary_valid_ = false; }
+
+    // Returns true if Find and Scan currently use the summary.
+    bool HasSummary() const { return summary_leaves_ != 0 && summary_valid_; }
+
 protected:
+    // Reallocates the summary (if enabled) for the current size of the
+    // bitmap. Must be called when the bitmap's storage is reallocated.
+    void ResizeSummary();
+
     // The size of this bitmap, in bits.
     size_t size_ = 0;
     // Owned by bits_, cached
     size_t* data_ = nullptr;
+
+private:
+    // The summary is a binary tree over groups of kSummaryGroupBits bits.
+    // Each node records the runs of unset bits in the range it covers.
+    struct SummaryNode {
+        // The number of unset bits at the start of the range.
+        uint32_t prefix;
+        // The number of unset bits at the end of the range.
+        uint32_t suffix;
+        // The length of the longest run of unset bits in the range.
+        uint32_t longest;
+    };
+
+    bool ScanWords(size_t bitoff, size_t bitmax, bool is_set, size_t* out) const;
+    size_t SummaryNodeBits(size_t node, size_t* start) const;
+    void UpdateSummaryGroup(size_t group);
+    void UpdateSummaryNode(size_t node);
+    void UpdateSummary(size_t bitoff, size_t bitmax);
+    bool FindUnsetRun(size_t bitoff, size_t run_len, size_t* out) const;
+    bool SearchSummary(size_t node, size_t bitoff, size_t run_len, size_t* carry,
+                       size_t* out) const;
+    bool SearchSummaryGroup(size_t group, size_t bitoff, size_t run_len, size_t* carry,
+                            size_t* out) const;
+
+    bool summary_enabled_ = false;
+    bool summary_valid_ = false;
+    fbl::Array<SummaryNode> summary_;
+    // The number of leaves of the summary tree, a power of two.
+    size_t summary_leaves_ = 0;
 };
 
 // A simple bitmap backed by generic storage.
@@ -133,6 +195,7 @@ public:
         size_t old_size = size_;
         data_ = static_cast<size_t*>(bits_.GetData());
         size_ = size;
+        ResizeSummary();
 
         // Clear the partial bits not included in the new "size_t"s.
         Clear(old_size, fbl::min(old_len * kBits, size_));
@@ -149,6 +212,7 @@ public:
     // Allocates memory, and can fail.
     zx_status_t Reset(size_t size) {
         size_ = size;
+        ResizeSummary();
         if (size_ == 0) {
             data_ = nullptr;
             return ZX_OK;
@@ -9,6 +9,7 @@
 #include <stddef.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fbl/macros.h>
 #include <zircon/types.h>
 
@@ -73,6 +74,24 @@ size_t MaskBits(size_t data, size_t idx, size_t bitoff, size_t bitmax,
 #error "Unsupported size_t length"
 #endif
 
+// The number of bits covered by each leaf of the summary. Leaves are scanned
+// a word at a time when they are updated or searched.
+constexpr size_t kSummaryGroupWords = 64;
+constexpr size_t kSummaryGroupBits = kSummaryGroupWords * kBits;
+
+// Scans shorter than this read the bitmap directly, rather than the summary.
+constexpr size_t kSummaryMinScan = kSummaryGroupBits;
+
+// Returns the length of the longest run of set bits in |x|.
+size_t LongestRun(size_t x) {
+    size_t len = 0;
+    while (x != 0) {
+        x &= x >> 1;
+        ++len;
+    }
+    return len;
+}
+
 } // namespace
 
 zx_status_t RawBitmapBase::Shrink(size_t size) {
@@ -80,6 +99,7 @@ zx_status_t RawBitmapBase::Shrink(size_t size) {
         return ZX_ERR_NO_MEMORY;
     }
     size_ = size;
+    summary_valid_ = false;
     return ZX_OK;
 }
 
@@ -89,6 +109,22 @@ bool RawBitmapBase::Scan(size_t bitoff, size_t bitmax, bool is_set,
     if (bitoff >= bitmax) {
         return true;
     }
+    if (is_set && bitmax - bitoff >= kSummaryMinScan && HasSummary()) {
+        // Looking for the first unset bit.
+        size_t first_unset;
+        if (!FindUnsetRun(bitoff, 1, &first_unset) || first_unset >= bitmax) {
+            return true;
+        }
+        if (out) {
+            *out = first_unset;
+        }
+        return false;
+    }
+    return ScanWords(bitoff, bitmax, is_set, out);
+}
+
+bool RawBitmapBase::ScanWords(size_t bitoff, size_t bitmax, bool is_set,
+                              size_t* out) const {
     size_t i = FirstIdx(bitoff);
     while (true) {
         size_t masked = MaskBits(data_[i], i, bitoff, bitmax, is_set);
@@ -132,6 +168,15 @@ zx_status_t RawBitmapBase::Find(bool is_set, size_t bitoff, size_t bitmax,
     if (!out || bitmax <= bitoff) {
         return ZX_ERR_INVALID_ARGS;
     }
+    if (!is_set && run_len > 0 && bitmax <= size_ && HasSummary()) {
+        size_t start;
+        if (!FindUnsetRun(bitoff, run_len, &start) || start > bitmax ||
+            bitmax - start < run_len) {
+            return ZX_ERR_NO_RESOURCES;
+        }
+        *out = start;
+        return ZX_OK;
+    }
     size_t start = bitoff;
     while (true) {
         if (Scan(bitoff, bitmax, !is_set, &start) ||
@@ -187,6 +232,7 @@ zx_status_t RawBitmapBase::Set(size_t bitoff, size_t bitmax) {
     for (size_t i = first_idx; i <= last_idx; ++i) {
         data_[i] |= GetMask(i == first_idx, i == last_idx, bitoff, bitmax);
     }
+    UpdateSummary(bitoff, bitmax);
     return ZX_OK;
 }
 
@@ -202,6 +248,7 @@ zx_status_t RawBitmapBase::Clear(size_t bitoff, size_t bitmax) {
     for (size_t i = first_idx; i <= last_idx; ++i) {
         data_[i] &= ~(GetMask(i == first_idx, i == last_idx, bitoff, bitmax));
     }
+    UpdateSummary(bitoff, bitmax);
     return ZX_OK;
 }
 
@@ -213,6 +260,220 @@ void RawBitmapBase::ClearAll() {
     for (size_t i = 0; i <= last_idx; ++i) {
         data_[i] = 0;
     }
+    summary_valid_ = false;
+}
+
+void RawBitmapBase::EnableSummary() {
+    summary_enabled_ = true;
+    ResizeSummary();
+}
+
+void RawBitmapBase::ResizeSummary() {
+    summary_valid_ = false;
+    if (!summary_enabled_) {
+        return;
+    }
+    summary_.reset();
+    summary_leaves_ = 0;
+    if (size_ == 0 || size_ > UINT32_MAX) {
+        // Run lengths past UINT32_MAX would not fit in a SummaryNode.
+        return;
+    }
+
+    size_t groups = (size_ + kSummaryGroupBits - 1) / kSummaryGroupBits;
+    size_t leaves = 1;
+    while (leaves < groups) {
+        leaves *= 2;
+    }
+    fbl::AllocChecker ac;
+    SummaryNode* nodes = new (&ac) SummaryNode[2 * leaves];
+    if (!ac.check()) {
+        return;
+    }
+    summary_.reset(nodes, 2 * leaves);
+    summary_leaves_ = leaves;
+}
+
+void RawBitmapBase::RebuildSummary() {
+    if (summary_leaves_ == 0) {
+        return;
+    }
+    for (size_t group = 0; group < summary_leaves_; ++group) {
+        UpdateSummaryGroup(group);
+    }
+    for (size_t node = summary_leaves_ - 1; node > 0; --node) {
+        UpdateSummaryNode(node);
+    }
+    summary_valid_ = true;
+}
+
+// Returns the number of bits covered by |node|, and places the first of them
+// in |start|. Nodes (or parts of nodes) past the end of the bitmap cover no
+// bits.
+size_t RawBitmapBase::SummaryNodeBits(size_t node, size_t* start) const {
+    size_t level_start = 1;
+    size_t groups = summary_leaves_;
+    while (level_start * 2 <= node) {
+        level_start *= 2;
+        groups /= 2;
+    }
+    size_t first = (node - level_start) * groups * kSummaryGroupBits;
+    size_t max = fbl::min(first + groups * kSummaryGroupBits, size_);
+    *start = first;
+    return max > first ? max - first : 0;
+}
+
+void RawBitmapBase::UpdateSummaryGroup(size_t group) {
+    SummaryNode& node = summary_[summary_leaves_ + group];
+    size_t bitoff = group * kSummaryGroupBits;
+    size_t bitmax = fbl::min(bitoff + kSummaryGroupBits, size_);
+    if (bitoff >= bitmax) {
+        node = {0, 0, 0};
+        return;
+    }
+
+    // Walk the words of the group, tracking the run of unset bits which
+    // reaches the end of the bits walked so far.
+    size_t prefix = 0;
+    bool in_prefix = true;
+    size_t longest = 0;
+    size_t run = 0;
+    for (size_t i = FirstIdx(bitoff); i <= LastIdx(bitmax); ++i) {
+        size_t valid = GetMask(false, i == LastIdx(bitmax), bitoff, bitmax);
+        size_t nbits = kBits - CLZ(valid);
+        size_t data = data_[i] & valid;
+        if (data == 0) {
+            run += nbits;
+            continue;
+        }
+        size_t low = CTZ(data);
+        size_t high = kBits - CLZ(data);
+        run += low;
+        if (in_prefix) {
+            prefix = run;
+            in_prefix = false;
+        }
+        longest = fbl::max(longest, run);
+        // Runs which lie between the lowest and highest set bits.
+        size_t below_high = high == kBits ? ~size_t(0) : (size_t(1) << high) - 1;
+        size_t inner = ~data & below_high & ~((size_t(1) << low) - 1);
+        longest = fbl::max(longest, LongestRun(inner));
+        run = nbits - high;
+    }
+    if (in_prefix) {
+        prefix = run;
+    }
+    longest = fbl::max(longest, run);
+
+    node.prefix = static_cast<uint32_t>(prefix);
+    node.suffix = static_cast<uint32_t>(run);
+    node.longest = static_cast<uint32_t>(longest);
+}
+
+void RawBitmapBase::UpdateSummaryNode(size_t node) {
+    size_t start;
+    const SummaryNode& left = summary_[2 * node];
+    const SummaryNode& right = summary_[2 * node + 1];
+    size_t left_bits = SummaryNodeBits(2 * node, &start);
+    size_t right_bits = SummaryNodeBits(2 * node + 1, &start);
+
+    SummaryNode& out = summary_[node];
+    out.prefix = left.prefix == left_bits ? static_cast<uint32_t>(left_bits + right.prefix)
+                                          : left.prefix;
+    out.suffix = right.suffix == right_bits ? static_cast<uint32_t>(right_bits + left.suffix)
+                                            : right.suffix;
+    out.longest = fbl::max(fbl::max(left.longest, right.longest),
+                           static_cast<uint32_t>(left.suffix + right.prefix));
+}
+
+// Updates the summary (if enabled) after the bits in [bitoff, bitmax) have
+// changed, rebuilding all of it if it is not yet valid.
+void RawBitmapBase::UpdateSummary(size_t bitoff, size_t bitmax) {
+    if (!summary_valid_) {
+        RebuildSummary();
+        return;
+    }
+    size_t first = bitoff / kSummaryGroupBits;
+    size_t last = (bitmax - 1) / kSummaryGroupBits;
+    for (size_t group = first; group <= last; ++group) {
+        UpdateSummaryGroup(group);
+    }
+    first += summary_leaves_;
+    last += summary_leaves_;
+    while (first > 1) {
+        first /= 2;
+        last /= 2;
+        for (size_t node = first; node <= last; ++node) {
+            UpdateSummaryNode(node);
+        }
+    }
+}
+
+// Finds the first run of |run_len| unset bits starting at or after |bitoff|,
+// placing its start in |out|. Returns false if there is no such run.
+bool RawBitmapBase::FindUnsetRun(size_t bitoff, size_t run_len, size_t* out) const {
+    size_t carry = 0;
+    return SearchSummary(1, bitoff, run_len, &carry, out);
+}
+
+// Searches the bits covered by |node|, given that the |carry| bits before
+// them are unset (and at or after |bitoff|). Updates |carry| to the number
+// of unset bits at the end of the node if the run is not found.
+bool RawBitmapBase::SearchSummary(size_t node, size_t bitoff, size_t run_len,
+                                  size_t* carry, size_t* out) const {
+    size_t start;
+    size_t bits = SummaryNodeBits(node, &start);
+    if (bits == 0) {
+        return false;
+    }
+    if (start + bits <= bitoff) {
+        *carry = 0;
+        return false;
+    }
+    if (start >= bitoff) {
+        const SummaryNode& summary = summary_[node];
+        if (*carry + summary.prefix >= run_len) {
+            *out = start - *carry;
+            return true;
+        }
+        if (summary.longest < run_len) {
+            *carry = summary.prefix == bits ? *carry + bits : summary.suffix;
+            return false;
+        }
+    }
+    // Either the run lies within this node, or |bitoff| does.
+    if (node >= summary_leaves_) {
+        return SearchSummaryGroup(node - summary_leaves_, bitoff, run_len, carry, out);
+    }
+    return SearchSummary(2 * node, bitoff, run_len, carry, out) ||
+           SearchSummary(2 * node + 1, bitoff, run_len, carry, out);
+}
+
+bool RawBitmapBase::SearchSummaryGroup(size_t group, size_t bitoff, size_t run_len,
+                                       size_t* carry, size_t* out) const {
+    size_t bitmax = fbl::min((group + 1) * kSummaryGroupBits, size_);
+    size_t pos = fbl::max(group * kSummaryGroupBits, bitoff);
+    size_t run = *carry;
+    while (true) {
+        size_t first_set;
+        bool all_unset = ScanWords(pos, bitmax, false, &first_set);
+        if (all_unset) {
+            first_set = bitmax;
+        }
+        if (run + (first_set - pos) >= run_len) {
+            *out = pos - run;
+            return true;
+        }
+        if (all_unset) {
+            *carry = run + (bitmax - pos);
+            return false;
+        }
+        if (ScanWords(first_set, bitmax, true, &pos)) {
+            *carry = 0;
+            return false;
+        }
+        run = 0;
+    }
 }
 
 } // namespace bitmap
@@ -118,7 +118,13 @@ zx_status_t Allocator::ResetFromStorage(fs::ReadTxn txn) {
     const auto info = space_manager_->Info();
     txn.Enqueue(block_map_vmoid_, 0, BlockMapStartBlock(info), BlockMapBlocks(info));
     txn.Enqueue(node_map_vmoid_, 0, NodeMapStartBlock(info), NodeMapBlocks(info));
-    return txn.Transact();
+    // The block map's storage is about to be overwritten.
+    block_map_.InvalidateSummary();
+    if ((status = txn.Transact()) != ZX_OK) {
+        return status;
+    }
+    block_map_.RebuildSummary();
+    return ZX_OK;
 }
 
 const zx::vmo& Allocator::GetBlockMapVmo() const {
@@ -152,6 +152,50 @@ zx_status_t Blobfs::VerifyBlob(uint32_t node_index) {
     return VnodeBlob::VerifyBlob(this, node_index);
 }
 
+void Blobfs::StartBackgroundVerification(uint32_t budget, zx::duration interval) {
+    verify_budget_ = budget;
+    verify_interval_ = interval;
+    verify_task_.PostDelayed(dispatcher(), verify_interval_);
+}
+
+void Blobfs::VerifyBlobsInBackground() {
+    TRACE_DURATION("blobfs", "Blobfs::VerifyBlobsInBackground");
+    // Cached blobs were verified when they were read or written, and the data of
+    // recently written blobs may not have reached the disk yet.
+    auto cached = [this](const Inode& inode) {
+        return Cache().Lookup(Digest(inode.merkle_root_hash), nullptr) != ZX_ERR_NOT_FOUND;
+    };
+    const uint64_t passes = verify_cursor_.passes();
+    uint32_t node_index;
+    const bool found = verify_cursor_.Next(allocator_.get(), info_.inode_count, cached,
+                                           &node_index);
+    if (verify_cursor_.passes() != passes && verify_cursor_.last_pass().blobs > 0) {
+        FS_TRACE_INFO("blobfs: Background verification checked %u blobs, %u corrupt\n",
+                      verify_cursor_.last_pass().blobs, verify_cursor_.last_pass().corrupt);
+    }
+
+    if (found) {
+        zx_status_t status = VerifyBlob(node_index);
+        if (status != ZX_OK) {
+            char name[digest::Digest::kLength * 2 + 1];
+            Digest(GetNode(node_index)->merkle_root_hash).ToString(name, sizeof(name));
+            FS_TRACE_ERROR("blobfs: CORRUPTED BLOB: %s @ index %u failed verification\n",
+                           name, node_index);
+        }
+        verify_cursor_.Record(status);
+
+        // Each task verifies a single blob, so that requests from clients are served
+        // between the blobs of a batch rather than waiting for all of them.
+        if (++verify_batch_count_ < verify_budget_) {
+            verify_task_.Post(dispatcher());
+            return;
+        }
+    }
+
+    verify_batch_count_ = 0;
+    verify_task_.PostDelayed(dispatcher(), verify_interval_);
+}
+
 void Blobfs::PersistBlocks(WritebackWork* wb, const ReservedExtent& reserved_extent) {
     TRACE_DURATION("blobfs", "Blobfs::PersistBlocks");
 
@@ -193,6 +237,9 @@ void Blobfs::FreeInode(WritebackWork* wb, uint32_t node_index) {
     ZX_DEBUG_ASSERT(wb != nullptr);
 
     if (mapped_inode->header.IsAllocated()) {
+        // Blobs which are mid-write were never indexed, so this may fail harmlessly.
+        __UNUSED zx_status_t status = digest_index_->Erase(mapped_inode->merkle_root_hash);
+
         // Always write back the first node.
         FreeNode(wb, node_index);
 
@@ -264,6 +311,8 @@ size_t Blobfs::WritebackCapacity() const {
 void Blobfs::Shutdown(fs::Vfs::ShutdownCallback cb) {
     TRACE_DURATION("blobfs", "Blobfs::Unmount");
 
+    verify_task_.Cancel();
+
     // 1) Shutdown all external connections to blobfs.
     ManagedVfs::Shutdown([this, cb = std::move(cb)](zx_status_t status) mutable {
         // 2a) Shutdown all internal connections to blobfs.
@@ -432,6 +481,9 @@ zx_status_t Blobfs::AddInodes(fzl::ResizeableVmoMapper* node_map) {
                            kBlobfsInodesPerBlock;
     ZX_DEBUG_ASSERT(inoblks_old <= inoblks);
 
+    if (digest_index_->Reserve(inodes) != ZX_OK) {
+        return ZX_ERR_NO_MEMORY;
+    }
     if (node_map->Grow(inoblks * kBlobfsBlockSize) != ZX_OK) {
         return ZX_ERR_NO_SPACE;
     }
@@ -584,6 +636,7 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const MountOptions& options, const
     }
 
     RawBitmap block_map;
+    block_map.EnableSummary();
     // Keep the block_map aligned to a block multiple
     if ((status = block_map.Reset(BlockMapBlocks(fs->info_) * kBlobfsBlockBits)) < 0) {
         FS_TRACE_ERROR("blobfs: Could not reset block bitmap\n");
@@ -602,6 +655,7 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const MountOptions& options, const
     }
     fs->allocator_ =
         fbl::make_unique<Allocator>(fs.get(), std::move(block_map), std::move(node_map));
+    fs->digest_index_ = fbl::make_unique<DigestIndex>(fs->allocator_.get());
     if ((status = fs->allocator_->ResetFromStorage(fs::ReadTxn(fs.get()))) != ZX_OK) {
         FS_TRACE_ERROR("blobfs: Failed to load bitmaps: %d\n", status);
         return status;
@@ -632,36 +686,73 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const MountOptions& options, const
 }
 
 zx_status_t Blobfs::InitializeVnodes() {
+    TRACE_DURATION("blobfs", "Blobfs::InitializeVnodes");
     Cache().Reset();
+    digest_index_->Reset();
+
+    // Every blob occupies at least one inode, so reserving room for all of them ensures that
+    // blobs written later can always be indexed.
+    zx_status_t status = digest_index_->Reserve(info_.inode_count);
+    if (status != ZX_OK) {
+        return status;
+    }
 
     for (uint32_t node_index = 0; node_index < info_.inode_count; node_index++) {
         const Inode* inode = GetNode(node_index);
         if (inode->header.IsAllocated() && !inode->header.IsExtentContainer()) {
-            Digest digest(inode->merkle_root_hash);
-            fbl::RefPtr<VnodeBlob> vnode = fbl::AdoptRef(new VnodeBlob(this, digest));
-            vnode->SetState(kBlobStateReadable);
-            vnode->PopulateInode(node_index);
-
-            // This blob is added to the cache, where it will quickly be relocated into the "closed
-            // set" once we drop our reference to |vnode|. Although we delay reading any of the
-            // contents of the blob from disk until requested, this pre-caching scheme allows us to
-            // quickly verify or deny the presence of a blob during blob lookup and creation.
-            zx_status_t status = Cache().Add(vnode);
-            if (status != ZX_OK) {
-                Digest digest(vnode->GetNode().merkle_root_hash);
+            // Only the node index is recorded here; the corresponding VnodeBlob is created by
+            // |LookupBlob()| the first time this blob is requested.
+            if ((status = digest_index_->Insert(node_index)) != ZX_OK) {
+                Digest digest(inode->merkle_root_hash);
                 char name[digest::Digest::kLength * 2 + 1];
                 digest.ToString(name, sizeof(name));
                 FS_TRACE_ERROR("blobfs: CORRUPTED FILESYSTEM: Duplicate node: %s @ index %u\n",
-                               name, node_index - 1);
+                               name, node_index);
                 return status;
             }
-            LocalMetrics().UpdateLookup(vnode->SizeData());
         }
     }
 
     return ZX_OK;
 }
 
+zx_status_t Blobfs::LookupBlob(const Digest& digest, fbl::RefPtr<VnodeBlob>* out) {
+    TRACE_DURATION("blobfs", "Blobfs::LookupBlob");
+    fbl::RefPtr<CacheNode> cache_node;
+    zx_status_t status = Cache().Lookup(digest, out != nullptr ? &cache_node : nullptr);
+    if (status != ZX_ERR_NOT_FOUND) {
+        if (status == ZX_OK && out != nullptr) {
+            *out = fbl::RefPtr<VnodeBlob>::Downcast(std::move(cache_node));
+        }
+        return status;
+    }
+
+    uint32_t node_index;
+    status = digest_index_->Lookup(digest.AcquireBytes(), &node_index);
+    digest.ReleaseBytes();
+    if (status != ZX_OK || out == nullptr) {
+        return status;
+    }
+
+    // This is the first time the blob has been requested since mount.
+    fbl::AllocChecker ac;
+    fbl::RefPtr<VnodeBlob> vnode = fbl::AdoptRef(new (&ac) VnodeBlob(this, digest));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    vnode->PopulateInode(node_index);
+    if ((status = Cache().Add(vnode)) != ZX_OK) {
+        return status;
+    }
+    *out = std::move(vnode);
+    return ZX_OK;
+}
+
+void Blobfs::IndexBlob(uint32_t node_index) {
+    zx_status_t status = digest_index_->Insert(node_index);
+    ZX_ASSERT_MSG(status == ZX_OK, "Failed to index blob @ index %u: %d\n", node_index, status);
+}
+
 zx_status_t Blobfs::Reload() {
     TRACE_DURATION("blobfs", "Blobfs::Reload");
 
@@ -790,6 +881,10 @@ zx_status_t Mount(async_dispatcher_t* dispatcher, fbl::unique_fd blockfd,
         return status;
     }
 
+    if (options.verify_budget > 0) {
+        fs->StartBackgroundVerification(options.verify_budget, options.verify_interval);
+    }
+
     // Shutdown is now responsible for deleting the Blobfs object.
     __UNUSED auto r = fs.release();
     return ZX_OK;
@@ -817,6 +912,17 @@ zx_status_t Blobfs::EnqueueWork(fbl::unique_ptr<WritebackWork> work, EnqueueType
         // fall through to the writeback queue if the journal doesn't exist.
         __FALLTHROUGH;
     case EnqueueType::kData:
+        if (journal_ != nullptr) {
+            // The data may overwrite blocks freed by a transaction already enqueued to the
+            // journal, so that transaction must reach the journal first.
+            zx_status_t status = journal_->CloseEntry();
+            if (status != ZX_OK) {
+                work->MarkCompleted(status);
+                return status;
+            }
+        }
+        __FALLTHROUGH;
+    case EnqueueType::kWriteback:
         if (writeback_ != nullptr) {
             return writeback_->Enqueue(std::move(work));
         }
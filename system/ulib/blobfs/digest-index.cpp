@@ -0,0 +1,143 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <blobfs/digest-index.h>
+#include <digest/digest.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <zircon/assert.h>
+
+#include <utility>
+
+using digest::Digest;
+
+namespace blobfs {
+namespace {
+
+// The smallest table allocated by |Reserve()|.
+constexpr size_t kMinimumSlots = 16;
+
+} // namespace
+
+DigestIndex::DigestIndex(NodeFinder* finder) : finder_(finder) {}
+
+DigestIndex::~DigestIndex() = default;
+
+void DigestIndex::Reset() {
+    for (size_t i = 0; i < slots_.size(); i++) {
+        slots_[i] = kEmptySlot;
+    }
+    size_ = 0;
+}
+
+zx_status_t DigestIndex::Reserve(size_t count) {
+    // Keep the table at most half full, so that probe sequences (particularly
+    // for blobs which do not exist) remain short.
+    if (count <= slots_.size() / 2) {
+        return ZX_OK;
+    }
+    size_t slot_count = kMinimumSlots;
+    while (slot_count / 2 < count) {
+        slot_count *= 2;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::Array<uint32_t> slots(new (&ac) uint32_t[slot_count], slot_count);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    for (size_t i = 0; i < slot_count; i++) {
+        slots[i] = kEmptySlot;
+    }
+
+    fbl::Array<uint32_t> old_slots = std::move(slots_);
+    slots_ = std::move(slots);
+    size_ = 0;
+    for (size_t i = 0; i < old_slots.size(); i++) {
+        if (old_slots[i] != kEmptySlot) {
+            __UNUSED zx_status_t status = Insert(old_slots[i]);
+            ZX_DEBUG_ASSERT(status == ZX_OK);
+        }
+    }
+    return ZX_OK;
+}
+
+zx_status_t DigestIndex::Insert(uint32_t node_index) {
+    ZX_DEBUG_ASSERT(node_index != kEmptySlot);
+    if (size_ + 1 > slots_.size() / 2) {
+        return ZX_ERR_NO_SPACE;
+    }
+    const uint8_t* digest = finder_->GetNode(node_index)->merkle_root_hash;
+    size_t slot = Probe(digest);
+    if (slots_[slot] != kEmptySlot) {
+        return ZX_ERR_ALREADY_EXISTS;
+    }
+    slots_[slot] = node_index;
+    size_++;
+    return ZX_OK;
+}
+
+zx_status_t DigestIndex::Lookup(const uint8_t* digest, uint32_t* out) const {
+    if (size_ == 0) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    size_t slot = Probe(digest);
+    if (slots_[slot] == kEmptySlot) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    *out = slots_[slot];
+    return ZX_OK;
+}
+
+zx_status_t DigestIndex::Erase(const uint8_t* digest) {
+    if (size_ == 0) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    size_t hole = Probe(digest);
+    if (slots_[hole] == kEmptySlot) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    // Close the gap left by the erased entry: walk the rest of the cluster,
+    // moving back any entry whose ideal slot does not lie between the hole and
+    // its current position.
+    const size_t mask = slots_.size() - 1;
+    for (size_t next = (hole + 1) & mask; slots_[next] != kEmptySlot; next = (next + 1) & mask) {
+        size_t ideal = SlotFor(KeyAt(next));
+        if (((next - ideal) & mask) >= ((next - hole) & mask)) {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+    }
+    slots_[hole] = kEmptySlot;
+    size_--;
+    return ZX_OK;
+}
+
+size_t DigestIndex::SlotFor(const uint8_t* digest) const {
+    uint64_t hash;
+    memcpy(&hash, digest, sizeof(hash));
+    return static_cast<size_t>(hash) & (slots_.size() - 1);
+}
+
+const uint8_t* DigestIndex::KeyAt(size_t slot) const {
+    return finder_->GetNode(slots_[slot])->merkle_root_hash;
+}
+
+size_t DigestIndex::Probe(const uint8_t* digest) const {
+    ZX_DEBUG_ASSERT(fbl::is_pow2(slots_.size()));
+    // The table is never more than half full, so an empty slot always
+    // terminates the search.
+    const size_t mask = slots_.size() - 1;
+    size_t slot = SlotFor(digest);
+    while (slots_[slot] != kEmptySlot && memcmp(KeyAt(slot), digest, Digest::kLength) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+} // namespace blobfs
@@ -9,6 +9,8 @@
 
 #ifdef __Fuchsia__
 #include <blobfs/blobfs.h>
+#include <threads.h>
+#include <zircon/syscalls.h>
 
 #include <utility>
 #else
@@ -19,6 +21,16 @@
 // TODO(planders): Potentially check the state of the journal.
 namespace blobfs {
 
+#ifdef __Fuchsia__
+namespace {
+
+// Every thread which issues block transactions permanently occupies one of the
+// block device's MAX_TXN_GROUP_COUNT transaction groups, so only use some of them.
+constexpr uint32_t kMaxVerifyThreads = MAX_TXN_GROUP_COUNT / 2;
+
+} // namespace
+#endif
+
 void BlobfsChecker::TraverseInodeBitmap() {
     for (unsigned n = 0; n < blobfs_->info_.inode_count; n++) {
         Inode* inode = blobfs_->GetNode(n);
@@ -54,10 +66,6 @@ void BlobfsChecker::TraverseInodeBitmap() {
                 inode_blocks_ += extent->Length();
             }
 
-            if (blobfs_->VerifyBlob(n) != ZX_OK) {
-                FS_TRACE_ERROR("check: detected inode %u with bad state\n", n);
-                valid = false;
-            }
             if (!valid) {
                 error_blobs_++;
             }
@@ -65,6 +73,54 @@ void BlobfsChecker::TraverseInodeBitmap() {
     }
 }
 
+void BlobfsChecker::VerifyBlobs() {
+    next_node_.store(0);
+#ifdef __Fuchsia__
+    // Blob verification is dominated by reading and hashing blob contents, so spread it
+    // across cores. Metrics are not thread-safe; verify serially when collecting them.
+    uint32_t thread_count = fbl::min(zx_system_get_num_cpus(), kMaxVerifyThreads);
+    if (blobfs_->CollectingMetrics()) {
+        thread_count = 1;
+    }
+
+    // The calling thread verifies blobs too.
+    thrd_t threads[kMaxVerifyThreads];
+    uint32_t started = 0;
+    while (started + 1 < thread_count) {
+        if (thrd_create_with_name(&threads[started], VerifyThread, this,
+                                  "blobfs-fsck-verify") != thrd_success) {
+            break;
+        }
+        started++;
+    }
+    VerifyNextBlobs();
+    for (uint32_t i = 0; i < started; i++) {
+        thrd_join(threads[i], nullptr);
+    }
+#else
+    VerifyNextBlobs();
+#endif
+}
+
+int BlobfsChecker::VerifyThread(void* arg) {
+    static_cast<BlobfsChecker*>(arg)->VerifyNextBlobs();
+    return 0;
+}
+
+void BlobfsChecker::VerifyNextBlobs() {
+    uint32_t n;
+    while ((n = next_node_.fetch_add(1)) < blobfs_->info_.inode_count) {
+        const Inode* inode = blobfs_->GetNode(n);
+        if (!inode->header.IsAllocated() || inode->header.IsExtentContainer()) {
+            continue;
+        }
+        if (blobfs_->VerifyBlob(n) != ZX_OK) {
+            FS_TRACE_ERROR("check: detected inode %u with bad state\n", n);
+            corrupt_blobs_.fetch_add(1);
+        }
+    }
+}
+
 void BlobfsChecker::TraverseBlockBitmap() {
     for (uint64_t n = 0; n < blobfs_->info_.data_block_count; n++) {
         if (blobfs_->CheckBlocksAllocated(n, n + 1)) {
@@ -101,7 +157,7 @@ zx_status_t BlobfsChecker::CheckAllocatedCounts() const {
         status = ZX_ERR_BAD_STATE;
     }
 
-    if (error_blobs_) {
+    if (error_blobs_ || corrupt_blobs_.load()) {
         status = ZX_ERR_BAD_STATE;
     }
 
@@ -109,17 +165,21 @@ zx_status_t BlobfsChecker::CheckAllocatedCounts() const {
 }
 
 BlobfsChecker::BlobfsChecker()
-    : blobfs_(nullptr), alloc_inodes_(0), alloc_blocks_(0), error_blobs_(0), inode_blocks_(0) {};
+    : blobfs_(nullptr), alloc_inodes_(0), alloc_blocks_(0), error_blobs_(0), inode_blocks_(0),
+      next_node_(0), corrupt_blobs_(0) {};
 
 void BlobfsChecker::Init(fbl::unique_ptr<Blobfs> blob) {
     blobfs_ = std::move(blob);
 }
 
-zx_status_t Fsck(fbl::unique_ptr<Blobfs> blob) {
+zx_status_t Fsck(fbl::unique_ptr<Blobfs> blob, const FsckOptions& options) {
     BlobfsChecker chk;
     chk.Init(std::move(blob));
     chk.TraverseInodeBitmap();
     chk.TraverseBlockBitmap();
+    if (options.verify_blobs) {
+        chk.VerifyBlobs();
+    }
     return chk.CheckAllocatedCounts();
 }
 
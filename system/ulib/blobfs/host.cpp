@@ -376,6 +376,7 @@ zx_status_t Blobfs::Create(fbl::unique_fd blockfd_, off_t offset, const info_blo
 
 zx_status_t Blobfs::LoadBitmap() {
     zx_status_t status;
+    block_map_.EnableSummary();
     if ((status = block_map_.Reset(block_map_block_count_ * kBlobfsBlockBits)) != ZX_OK) {
         return status;
     } else if ((status = block_map_.Shrink(info_.data_block_count)) != ZX_OK) {
@@ -394,6 +395,7 @@ zx_status_t Blobfs::LoadBitmap() {
             memcpy(bmdata, cache_.blk, kBlobfsBlockSize);
         }
     }
+    block_map_.RebuildSummary();
     return ZX_OK;
 }
 
@@ -31,16 +31,19 @@
 #include <fs/vfs.h>
 #include <fs/vnode.h>
 #include <fuchsia/io/c/fidl.h>
+#include <lib/async/cpp/task.h>
 #include <lib/async/cpp/wait.h>
 #include <lib/fzl/owned-vmo-mapper.h>
 #include <lib/fzl/resizeable-vmo-mapper.h>
 #include <lib/zx/event.h>
+#include <lib/zx/time.h>
 #include <lib/zx/vmo.h>
 #include <trace/event.h>
 
 #include <blobfs/allocator.h>
 #include <blobfs/blob-cache.h>
 #include <blobfs/common.h>
+#include <blobfs/digest-index.h>
 #include <blobfs/extent-reserver.h>
 #include <blobfs/format.h>
 #include <blobfs/iterator/allocated-extent-iterator.h>
@@ -49,6 +52,7 @@
 #include <blobfs/lz4.h>
 #include <blobfs/metrics.h>
 #include <blobfs/node-reserver.h>
+#include <blobfs/verify-cursor.h>
 #include <blobfs/vnode.h>
 #include <blobfs/writeback.h>
 
@@ -68,6 +72,8 @@ using digest::Digest;
 enum class EnqueueType {
     kJournal,
     kData,
+    // Like kData, but not ordered after the journal's open entry. Only used by the journal itself.
+    kWriteback,
 };
 
 // Toggles that may be set on blobfs during initialization.
@@ -76,6 +82,10 @@ struct MountOptions {
     bool metrics = false;
     bool journal = false;
     CachePolicy cache_policy = CachePolicy::EvictImmediately;
+    // Number of blobs to verify in the background every |verify_interval| while
+    // mounted. Zero disables background verification.
+    uint32_t verify_budget = 0;
+    zx::duration verify_interval = zx::sec(60);
 };
 
 class Blobfs : public fs::ManagedVfs,
@@ -181,6 +191,19 @@ public:
         return blob_cache_;
     }
 
+    // Searches for a readable blob by |digest|.
+    //
+    // Blobs which have not been opened since mount are only present in the digest index;
+    // their vnodes are instantiated and added to the cache on first lookup.
+    //
+    // Returns ZX_ERR_NOT_FOUND if no such blob exists. |out| may be null, in which case
+    // presence is checked without instantiating a vnode.
+    zx_status_t LookupBlob(const Digest& digest, fbl::RefPtr<VnodeBlob>* out) __WARN_UNUSED_RESULT;
+
+    // Makes the blob at |node_index| discoverable by |LookupBlob()|, once its inode (including
+    // the merkle root) has been written to the node map.
+    void IndexBlob(uint32_t node_index);
+
     zx_status_t Readdir(fs::vdircookie_t* cookie, void* dirents, size_t len, size_t* out_actual);
 
     int Fd() const { return blockfd_.get(); }
@@ -206,14 +229,18 @@ public:
     // disk.
     void FreeInode(WritebackWork* wb, uint32_t node_index);
 
-    // Does a single pass of all blobs, creating uninitialized Vnode
-    // objects for them all.
+    // Does a single pass of all blobs, adding each of them to the digest index.
     //
     // By executing this function at mount, we can quickly assert
     // either the presence or absence of a blob on the system without
-    // further scanning.
+    // further scanning. Vnodes are only created once a blob is looked up.
     zx_status_t InitializeVnodes();
 
+    // Begins verifying up to |budget| blobs every |interval| on the dispatcher, one
+    // per task, resuming each time where the previous batch stopped, so that
+    // corruption of blobs which are never read is still detected eventually.
+    void StartBackgroundVerification(uint32_t budget, zx::duration interval);
+
     // Writes node data to the inode table and updates disk.
     void PersistNode(WritebackWork* wb, uint32_t node_index);
 
@@ -257,6 +284,9 @@ private:
     // Verifies that the contents of a blob are valid.
     zx_status_t VerifyBlob(uint32_t node_index);
 
+    // Verifies the next blob for |StartBackgroundVerification()|.
+    void VerifyBlobsInBackground();
+
     fbl::unique_ptr<WritebackQueue> writeback_;
     fbl::unique_ptr<Journal> journal_;
     Superblock info_;
@@ -269,6 +299,8 @@ private:
     block_client::Client fifo_client_;
 
     fbl::unique_ptr<Allocator> allocator_;
+    // Maps the merkle root of every readable blob to its node; reads keys from |allocator_|.
+    fbl::unique_ptr<DigestIndex> digest_index_;
 
     fzl::ResizeableVmoMapper info_mapping_;
     vmoid_t info_vmoid_ = {};
@@ -280,6 +312,14 @@ private:
 
     fbl::Closure on_unmount_ = {};
 
+    // Background verification state. |verify_batch_count_| is the number of blobs
+    // verified so far in the current batch of up to |verify_budget_|.
+    uint32_t verify_budget_ = 0;
+    zx::duration verify_interval_;
+    uint32_t verify_batch_count_ = 0;
+    VerifyCursor verify_cursor_;
+    async::TaskClosureMethod<Blobfs, &Blobfs::VerifyBlobsInBackground> verify_task_{this};
+
     // TODO(gevalentino): clean up old metrics and update this to inspect API.
     fs::Metrics cobalt_metrics_;
 };
@@ -0,0 +1,80 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <blobfs/format.h>
+#include <blobfs/iterator/extent-iterator.h>
+#include <fbl/array.h>
+#include <fbl/macros.h>
+#include <zircon/types.h>
+
+namespace blobfs {
+
+// DigestIndex maps the merkle root of every readable blob to the index of the
+// inode which describes it.
+//
+// The index stores nothing but node indices: keys are read out of the inode
+// table through |NodeFinder|, so an entry costs four bytes (at most eight
+// including slack), compared with a full |VnodeBlob| per blob. This lets
+// blobfs answer presence queries for every blob on disk while only
+// instantiating vnodes for blobs which are actually opened.
+//
+// Internally, this is an open-addressed table using linear probing. Merkle
+// roots are uniformly distributed, so their leading bytes are used directly
+// as the hash. Erasure shifts subsequent entries backwards rather than leaving
+// tombstones, so only |Reserve()| ever allocates memory.
+//
+// Thread-compatible.
+class DigestIndex {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(DigestIndex);
+    explicit DigestIndex(NodeFinder* finder);
+    ~DigestIndex();
+
+    // Removes all entries, retaining the current capacity.
+    void Reset();
+
+    // Ensures that up to |count| entries may be inserted without allocating.
+    zx_status_t Reserve(size_t count);
+
+    // Adds the inode at |node_index|, which must already hold its merkle root
+    // in the inode table.
+    //
+    // Returns ZX_ERR_ALREADY_EXISTS if a blob with the same merkle root is
+    // already indexed, or ZX_ERR_NO_SPACE if |Reserve()| has not provided
+    // room for another entry.
+    zx_status_t Insert(uint32_t node_index);
+
+    // Places the index of the inode holding |digest| in |out|.
+    //
+    // Returns ZX_ERR_NOT_FOUND if no such blob is indexed.
+    zx_status_t Lookup(const uint8_t* digest, uint32_t* out) const;
+
+    // Removes the blob with merkle root |digest|.
+    //
+    // Returns ZX_ERR_NOT_FOUND if no such blob is indexed.
+    zx_status_t Erase(const uint8_t* digest);
+
+    size_t size() const { return size_; }
+
+private:
+    static constexpr uint32_t kEmptySlot = UINT32_MAX;
+
+    size_t SlotFor(const uint8_t* digest) const;
+    const uint8_t* KeyAt(size_t slot) const;
+
+    // Finds the slot holding |digest|, or the empty slot which terminates its
+    // probe sequence.
+    size_t Probe(const uint8_t* digest) const;
+
+    NodeFinder* finder_;
+    fbl::Array<uint32_t> slots_;
+    size_t size_ = 0;
+};
+
+} // namespace blobfs
@@ -13,25 +13,47 @@
 #include <blobfs/host.h>
 #endif
 
+#include <atomic>
+
 namespace blobfs {
 
+struct FsckOptions {
+    // If false, only the consistency of the inode table and the allocation
+    // bitmaps is checked; the (much slower) merkle verification of every blob
+    // is skipped.
+    bool verify_blobs = true;
+};
+
 class BlobfsChecker {
 public:
     BlobfsChecker();
     void Init(fbl::unique_ptr<Blobfs> vnode);
     void TraverseInodeBitmap();
     void TraverseBlockBitmap();
+
+    // Verifies the contents of every allocated blob. On Fuchsia, blobs are
+    // verified by several threads at once.
+    void VerifyBlobs();
+
     zx_status_t CheckAllocatedCounts() const;
 
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(BlobfsChecker);
+
+    static int VerifyThread(void* arg);
+
+    // Verifies blobs until every inode has been claimed through |next_node_|.
+    void VerifyNextBlobs();
+
     fbl::unique_ptr<Blobfs> blobfs_;
     uint32_t alloc_inodes_;
     uint32_t alloc_blocks_;
     uint32_t error_blobs_;
     uint32_t inode_blocks_;
+    std::atomic<uint32_t> next_node_;
+    std::atomic<uint32_t> corrupt_blobs_;
 };
 
-zx_status_t Fsck(fbl::unique_ptr<Blobfs> vnode);
+zx_status_t Fsck(fbl::unique_ptr<Blobfs> vnode, const FsckOptions& options = FsckOptions());
 
 } // namespace blobfs
@@ -45,6 +45,8 @@ constexpr uint64_t kEntryCommitMagic = 0x7472696369612331ULL;
 // deleted from the journal. At each step a callback is invoked to update the state of the entry to
 // reflect the success of the operation. Some entries are "sync" entries, which have no associated
 // journal data, and are only invoked once all entries queued before them have been fully processed.
+// Until the work which writes an entry to the journal has been enqueued, further transactions may
+// be merged into it, so that they are committed together.
 class JournalEntry : public fbl::SinglyLinkedListable<fbl::unique_ptr<JournalEntry>>  {
 public:
     DISALLOW_COPY_ASSIGN_AND_MOVE(JournalEntry);
@@ -62,7 +64,7 @@ public:
     }
 
     // Returns the number of blocks this entry will take up in the journal.
-    size_t BlockCount() {
+    size_t BlockCount() const {
         if (commit_index_ == header_index_) {
             return 0;
         }
@@ -70,6 +72,19 @@ public:
         return block_count_ + kEntryMetadataBlocks;
     }
 
+    // Returns the number of transactions merged into this entry.
+    size_t WorkCount() const { return work_count_; }
+
+    // Returns true if |blocks| more data blocks fit within this entry.
+    bool HasSpaceFor(size_t blocks) const {
+        return block_count_ + blocks <= kMaxEntryDataBlocks;
+    }
+
+    // Appends the transactions in |work| to this entry. The data for |work| must already be copied
+    // into the journal buffer immediately following the entry's existing data, and |commit_index|
+    // is the index of the block following it.
+    void Merge(fbl::unique_ptr<WritebackWork> work, uint64_t commit_index);
+
     // Returns the WritebackWork this entry represents.
     // Any WritebackWorks acquired via TakeWork() with callbacks referencing the entry must
     // be called while the entry is still alive, as the entry requires the result of these callbacks
@@ -116,9 +131,13 @@ public:
     const CommitBlock& GetCommitBlock() const { return commit_block_; }
 
 private:
+    // Copies the target blocks of all requests in |work| into the header block.
+    void AddTargetBlocks(WritebackWork* work);
+
     JournalBase* journal_; // Pointer to the journal containing this entry.
     std::atomic<uint32_t> status_; // Current EntryStatus. Accessed by multiple threads.
     uint32_t block_count_; // Number of blocks in the entry (not including header/commit).
+    uint32_t work_count_; // Number of transactions merged into the entry.
 
     // Contents of the start and commit blocks for this journal entry.
     HeaderBlock header_block_;
@@ -164,6 +183,9 @@ public:
     // Enqueues transactions from the entry buffer to the blobfs writeback queue.
     // Verifies the transactions and sets the buffer if necessary.
     virtual zx_status_t EnqueueEntryWork(fbl::unique_ptr<WritebackWork> work) = 0;
+
+    // Records that |entry| has been committed to the on-disk journal.
+    virtual void UpdateCommitMetrics(const JournalEntry& entry) = 0;
 };
 
 // Journal which manages the in-memory journal (and background thread, which handles writing
@@ -177,8 +199,14 @@ public:
 //    containing sync callbacks will go through the same queues as regular entries from here on
 //    out, but nothing will be done with them until step 7.
 //
-// 2. The JournalThread will write the transaction data to its buffer, and send work to the
-//    WritebackBuffer queue with transactions intended to write the journal entry out to disk.
+// 2. The transaction data is copied into the journal's buffer. If the most recent entry is still
+//    open and has room, the transaction is merged into that entry (group commit), so that
+//    consecutive transactions share one header, commit block and journal write. Otherwise the open
+//    entry is closed and a new entry is created. Closing an entry sends work to the WritebackBuffer
+//    queue to write it out to the on-disk journal. The entry is closed when the next entry is
+//    created, when data is enqueued directly to the writeback queue, or when the JournalThread
+//    picks it up, whichever comes first. This keeps journal writes ordered ahead of any data
+//    written after them, which may reuse blocks freed by the journaled transactions.
 //    However, the header and commit blocks will not yet be written out to the buffer, so the work
 //    will block the writeback queue (not allowing any more writes to go through) until it is ready.
 //
@@ -230,6 +258,11 @@ public:
     // An error will be returned if the journal is currently in read only mode.
     zx_status_t Enqueue(fbl::unique_ptr<WritebackWork> work);
 
+    // Closes the open entry, if any, enqueueing its journal write to the writeback queue. Must be
+    // called before writes which bypass the journal are enqueued, so that they are ordered after
+    // all transactions which have already been enqueued to the journal.
+    zx_status_t CloseEntry() __TA_EXCLUDES(lock_);
+
     // Asynchronously processes journal entries and updates journal state.
     void ProcessLoop();
 
@@ -260,6 +293,8 @@ public:
     // Verifies the transactions and sets the buffer if necessary.
     zx_status_t EnqueueEntryWork(fbl::unique_ptr<WritebackWork> work) final;
 
+    void UpdateCommitMetrics(const JournalEntry& entry) final;
+
 private:
     // The waiter struct may be used as a stack-allocated queue for producers.
     // It allows them to take turns putting data into the buffer when it is
@@ -286,6 +321,11 @@ private:
     // end of the circular buffer). The entry in the buffer itself may not be ready at this point.
     void PrepareWork(JournalEntry* entry, fbl::unique_ptr<WritebackWork>* work);
 
+    // Enqueues the work which writes |open_entry_| to the journal, after which no further
+    // transactions may be merged into it. If this fails, the journal enters a read only state;
+    // the entry is moved to an error state once the writeback queue completes its work.
+    zx_status_t CloseEntryLocked() __TA_REQUIRES(lock_);
+
     // Returns the block at |index| within the buffer as a journal entry header block.
     HeaderBlock* GetHeaderBlock(uint64_t index) {
         return reinterpret_cast<HeaderBlock*>(entries_->MutableData(index));
@@ -381,6 +421,10 @@ private:
     // but not yet persisted to the journal on disk.
     EntryQueue work_queue_ __TA_GUARDED(lock_);
 
+    // The most recently created entry in |work_queue_|, if it has not yet been closed.
+    // Subsequent transactions may be merged into this entry.
+    JournalEntry* open_entry_ __TA_GUARDED(lock_) = nullptr;
+
     // Ensures that if multiple producers are waiting for space to write their
     // entries into the entry buffer, they can each write in-order.
     ProducerQueue producer_queue_ __TA_GUARDED(lock_);
@@ -444,8 +488,8 @@ public:
     }
 
     void EnqueueWork() {
-        if (work_ != nullptr) {
-            journal_->EnqueueEntryWork(std::move(work_));
+        if (work_ != nullptr && journal_->EnqueueEntryWork(std::move(work_)) != ZX_OK) {
+            error_ = true;
         }
     }
 
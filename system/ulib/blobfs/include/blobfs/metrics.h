@@ -51,6 +51,12 @@ public:
     // to the underlying storage driver.
     void UpdateWriteback(uint64_t size, const fs::Duration& duration);
 
+    // Updates aggregate information about journal entries committed to the
+    // on-disk journal, each of which may batch several transactions.
+    // |duration| is the time from creating the entry until it was committed.
+    void UpdateJournalCommit(uint64_t transactions, uint64_t blocks,
+                             const fs::Duration& duration);
+
     // Updates aggregate information about reading blobs from storage
     // since mounting.
     void UpdateMerkleDiskRead(uint64_t size, const fs::Duration& duration);
@@ -90,6 +96,15 @@ private:
     zx::ticks total_writeback_time_ticks_ = {};
     uint64_t total_writeback_bytes_written_ = 0;
 
+    // JOURNAL STATS
+
+    // Entries written to the journal, and the transactions batched into them.
+    uint64_t journal_entries_committed_ = 0;
+    uint64_t journal_transactions_committed_ = 0;
+    // Includes the header and commit blocks of each entry.
+    uint64_t journal_blocks_committed_ = 0;
+    zx::ticks total_journal_commit_time_ticks_ = {};
+
     // LOOKUP STATS
 
     // Total time waiting for reads from disk.
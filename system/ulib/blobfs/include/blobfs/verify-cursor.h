@@ -0,0 +1,54 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <blobfs/format.h>
+#include <blobfs/iterator/extent-iterator.h>
+#include <fbl/function.h>
+#include <zircon/types.h>
+
+namespace blobfs {
+
+// Walks the inode table one blob at a time on behalf of background verification, wrapping
+// around to the start each time it passes the end, and counts the blobs verified during
+// each full pass.
+// Thread-compatible.
+class VerifyCursor {
+public:
+    // The blobs verified during one pass over the inode table.
+    struct Pass {
+        uint32_t blobs = 0;
+        uint32_t corrupt = 0;
+    };
+
+    // Returns true if the blob should not be verified.
+    using SkipCallback = fbl::Function<bool(const Inode& inode)>;
+
+    // Advances to the next blob among the first |inode_count| nodes of |finder| for which
+    // |skip| returns false, and returns its index in |out|. Each node is examined at most
+    // once per call: returns false if none of them is a blob to verify.
+    bool Next(NodeFinder* finder, uint32_t inode_count, const SkipCallback& skip,
+              uint32_t* out);
+
+    // Records the result of verifying the blob last returned by |Next()|.
+    void Record(zx_status_t status);
+
+    // Returns the number of passes over the inode table completed.
+    uint64_t passes() const { return passes_; }
+
+    // Returns the blobs verified during the last pass completed.
+    const Pass& last_pass() const { return last_pass_; }
+
+private:
+    // The next node to examine.
+    uint32_t next_node_ = 0;
+    uint64_t passes_ = 0;
+    Pass pass_;
+    Pass last_pass_;
+};
+
+} // namespace blobfs
@@ -95,6 +95,10 @@ public:
         vmoid_ = VMOID_INVALID;
     }
 
+    // Moves all requests from |txn| into this transaction. Both transactions must already be
+    // buffered within the same buffer; |txn| is left empty.
+    void MergeTransaction(WriteTxn* txn);
+
 protected:
     // Activates the transaction.
     zx_status_t Flush();
@@ -153,10 +157,21 @@ public:
     // and resets the WritebackWork to its initial state.
     zx_status_t Complete();
 
+    // Takes over the transactions of |work|, which must be buffered within the same buffer as
+    // this work. |work| is held until this work completes, at which point it is completed with
+    // the same status (including its sync callback and vnode sync flag).
+    void Merge(fbl::unique_ptr<WritebackWork> work);
+
 private:
+    using WorkList = fbl::SinglyLinkedList<fbl::unique_ptr<WritebackWork>>;
+
     // If a sync callback exists, call it with |status|.
     void InvokeSyncCallback(zx_status_t status);
 
+    // Completes all works previously merged into this one with |status|. If |flushed| is true,
+    // their transactions have been persisted to disk.
+    void CompleteMerged(zx_status_t status, bool flushed);
+
     // Delete any internal members that are no longer needed.
     void ResetInternal();
 
@@ -166,6 +181,9 @@ private:
 
     bool sync_;
     fbl::RefPtr<VnodeBlob> vn_;
+
+    // Works whose transactions have been merged into this one.
+    WorkList merged_;
 };
 
 // In-memory data buffer.
@@ -226,6 +244,13 @@ public:
         return (start_ + length_++) % capacity_;
     }
 
+    // Releases the most recently reserved index, so that it may be overwritten by the next
+    // transaction copied into the buffer.
+    void ReleaseIndex() {
+        ZX_DEBUG_ASSERT(length_ > 0);
+        length_--;
+    }
+
     // Returns data starting at block |index| in the buffer.
     void* MutableData(size_t index) {
         ZX_DEBUG_ASSERT(index < capacity_);
@@ -12,7 +12,7 @@
 
 namespace blobfs {
 
-// TODO(ZX-2415): Add tracing/metrics collection to journal related operations.
+// TODO(ZX-2415): Add tracing to journal related operations.
 
 // Thread which asynchronously processes journal entries.
 static int JournalThread(void* arg) {
@@ -24,7 +24,8 @@ static int JournalThread(void* arg) {
 JournalEntry::JournalEntry(JournalBase* journal, EntryStatus status, size_t header_index,
                            size_t commit_index, fbl::unique_ptr<WritebackWork> work)
         : journal_(journal), status_(static_cast<uint32_t>(status)), block_count_(0),
-          header_index_(header_index), commit_index_(commit_index), work_(std::move(work)) {
+          work_count_(0), header_index_(header_index), commit_index_(commit_index),
+          work_(std::move(work)) {
     if (status != EntryStatus::kInit) {
         // In the case of a sync request or error, return early.
         ZX_DEBUG_ASSERT(status == EntryStatus::kSync || status == EntryStatus::kError);
@@ -37,19 +38,11 @@ JournalEntry::JournalEntry(JournalBase* journal, EntryStatus status, size_t head
     ZX_DEBUG_ASSERT(work_->IsBuffered());
     ZX_DEBUG_ASSERT(work_blocks <= kMaxEntryDataBlocks);
 
-    // Copy all target blocks from the WritebackWork to the entry's header block.
-    for (size_t i = 0; i < work_->Requests().size(); i++) {
-        WriteRequest& request = work_->Requests()[i];
-        for (size_t j = request.dev_offset; j < request.dev_offset + request.length; j++) {
-            header_block_.target_blocks[block_count_++] = j;
-        }
-    }
-
+    AddTargetBlocks(work_.get());
     ZX_DEBUG_ASSERT(work_blocks == block_count_);
 
     // Set other information in the header/commit blocks.
     header_block_.magic = kEntryHeaderMagic;
-    header_block_.num_blocks = block_count_;
     header_block_.timestamp = zx_ticks_get();
     commit_block_.magic = kEntryCommitMagic;
     commit_block_.timestamp = header_block_.timestamp;
@@ -77,6 +70,30 @@ ReadyCallback JournalEntry::CreateReadyCallback() {
     };
 }
 
+void JournalEntry::Merge(fbl::unique_ptr<WritebackWork> work, uint64_t commit_index) {
+    ZX_DEBUG_ASSERT(GetStatus() == EntryStatus::kInit);
+    ZX_DEBUG_ASSERT(work->IsBuffered());
+    ZX_DEBUG_ASSERT(HasSpaceFor(work->BlkCount()));
+
+    AddTargetBlocks(work.get());
+    commit_index_ = commit_index;
+    work_->Merge(std::move(work));
+    ZX_DEBUG_ASSERT(work_->BlkCount() == block_count_);
+}
+
+void JournalEntry::AddTargetBlocks(WritebackWork* work) {
+    // Copy all target blocks from the WritebackWork to the entry's header block.
+    for (size_t i = 0; i < work->Requests().size(); i++) {
+        WriteRequest& request = work->Requests()[i];
+        for (size_t j = request.dev_offset; j < request.dev_offset + request.length; j++) {
+            header_block_.target_blocks[block_count_++] = j;
+        }
+    }
+
+    header_block_.num_blocks = block_count_;
+    work_count_++;
+}
+
 SyncCallback JournalEntry::CreateSyncCallback() {
     return [this] (zx_status_t result) {
         // Signal the journal that an entry is ready for processing.
@@ -301,6 +318,20 @@ zx_status_t Journal::Enqueue(fbl::unique_ptr<WritebackWork> work) {
         if (IsReadOnly()) {
             // The Journal is in a bad state and is no longer accepting new entries.
             status = ZX_ERR_BAD_STATE;
+        } else if (open_entry_ != nullptr && open_entry_->HasSpaceFor(blocks - 2)) {
+            // The most recent entry has not yet been sent to the writeback queue, so rather than
+            // creating a new entry, append this transaction to it. The new data overwrites the
+            // entry's commit block, which is moved to follow it.
+            entries_->ReleaseIndex();
+            entries_->CopyTransaction(work.get());
+            commit_index = entries_->ReserveIndex();
+            open_entry_->Merge(std::move(work), commit_index);
+
+            ZX_DEBUG_ASSERT(commit_index == (open_entry_->GetHeaderIndex() +
+                                             open_entry_->BlockCount() - 1) % entries_->capacity());
+
+            // The journal thread has already been signalled to process the entry.
+            return ZX_OK;
         } else {
             // Assign header index of journal entry to the next available value before we attempt to
             // copy the meat of the entry to the buffer.
@@ -322,25 +353,27 @@ zx_status_t Journal::Enqueue(fbl::unique_ptr<WritebackWork> work) {
         }
     }
 
+    // Before a new entry is created, the previous one must be closed so that their journal writes
+    // are enqueued in order.
+    zx_status_t close_status = CloseEntryLocked();
+    if (status == ZX_OK) {
+        status = close_status;
+    }
+
     // Create the journal entry and push it onto the work queue.
     fbl::unique_ptr<JournalEntry> entry = CreateEntry(header_index, commit_index, std::move(work));
 
-    if (entry->GetStatus() == EntryStatus::kInit) {
-        // If we have a non-sync work, there is some extra preparation we need to do.
-        if (status == ZX_OK) {
-            // Prepare a WritebackWork to write out the entry to disk. Note that this does not
-            // fully prepare the buffer for writeback, so a ready callback is added to the work as
-            // part of this step.
-            PrepareWork(entry.get(), &work);
-            ZX_DEBUG_ASSERT(work != nullptr);
-            status = EnqueueEntryWork(std::move(work));
-        } else {
-            // If the status is not okay (i.e. we are in a readonly state), do no additional
-            // processing but set the entry state to error.
-            entry->SetStatus(EntryStatus::kError);
-        }
+    if (entry->GetStatus() == EntryStatus::kInit && status != ZX_OK) {
+        // If the status is not okay (i.e. we are in a readonly state), do no additional
+        // processing but set the entry state to error.
+        entry->SetStatus(EntryStatus::kError);
     }
 
+    // Only a new data entry may absorb subsequent transactions. Otherwise, transactions enqueued
+    // after a sync request could be committed before the sync completes. The entry's journal write
+    // is enqueued once it is closed.
+    open_entry_ = (entry->GetStatus() == EntryStatus::kInit) ? entry.get() : nullptr;
+
     // Queue the entry to be processed asynchronously.
     work_queue_.push(std::move(entry));
 
@@ -349,6 +382,11 @@ zx_status_t Journal::Enqueue(fbl::unique_ptr<WritebackWork> work) {
     return status;
 }
 
+zx_status_t Journal::CloseEntry() {
+    fbl::AutoLock lock(&lock_);
+    return CloseEntryLocked();
+}
+
 void Journal::SendSignalLocked(zx_status_t status) {
     if (status == ZX_OK) {
         // Once writeback has entered a read only state, no further transactions should succeed.
@@ -402,6 +440,28 @@ void Journal::PrepareWork(JournalEntry* entry, fbl::unique_ptr<WritebackWork>* o
     *out = std::move(work);
 }
 
+zx_status_t Journal::CloseEntryLocked() {
+    if (open_entry_ == nullptr) {
+        return ZX_OK;
+    }
+
+    // Prepare a WritebackWork to write out the entry to disk. Note that this does not fully
+    // prepare the buffer for writeback, so a ready callback is added to the work as part of
+    // this step.
+    fbl::unique_ptr<WritebackWork> work;
+    PrepareWork(open_entry_, &work);
+    ZX_DEBUG_ASSERT(work != nullptr);
+    open_entry_ = nullptr;
+
+    zx_status_t status = EnqueueEntryWork(std::move(work));
+    if (status != ZX_OK) {
+        // The writeback queue still completes the work with an error, which moves the entry to
+        // an error state. No further transactions may be committed.
+        state_ = WritebackState::kReadOnly;
+    }
+    return status;
+}
+
 void Journal::ProcessEntryResult(zx_status_t result, JournalEntry* entry) {
     fbl::AutoLock lock(&lock_);
     // Since it is possible for the entry to be deleted immediately after updating its status
@@ -472,7 +532,16 @@ fbl::unique_ptr<WritebackWork> Journal::CreateWork() {
 
 zx_status_t Journal::EnqueueEntryWork(fbl::unique_ptr<WritebackWork> work) {
     entries_->ValidateTransaction(work.get());
-    return blobfs_->EnqueueWork(std::move(work), EnqueueType::kData);
+    return blobfs_->EnqueueWork(std::move(work), EnqueueType::kWriteback);
+}
+
+void Journal::UpdateCommitMetrics(const JournalEntry& entry) {
+    BlobfsMetrics& metrics = blobfs_->LocalMetrics();
+    if (metrics.Collecting()) {
+        // The header timestamp is taken when the entry is created.
+        zx::ticks duration(zx_ticks_get() - entry.GetHeaderBlock().timestamp);
+        metrics.UpdateJournalCommit(entry.WorkCount(), entry.BlockCount(), duration);
+    }
 }
 
 bool Journal::VerifyEntryMetadata(size_t header_index, uint64_t last_timestamp, bool expect_valid) {
@@ -619,7 +688,7 @@ zx_status_t Journal::WriteInfo(uint64_t start, uint64_t length) {
 
     info_->AddTransaction(0, start_block_, 1, work.get());
     info_->ValidateTransaction(work.get());
-    return blobfs_->EnqueueWork(std::move(work), EnqueueType::kData);
+    return blobfs_->EnqueueWork(std::move(work), EnqueueType::kWriteback);
 }
 
 void Journal::EnsureSpaceLocked(size_t blocks) {
@@ -695,7 +764,13 @@ uint32_t Journal::GenerateChecksum(size_t header_index, size_t commit_index) {
 
 fbl::unique_ptr<JournalEntry> Journal::GetNextEntry() {
     fbl::AutoLock lock(&lock_);
-    return work_queue_.pop();
+    fbl::unique_ptr<JournalEntry> entry = work_queue_.pop();
+    if (entry.get() == open_entry_) {
+        // Once the journal thread has taken the entry, its contents are final. If enqueueing its
+        // journal write fails, the entry is moved to an error state by the writeback queue.
+        CloseEntryLocked();
+    }
+    return entry;
 }
 
 void Journal::ProcessQueues(JournalProcessor* processor) {
@@ -983,8 +1058,13 @@ ProcessResult JournalProcessor::ProcessWorkDefault(JournalEntry* entry) {
 ProcessResult JournalProcessor::ProcessWaitDefault(JournalEntry* entry) {
     EntryStatus last_status = entry->SetStatus(EntryStatus::kWaiting);
     ZX_DEBUG_ASSERT(last_status == EntryStatus::kPersisted);
+    journal_->UpdateCommitMetrics(*entry);
     fbl::unique_ptr<WritebackWork> work = entry->TakeWork();
-    journal_->EnqueueEntryWork(std::move(work));
+    if (journal_->EnqueueEntryWork(std::move(work)) != ZX_OK) {
+        // The writeback queue still completes the work, whose callback moves the entry to an
+        // error state. Until then, the entry is left waiting in the next queue.
+        error_ = true;
+    }
     return ProcessResult::kContinue;
 }
 
@@ -1024,7 +1104,9 @@ ProcessResult JournalProcessor::ProcessSyncComplete(JournalEntry* entry) {
 
     // Remove and enqueue the sync work.
     fbl::unique_ptr<WritebackWork> work = entry->TakeWork();
-    journal_->EnqueueEntryWork(std::move(work));
+    if (journal_->EnqueueEntryWork(std::move(work)) != ZX_OK) {
+        error_ = true;
+    }
 
     // The sync entry is complete; do not re-enqueue it.
     return ProcessResult::kRemove;
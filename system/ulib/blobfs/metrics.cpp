@@ -39,6 +39,12 @@ void BlobfsMetrics::Dump() const {
     FS_TRACE_INFO("  (Writeback Thread) Wrote %zu MB of data in %zu ms\n",
                   total_writeback_bytes_written_ / mb,
                   TicksToMs(total_writeback_time_ticks_));
+    FS_TRACE_INFO("Journal Info:\n");
+    FS_TRACE_INFO("  Committed %zu transactions in %zu entries (%zu blocks)\n",
+                  journal_transactions_committed_, journal_entries_committed_,
+                  journal_blocks_committed_);
+    FS_TRACE_INFO("  Spent %zu ms waiting for entries to commit\n",
+                  TicksToMs(total_journal_commit_time_ticks_));
     FS_TRACE_INFO("Lookup Info:\n");
     FS_TRACE_INFO("  Opened %zu blobs (%zu MB)\n", blobs_opened_,
                   blobs_opened_total_size_ / mb);
@@ -84,6 +90,16 @@ void BlobfsMetrics::UpdateWriteback(uint64_t size, const fs::Duration& duration)
     }
 }
 
+void BlobfsMetrics::UpdateJournalCommit(uint64_t transactions, uint64_t blocks,
+                                        const fs::Duration& duration) {
+    if (Collecting()) {
+        journal_entries_committed_++;
+        journal_transactions_committed_ += transactions;
+        journal_blocks_committed_ += blocks;
+        total_journal_commit_time_ticks_ += duration;
+    }
+}
+
 void BlobfsMetrics::UpdateMerkleDiskRead(uint64_t size, const fs::Duration& duration) {
     if (Collecting()) {
         total_read_from_disk_time_ticks_ += duration;
@@ -32,10 +32,12 @@ COMMON_TARGET_SRCS := \
     $(LOCAL_DIR)/blob-cache.cpp \
     $(LOCAL_DIR)/blobfs.cpp \
     $(LOCAL_DIR)/cache-node.cpp \
+    $(LOCAL_DIR)/digest-index.cpp \
     $(LOCAL_DIR)/iterator/node-populator.cpp \
     $(LOCAL_DIR)/journal.cpp \
     $(LOCAL_DIR)/metrics.cpp \
     $(LOCAL_DIR)/rpc.cpp \
+    $(LOCAL_DIR)/verify-cursor.cpp \
     $(LOCAL_DIR)/vnode.cpp \
     $(LOCAL_DIR)/writeback.cpp \
 
@@ -99,6 +101,7 @@ MODULE_SRCS := \
     $(TEST_DIR)/allocator-test.cpp \
     $(TEST_DIR)/blob-cache-test.cpp \
     $(TEST_DIR)/compressor-test.cpp \
+    $(TEST_DIR)/digest-index-test.cpp \
     $(TEST_DIR)/extent-reserver-test.cpp \
     $(TEST_DIR)/journal-test.cpp \
     $(TEST_DIR)/main.cpp \
@@ -106,6 +109,7 @@ MODULE_SRCS := \
     $(TEST_DIR)/node-reserver-test.cpp \
     $(TEST_DIR)/utils.cpp \
     $(TEST_DIR)/vector-extent-iterator-test.cpp \
+    $(TEST_DIR)/verify-cursor-test.cpp \
 
 MODULE_STATIC_LIBS := $(TARGET_MODULE_STATIC_LIBS)
 
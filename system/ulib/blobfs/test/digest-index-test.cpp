@@ -0,0 +1,206 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <blobfs/digest-index.h>
+#include <blobfs/format.h>
+#include <digest/digest.h>
+#include <fbl/array.h>
+#include <unittest/unittest.h>
+
+namespace blobfs {
+namespace {
+
+using digest::Digest;
+
+constexpr uint32_t kNodeCount = 256;
+
+// A node map which lets tests choose the merkle root of each node.
+class MockNodeFinder : public NodeFinder {
+public:
+    MockNodeFinder() : nodes_(new Inode[kNodeCount](), kNodeCount) {}
+
+    Inode* GetNode(uint32_t node_index) final {
+        ZX_ASSERT(node_index < nodes_.size());
+        return &nodes_[node_index];
+    }
+
+    // Gives |node_index| a merkle root whose leading (hashed) bytes are |hash|, with the
+    // remainder derived from |node_index| so that roots are distinct.
+    void SetDigest(uint32_t node_index, uint64_t hash) {
+        uint8_t* digest = GetNode(node_index)->merkle_root_hash;
+        memset(digest, 0, Digest::kLength);
+        memcpy(digest, &hash, sizeof(hash));
+        memcpy(&digest[sizeof(hash)], &node_index, sizeof(node_index));
+    }
+
+    const uint8_t* GetDigest(uint32_t node_index) {
+        return GetNode(node_index)->merkle_root_hash;
+    }
+
+private:
+    fbl::Array<Inode> nodes_;
+};
+
+bool NullTest() {
+    BEGIN_TEST;
+
+    MockNodeFinder finder;
+    finder.SetDigest(0, 0);
+    DigestIndex index(&finder);
+
+    uint32_t node_index;
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, index.Lookup(finder.GetDigest(0), &node_index));
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, index.Erase(finder.GetDigest(0)));
+    // Without a reservation, there is no room for any entries.
+    EXPECT_EQ(ZX_ERR_NO_SPACE, index.Insert(0));
+    EXPECT_EQ(0, index.size());
+
+    END_TEST;
+}
+
+bool InsertLookupEraseTest() {
+    BEGIN_TEST;
+
+    MockNodeFinder finder;
+    DigestIndex index(&finder);
+    ASSERT_EQ(ZX_OK, index.Reserve(2));
+
+    finder.SetDigest(3, 0x1234);
+    finder.SetDigest(7, 0x5678);
+    ASSERT_EQ(ZX_OK, index.Insert(3));
+    ASSERT_EQ(ZX_OK, index.Insert(7));
+    EXPECT_EQ(2, index.size());
+
+    finder.SetDigest(9, 0x9abc);
+    uint32_t node_index;
+    ASSERT_EQ(ZX_OK, index.Lookup(finder.GetDigest(3), &node_index));
+    EXPECT_EQ(3, node_index);
+    ASSERT_EQ(ZX_OK, index.Lookup(finder.GetDigest(7), &node_index));
+    EXPECT_EQ(7, node_index);
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, index.Lookup(finder.GetDigest(9), &node_index));
+
+    // A second node holding an indexed merkle root is a duplicate.
+    memcpy(finder.GetNode(9)->merkle_root_hash, finder.GetDigest(3), Digest::kLength);
+    ASSERT_EQ(ZX_OK, index.Erase(finder.GetDigest(7)));
+    EXPECT_EQ(ZX_ERR_ALREADY_EXISTS, index.Insert(9));
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, index.Lookup(finder.GetDigest(7), &node_index));
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, index.Erase(finder.GetDigest(7)));
+    EXPECT_EQ(1, index.size());
+
+    index.Reset();
+    EXPECT_EQ(0, index.size());
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, index.Lookup(finder.GetDigest(3), &node_index));
+    EXPECT_EQ(ZX_OK, index.Insert(7));
+
+    END_TEST;
+}
+
+// Reserving more room rehashes existing entries.
+bool ReserveTest() {
+    BEGIN_TEST;
+
+    MockNodeFinder finder;
+    DigestIndex index(&finder);
+    ASSERT_EQ(ZX_OK, index.Reserve(1));
+    for (uint32_t i = 0; i < kNodeCount; i++) {
+        finder.SetDigest(i, i * 0x9E3779B97F4A7C15ULL);
+        ASSERT_EQ(ZX_OK, index.Reserve(i + 1));
+        ASSERT_EQ(ZX_OK, index.Insert(i));
+    }
+    EXPECT_EQ(kNodeCount, index.size());
+
+    for (uint32_t i = 0; i < kNodeCount; i++) {
+        uint32_t node_index;
+        ASSERT_EQ(ZX_OK, index.Lookup(finder.GetDigest(i), &node_index));
+        EXPECT_EQ(i, node_index);
+    }
+
+    END_TEST;
+}
+
+// Erasing entries from the middle of a probe sequence, including one which wraps around the
+// end of the table, must not hide the entries behind them.
+bool CollisionTest() {
+    BEGIN_TEST;
+
+    MockNodeFinder finder;
+    DigestIndex index(&finder);
+    ASSERT_EQ(ZX_OK, index.Reserve(kNodeCount));
+
+    // All nodes hash to one of four adjacent slots at the end of the table.
+    for (uint32_t i = 0; i < kNodeCount; i++) {
+        finder.SetDigest(i, UINT64_MAX - (i % 4));
+        ASSERT_EQ(ZX_OK, index.Insert(i));
+    }
+    for (uint32_t i = 0; i < kNodeCount; i += 3) {
+        ASSERT_EQ(ZX_OK, index.Erase(finder.GetDigest(i)));
+    }
+    for (uint32_t i = 0; i < kNodeCount; i++) {
+        uint32_t node_index;
+        if (i % 3 == 0) {
+            EXPECT_EQ(ZX_ERR_NOT_FOUND, index.Lookup(finder.GetDigest(i), &node_index));
+        } else {
+            ASSERT_EQ(ZX_OK, index.Lookup(finder.GetDigest(i), &node_index));
+            EXPECT_EQ(i, node_index);
+        }
+    }
+
+    END_TEST;
+}
+
+// Compare the index against a trivial model under a random sequence of operations.
+bool RandomTest() {
+    BEGIN_TEST;
+
+    MockNodeFinder finder;
+    DigestIndex index(&finder);
+    ASSERT_EQ(ZX_OK, index.Reserve(kNodeCount));
+
+    unsigned int seed = 0;
+    bool present[kNodeCount] = {};
+    size_t count = 0;
+    for (uint32_t i = 0; i < kNodeCount; i++) {
+        // Restrict the hashes to force long, overlapping probe sequences.
+        finder.SetDigest(i, rand_r(&seed) % 64);
+    }
+    for (size_t iteration = 0; iteration < 10000; iteration++) {
+        uint32_t i = rand_r(&seed) % kNodeCount;
+        if (present[i]) {
+            ASSERT_EQ(ZX_OK, index.Erase(finder.GetDigest(i)));
+            present[i] = false;
+            count--;
+        } else {
+            ASSERT_EQ(ZX_OK, index.Insert(i));
+            present[i] = true;
+            count++;
+        }
+        ASSERT_EQ(count, index.size());
+
+        uint32_t j = rand_r(&seed) % kNodeCount;
+        uint32_t node_index;
+        zx_status_t status = index.Lookup(finder.GetDigest(j), &node_index);
+        if (present[j]) {
+            ASSERT_EQ(ZX_OK, status);
+            ASSERT_EQ(j, node_index);
+        } else {
+            ASSERT_EQ(ZX_ERR_NOT_FOUND, status);
+        }
+    }
+
+    END_TEST;
+}
+
+} // namespace
+} // namespace blobfs
+
+BEGIN_TEST_CASE(blobfsDigestIndexTests)
+RUN_TEST(blobfs::NullTest)
+RUN_TEST(blobfs::InsertLookupEraseTest)
+RUN_TEST(blobfs::ReserveTest)
+RUN_TEST(blobfs::CollisionTest)
+RUN_TEST(blobfs::RandomTest)
+END_TEST_CASE(blobfsDigestIndexTests);
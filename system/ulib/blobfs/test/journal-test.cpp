@@ -12,7 +12,7 @@ namespace {
 // functionality.
 class FakeJournal : public JournalBase {
 public:
-    FakeJournal() : readonly_(false), capacity_(0) {}
+    FakeJournal() : readonly_(false), capacity_(0), enqueue_status_(ZX_OK) {}
 
     ~FakeJournal() {
         // On destruction, clean up work_queue_ entries.
@@ -47,6 +47,11 @@ public:
         return work_queue_.pop();
     }
 
+    // Sets the status returned by subsequent calls to EnqueueEntryWork.
+    void SetEnqueueStatus(zx_status_t status) {
+        enqueue_status_ = status;
+    }
+
 private:
     using WorkQueue = fs::Queue<fbl::unique_ptr<WritebackWork>>;
 
@@ -66,15 +71,18 @@ private:
     // JournalProcessor.
     void PrepareBuffer(JournalEntry* entry) final {}
     void PrepareDelete(JournalEntry* entry, WritebackWork* work) final {}
+    void UpdateCommitMetrics(const JournalEntry& entry) final {}
 
-    // Stores the WritebackWork in work_queue_;
+    // Stores the WritebackWork in work_queue_. Like the writeback queue, the work is stored even
+    // if an error is returned, so that it is still completed.
     zx_status_t EnqueueEntryWork(fbl::unique_ptr<WritebackWork> work) final {
         work_queue_.push(std::move(work));
-        return ZX_OK;
+        return enqueue_status_;
     }
 
     bool readonly_;
     size_t capacity_;
+    zx_status_t enqueue_status_;
 
     // Enqueued entry works are stored here.
     WorkQueue work_queue_;
@@ -189,10 +197,102 @@ static bool JournalProcessorResetWorkTest() {
     END_TEST;
 }
 
+static bool JournalEntryMergeTest() {
+    BEGIN_TEST;
+    // Create a dummy journal and journal processor.
+    FakeJournal journal;
+    JournalProcessor processor(&journal);
+
+    // Create an entry, and merge a second transaction into it.
+    fbl::unique_ptr<JournalEntry> entry(
+        new JournalEntry(&journal, EntryStatus::kInit, 0, 2, journal.CreateBufferedWork(1)));
+    fbl::unique_ptr<WritebackWork> merged_work = journal.CreateBufferedWork(2);
+    bool merged_completed = false;
+    merged_work->SetSyncCallback([&merged_completed](zx_status_t status) {
+        merged_completed = (status == ZX_OK);
+    });
+
+    ASSERT_TRUE(entry->HasSpaceFor(2));
+    ASSERT_FALSE(entry->HasSpaceFor(kMaxEntryDataBlocks));
+    entry->Merge(std::move(merged_work), 4);
+
+    // Both transactions are committed by a single header and commit block.
+    EXPECT_EQ(2, entry->WorkCount());
+    EXPECT_EQ(5, entry->BlockCount());
+    EXPECT_EQ(0, entry->GetHeaderIndex());
+    EXPECT_EQ(4, entry->GetCommitIndex());
+    EXPECT_EQ(3, entry->GetHeaderBlock().num_blocks);
+
+    // Both transactions are written to the journal by a single work.
+    fbl::unique_ptr<WritebackWork> work = journal.CreateDefaultWork();
+    work->SetSyncCallback(entry->CreateSyncCallback());
+    processor.ProcessWorkEntry(std::move(entry));
+
+    // Enqueue and process the processor's work.
+    processor.EnqueueWork();
+    journal.DequeueWork()->MarkCompleted(ZX_OK);
+    work->MarkCompleted(ZX_OK);
+
+    // Once committed, the entry issues a single write of both transactions to their final
+    // locations.
+    processor.ProcessWaitQueue();
+    work = journal.DequeueWork();
+    ASSERT_NE(work.get(), nullptr);
+    ASSERT_NULL(journal.DequeueWork());
+    EXPECT_EQ(3, work->BlkCount());
+
+    // Completing that write completes the merged transaction as well.
+    EXPECT_FALSE(merged_completed);
+    work->MarkCompleted(ZX_OK);
+    EXPECT_TRUE(merged_completed);
+
+    processor.ProcessDeleteQueue();
+    EXPECT_FALSE(processor.HasError());
+    EXPECT_EQ(5, processor.GetBlocksProcessed());
+    processor.EnqueueWork();
+    journal.DequeueWork()->MarkCompleted(ZX_OK);
+
+    processor.ProcessSyncQueue();
+    END_TEST;
+}
+
+static bool JournalProcessorEnqueueErrorTest() {
+    BEGIN_TEST;
+    // Create a dummy journal and journal processor.
+    FakeJournal journal;
+    JournalProcessor processor(&journal);
+
+    // Create and process a 'work' entry, and persist it to the journal.
+    fbl::unique_ptr<JournalEntry> entry(
+        new JournalEntry(&journal, EntryStatus::kInit, 0, 1, journal.CreateBufferedWork(1)));
+    fbl::unique_ptr<WritebackWork> work = journal.CreateDefaultWork();
+    work->SetSyncCallback(entry->CreateSyncCallback());
+    processor.ProcessWorkEntry(std::move(entry));
+    processor.EnqueueWork();
+    journal.DequeueWork()->MarkCompleted(ZX_OK);
+    work->MarkCompleted(ZX_OK);
+
+    // Fail to enqueue the write of the entry to its final location.
+    journal.SetEnqueueStatus(ZX_ERR_BAD_STATE);
+    processor.ProcessWaitQueue();
+    ASSERT_TRUE(processor.HasError());
+
+    // The entry waits for its work to be completed, which moves it to an error state.
+    processor.ProcessDeleteQueue();
+    ASSERT_FALSE(processor.IsEmpty());
+    journal.DequeueWork()->MarkCompleted(ZX_ERR_BAD_STATE);
+    processor.ProcessDeleteQueue();
+    processor.ProcessSyncQueue();
+    ASSERT_TRUE(processor.IsEmpty());
+    END_TEST;
+}
+
 } // namespace
 } // namespace blobfs
 
 BEGIN_TEST_CASE(blobfsJournalTests)
 RUN_TEST(blobfs::JournalEntryLifetimeTest)
 RUN_TEST(blobfs::JournalProcessorResetWorkTest)
+RUN_TEST(blobfs::JournalEntryMergeTest)
+RUN_TEST(blobfs::JournalProcessorEnqueueErrorTest)
 END_TEST_CASE(blobfsJournalTests);
@@ -0,0 +1,132 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <blobfs/format.h>
+#include <blobfs/iterator/extent-iterator.h>
+#include <blobfs/verify-cursor.h>
+#include <unittest/unittest.h>
+
+namespace blobfs {
+namespace {
+
+constexpr uint32_t kNodeCount = 8;
+
+// A trivial inode table.
+class TestNodes : public NodeFinder {
+public:
+    Inode* GetNode(uint32_t node_index) final {
+        return &nodes_[node_index];
+    }
+
+    void AddBlob(uint32_t node_index) {
+        nodes_[node_index].header.flags = kBlobFlagAllocated;
+    }
+
+    void AddContainer(uint32_t node_index) {
+        nodes_[node_index].header.flags = kBlobFlagAllocated | kBlobFlagExtentContainer;
+    }
+
+private:
+    Inode nodes_[kNodeCount] = {};
+};
+
+bool SkipNone(const Inode& inode) {
+    return false;
+}
+
+bool EmptyTableTest() {
+    BEGIN_TEST;
+
+    TestNodes nodes;
+    VerifyCursor cursor;
+    uint32_t node_index;
+    ASSERT_FALSE(cursor.Next(&nodes, kNodeCount, SkipNone, &node_index));
+    EXPECT_EQ(0u, cursor.passes());
+
+    // The next call starts a new pass, in which nothing is found either.
+    ASSERT_FALSE(cursor.Next(&nodes, kNodeCount, SkipNone, &node_index));
+    EXPECT_EQ(1u, cursor.passes());
+    EXPECT_EQ(0u, cursor.last_pass().blobs);
+
+    END_TEST;
+}
+
+bool SkipTest() {
+    BEGIN_TEST;
+
+    TestNodes nodes;
+    nodes.AddBlob(0);
+    nodes.AddContainer(2);
+    nodes.AddBlob(3);
+    nodes.AddBlob(4);
+    nodes.GetNode(3)->merkle_root_hash[0] = 1;
+    auto skip = [](const Inode& inode) { return inode.merkle_root_hash[0] == 1; };
+
+    // Free nodes, extent containers, and blobs which |skip| rejects are passed over.
+    VerifyCursor cursor;
+    uint32_t node_index;
+    ASSERT_TRUE(cursor.Next(&nodes, kNodeCount, skip, &node_index));
+    EXPECT_EQ(0u, node_index);
+    ASSERT_TRUE(cursor.Next(&nodes, kNodeCount, skip, &node_index));
+    EXPECT_EQ(4u, node_index);
+    ASSERT_TRUE(cursor.Next(&nodes, kNodeCount, skip, &node_index));
+    EXPECT_EQ(0u, node_index);
+    EXPECT_EQ(1u, cursor.passes());
+
+    END_TEST;
+}
+
+bool WraparoundTest() {
+    BEGIN_TEST;
+
+    TestNodes nodes;
+    nodes.AddBlob(2);
+    nodes.AddBlob(5);
+    nodes.AddBlob(7);
+
+    VerifyCursor cursor;
+    const uint32_t expected[] = {2, 5, 7};
+    for (uint64_t pass = 0; pass < 3; pass++) {
+        for (uint32_t expected_index : expected) {
+            uint32_t node_index;
+            ASSERT_TRUE(cursor.Next(&nodes, kNodeCount, SkipNone, &node_index));
+            EXPECT_EQ(expected_index, node_index);
+            // The first blob of each pass wraps the cursor around.
+            EXPECT_EQ(pass, cursor.passes());
+            // Only the first pass finds a corrupt blob.
+            cursor.Record(pass == 0 && node_index == 5 ? ZX_ERR_IO_DATA_INTEGRITY : ZX_OK);
+        }
+        if (pass > 0) {
+            EXPECT_EQ(3u, cursor.last_pass().blobs);
+            EXPECT_EQ(pass == 1 ? 1u : 0u, cursor.last_pass().corrupt);
+        }
+    }
+
+    // Nodes added to the table are picked up by the pass in progress.
+    uint32_t node_index;
+    ASSERT_TRUE(cursor.Next(&nodes, kNodeCount, SkipNone, &node_index));
+    EXPECT_EQ(2u, node_index);
+    EXPECT_EQ(3u, cursor.passes());
+    nodes.AddBlob(6);
+    ASSERT_TRUE(cursor.Next(&nodes, kNodeCount, SkipNone, &node_index));
+    EXPECT_EQ(5u, node_index);
+    ASSERT_TRUE(cursor.Next(&nodes, kNodeCount, SkipNone, &node_index));
+    EXPECT_EQ(6u, node_index);
+
+    // The cursor also wraps around when the table is smaller than it expects.
+    ASSERT_TRUE(cursor.Next(&nodes, 4, SkipNone, &node_index));
+    EXPECT_EQ(2u, node_index);
+    EXPECT_EQ(4u, cursor.passes());
+
+    END_TEST;
+}
+
+} // namespace
+} // namespace blobfs
+
+BEGIN_TEST_CASE(blobfsVerifyCursorTests)
+RUN_TEST(blobfs::EmptyTableTest)
+RUN_TEST(blobfs::SkipTest)
+RUN_TEST(blobfs::WraparoundTest)
+END_TEST_CASE(blobfsVerifyCursorTests);
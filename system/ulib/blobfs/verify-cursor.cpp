@@ -0,0 +1,42 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <blobfs/format.h>
+#include <blobfs/verify-cursor.h>
+#include <zircon/types.h>
+
+namespace blobfs {
+
+bool VerifyCursor::Next(NodeFinder* finder, uint32_t inode_count, const SkipCallback& skip,
+                        uint32_t* out) {
+    for (uint32_t examined = 0; examined < inode_count; examined++) {
+        if (next_node_ >= inode_count) {
+            next_node_ = 0;
+            passes_++;
+            last_pass_ = pass_;
+            pass_ = Pass();
+        }
+
+        uint32_t node_index = next_node_++;
+        const Inode* inode = finder->GetNode(node_index);
+        if (!inode->header.IsAllocated() || inode->header.IsExtentContainer() ||
+            skip(*inode)) {
+            continue;
+        }
+        *out = node_index;
+        return true;
+    }
+    return false;
+}
+
+void VerifyCursor::Record(zx_status_t status) {
+    pass_.blobs++;
+    if (status != ZX_OK) {
+        pass_.corrupt++;
+    }
+}
+
+} // namespace blobfs
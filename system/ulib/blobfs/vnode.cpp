@@ -494,10 +494,13 @@ zx_status_t VnodeBlob::WriteMetadata() {
         // Special case: Empty node.
         ZX_DEBUG_ASSERT(write_info_->node_indices.size() == 1);
         const ReservedNode& node = write_info_->node_indices[0];
+        *blobfs_->GetNode(node.index()) = inode_;
         blobfs_->GetAllocator()->MarkInodeAllocated(node);
         blobfs_->PersistNode(wb.get(), node.index());
     }
 
+    blobfs_->IndexBlob(map_index_);
+
     wb->SetSyncComplete();
     if ((status = blobfs_->EnqueueWork(std::move(wb), EnqueueType::kJournal)) != ZX_OK) {
         return status;
@@ -912,11 +915,10 @@ zx_status_t VnodeBlob::Lookup(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece name
     if ((status = digest.Parse(name.data(), name.length())) != ZX_OK) {
         return status;
     }
-    fbl::RefPtr<CacheNode> cache_node;
-    if ((status = Cache().Lookup(digest, &cache_node)) != ZX_OK) {
+    fbl::RefPtr<VnodeBlob> vnode;
+    if ((status = blobfs_->LookupBlob(digest, &vnode)) != ZX_OK) {
         return status;
     }
-    auto vnode = fbl::RefPtr<VnodeBlob>::Downcast(std::move(cache_node));
     blobfs_->LocalMetrics().UpdateLookup(vnode->SizeData());
     *out = std::move(vnode);
     return ZX_OK;
@@ -951,6 +953,12 @@ zx_status_t VnodeBlob::Create(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece name
         return status;
     }
 
+    // Blobs which have not been opened since mount are not in the cache, so the cache alone
+    // cannot reject duplicates.
+    if ((status = blobfs_->LookupBlob(digest, nullptr)) != ZX_ERR_NOT_FOUND) {
+        return status == ZX_OK ? ZX_ERR_ALREADY_EXISTS : status;
+    }
+
     fbl::RefPtr<VnodeBlob> vn = fbl::AdoptRef(new VnodeBlob(blobfs_, std::move(digest)));
     if ((status = Cache().Add(vn)) != ZX_OK) {
         return status;
@@ -1016,11 +1024,10 @@ zx_status_t VnodeBlob::Unlink(fbl::StringPiece name, bool must_be_dir) {
     if ((status = digest.Parse(name.data(), name.length())) != ZX_OK) {
         return status;
     }
-    fbl::RefPtr<CacheNode> cache_node;
-    if ((status = Cache().Lookup(digest, &cache_node)) != ZX_OK) {
+    fbl::RefPtr<VnodeBlob> vnode;
+    if ((status = blobfs_->LookupBlob(digest, &vnode)) != ZX_OK) {
         return status;
     }
-    auto vnode = fbl::RefPtr<VnodeBlob>::Downcast(std::move(cache_node));
     blobfs_->LocalMetrics().UpdateLookup(vnode->SizeData());
     return vnode->QueueUnlink();
 }
@@ -64,6 +64,19 @@ void WriteTxn::SetBuffer(vmoid_t vmoid) {
     vmoid_ = vmoid;
 }
 
+void WriteTxn::MergeTransaction(WriteTxn* txn) {
+    ZX_DEBUG_ASSERT(IsBuffered());
+    ZX_DEBUG_ASSERT(txn->CheckBuffer(vmoid_));
+
+    for (size_t i = 0; i < txn->requests_.size(); i++) {
+        requests_.push_back(txn->requests_[i]);
+    }
+    block_count_ += txn->block_count_;
+
+    txn->Reset();
+    txn->block_count_ = 0;
+}
+
 zx_status_t WriteTxn::Flush() {
     ZX_ASSERT(IsBuffered());
     fs::Ticker ticker(bs_->LocalMetrics().Collecting());
@@ -103,6 +116,7 @@ zx_status_t WriteTxn::Flush() {
 
 void WritebackWork::MarkCompleted(zx_status_t status) {
     WriteTxn::Reset();
+    CompleteMerged(status, false);
     InvokeSyncCallback(status);
     ResetInternal();
 }
@@ -138,6 +152,7 @@ void WritebackWork::SetSyncComplete() {
 // Returns the number of blocks of the writeback buffer that have been consumed
 zx_status_t WritebackWork::Complete() {
     zx_status_t status = Flush();
+    CompleteMerged(status, true);
 
     if (status == ZX_OK && sync_) {
         vn_->CompleteSync();
@@ -148,6 +163,12 @@ zx_status_t WritebackWork::Complete() {
     return status;
 }
 
+void WritebackWork::Merge(fbl::unique_ptr<WritebackWork> work) {
+    ZX_DEBUG_ASSERT(!work->ready_cb_);
+    MergeTransaction(work.get());
+    merged_.push_front(std::move(work));
+}
+
 WritebackWork::WritebackWork(Blobfs* bs, fbl::RefPtr<VnodeBlob> vn) :
     WriteTxn(bs), ready_cb_(nullptr), sync_cb_(nullptr), sync_(false), vn_(std::move(vn)) {}
 
@@ -157,6 +178,18 @@ void WritebackWork::InvokeSyncCallback(zx_status_t status) {
     }
 }
 
+void WritebackWork::CompleteMerged(zx_status_t status, bool flushed) {
+    while (!merged_.is_empty()) {
+        fbl::unique_ptr<WritebackWork> work = merged_.pop_front();
+        if (flushed && status == ZX_OK && work->sync_) {
+            work->vn_->CompleteSync();
+        }
+
+        work->InvokeSyncCallback(status);
+        work->ResetInternal();
+    }
+}
+
 void WritebackWork::ResetInternal() {
     sync_cb_ = nullptr;
     ready_cb_ = nullptr;
@@ -6,6 +6,11 @@
 
 #include <limits.h>
 #include <string.h>
+#if BOOTDATA_DECOMPRESS_THREADS
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <threads.h>
+#endif
 
 #include <zircon/boot/bootdata.h>
 #include <zircon/compiler.h>
@@ -21,6 +26,7 @@
 //  - No block checksums
 //  - Final content size must be included in frame header
 //  - Max block size is 64kB
+// The content may also be split across a series of frames.
 //
 //  See https://github.com/lz4/lz4/blob/dev/lz4_Frame_format.md for details.
 #define ZX_LZ4_MAGIC 0x184D2204
@@ -76,7 +82,9 @@ static zx_status_t check_lz4_frame(const lz4_frame_desc* fd,
         *err = "bad lz4 flag (reserved bits in bd must be zero)";
         return ZX_ERR_INVALID_ARGS;
     }
-    if (fd->content_size != expected) {
+    // The content may be split across several frames, each of which holds
+    // some of the bytes still expected.
+    if (fd->content_size > expected || (fd->content_size == 0 && expected > 0)) {
         *err = "lz4 content size does not match bootdata outsize";
         return ZX_ERR_INVALID_ARGS;
     }
@@ -85,89 +93,234 @@ static zx_status_t check_lz4_frame(const lz4_frame_desc* fd,
     return ZX_OK;
 }
 
-static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
-                                         size_t _outsize, zx_handle_t* out,
-                                         const char** err) {
-    if (*(const uint32_t*)data != ZX_LZ4_MAGIC) {
+// A frame of the content, which decompresses into its own part of the output.
+typedef struct {
+    // The size of the first block, followed by the block itself.
+    const uint8_t* blocks;
+    uint8_t* dst;
+    size_t size;
+} lz4_frame;
+
+// Checks the frame at |*data| and finds its blocks, and advances |*data|
+// past it.  |*expected| is the number of bytes of content still expected.
+static zx_status_t scan_lz4_frame(const uint8_t** data, size_t* expected,
+                                  lz4_frame* frame, const char** err) {
+    const uint8_t* src = *data;
+    if (*(const uint32_t*)src != ZX_LZ4_MAGIC) {
         *err = "bad magic number for compressed bootfs";
         return ZX_ERR_INVALID_ARGS;
     }
-    data += sizeof(uint32_t);
+    src += sizeof(uint32_t);
 
-    zx_status_t status = check_lz4_frame((const lz4_frame_desc*)data, _outsize, err);
+    const lz4_frame_desc* fd = (const lz4_frame_desc*)src;
+    zx_status_t status = check_lz4_frame(fd, *expected, err);
     if (status < 0)
         return status;
-    data += sizeof(lz4_frame_desc);
+    *expected -= fd->content_size;
+    frame->size = fd->content_size;
+    src += sizeof(lz4_frame_desc);
+    frame->blocks = src;
 
-    size_t outsize = (_outsize + 4095) & ~4095;
-    if (outsize < _outsize) {
-        // newsize wrapped, which means the outsize was too large
-        *err = "lz4 output size too large";
-        return ZX_ERR_NO_MEMORY;
-    }
-    zx_handle_t dst_vmo;
-    status = zx_vmo_create((uint64_t)outsize, 0, &dst_vmo);
-    if (status < 0) {
-        *err = "zx_vmo_create failed for decompressing bootfs";
-        return status;
-    }
-    zx_object_set_property(dst_vmo, ZX_PROP_NAME, "bootfs", 6);
+    // Skip over the blocks. Block sizes are 32 bits, and the high bit is
+    // set if the block is uncompressed.
+    uint32_t blocksize;
+    do {
+        blocksize = *(const uint32_t*)src;
+        src += sizeof(uint32_t) + (blocksize & 0x7fffffff);
+    } while (blocksize);
 
-    uintptr_t dst_addr = 0;
-    status = zx_vmar_map(vmar,
-            ZX_VM_PERM_READ|ZX_VM_PERM_WRITE,
-            0, dst_vmo, 0, outsize, &dst_addr);
-    if (status < 0) {
-        *err = "zx_vmar_map failed on bootfs vmo during decompression";
-        return status;
-    }
+    *data = src;
+    return ZX_OK;
+}
 
-    size_t remaining = outsize;
-    uint8_t* dst = (uint8_t*)dst_addr;
+// Decompresses the blocks of |frame| into |frame->dst|.
+static zx_status_t decompress_lz4_frame(const lz4_frame* frame, const char** err) {
+    const uint8_t* src = frame->blocks;
+    uint8_t* dst = frame->dst;
+    size_t remaining = frame->size;
 
     // Read each LZ4 block and decompress it. Block sizes are 32 bits.
-    uint32_t blocksize = *(const uint32_t*)data;
-    data += sizeof(uint32_t);
+    uint32_t blocksize = *(const uint32_t*)src;
+    src += sizeof(uint32_t);
     while (blocksize) {
         // If the data is uncompressed, the high bit is 1.
         if (blocksize >> 31) {
             uint32_t actual = blocksize & 0x7fffffff;
-            memcpy(dst, data, actual);
-            dst += actual;
-            data += actual;
-            if (remaining - actual > remaining) {
-                // Remaining wrapped around (would be negative if signed)
+            if (actual > remaining) {
                 *err = "bootdata outsize too small for lz4 decompression";
                 return ZX_ERR_INVALID_ARGS;
             }
+            memcpy(dst, src, actual);
+            dst += actual;
+            src += actual;
             remaining -= actual;
         } else {
-            int dcmp = LZ4_decompress_safe((const char*)data, (char*)dst, blocksize, remaining);
+            int dcmp = LZ4_decompress_safe((const char*)src, (char*)dst, blocksize,
+                                           remaining > INT_MAX ? INT_MAX : (int)remaining);
             if (dcmp < 0) {
                 *err = "lz4 decompression failed";
                 return ZX_ERR_BAD_STATE;
             }
             dst += dcmp;
-            data += blocksize;
-            if (remaining - dcmp > remaining) {
-                // Remaining wrapped around (would be negative if signed)
-                *err = "bootdata outsize too small for lz4 decompression";
-                return ZX_ERR_INVALID_ARGS;
-            }
+            src += blocksize;
             remaining -= dcmp;
         }
 
-        blocksize = *(uint32_t*)data;
-        data += sizeof(uint32_t);
+        blocksize = *(const uint32_t*)src;
+        src += sizeof(uint32_t);
     }
 
-    // Sanity check: verify that we didn't have more than one page leftover.
-    // The bootdata header should have specified the exact outsize needed, which
-    // we rounded up to the next full page.
-    if (remaining > 4095) {
+    if (remaining > 0) {
         *err = "bootdata size error; outsize does not match decompressed size";
         return ZX_ERR_INVALID_ARGS;
     }
+    return ZX_OK;
+}
+
+#if BOOTDATA_DECOMPRESS_THREADS
+
+// The frames of one payload, shared by the threads decompressing them.
+typedef struct {
+    const lz4_frame* frames;
+    size_t count;
+    atomic_size_t next;
+    // The first failure, if any.
+    atomic_flag failed;
+    zx_status_t status;
+    const char* err;
+} lz4_frame_work;
+
+static int decompress_lz4_frames_thread(void* arg) {
+    lz4_frame_work* work = arg;
+    size_t i;
+    while ((i = atomic_fetch_add(&work->next, 1)) < work->count) {
+        const char* err;
+        zx_status_t status = decompress_lz4_frame(&work->frames[i], &err);
+        if (status != ZX_OK) {
+            if (!atomic_flag_test_and_set(&work->failed)) {
+                work->status = status;
+                work->err = err;
+            }
+            // Leave the remaining frames undone.
+            atomic_store(&work->next, work->count);
+        }
+    }
+    return 0;
+}
+
+// Decompresses the frames at |data| into |dst|.  Every frame is found first,
+// and then they are spread across one thread per CPU.
+static zx_status_t decompress_lz4_frames(const uint8_t* data, uint8_t* dst,
+                                         size_t expected, const char** err) {
+    lz4_frame* frames = NULL;
+    size_t count = 0, capacity = 0;
+    zx_status_t status;
+    do {
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            lz4_frame* grown = realloc(frames, capacity * sizeof(*frames));
+            if (grown == NULL) {
+                free(frames);
+                *err = "out of memory for lz4 frames";
+                return ZX_ERR_NO_MEMORY;
+            }
+            frames = grown;
+        }
+        status = scan_lz4_frame(&data, &expected, &frames[count], err);
+        if (status < 0) {
+            free(frames);
+            return status;
+        }
+        frames[count].dst = dst;
+        dst += frames[count].size;
+        ++count;
+    } while (expected > 0);
+
+    lz4_frame_work work = {
+        .frames = frames,
+        .count = count,
+        .failed = ATOMIC_FLAG_INIT,
+        .status = ZX_OK,
+    };
+    atomic_init(&work.next, 0);
+
+    thrd_t threads[16];
+    size_t num_threads = zx_system_get_num_cpus();
+    if (num_threads > count)
+        num_threads = count;
+    if (num_threads > countof(threads) + 1)
+        num_threads = countof(threads) + 1;
+    size_t started = 0;
+    while (started + 1 < num_threads &&
+           thrd_create(&threads[started], decompress_lz4_frames_thread,
+                       &work) == thrd_success) {
+        ++started;
+    }
+    // This thread does its share, or all of the work if no thread started.
+    decompress_lz4_frames_thread(&work);
+    for (size_t i = 0; i < started; ++i) {
+        thrd_join(threads[i], NULL);
+    }
+
+    free(frames);
+    if (work.status != ZX_OK)
+        *err = work.err;
+    return work.status;
+}
+
+#else
+
+// Decompresses the frames at |data| into |dst|, one after another.  Userboot
+// has neither threads nor an allocator for a list of the frames.
+static zx_status_t decompress_lz4_frames(const uint8_t* data, uint8_t* dst,
+                                         size_t expected, const char** err) {
+    do {
+        lz4_frame frame;
+        zx_status_t status = scan_lz4_frame(&data, &expected, &frame, err);
+        if (status < 0)
+            return status;
+        frame.dst = dst;
+        status = decompress_lz4_frame(&frame, err);
+        if (status < 0)
+            return status;
+        dst += frame.size;
+    } while (expected > 0);
+    return ZX_OK;
+}
+
+#endif // BOOTDATA_DECOMPRESS_THREADS
+
+static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
+                                         size_t _outsize, zx_handle_t* out,
+                                         const char** err) {
+    size_t outsize = (_outsize + 4095) & ~4095;
+    if (outsize < _outsize) {
+        // newsize wrapped, which means the outsize was too large
+        *err = "lz4 output size too large";
+        return ZX_ERR_NO_MEMORY;
+    }
+    zx_handle_t dst_vmo;
+    zx_status_t status = zx_vmo_create((uint64_t)outsize, 0, &dst_vmo);
+    if (status < 0) {
+        *err = "zx_vmo_create failed for decompressing bootfs";
+        return status;
+    }
+    zx_object_set_property(dst_vmo, ZX_PROP_NAME, "bootfs", 6);
+
+    uintptr_t dst_addr = 0;
+    status = zx_vmar_map(vmar,
+            ZX_VM_PERM_READ|ZX_VM_PERM_WRITE,
+            0, dst_vmo, 0, outsize, &dst_addr);
+    if (status < 0) {
+        *err = "zx_vmar_map failed on bootfs vmo during decompression";
+        return status;
+    }
+
+    // Each frame must decompress to exactly its content size, and the
+    // content sizes of the frames must add up to the bootdata outsize.
+    status = decompress_lz4_frames(data, (uint8_t*)dst_addr, _outsize, err);
+    if (status < 0)
+        return status;
 
     status = zx_vmar_unmap(vmar, dst_addr, outsize);
     if (status < 0) {
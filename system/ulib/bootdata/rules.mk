@@ -10,6 +10,9 @@ MODULE_TYPE := userlib
 
 MODULE_COMPILEFLAGS += -fvisibility=hidden
 
+# Userboot builds decompress.c itself, without threads.
+MODULE_DEFINES := BOOTDATA_DECOMPRESS_THREADS=1
+
 MODULE_SRCS += $(LOCAL_DIR)/decompress.c
 
 MODULE_LIBS := \
@@ -101,24 +101,6 @@ void InitLazily(const MetricOptions& options, HistogramBucket* buckets, uint32_t
     InitBucketBuffer(buckets, num_buckets);
 }
 
-bool HistogramFlush(const RemoteMetricInfo& metric_info, Logger* logger,
-                    BaseCounter<uint64_t>* buckets, HistogramBucket* bucket_buffer,
-                    uint32_t num_buckets) {
-    // Sets every bucket back to 0, not all buckets will be at the same instant, but
-    // eventual consistency in the backend is good enough.
-    for (uint32_t bucket_index = 0; bucket_index < num_buckets; ++bucket_index) {
-        bucket_buffer[bucket_index].count = buckets[bucket_index].Exchange();
-    }
-    return logger->Log(metric_info, bucket_buffer, num_buckets);
-}
-
-void HistogramUndoFlush(BaseCounter<uint64_t>* buckets, HistogramBucket* bucket_buffer,
-                        uint32_t num_buckets) {
-    for (uint32_t bucket_index = 0; bucket_index < num_buckets; ++bucket_index) {
-        buckets[bucket_index].Increment(bucket_buffer[bucket_index].count);
-    }
-}
-
 } // namespace internal
 
 HistogramOptions::HistogramOptions(const HistogramOptions&) = default;
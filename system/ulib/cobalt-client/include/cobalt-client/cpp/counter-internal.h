@@ -7,9 +7,11 @@
 #include <atomic>
 #include <stdint.h>
 #include <unistd.h>
+#include <zircon/compiler.h>
 
 #include <cobalt-client/cpp/metric-options.h>
 #include <cobalt-client/cpp/types-internal.h>
+#include <fbl/algorithm.h>
 #include <fbl/function.h>
 #include <fbl/string.h>
 #include <fbl/vector.h>
@@ -19,14 +21,35 @@ namespace internal {
 // Note: Everything on this namespace is internal, no external users should rely
 // on the behaviour of any of these classes.
 
-// BaseCounter and RemoteCounter differ in that the first is simply a thin wrapper over
-// an atomic while the second provides Cobalt Fidl specific API and holds more metric related
-// data for a full fledged metric.
+// Number of shards each counter is split into.
+constexpr uint32_t kCounterShards = 8;
+
+// Shards are padded to a multiple of this size, so that no two shards of a counter share a
+// cache line.
+constexpr size_t kCounterShardSize = 64;
+
+// Returns the shard the calling thread updates. Threads are assigned shards round robin the first
+// time they update any counter.
+inline uint32_t GetCounterShard() {
+    static std::atomic<uint32_t> next_shard(0);
+    thread_local uint32_t shard = kCounterShards;
+    if (unlikely(shard == kCounterShards)) {
+        shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kCounterShards;
+    }
+    return shard;
+}
+
+// Collection of |num_counters| counters, each of which is split into |kCounterShards| shards.
+// Each thread only increments the shards of one shard index, so threads updating the same counter
+// do not bounce a cache line between them. Reading a counter sums its shards.
 //
-// Thin wrapper on top of an atomic, which provides a fixed memory ordering for all calls.
-// Calls are inlined to reduce overhead.A
-template <typename T>
-class BaseCounter {
+// Shards of the same index are laid out together, so a collection of counters (e.g. the buckets
+// of a histogram) needs a cache line per shard, not per counter and shard.
+//
+// This class is not copyable, moveable or assignable.
+// This class is thread-safe.
+template <typename T, uint32_t num_counters>
+class ShardedCounters {
 public:
     // Alias for the underlying counter type.
     using Type = T;
@@ -34,28 +57,86 @@ public:
     // All atomic operations use this memory order.
     static constexpr auto kMemoryOrder = std::memory_order_relaxed;
 
-    BaseCounter()
-        : counter_(0) {}
+    ShardedCounters() {
+        for (auto& shard : shards_) {
+            for (auto& counter : shard.counters) {
+                counter.store(0, kMemoryOrder);
+            }
+        }
+    }
+    ShardedCounters(const ShardedCounters&) = delete;
+    ShardedCounters(ShardedCounters&&) = delete;
+    ShardedCounters& operator=(const ShardedCounters&) = delete;
+    ShardedCounters& operator=(ShardedCounters&&) = delete;
+    ~ShardedCounters() = default;
+
+    // Increments the counter at |index| by |val|.
+    void Increment(uint32_t index, Type val) {
+        shards_[GetCounterShard()].counters[index].fetch_add(val, kMemoryOrder);
+    }
+
+    // Returns the current value of the counter at |index| and resets it to |val|. Every shard is
+    // exchanged atomically, so no increment is ever lost or seen twice, though increments which
+    // race with this call may be left for the next one.
+    Type Exchange(uint32_t index, Type val) {
+        Type sum = shards_[0].counters[index].exchange(val, kMemoryOrder);
+        for (uint32_t shard = 1; shard < kCounterShards; ++shard) {
+            sum += shards_[shard].counters[index].exchange(0, kMemoryOrder);
+        }
+        return sum;
+    }
+
+    // Returns the current value of the counter at |index|.
+    Type Load(uint32_t index) const {
+        Type sum = 0;
+        for (const auto& shard : shards_) {
+            sum += shard.counters[index].load(kMemoryOrder);
+        }
+        return sum;
+    }
+
+private:
+    static_assert(fbl::is_integral<Type>::value, "Can only count integral types");
+    static_assert(num_counters > 0, "num_counters must be positive.");
+
+    union Shard {
+        std::atomic<Type> counters[num_counters];
+        uint8_t padding[fbl::round_up(sizeof(std::atomic<Type>) * num_counters,
+                                      kCounterShardSize)];
+    };
+
+    Shard shards_[kCounterShards];
+};
+
+// BaseCounter and RemoteCounter differ in that the first is simply a thin wrapper over
+// a sharded atomic while the second provides Cobalt Fidl specific API and holds more metric
+// related data for a full fledged metric.
+//
+// Thin wrapper on top of a single sharded counter. Calls are inlined to reduce overhead.
+template <typename T>
+class BaseCounter {
+public:
+    // Alias for the underlying counter type.
+    using Type = T;
+
+    BaseCounter() = default;
     BaseCounter(const BaseCounter&) = delete;
-    BaseCounter(BaseCounter&& other)
-        : counter_(other.Exchange(0)) {}
+    BaseCounter(BaseCounter&& other) { counter_.Exchange(0, other.Exchange(0)); }
     BaseCounter& operator=(const BaseCounter&) = delete;
     BaseCounter& operator=(BaseCounter&&) = delete;
     ~BaseCounter() = default;
 
     // Increments |counter_| by |val|.
-    void Increment(Type val = 1) { counter_.fetch_add(val, kMemoryOrder); }
+    void Increment(Type val = 1) { counter_.Increment(0, val); }
 
     // Returns the current value of|counter_| and resets it to |val|.
-    Type Exchange(Type val = 0) { return counter_.exchange(val, kMemoryOrder); }
+    Type Exchange(Type val = 0) { return counter_.Exchange(0, val); }
 
     // Returns the current value of |counter_|.
-    Type Load() const { return counter_.load(kMemoryOrder); }
+    Type Load() const { return counter_.Load(0); }
 
 protected:
-    static_assert(fbl::is_integral<Type>::value, "Can only count integral types");
-
-    std::atomic<Type> counter_;
+    ShardedCounters<Type, 1> counter_;
 };
 
 // Counter which represents a standalone cobalt metric. Provides API for converting
@@ -44,17 +44,17 @@ public:
     void IncrementCount(Bucket bucket, Count val = 1) {
         ZX_DEBUG_ASSERT_MSG(bucket < size(), "IncrementCount bucket(%u) out of range(%u).", bucket,
                             size());
-        buckets_[bucket].Increment(val);
+        buckets_.Increment(bucket, val);
     }
 
     Count GetCount(uint32_t bucket) const {
         ZX_DEBUG_ASSERT_MSG(bucket < size(), "GetCount bucket out of range.");
-        return buckets_[bucket].Load();
+        return buckets_.Load(bucket);
     }
 
 protected:
     // Counter for the abs frequency of every histogram bucket.
-    BaseCounter<uint64_t> buckets_[num_buckets];
+    ShardedCounters<Count, num_buckets> buckets_;
 };
 
 // Free functions to move logic outside the templated class.
@@ -66,16 +66,6 @@ void InitBucketBuffer(HistogramBucket* buckets, uint32_t bucket_count);
 void InitLazily(const MetricOptions& options, HistogramBucket* buckets, uint32_t num_buckets,
                 RemoteMetricInfo* metric_info);
 
-// Sets the count of each bucket in |bucket_buffer| to the respective value in
-// |buckets|, and sets the count in |buckets| to 0.
-bool HistogramFlush(const RemoteMetricInfo& metric_info, Logger* logger,
-                    BaseCounter<uint64_t>* buckets, HistogramBucket* bucket_buffer,
-                    uint32_t num_buckets);
-
-// Undo's an ungoing Flush effects.
-void HistogramUndoFlush(BaseCounter<uint64_t>* buckets, HistogramBucket* bucket_buffer,
-                        uint32_t num_buckets);
-
 // This class provides a histogram which represents a full fledged cobalt metric. The histogram
 // owner will call |Flush| which is meant to incrementally persist data to cobalt.
 //
@@ -100,10 +90,19 @@ public:
     }
 
     bool Flush(Logger* logger) override {
-        return HistogramFlush(metric_info_, logger, this->buckets_, bucket_buffer_, num_buckets);
+        // Sets every bucket back to 0, not all buckets will be at the same instant, but
+        // eventual consistency in the backend is good enough.
+        for (uint32_t bucket_index = 0; bucket_index < num_buckets; ++bucket_index) {
+            bucket_buffer_[bucket_index].count = this->buckets_.Exchange(bucket_index, 0);
+        }
+        return logger->Log(metric_info_, bucket_buffer_, num_buckets);
     }
 
-    void UndoFlush() override { HistogramUndoFlush(this->buckets_, bucket_buffer_, num_buckets); }
+    void UndoFlush() override {
+        for (uint32_t bucket_index = 0; bucket_index < num_buckets; ++bucket_index) {
+            this->buckets_.Increment(bucket_index, bucket_buffer_[bucket_index].count);
+        }
+    }
 
     // Returns the metric_id associated with this remote metric.
     const RemoteMetricInfo& metric_info() const { return metric_info_; }
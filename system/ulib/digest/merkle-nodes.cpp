@@ -0,0 +1,220 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "merkle-nodes.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <digest/digest.h>
+#include <digest/merkle-tree.h>
+#include <zircon/assert.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+
+#include <atomic>
+#endif
+
+namespace digest {
+namespace internal {
+
+#if defined(__x86_64__)
+
+namespace {
+
+// A multi-buffer implementation of SHA-256: each 32-bit lane of a vector holds
+// the state of a different message, so that eight messages are hashed by one
+// instruction stream using AVX2.  All of the messages have the same length.
+typedef uint32_t Lanes __attribute__((vector_size(kNodeLanes * sizeof(uint32_t))));
+
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#define AVX2_INLINE __attribute__((target("avx2"), always_inline)) inline
+
+constexpr uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// The SHA-256 block size.
+constexpr size_t kBlockSize = 64;
+
+// Each node is hashed as |locality| (8 bytes), its length (4 bytes) and then
+// |kNodeSize| bytes of data.  The data is therefore offset within the SHA-256
+// blocks by |kPrefixSize|, and the final block holds the last |kPrefixSize|
+// bytes of data followed by the SHA-256 padding.
+constexpr size_t kPrefixSize = sizeof(uint64_t) + sizeof(uint32_t);
+constexpr size_t kMessageSize = kPrefixSize + MerkleTree::kNodeSize;
+constexpr size_t kBlockCount = kMessageSize / kBlockSize + 1;
+static_assert(kMessageSize % kBlockSize == kPrefixSize, "unexpected node message layout");
+static_assert(kPrefixSize + 1 + sizeof(uint64_t) <= kBlockSize, "padding must fit in one block");
+
+AVX2_INLINE Lanes Rotr(Lanes x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+// Runs the SHA-256 compression function on one block from each lane.
+AVX2_INLINE void Compress(Lanes state[8], const uint8_t* const blocks[kNodeLanes]) {
+    Lanes w[16];
+    for (size_t t = 0; t < 16; ++t) {
+        for (size_t lane = 0; lane < kNodeLanes; ++lane) {
+            uint32_t word;
+            memcpy(&word, blocks[lane] + t * sizeof(word), sizeof(word));
+            w[t][lane] = __builtin_bswap32(word);
+        }
+    }
+
+    Lanes a = state[0], b = state[1], c = state[2], d = state[3];
+    Lanes e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t t = 0; t < 64; ++t) {
+        if (t >= 16) {
+            Lanes w15 = w[(t - 15) % 16];
+            Lanes w2 = w[(t - 2) % 16];
+            Lanes s0 = Rotr(w15, 7) ^ Rotr(w15, 18) ^ (w15 >> 3);
+            Lanes s1 = Rotr(w2, 17) ^ Rotr(w2, 19) ^ (w2 >> 10);
+            w[t % 16] += s0 + w[(t - 7) % 16] + s1;
+        }
+        Lanes s1 = Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25);
+        Lanes ch = (e & f) ^ (~e & g);
+        Lanes t1 = h + s1 + ch + kRoundConstants[t] + w[t % 16];
+        Lanes s0 = Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22);
+        Lanes maj = (a & b) ^ (a & c) ^ (b & c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + s0 + maj;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+AVX2_FUNCTION void HashNodesAvx2(const uint8_t* data, uint64_t locality, uint8_t* out) {
+    // The first and last blocks of each message mix data with other fields, so
+    // they are assembled separately.  All others are read in place.
+    uint8_t first[kNodeLanes][kBlockSize];
+    uint8_t last[kNodeLanes][kBlockSize];
+    const uint32_t length = static_cast<uint32_t>(MerkleTree::kNodeSize);
+    const uint64_t bits = __builtin_bswap64(kMessageSize * 8);
+    for (size_t lane = 0; lane < kNodeLanes; ++lane) {
+        const uint8_t* node = data + lane * MerkleTree::kNodeSize;
+        uint64_t node_locality = locality + lane * MerkleTree::kNodeSize;
+        memcpy(&first[lane][0], &node_locality, sizeof(node_locality));
+        memcpy(&first[lane][sizeof(node_locality)], &length, sizeof(length));
+        memcpy(&first[lane][kPrefixSize], node, kBlockSize - kPrefixSize);
+
+        memset(last[lane], 0, kBlockSize);
+        memcpy(last[lane], node + MerkleTree::kNodeSize - kPrefixSize, kPrefixSize);
+        last[lane][kPrefixSize] = 0x80;
+        memcpy(&last[lane][kBlockSize - sizeof(bits)], &bits, sizeof(bits));
+    }
+
+    Lanes state[8];
+    for (size_t i = 0; i < 8; ++i) {
+        for (size_t lane = 0; lane < kNodeLanes; ++lane) {
+            state[i][lane] = kInitialState[i];
+        }
+    }
+
+    const uint8_t* blocks[kNodeLanes];
+    for (size_t lane = 0; lane < kNodeLanes; ++lane) {
+        blocks[lane] = first[lane];
+    }
+    Compress(state, blocks);
+    for (size_t i = 1; i < kBlockCount - 1; ++i) {
+        for (size_t lane = 0; lane < kNodeLanes; ++lane) {
+            blocks[lane] = data + lane * MerkleTree::kNodeSize + i * kBlockSize - kPrefixSize;
+        }
+        Compress(state, blocks);
+    }
+    for (size_t lane = 0; lane < kNodeLanes; ++lane) {
+        blocks[lane] = last[lane];
+    }
+    Compress(state, blocks);
+
+    for (size_t lane = 0; lane < kNodeLanes; ++lane) {
+        for (size_t i = 0; i < 8; ++i) {
+            uint32_t word = __builtin_bswap32(state[i][lane]);
+            memcpy(out + lane * Digest::kLength + i * sizeof(word), &word, sizeof(word));
+        }
+    }
+}
+
+enum class Support : int {
+    kUnknown,
+    kSupported,
+    kUnsupported,
+};
+
+std::atomic<Support> support(Support::kUnknown);
+
+// Checks that the CPU supports AVX2 and the OS saves the YMM registers, and
+// that the CPU does not implement the SHA extensions.
+bool CheckSupport() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    // XMM and YMM state.
+    if ((xcr0_lo & 0x6) != 0x6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    constexpr unsigned int kSha = 1u << 29;
+    return (ebx & bit_AVX2) && !(ebx & kSha);
+}
+
+} // namespace
+
+bool CanHashNodes() {
+    Support s = support.load(std::memory_order_relaxed);
+    if (s == Support::kUnknown) {
+        s = CheckSupport() ? Support::kSupported : Support::kUnsupported;
+        support.store(s, std::memory_order_relaxed);
+    }
+    return s == Support::kSupported;
+}
+
+void HashNodes(const uint8_t* data, uint64_t locality, uint8_t* out) {
+    ZX_DEBUG_ASSERT(CanHashNodes());
+    HashNodesAvx2(data, locality, out);
+}
+
+#else // !defined(__x86_64__)
+
+bool CanHashNodes() {
+    return false;
+}
+
+void HashNodes(const uint8_t* data, uint64_t locality, uint8_t* out) {
+    ZX_PANIC("multi-lane node hashing is not supported on this architecture\n");
+}
+
+#endif // defined(__x86_64__)
+
+} // namespace internal
+} // namespace digest
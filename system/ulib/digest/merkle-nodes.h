@@ -0,0 +1,29 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace digest {
+namespace internal {
+
+// The number of Merkle tree nodes hashed together by |HashNodes|.
+constexpr size_t kNodeLanes = 8;
+
+// Returns true if |HashNodes| may be used, i.e. the CPU supports hashing
+// several nodes at once with SIMD instructions, and doing so is faster than
+// hashing them one at a time.  This is false on CPUs with dedicated SHA-256
+// instructions, which BoringSSL already uses.
+bool CanHashNodes();
+
+// Computes the digests of |kNodeLanes| consecutive, complete nodes starting at
+// |data|, which belongs to the tree level at |locality| (i.e. |offset | level|
+// for the first node).  The digests are written consecutively to |out|, and
+// match those computed for each node by |MerkleTree|.
+void HashNodes(const uint8_t* data, uint64_t locality, uint8_t* out);
+
+} // namespace internal
+} // namespace digest
@@ -4,8 +4,10 @@
 
 #include <digest/merkle-tree.h>
 
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <digest/digest.h>
 #include <fbl/algorithm.h>
@@ -14,6 +16,8 @@
 #include <zircon/assert.h>
 #include <zircon/errors.h>
 
+#include "merkle-nodes.h"
+
 namespace digest {
 
 // Size of a node in bytes.  Defined in tree.h.
@@ -94,6 +98,108 @@ size_t NextAligned(size_t length) {
     return fbl::round_up(NextLength(length), MerkleTree::kNodeSize);
 }
 
+////////
+// Helper functions for hashing many nodes at once.
+
+// Each thread hashing a level is given at least this much data.
+constexpr size_t kMinThreadLength = 1 << 20;
+
+// The most threads used to hash a level.
+constexpr size_t kMaxThreads = 8;
+
+// A run of |count| consecutive nodes from |in|, the first at |offset| in a level
+// which is |length| bytes long.  The nodes' digests are written to |out|.
+struct NodeRange {
+    const uint8_t* in;
+    uint64_t level;
+    size_t offset;
+    size_t length;
+    size_t count;
+    uint8_t* out;
+    zx_status_t status;
+};
+
+// Hashes the nodes in |range|, several at a time if the CPU supports it.
+zx_status_t HashNodeRange(const NodeRange& range) {
+    const size_t kNodeSize = MerkleTree::kNodeSize;
+    size_t i = 0;
+    if (internal::CanHashNodes()) {
+        // Only complete nodes can be hashed together.
+        size_t complete = fbl::min(range.count, (range.length - range.offset) / kNodeSize);
+        for (; i + internal::kNodeLanes <= complete; i += internal::kNodeLanes) {
+            uint64_t locality = (range.offset + i * kNodeSize) | range.level;
+            internal::HashNodes(range.in + i * kNodeSize, locality,
+                                range.out + i * Digest::kLength);
+        }
+    }
+    Digest digest;
+    for (; i < range.count; ++i) {
+        zx_status_t rc;
+        size_t offset = range.offset + i * kNodeSize;
+        if ((rc = DigestInit(&digest, offset | range.level, range.length - offset)) != ZX_OK) {
+            return rc;
+        }
+        offset += DigestUpdate(&digest, range.in + i * kNodeSize, offset, range.length - offset);
+        DigestFinal(&digest, offset);
+        digest.CopyTo(range.out + i * Digest::kLength, Digest::kLength);
+    }
+    return ZX_OK;
+}
+
+void* HashNodeRangeThread(void* arg) {
+    NodeRange* range = static_cast<NodeRange*>(arg);
+    range->status = HashNodeRange(*range);
+    return nullptr;
+}
+
+// Hashes the nodes in |all|, dividing large ranges between several threads.
+zx_status_t HashNodesInParallel(const NodeRange& all) {
+    size_t num_threads = fbl::min(all.count * MerkleTree::kNodeSize / kMinThreadLength,
+                                  kMaxThreads);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0) {
+        num_threads = fbl::min(num_threads, static_cast<size_t>(cpus));
+    }
+    if (num_threads <= 1) {
+        return HashNodeRange(all);
+    }
+
+    // Keep each thread's share a multiple of the nodes hashed together.
+    size_t per_thread = fbl::round_up(fbl::round_up(all.count, num_threads) / num_threads,
+                                      internal::kNodeLanes);
+    NodeRange ranges[kMaxThreads];
+    pthread_t threads[kMaxThreads];
+    bool started[kMaxThreads] = {};
+    size_t num_ranges = 0;
+    for (size_t first = 0; first < all.count; first += per_thread, ++num_ranges) {
+        NodeRange& range = ranges[num_ranges];
+        range = all;
+        range.in += first * MerkleTree::kNodeSize;
+        range.offset += first * MerkleTree::kNodeSize;
+        range.count = fbl::min(per_thread, all.count - first);
+        range.out += first * Digest::kLength;
+        range.status = ZX_OK;
+        // The calling thread hashes the first range.
+        if (num_ranges != 0) {
+            started[num_ranges] =
+                pthread_create(&threads[num_ranges], nullptr, HashNodeRangeThread, &range) == 0;
+        }
+    }
+
+    zx_status_t rc = ZX_OK;
+    for (size_t i = 0; i < num_ranges; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], nullptr);
+        } else {
+            HashNodeRangeThread(&ranges[i]);
+        }
+        if (rc == ZX_OK) {
+            rc = ranges[i].status;
+        }
+    }
+    return rc;
+}
+
 } // namespace
 
 ////////
@@ -170,6 +276,33 @@ zx_status_t MerkleTree::CreateUpdate(const void* data, size_t length, void* tree
     // Consume the data.
     zx_status_t rc = ZX_OK;
     while (length > 0 && rc == ZX_OK) {
+        // Hash any whole nodes together, unless this is the top of the tree.
+        size_t nodes = 0;
+        if (offset_ % kNodeSize == 0 && length_ > kNodeSize) {
+            nodes = (offset_ + length == length_ ? fbl::round_up(length, kNodeSize) : length) /
+                    kNodeSize;
+        }
+        if (nodes != 0) {
+            // If any digests start a new node, first initialize it.
+            for (size_t i = 0; i < nodes; ++i) {
+                if ((tree_off + i * Digest::kLength) % kNodeSize == 0) {
+                    memset(out + i * Digest::kLength, 0, kNodeSize);
+                }
+            }
+            NodeRange range = {in, level_, offset_, length_, nodes, out, ZX_OK};
+            if ((rc = HashNodesInParallel(range)) != ZX_OK) {
+                break;
+            }
+            size_t chunk = fbl::min(nodes * kNodeSize, length);
+            in += chunk;
+            offset_ += chunk;
+            length -= chunk;
+            // Add the digests and ascend the tree.
+            rc = next_->CreateUpdate(out, nodes * Digest::kLength, next);
+            out += nodes * Digest::kLength;
+            tree_off += nodes * Digest::kLength;
+            continue;
+        }
         // Check if this is the start of a node.
         if (offset_ % kNodeSize == 0 &&
             (rc = DigestInit(&digest_, offset_ | level_, length_ - offset_)) != ZX_OK) {
@@ -10,6 +10,7 @@ MODULE_TYPE := userlib
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/digest.cpp \
+    $(LOCAL_DIR)/merkle-nodes.cpp \
     $(LOCAL_DIR)/merkle-tree.cpp
 
 MODULE_SO_NAME := digest
@@ -33,6 +34,7 @@ MODULE_COMPILEFLAGS := \
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/digest.cpp \
+    $(LOCAL_DIR)/merkle-nodes.cpp \
     $(LOCAL_DIR)/merkle-tree.cpp
 
 MODULE_HOST_LIBS := \
@@ -157,6 +157,8 @@ static zx_status_t finish_load_segment(
 
         start_offset += file_size;
         size -= file_size;
+        if (size == 0)
+            return ZX_OK;
     }
 
     // The rest of the segment will be backed by anonymous memory.
@@ -200,7 +202,7 @@ static zx_status_t finish_load_segment(
 
 static zx_status_t load_segment(zx_handle_t vmar, size_t vmar_offset,
                                 zx_handle_t vmo, const char* vmo_name,
-                                const elf_phdr_t* ph) {
+                                const elf_phdr_t* ph, zx_handle_t data_vmo) {
     // The p_vaddr can start in the middle of a page, but the
     // semantics are that all the whole pages containing the
     // p_vaddr+p_filesz range are mapped in.
@@ -229,17 +231,25 @@ static zx_status_t load_segment(zx_handle_t vmar, size_t vmar_offset,
         return finish_load_segment(vmar, vmo, vmo_name, ph, start, size,
                                    file_start, file_end, partial_page);
 
-    // For a writable segment, we need a writable VMO.
+    // For a writable segment, we need a writable VMO.  Prepared data
+    // already holds the final partial page, with the bss part cleared.
     zx_handle_t writable_vmo;
-    zx_status_t status = zx_vmo_clone(vmo, ZX_VMO_CLONE_COPY_ON_WRITE,
-                                      file_start, data_size, &writable_vmo);
+    zx_status_t status = zx_vmo_clone(
+        data_vmo != ZX_HANDLE_INVALID ? data_vmo : vmo,
+        ZX_VMO_CLONE_COPY_ON_WRITE,
+        data_vmo != ZX_HANDLE_INVALID ? 0 : file_start, data_size,
+        &writable_vmo);
     if (status == ZX_OK) {
         char name[ZX_MAX_NAME_LEN] = VMO_NAME_PREFIX_DATA;
         memcpy(&name[sizeof(VMO_NAME_PREFIX_DATA) - 1],
                vmo_name, ZX_MAX_NAME_LEN - sizeof(VMO_NAME_PREFIX_DATA));
         status = zx_object_set_property(writable_vmo, ZX_PROP_NAME,
                                         name, strlen(name));
-        if (status == ZX_OK)
+        if (status == ZX_OK && data_vmo != ZX_HANDLE_INVALID)
+            status = finish_load_segment(
+                vmar, writable_vmo, vmo_name, ph, start, size,
+                0, data_size, 0);
+        else if (status == ZX_OK)
             status = finish_load_segment(
                 vmar, writable_vmo, vmo_name, ph, start, size,
                 0, file_end - file_start, partial_page);
@@ -248,12 +258,59 @@ static zx_status_t load_segment(zx_handle_t vmar, size_t vmar_offset,
     return status;
 }
 
+zx_status_t elf_load_prepare_data(zx_handle_t vmo, const elf_phdr_t* ph,
+                                  zx_handle_t* data_vmo) {
+    uintptr_t file_start = (uintptr_t)ph->p_offset & -PAGE_SIZE;
+    uintptr_t file_end = (uintptr_t)ph->p_offset + ph->p_filesz;
+    uintptr_t data_end = (file_end + PAGE_SIZE - 1) & -PAGE_SIZE;
+    const size_t partial_page = file_end & (PAGE_SIZE - 1);
+
+    // Only segments with writable data are loaded from a clone.
+    if (!(ph->p_flags & PF_W) || data_end == file_start) {
+        *data_vmo = ZX_HANDLE_INVALID;
+        return ZX_OK;
+    }
+
+    zx_handle_t clone;
+    zx_status_t status = zx_vmo_clone(vmo, ZX_VMO_CLONE_COPY_ON_WRITE,
+                                      file_start, data_end - file_start,
+                                      &clone);
+    if (status != ZX_OK)
+        return status;
+
+    // The rest of the last page of data is the start of the bss.
+    if (partial_page > 0 && ph->p_memsz > ph->p_filesz) {
+        char zero[PAGE_SIZE];
+        memset(zero, 0, PAGE_SIZE - partial_page);
+        status = zx_vmo_write(clone, zero, file_end - file_start,
+                              PAGE_SIZE - partial_page);
+        if (status != ZX_OK) {
+            zx_handle_close(clone);
+            return status;
+        }
+    }
+
+    *data_vmo = clone;
+    return ZX_OK;
+}
+
 zx_status_t elf_load_map_segments(zx_handle_t root_vmar,
                                   const elf_load_header_t* header,
                                   const elf_phdr_t phdrs[],
                                   zx_handle_t vmo,
                                   zx_handle_t* segments_vmar,
                                   zx_vaddr_t* base, zx_vaddr_t* entry) {
+    return elf_load_map_prepared_segments(root_vmar, header, phdrs, vmo, NULL,
+                                          segments_vmar, base, entry);
+}
+
+zx_status_t elf_load_map_prepared_segments(zx_handle_t root_vmar,
+                                           const elf_load_header_t* header,
+                                           const elf_phdr_t phdrs[],
+                                           zx_handle_t vmo,
+                                           const zx_handle_t data_vmos[],
+                                           zx_handle_t* segments_vmar,
+                                           zx_vaddr_t* base, zx_vaddr_t* entry) {
     char vmo_name[ZX_MAX_NAME_LEN];
     if (zx_object_get_property(vmo, ZX_PROP_NAME,
                                vmo_name, sizeof(vmo_name)) != ZX_OK ||
@@ -269,7 +326,9 @@ zx_status_t elf_load_map_segments(zx_handle_t root_vmar,
     size_t vmar_offset = bias - vmar_base;
     for (uint_fast16_t i = 0; status == ZX_OK && i < header->e_phnum; ++i) {
         if (phdrs[i].p_type == PT_LOAD)
-            status = load_segment(vmar, vmar_offset, vmo, vmo_name, &phdrs[i]);
+            status = load_segment(vmar, vmar_offset, vmo, vmo_name, &phdrs[i],
+                                  data_vmos != NULL ? data_vmos[i] :
+                                  ZX_HANDLE_INVALID);
     }
 
     if (status == ZX_OK && segments_vmar != NULL)
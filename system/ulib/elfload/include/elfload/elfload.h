@@ -56,6 +56,25 @@ zx_status_t elf_load_map_segments(zx_handle_t vmar,
                                   zx_handle_t* segments_vmar,
                                   zx_vaddr_t* bias, zx_vaddr_t* entry);
 
+// Make a VMO holding the writable data of the segment 'ph' of the file
+// 'vmo': a copy-on-write clone of the pages holding its p_filesz bytes,
+// with the bss part of the last page cleared.  Loads that map the segment
+// from clones of it don't copy that page out of the file each time.
+// *data_vmo is ZX_HANDLE_INVALID if the segment has no writable data.
+zx_status_t elf_load_prepare_data(zx_handle_t vmo, const elf_phdr_t* ph,
+                                  zx_handle_t* data_vmo);
+
+// Like elf_load_map_segments, but writable segments are loaded from
+// clones of data_vmos[i], made by elf_load_prepare_data for phdrs[i],
+// unless that's ZX_HANDLE_INVALID.
+zx_status_t elf_load_map_prepared_segments(zx_handle_t vmar,
+                                           const elf_load_header_t* header,
+                                           const elf_phdr_t* phdrs,
+                                           zx_handle_t vmo,
+                                           const zx_handle_t* data_vmos,
+                                           zx_handle_t* segments_vmar,
+                                           zx_vaddr_t* bias, zx_vaddr_t* entry);
+
 // Locate the PT_INTERP program header and extract its bounds in the file.
 // Returns false if there was no PT_INTERP.
 bool elf_load_find_interp(const elf_phdr_t* phdrs, size_t phnum,
@@ -0,0 +1,697 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <zircon/assert.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/intrusive_container_utils.h>
+#include <fbl/intrusive_pointer_traits.h>
+#include <fbl/intrusive_single_list.h>
+#include <fbl/macros.h>
+
+#include <stdint.h>
+#include <utility>
+
+namespace fbl {
+
+// Fwd decl of sanity checker class used by tests.
+namespace tests {
+namespace intrusive_containers {
+class ResizableHashTableChecker;
+}  // namespace tests
+}  // namespace intrusive_containers
+
+// DefaultResizableHashTraits defines a default implementation of traits used
+// to define the hash function for a resizable hash table.
+//
+// Unlike the traits of a fixed size HashTable, GetHash must *not* reduce its
+// result to a bucket index; the table does so itself as its size changes.
+// The table mixes the hash before using it, so simple functions (such as
+// returning an integer key unmodified) are sufficient.
+//
+// DefaultResizableHashTraits calls a static method of ObjType named GetHash
+// which takes a const reference to a KeyType and returns a HashType.
+template <typename KeyType,
+          typename ObjType,
+          typename HashType>
+struct DefaultResizableHashTraits {
+    static_assert(is_unsigned_integer<HashType>::value, "HashTypes must be unsigned integers");
+    static HashType GetHash(const KeyType& key) {
+        return static_cast<HashType>(ObjType::GetHash(key));
+    }
+};
+
+// ResizableHashTable
+//
+// An intrusive hash table with the same API as HashTable whose number of
+// buckets grows along with the number of elements it holds.
+//
+// The table starts out with kMinBuckets buckets stored inline, so it never
+// needs to allocate memory in order to hold an element; inserting can not
+// fail.  When the number of elements reaches the number of buckets, the table
+// attempts to allocate an array twice the size.  Instead of moving every
+// element at once, each subsequent insert moves the contents of a couple of
+// the old buckets to the new array, so no single operation takes time
+// proportional to the size of the table.  If the allocation fails the table
+// simply keeps using its current buckets, and tries again once it has grown
+// further.
+//
+// Because elements are only ever moved by insert operations, find and erase
+// never invalidate iterators.  Inserting (with insert, insert_or_find or
+// insert_or_replace) may invalidate any outstanding iterator other than the
+// one returned by insert_or_find.
+//
+// The table shrinks back to its inline buckets when it is cleared.
+template <typename  _KeyType,
+          typename  _PtrType,
+          typename  _BucketType = SinglyLinkedList<_PtrType>,
+          typename  _HashType   = size_t,
+          typename  _KeyTraits  = DefaultKeyedObjectTraits<
+                                    _KeyType,
+                                    typename internal::ContainerPtrTraits<_PtrType>::ValueType>,
+          typename  _HashTraits = DefaultResizableHashTraits<
+                                    _KeyType,
+                                    typename internal::ContainerPtrTraits<_PtrType>::ValueType,
+                                    _HashType>>
+class ResizableHashTable {
+private:
+    // Private fwd decls of the iterator implementation.
+    template <typename IterTraits> class iterator_impl;
+    struct iterator_traits;
+    struct const_iterator_traits;
+
+public:
+    // Pointer types/traits
+    using PtrType      = _PtrType;
+    using PtrTraits    = internal::ContainerPtrTraits<PtrType>;
+    using ValueType    = typename PtrTraits::ValueType;
+
+    // Key types/traits
+    using KeyType      = _KeyType;
+    using KeyTraits    = _KeyTraits;
+
+    // Hash types/traits
+    using HashType     = _HashType;
+    using HashTraits   = _HashTraits;
+
+    // Bucket types/traits
+    using BucketType   = _BucketType;
+    using NodeTraits   = typename BucketType::NodeTraits;
+
+    // Declarations of the standard iterator types.
+    using iterator       = iterator_impl<iterator_traits>;
+    using const_iterator = iterator_impl<const_iterator_traits>;
+
+    // An alias for the type of this specific ResizableHashTable<...> and its
+    // test sanity checker.
+    using ContainerType = ResizableHashTable<_KeyType, _PtrType, _BucketType, _HashType,
+                                             _KeyTraits, _HashTraits>;
+    using CheckerType   = ::fbl::tests::intrusive_containers::ResizableHashTableChecker;
+
+    // The number of buckets stored inline in the table.  Bucket counts are
+    // always powers of two.
+    static constexpr size_t kMinBuckets = 16;
+
+    // Hash tables only support constant order erase if their underlying bucket
+    // type does.
+    static constexpr bool SupportsConstantOrderErase = BucketType::SupportsConstantOrderErase;
+    static constexpr bool SupportsConstantOrderSize = true;
+    static constexpr bool IsAssociative = true;
+    static constexpr bool IsSequenced = false;
+
+    static_assert(is_unsigned_integer<HashType>::value, "HashTypes must be unsigned integers");
+    static_assert(sizeof(HashType) <= sizeof(uint64_t), "HashTypes must fit in 64 bits");
+
+    ResizableHashTable() {}
+    ~ResizableHashTable() {
+        ZX_DEBUG_ASSERT(PtrTraits::IsManaged || is_empty());
+        ResetBuckets();
+    }
+
+    // Standard begin/end, cbegin/cend iterator accessors.
+    iterator begin()              { return       iterator(this,       iterator::BEGIN); }
+    const_iterator begin()  const { return const_iterator(this, const_iterator::BEGIN); }
+    const_iterator cbegin() const { return const_iterator(this, const_iterator::BEGIN); }
+
+    iterator end()              { return       iterator(this,       iterator::END); }
+    const_iterator end()  const { return const_iterator(this, const_iterator::END); }
+    const_iterator cend() const { return const_iterator(this, const_iterator::END); }
+
+    // make_iterator : construct an iterator out of a reference to an object.
+    iterator make_iterator(ValueType& obj) {
+        size_t ndx = Locate(KeyTraits::GetKey(obj));
+        return iterator(this, ndx, GetBucket(ndx).make_iterator(obj));
+    }
+
+    void insert(const PtrType& ptr) { insert(PtrType(ptr)); }
+    void insert(PtrType&& ptr) {
+        ZX_DEBUG_ASSERT(ptr != nullptr);
+        Grow();
+
+        KeyType key = KeyTraits::GetKey(*ptr);
+        BucketType& bucket = GetBucket(Locate(key));
+
+        // Duplicate keys are disallowed.  Debug assert if someone tries to to
+        // insert an element with a duplicate key.  If the user thought that
+        // there might be a duplicate key in the table already, he/she should
+        // have used insert_or_find() instead.
+        ZX_DEBUG_ASSERT(FindInBucket(bucket, key).IsValid() == false);
+
+        bucket.push_front(std::move(ptr));
+        ++count_;
+    }
+
+    // insert_or_find
+    //
+    // Insert the element pointed to by ptr if it is not already in the
+    // table, or find the element that the ptr collided with instead.
+    //
+    // 'iter' is an optional out parameter pointer to an iterator which
+    // will reference either the newly inserted item, or the item whose key
+    // collided with ptr.
+    //
+    // insert_or_find returns true if there was no collision and the item was
+    // successfully inserted, otherwise it returns false.
+    //
+    bool insert_or_find(const PtrType& ptr, iterator* iter = nullptr) {
+        return insert_or_find(PtrType(ptr), iter);
+    }
+
+    bool insert_or_find(PtrType&& ptr, iterator* iter = nullptr) {
+        ZX_DEBUG_ASSERT(ptr != nullptr);
+        Grow();
+
+        KeyType key         = KeyTraits::GetKey(*ptr);
+        size_t  ndx         = Locate(key);
+        auto&   bucket      = GetBucket(ndx);
+        auto    bucket_iter = FindInBucket(bucket, key);
+
+        if (bucket_iter.IsValid()) {
+            if (iter) *iter = iterator(this, ndx, bucket_iter);
+            return false;
+        }
+
+        bucket.push_front(std::move(ptr));
+        ++count_;
+        if (iter) *iter = iterator(this, ndx, bucket.begin());
+        return true;
+    }
+
+    // insert_or_replace
+    //
+    // Find the element in the table with the same key as *ptr and replace it
+    // with ptr, then return the pointer to the element which was replaced.
+    // If no element in the table shares a key with *ptr, simply add ptr to
+    // the table and return nullptr.
+    //
+    PtrType insert_or_replace(const PtrType& ptr) {
+        return insert_or_replace(PtrType(ptr));
+    }
+
+    PtrType insert_or_replace(PtrType&& ptr) {
+        ZX_DEBUG_ASSERT(ptr != nullptr);
+        Grow();
+
+        KeyType key    = KeyTraits::GetKey(*ptr);
+        auto&   bucket = GetBucket(Locate(key));
+        auto    orig   = PtrTraits::GetRaw(ptr);
+
+        PtrType replaced = bucket.replace_if(
+            [key](const ValueType& other) -> bool {
+                return KeyTraits::EqualTo(key, KeyTraits::GetKey(other));
+            },
+            std::move(ptr));
+
+        if (orig == PtrTraits::GetRaw(replaced)) {
+            bucket.push_front(std::move(replaced));
+            count_++;
+            return nullptr;
+        }
+
+        return replaced;
+    }
+
+    iterator find(const KeyType& key) {
+        size_t ndx         = Locate(key);
+        auto&  bucket      = GetBucket(ndx);
+        auto   bucket_iter = FindInBucket(bucket, key);
+
+        return bucket_iter.IsValid() ? iterator(this, ndx, bucket_iter)
+                                     : iterator(this, iterator::END);
+    }
+
+    const_iterator find(const KeyType& key) const {
+        size_t      ndx         = Locate(key);
+        const auto& bucket      = GetBucket(ndx);
+        auto        bucket_iter = FindInBucket(bucket, key);
+
+        return bucket_iter.IsValid() ? const_iterator(this, ndx, bucket_iter)
+                                     : const_iterator(this, const_iterator::END);
+    }
+
+    PtrType erase(const KeyType& key) {
+        BucketType& bucket = GetBucket(Locate(key));
+
+        PtrType ret = internal::KeyEraseUtils<BucketType, KeyTraits>::erase(bucket, key);
+        if (ret != nullptr)
+            --count_;
+
+        return ret;
+    }
+
+    PtrType erase(const iterator& iter) {
+        if (!iter.IsValid())
+            return PtrType(nullptr);
+
+        return direct_erase(GetBucket(iter.bucket_ndx_), *iter);
+    }
+
+    PtrType erase(ValueType& obj) {
+        return direct_erase(GetBucket(Locate(KeyTraits::GetKey(obj))), obj);
+    }
+
+    // clear
+    //
+    // Clear out the all of the buckets and return to the inline bucket array.
+    // For managed pointer types, this will release all references held by the
+    // table to the objects which were in it.
+    void clear() {
+        for (size_t i = 0; i < BucketCount(); ++i)
+            GetBucket(i).clear();
+        count_ = 0;
+        ResetBuckets();
+    }
+
+    // clear_unsafe
+    //
+    // Perform a clear_unsafe on all buckets and reset the internal count to
+    // zero.  See comments in fbl/intrusive_single_list.h
+    // Think carefully before calling this!
+    void clear_unsafe() {
+        static_assert(PtrTraits::IsManaged == false,
+                     "clear_unsafe is not allowed for containers of managed pointers");
+
+        for (size_t i = 0; i < BucketCount(); ++i)
+            GetBucket(i).clear_unsafe();
+
+        count_ = 0;
+        ResetBuckets();
+    }
+
+    size_t size()      const { return count_; }
+    bool   is_empty()  const { return count_ == 0; }
+
+    // erase_if
+    //
+    // Find the first member of the table which satisfies the predicate given
+    // by 'fn' and erase it, returning a referenced pointer to the removed
+    // element.  Return nullptr if no member satisfies the predicate.
+    template <typename UnaryFn>
+    PtrType erase_if(UnaryFn fn) {
+        if (is_empty())
+            return PtrType(nullptr);
+
+        for (size_t i = 0; i < BucketCount(); ++i) {
+            auto& bucket = GetBucket(i);
+            if (!bucket.is_empty()) {
+                PtrType ret = bucket.erase_if(fn);
+                if (ret != nullptr) {
+                    --count_;
+                    return ret;
+                }
+            }
+        }
+
+        return PtrType(nullptr);
+    }
+
+    // find_if
+    //
+    // Find the first member of the table which satisfies the predicate given
+    // by 'fn' and return an iterator to it.  Return end() if no member
+    // satisfies the predicate.
+    template <typename UnaryFn>
+    const_iterator find_if(UnaryFn fn) const {
+        for (auto iter = begin(); iter.IsValid(); ++iter)
+            if (fn(*iter))
+                return iter;
+
+        return end();
+    }
+
+    template <typename UnaryFn>
+    iterator find_if(UnaryFn fn) {
+        for (auto iter = begin(); iter.IsValid(); ++iter)
+            if (fn(*iter))
+                return iter;
+
+        return end();
+    }
+
+private:
+    // The traits of a non-const iterator
+    struct iterator_traits {
+        using RefType    = typename PtrTraits::RefType;
+        using RawPtrType = typename PtrTraits::RawPtrType;
+        using IterType   = typename BucketType::iterator;
+
+        static IterType BucketBegin(BucketType& bucket) { return bucket.begin(); }
+        static IterType BucketEnd  (BucketType& bucket) { return bucket.end(); }
+    };
+
+    // The traits of a const iterator
+    struct const_iterator_traits {
+        using RefType    = typename PtrTraits::ConstRefType;
+        using RawPtrType = typename PtrTraits::ConstRawPtrType;
+        using IterType   = typename BucketType::const_iterator;
+
+        static IterType BucketBegin(const BucketType& bucket) { return bucket.cbegin(); }
+        static IterType BucketEnd  (const BucketType& bucket) { return bucket.cend(); }
+    };
+
+    // The shared implementation of the iterator.  Iterators walk the old
+    // bucket array (while a resize is in progress) followed by the current
+    // one; see GetBucket.
+    template <class IterTraits>
+    class iterator_impl {
+    public:
+        iterator_impl() { }
+        iterator_impl(const iterator_impl& other) {
+            hash_table_ = other.hash_table_;
+            bucket_ndx_ = other.bucket_ndx_;
+            iter_       = other.iter_;
+        }
+
+        iterator_impl& operator=(const iterator_impl& other) {
+            hash_table_ = other.hash_table_;
+            bucket_ndx_ = other.bucket_ndx_;
+            iter_       = other.iter_;
+            return *this;
+        }
+
+        bool IsValid() const { return iter_.IsValid(); }
+        bool operator==(const iterator_impl& other) const { return iter_ == other.iter_; }
+        bool operator!=(const iterator_impl& other) const { return iter_ != other.iter_; }
+
+        // Prefix
+        iterator_impl& operator++() {
+            if (!IsValid()) return *this;
+            ZX_DEBUG_ASSERT(hash_table_);
+
+            // Bump the bucket iterator and go looking for a new bucket if the
+            // iterator has become invalid.
+            ++iter_;
+            advance_if_invalid_iter();
+
+            return *this;
+        }
+
+        iterator_impl& operator--() {
+            // If we have never been bound to a table instance, the we had
+            // better be invalid.
+            if (!hash_table_) {
+                ZX_DEBUG_ASSERT(!IsValid());
+                return *this;
+            }
+
+            // Back up the bucket iterator.  If it is still valid, then we are done.
+            --iter_;
+            if (iter_.IsValid())
+                return *this;
+
+            // If the iterator is invalid after backing up, check previous
+            // buckets to see if they contain any nodes.
+            while (bucket_ndx_) {
+                --bucket_ndx_;
+                auto& bucket = GetBucket(bucket_ndx_);
+                if (!bucket.is_empty()) {
+                    iter_ = --IterTraits::BucketEnd(bucket);
+                    ZX_DEBUG_ASSERT(iter_.IsValid());
+                    return *this;
+                }
+            }
+
+            // Looks like we have backed up past the beginning.  Update the
+            // bookkeeping to point at the end of the last bucket.
+            bucket_ndx_ = hash_table_->BucketCount() - 1;
+            iter_ = IterTraits::BucketEnd(GetBucket(bucket_ndx_));
+
+            return *this;
+        }
+
+        // Postfix
+        iterator_impl operator++(int) {
+            iterator_impl ret(*this);
+            ++(*this);
+            return ret;
+        }
+
+        iterator_impl operator--(int) {
+            iterator_impl ret(*this);
+            --(*this);
+            return ret;
+        }
+
+        typename PtrTraits::PtrType CopyPointer()    const { return iter_.CopyPointer(); }
+        typename IterTraits::RefType operator*()     const { return iter_.operator*(); }
+        typename IterTraits::RawPtrType operator->() const { return iter_.operator->(); }
+
+    private:
+        friend ContainerType;
+        using IterType = typename IterTraits::IterType;
+
+        enum BeginTag { BEGIN };
+        enum EndTag { END };
+
+        iterator_impl(const ContainerType* hash_table, BeginTag)
+            : hash_table_(hash_table),
+              bucket_ndx_(0),
+              iter_(IterTraits::BucketBegin(GetBucket(0))) {
+            advance_if_invalid_iter();
+        }
+
+        iterator_impl(const ContainerType* hash_table, EndTag)
+            : hash_table_(hash_table),
+              bucket_ndx_(hash_table->BucketCount() - 1),
+              iter_(IterTraits::BucketEnd(GetBucket(bucket_ndx_))) { }
+
+        iterator_impl(const ContainerType* hash_table, size_t bucket_ndx, const IterType& iter)
+            : hash_table_(hash_table),
+              bucket_ndx_(bucket_ndx),
+              iter_(iter) { }
+
+        BucketType& GetBucket(size_t ndx) {
+            return const_cast<ContainerType*>(hash_table_)->GetBucket(ndx);
+        }
+
+        void advance_if_invalid_iter() {
+            // If the iterator has run off the end of it's current bucket, then
+            // check to see if there are nodes in any of the remaining buckets.
+            if (!iter_.IsValid()) {
+                const size_t last = hash_table_->BucketCount() - 1;
+                while (bucket_ndx_ < last) {
+                    ++bucket_ndx_;
+                    auto& bucket = GetBucket(bucket_ndx_);
+
+                    if (!bucket.is_empty()) {
+                        iter_ = IterTraits::BucketBegin(bucket);
+                        ZX_DEBUG_ASSERT(iter_.IsValid());
+                        break;
+                    } else if (bucket_ndx_ == last) {
+                        iter_ = IterTraits::BucketEnd(bucket);
+                    }
+                }
+            }
+        }
+
+        const ContainerType* hash_table_ = nullptr;
+        size_t bucket_ndx_ = 0;
+        IterType iter_;
+    };
+
+    PtrType direct_erase(BucketType& bucket, ValueType& obj) {
+        PtrType ret = internal::DirectEraseUtils<BucketType>::erase(bucket, obj);
+
+        if (ret != nullptr)
+            --count_;
+
+        return ret;
+    }
+
+    static typename BucketType::iterator FindInBucket(BucketType& bucket,
+                                                      const KeyType& key) {
+        return bucket.find_if(
+            [key](const ValueType& other) -> bool {
+                return KeyTraits::EqualTo(key, KeyTraits::GetKey(other));
+            });
+    }
+
+    static typename BucketType::const_iterator FindInBucket(const BucketType& bucket,
+                                                            const KeyType& key) {
+        return bucket.find_if(
+            [key](const ValueType& other) -> bool {
+                return KeyTraits::EqualTo(key, KeyTraits::GetKey(other));
+            });
+    }
+
+    // The test framework's 'checker' class is our friend.
+    friend CheckerType;
+
+    // Iterators need to access our bucket arrays in order to iterate.
+    friend iterator;
+    friend const_iterator;
+
+    // Resizable hash tables may not currently be copied, assigned or moved.
+    DISALLOW_COPY_ASSIGN_AND_MOVE(ResizableHashTable);
+
+    // The number of buckets moved from the old bucket array to the new one
+    // by each insert while a resize is in progress.  Moving two at a time
+    // guarantees that the resize finishes before the new array fills up.
+    static constexpr size_t kBucketsMovedPerInsert = 2;
+
+    // Maps |hash| onto one of 2^|shift| buckets.  Multiplying by 2^64 divided
+    // by the golden ratio and keeping the top bits (Fibonacci hashing) spreads
+    // out keys which differ only in their low or high bits, so the traits'
+    // hash functions do not need to.
+    static size_t BucketIndex(const KeyType& key, uint32_t shift) {
+        uint64_t hash = static_cast<uint64_t>(HashTraits::GetHash(key));
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> (64 - shift));
+    }
+
+    size_t OldBucketCount() const {
+        return (old_buckets_ != nullptr) ? (static_cast<size_t>(1) << old_shift_) : 0;
+    }
+
+    // The number of buckets in the old and current arrays together.
+    size_t BucketCount() const {
+        return OldBucketCount() + (static_cast<size_t>(1) << shift_);
+    }
+
+    // Buckets are indexed with the old array (if any) first, followed by the
+    // current array.
+    BucketType& GetBucket(size_t ndx) {
+        size_t old_count = OldBucketCount();
+        return (ndx < old_count) ? old_buckets_[ndx] : buckets_[ndx - old_count];
+    }
+
+    const BucketType& GetBucket(size_t ndx) const {
+        return const_cast<ContainerType*>(this)->GetBucket(ndx);
+    }
+
+    // Returns the index of the bucket holding |key|.  Old buckets at or past
+    // |migrate_ndx_| have yet to be moved to the current array.
+    size_t Locate(const KeyType& key) const {
+        if (old_buckets_ != nullptr) {
+            size_t old_ndx = BucketIndex(key, old_shift_);
+            if (old_ndx >= migrate_ndx_)
+                return old_ndx;
+        }
+        return OldBucketCount() + BucketIndex(key, shift_);
+    }
+
+    // Called before each insert.  Moves part of the old bucket array if a
+    // resize is in progress, otherwise starts one if the table is full.
+    void Grow() {
+        if (old_buckets_ != nullptr) {
+            MigrateBuckets();
+            return;
+        }
+
+        if (count_ < grow_at_)
+            return;
+
+        size_t count = static_cast<size_t>(1) << (shift_ + 1);
+        AllocChecker ac;
+        BucketType* buckets = new (&ac) BucketType[count];
+        if (!ac.check()) {
+            // Keep using the current buckets, and try again once the table
+            // holds as many more elements as it has buckets.
+            grow_at_ = count_ + (static_cast<size_t>(1) << shift_);
+            return;
+        }
+
+        old_buckets_ = buckets_;
+        old_shift_   = shift_;
+        migrate_ndx_ = 0;
+        buckets_     = buckets;
+        shift_       = shift_ + 1;
+        grow_at_     = count;
+
+        MigrateBuckets();
+    }
+
+    void MigrateBuckets() {
+        const size_t old_count = OldBucketCount();
+        for (size_t i = 0; (i < kBucketsMovedPerInsert) && (migrate_ndx_ < old_count); ++i) {
+            BucketType& bucket = old_buckets_[migrate_ndx_++];
+            while (!bucket.is_empty()) {
+                PtrType ptr = bucket.pop_front();
+                buckets_[BucketIndex(KeyTraits::GetKey(*ptr), shift_)].push_front(std::move(ptr));
+            }
+        }
+
+        if (migrate_ndx_ == old_count) {
+            if (old_buckets_ != inline_buckets_)
+                delete[] old_buckets_;
+            old_buckets_ = nullptr;
+            old_shift_   = 0;
+            migrate_ndx_ = 0;
+        }
+    }
+
+    // Frees any heap allocated bucket arrays, which must be empty, and
+    // returns to the inline array.
+    void ResetBuckets() {
+        if ((old_buckets_ != nullptr) && (old_buckets_ != inline_buckets_))
+            delete[] old_buckets_;
+        if (buckets_ != inline_buckets_)
+            delete[] buckets_;
+
+        old_buckets_ = nullptr;
+        old_shift_   = 0;
+        migrate_ndx_ = 0;
+        buckets_     = inline_buckets_;
+        shift_       = kMinShift;
+        grow_at_     = kMinBuckets;
+    }
+
+    static constexpr uint32_t kMinShift = 4;
+    static_assert((static_cast<size_t>(1) << kMinShift) == kMinBuckets,
+                  "kMinShift must match kMinBuckets");
+
+    size_t count_ = 0UL;
+    size_t grow_at_ = kMinBuckets;
+
+    // The current bucket array, which holds 2^shift_ buckets.
+    BucketType* buckets_ = inline_buckets_;
+    uint32_t shift_ = kMinShift;
+
+    // While a resize is in progress, the previous bucket array.  Buckets
+    // before migrate_ndx_ have been moved to buckets_, and are empty.
+    BucketType* old_buckets_ = nullptr;
+    uint32_t old_shift_ = 0;
+    size_t migrate_ndx_ = 0;
+
+    BucketType inline_buckets_[kMinBuckets];
+};
+
+// Explicit declaration of constexpr storage.
+#define RESIZABLE_HASH_TABLE_PROP(_type, _name) \
+template <typename KeyType, typename PtrType, typename BucketType, typename HashType, \
+          typename KeyTraits, typename HashTraits> \
+constexpr _type ResizableHashTable<KeyType, PtrType, BucketType, HashType, \
+                                   KeyTraits, HashTraits>::_name
+
+RESIZABLE_HASH_TABLE_PROP(size_t, kMinBuckets);
+RESIZABLE_HASH_TABLE_PROP(bool, SupportsConstantOrderErase);
+RESIZABLE_HASH_TABLE_PROP(bool, SupportsConstantOrderSize);
+RESIZABLE_HASH_TABLE_PROP(bool, IsAssociative);
+RESIZABLE_HASH_TABLE_PROP(bool, IsSequenced);
+RESIZABLE_HASH_TABLE_PROP(size_t, kBucketsMovedPerInsert);
+RESIZABLE_HASH_TABLE_PROP(uint32_t, kMinShift);
+
+#undef RESIZABLE_HASH_TABLE_PROP
+
+}  // namespace fbl
@@ -0,0 +1,487 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <fuchsia/io/c/fidl.h>
+#include <lib/fdio/cache.h>
+#include <lib/fdio/private.h>
+#include <lib/fdio/unsafe.h>
+#include <zircon/syscalls.h>
+#include <zircon/time.h>
+
+#include "private-cache.h"
+#include "unistd.h"
+
+// The path cache holds two kinds of records, each in a hash table keyed by
+// absolute path:
+//
+// - cache_dir_t, for each directory containing a cached path, and each of
+//   its ancestors. Every directory holds a watcher channel, on which the
+//   server reports entries added to or removed from the directory.
+//
+// - cache_entry_t, for each cached path, which refers to the directory
+//   containing it.
+//
+// Watchers are not read in the background: before the cache answers a
+// query, it drains the watchers of every directory on the path. Since the
+// server reports a change before replying to the request which made it,
+// any change which completed before the query is observed.
+//
+// A change to an entry only drops that entry. A change to a directory
+// (or a failed watcher) is rare enough that the whole cache is dropped,
+// rather than tracking the descendants of each directory.
+
+// Number of buckets in each of the hash tables.
+#define CACHE_BUCKETS 256
+
+// The cache is dropped when it would grow beyond either limit.
+#define CACHE_MAX_ENTRIES 1024
+#define CACHE_MAX_DIRS 128
+
+#define CACHE_WATCH_MASK (fuchsia_io_WATCH_MASK_DELETED | \
+                          fuchsia_io_WATCH_MASK_ADDED | \
+                          fuchsia_io_WATCH_MASK_REMOVED)
+
+typedef struct cache_dir cache_dir_t;
+
+struct cache_dir {
+    cache_dir_t* next;
+    // The directory containing this one, or NULL for "/".
+    cache_dir_t* parent;
+    // ZX_HANDLE_INVALID if the directory belongs to the local namespace,
+    // which cannot change once installed.
+    zx_handle_t watcher;
+    uint32_t hash;
+    char path[];
+};
+
+typedef struct cache_entry cache_entry_t;
+
+struct cache_entry {
+    cache_entry_t* next;
+    uint32_t hash;
+    // Either ZX_OK or ZX_ERR_NOT_FOUND.
+    zx_status_t status;
+    // The time at which |attr| becomes stale, if |status| is ZX_OK.
+    zx_time_t expiry;
+    fuchsia_io_NodeAttributes attr;
+    char path[];
+};
+
+static struct {
+    mtx_t lock;
+    atomic_bool enabled;
+    zx_duration_t attr_ttl;
+    // Incremented whenever an entry may have been dropped, so that results
+    // queried from the server before the change are not inserted after it.
+    uint64_t epoch;
+    size_t entry_count;
+    size_t dir_count;
+    cache_entry_t* entries[CACHE_BUCKETS];
+    cache_dir_t* dirs[CACHE_BUCKETS];
+} cache = {
+    .lock = MTX_INIT,
+};
+
+static uint32_t cache_hash(const char* path, size_t len) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t) path[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Returns the length of the path of the directory containing |path|.
+static size_t cache_parent_len(const char* path, size_t len) {
+    while (len > 0 && path[len - 1] != '/') {
+        len--;
+    }
+    // Drop the separator, unless the parent is "/".
+    return len > 1 ? len - 1 : len;
+}
+
+static void cache_flush_locked(void) {
+    for (size_t i = 0; i < CACHE_BUCKETS; i++) {
+        cache_entry_t* entry = cache.entries[i];
+        while (entry != NULL) {
+            cache_entry_t* next = entry->next;
+            free(entry);
+            entry = next;
+        }
+        cache.entries[i] = NULL;
+
+        cache_dir_t* dir = cache.dirs[i];
+        while (dir != NULL) {
+            cache_dir_t* next = dir->next;
+            zx_handle_close(dir->watcher);
+            free(dir);
+            dir = next;
+        }
+        cache.dirs[i] = NULL;
+    }
+    cache.entry_count = 0;
+    cache.dir_count = 0;
+    cache.epoch++;
+}
+
+static cache_dir_t* cache_find_dir_locked(const char* path, size_t len) {
+    uint32_t hash = cache_hash(path, len);
+    for (cache_dir_t* dir = cache.dirs[hash % CACHE_BUCKETS]; dir != NULL; dir = dir->next) {
+        if (dir->hash == hash && strncmp(dir->path, path, len) == 0 && dir->path[len] == 0) {
+            return dir;
+        }
+    }
+    return NULL;
+}
+
+// Returns the link which points at the entry for |path|, or NULL.
+static cache_entry_t** cache_find_entry_locked(const char* path, size_t len) {
+    uint32_t hash = cache_hash(path, len);
+    for (cache_entry_t** link = &cache.entries[hash % CACHE_BUCKETS]; *link != NULL;
+         link = &(*link)->next) {
+        cache_entry_t* entry = *link;
+        if (entry->hash == hash && strncmp(entry->path, path, len) == 0 &&
+            entry->path[len] == 0) {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+static void cache_remove_entry_locked(const char* path, size_t len) {
+    cache_entry_t** link = cache_find_entry_locked(path, len);
+    if (link != NULL) {
+        cache_entry_t* entry = *link;
+        *link = entry->next;
+        free(entry);
+        cache.entry_count--;
+    }
+    cache.epoch++;
+}
+
+// Handles the server reporting that |name| was added to or removed from
+// |dir|. Returns false if the cache was dropped.
+static bool cache_dir_changed_locked(cache_dir_t* dir, const char* name, size_t namelen) {
+    char path[PATH_MAX];
+    int len = snprintf(path, sizeof(path), "%s/%.*s", strcmp(dir->path, "/") ? dir->path : "",
+                       (int) namelen, name);
+    if (len < 0 || (size_t) len >= sizeof(path) || cache_find_dir_locked(path, len) != NULL) {
+        cache_flush_locked();
+        return false;
+    }
+    cache_remove_entry_locked(path, len);
+    return true;
+}
+
+// Handles every change reported by the watcher of |dir| so far.
+// Returns false if the cache was dropped.
+static bool cache_drain_dir_locked(cache_dir_t* dir) {
+    if (dir->watcher == ZX_HANDLE_INVALID) {
+        return true;
+    }
+    for (;;) {
+        uint8_t msg[fuchsia_io_MAX_BUF];
+        uint32_t sz;
+        zx_status_t status = zx_channel_read(dir->watcher, 0, msg, NULL, sizeof(msg), 0,
+                                             &sz, NULL);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            return true;
+        } else if (status != ZX_OK) {
+            cache_flush_locked();
+            return false;
+        }
+
+        // Message Format: { OP, LEN, DATA[LEN] }
+        const uint8_t* ptr = msg;
+        while (sz >= 2) {
+            unsigned event = ptr[0];
+            unsigned namelen = ptr[1];
+            if (sz < namelen + 2u) {
+                break;
+            }
+
+            switch (event) {
+            case fuchsia_io_WATCH_EVENT_ADDED:
+            case fuchsia_io_WATCH_EVENT_REMOVED:
+                if (!cache_dir_changed_locked(dir, (const char*) ptr + 2, namelen)) {
+                    return false;
+                }
+                break;
+            default:
+                // The directory itself was deleted.
+                cache_flush_locked();
+                return false;
+            }
+            ptr += namelen + 2;
+            sz -= namelen + 2;
+        }
+    }
+}
+
+// Drains the watchers of |dir| and each of its ancestors.
+// Returns false if the cache was dropped.
+static bool cache_drain_locked(cache_dir_t* dir) {
+    for (; dir != NULL; dir = dir->parent) {
+        if (!cache_drain_dir_locked(dir)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Opens the directory at |path|, and creates a watcher for it.
+static zx_status_t cache_watch(const char* path, zx_handle_t* out) {
+    fdio_t* io;
+    zx_status_t status = __fdio_open_at_uncached(&io, AT_FDCWD, path, O_RDONLY | O_DIRECTORY,
+                                                 0);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    zx_handle_t dir_channel = fdio_unsafe_borrow_channel(io);
+    if (dir_channel == ZX_HANDLE_INVALID) {
+        *out = ZX_HANDLE_INVALID;
+    } else {
+        zx_handle_t client, server;
+        if ((status = zx_channel_create(0, &client, &server)) == ZX_OK) {
+            zx_status_t io_status = fuchsia_io_DirectoryWatch(dir_channel, CACHE_WATCH_MASK, 0,
+                                                              server, &status);
+            if (io_status != ZX_OK) {
+                status = io_status;
+            }
+            if (status == ZX_OK) {
+                *out = client;
+            } else {
+                zx_handle_close(client);
+            }
+        }
+    }
+
+    fdio_close(io);
+    fdio_release(io);
+    return status;
+}
+
+// Ensures that the directory at |path| (of length |len|), and each of its
+// ancestors, are watched. Fails if any of them cannot be watched, or if the
+// cache changed while they were being watched.
+static zx_status_t cache_add_dir(const char* path, size_t len) {
+    mtx_lock(&cache.lock);
+    cache_dir_t* dir = cache_find_dir_locked(path, len);
+    mtx_unlock(&cache.lock);
+    if (dir != NULL) {
+        return ZX_OK;
+    }
+
+    if (len > 1) {
+        zx_status_t status = cache_add_dir(path, cache_parent_len(path, len));
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+
+    // Changes made after this point are reported by the watcher of the parent.
+    mtx_lock(&cache.lock);
+    uint64_t epoch = cache.epoch;
+    mtx_unlock(&cache.lock);
+
+    char copy[PATH_MAX];
+    memcpy(copy, path, len);
+    copy[len] = 0;
+    zx_handle_t watcher;
+    zx_status_t status = cache_watch(copy, &watcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if ((dir = malloc(sizeof(cache_dir_t) + len + 1)) == NULL) {
+        zx_handle_close(watcher);
+        return ZX_ERR_NO_MEMORY;
+    }
+    dir->watcher = watcher;
+    dir->hash = cache_hash(path, len);
+    memcpy(dir->path, copy, len + 1);
+
+    mtx_lock(&cache.lock);
+    cache_dir_t* parent = NULL;
+    if (len > 1) {
+        parent = cache_find_dir_locked(path, cache_parent_len(path, len));
+    }
+    if ((len > 1 && parent == NULL) || !cache_drain_locked(parent) ||
+        cache.epoch != epoch || cache_find_dir_locked(path, len) != NULL) {
+        // The path may have been replaced by another directory since it was
+        // opened; let the next lookup try again.
+        mtx_unlock(&cache.lock);
+        zx_handle_close(watcher);
+        free(dir);
+        return ZX_ERR_SHOULD_WAIT;
+    }
+    if (cache.dir_count == CACHE_MAX_DIRS) {
+        cache_flush_locked();
+        mtx_unlock(&cache.lock);
+        zx_handle_close(watcher);
+        free(dir);
+        return ZX_ERR_SHOULD_WAIT;
+    }
+    dir->parent = parent;
+    dir->next = cache.dirs[dir->hash % CACHE_BUCKETS];
+    cache.dirs[dir->hash % CACHE_BUCKETS] = dir;
+    cache.dir_count++;
+    mtx_unlock(&cache.lock);
+    return ZX_OK;
+}
+
+bool fdio_cache_enabled(void) {
+    return atomic_load(&cache.enabled);
+}
+
+bool fdio_cache_key(int dirfd, const char* path, char* out) {
+    char tmp[PATH_MAX];
+    if (path == NULL || path[0] == 0) {
+        return false;
+    } else if (path[0] != '/') {
+        if (dirfd != AT_FDCWD) {
+            return false;
+        }
+        mtx_lock(&fdio_cwd_lock);
+        int len = snprintf(tmp, sizeof(tmp), "%s/%s", fdio_cwd_path, path);
+        mtx_unlock(&fdio_cwd_lock);
+        if (len < 0 || (size_t) len >= sizeof(tmp)) {
+            return false;
+        }
+        path = tmp;
+    }
+
+    size_t outlen;
+    bool is_dir;
+    if (__fdio_cleanpath(path, out, &outlen, &is_dir) != ZX_OK) {
+        return false;
+    }
+    // Paths which must name a directory ("a/", "a/.") fail differently for
+    // files than the same path without the trailing component.
+    return !is_dir;
+}
+
+zx_status_t fdio_cache_lookup(const char* key, fuchsia_io_NodeAttributes* attr,
+                              uint64_t* ticket) {
+    size_t len = strlen(key);
+    size_t parent_len = cache_parent_len(key, len);
+
+    mtx_lock(&cache.lock);
+    cache_dir_t* dir = cache_find_dir_locked(key, parent_len);
+    if (dir != NULL && cache_drain_locked(dir)) {
+        cache_entry_t** link = cache_find_entry_locked(key, len);
+        cache_entry_t* entry = link ? *link : NULL;
+        if (entry != NULL && entry->status == ZX_OK &&
+            zx_clock_get_monotonic() >= entry->expiry) {
+            *link = entry->next;
+            free(entry);
+            cache.entry_count--;
+            entry = NULL;
+        }
+        if (entry != NULL) {
+            zx_status_t status = entry->status;
+            if (status == ZX_OK && attr != NULL) {
+                *attr = entry->attr;
+            }
+            *ticket = cache.epoch;
+            mtx_unlock(&cache.lock);
+            return status;
+        }
+    }
+    mtx_unlock(&cache.lock);
+
+    if (cache_add_dir(key, parent_len) != ZX_OK) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    mtx_lock(&cache.lock);
+    if ((dir = cache_find_dir_locked(key, parent_len)) == NULL || !cache_drain_locked(dir)) {
+        mtx_unlock(&cache.lock);
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    *ticket = cache.epoch;
+    mtx_unlock(&cache.lock);
+    return ZX_ERR_SHOULD_WAIT;
+}
+
+void fdio_cache_insert(const char* key, uint64_t ticket, zx_status_t status,
+                       const fuchsia_io_NodeAttributes* attr) {
+    size_t len = strlen(key);
+    size_t parent_len = cache_parent_len(key, len);
+
+    mtx_lock(&cache.lock);
+    cache_dir_t* dir = cache_find_dir_locked(key, parent_len);
+    if (dir == NULL || !cache_drain_locked(dir) || cache.epoch != ticket) {
+        mtx_unlock(&cache.lock);
+        return;
+    }
+    if (status == ZX_OK && cache.attr_ttl <= 0) {
+        mtx_unlock(&cache.lock);
+        return;
+    }
+    if (cache.entry_count == CACHE_MAX_ENTRIES) {
+        cache_flush_locked();
+        mtx_unlock(&cache.lock);
+        return;
+    }
+
+    cache_entry_t* entry;
+    if (cache_find_entry_locked(key, len) != NULL ||
+        (entry = malloc(sizeof(cache_entry_t) + len + 1)) == NULL) {
+        mtx_unlock(&cache.lock);
+        return;
+    }
+    entry->hash = cache_hash(key, len);
+    entry->status = status;
+    if (status == ZX_OK) {
+        entry->expiry = zx_time_add_duration(zx_clock_get_monotonic(), cache.attr_ttl);
+        entry->attr = *attr;
+    }
+    memcpy(entry->path, key, len + 1);
+    entry->next = cache.entries[entry->hash % CACHE_BUCKETS];
+    cache.entries[entry->hash % CACHE_BUCKETS] = entry;
+    cache.entry_count++;
+    mtx_unlock(&cache.lock);
+}
+
+void fdio_cache_invalidate(const char* key) {
+    mtx_lock(&cache.lock);
+    cache_remove_entry_locked(key, strlen(key));
+    mtx_unlock(&cache.lock);
+}
+
+void fdio_cache_flush(void) {
+    mtx_lock(&cache.lock);
+    cache_flush_locked();
+    mtx_unlock(&cache.lock);
+}
+
+__EXPORT
+zx_status_t fdio_cache_enable(zx_duration_t attr_ttl) {
+    if (attr_ttl < 0) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    mtx_lock(&cache.lock);
+    cache.attr_ttl = attr_ttl;
+    atomic_store(&cache.enabled, true);
+    mtx_unlock(&cache.lock);
+    return ZX_OK;
+}
+
+__EXPORT
+void fdio_cache_disable(void) {
+    mtx_lock(&cache.lock);
+    atomic_store(&cache.enabled, false);
+    cache_flush_locked();
+    mtx_unlock(&cache.lock);
+}
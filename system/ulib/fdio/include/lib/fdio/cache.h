@@ -0,0 +1,38 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <zircon/compiler.h>
+#include <zircon/types.h>
+
+__BEGIN_CDECLS
+
+// Enables a process-wide cache of path lookups, which allows stat(),
+// access() and open() to answer repeated queries for the same paths
+// without a round trip to the filesystem server.
+//
+// Only absolute paths, and paths relative to the current working
+// directory, are cached. The cache watches every directory containing
+// a cached path, and drops entries as the server reports them added,
+// removed or renamed:
+//
+// - Paths which do not exist are cached until they are created, and
+//   open() fails for them with ENOENT without contacting the server.
+//
+// - The attributes of paths which exist are cached for |attr_ttl|.
+//   Directory watchers do not report changes to the contents or
+//   attributes of a file (writes, truncation, timestamps) made through
+//   an open file descriptor, or by another process, so stat() may
+//   return attributes which are up to |attr_ttl| out of date.
+//   An |attr_ttl| of zero caches missing paths only.
+//
+// Calling fdio_cache_enable again updates |attr_ttl|.
+zx_status_t fdio_cache_enable(zx_duration_t attr_ttl);
+
+// Disables the cache enabled by fdio_cache_enable, and drops every
+// cached entry.
+void fdio_cache_disable(void);
+
+__END_CDECLS
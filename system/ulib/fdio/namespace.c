@@ -21,6 +21,7 @@
 #include <lib/zxio/null.h>
 
 #include "private.h"
+#include "private-cache.h"
 #include "private-remoteio.h"
 
 
@@ -543,6 +544,11 @@ zx_status_t fdio_ns_bind(fdio_ns_t* ns, const char* path, zx_handle_t remote) {
     }
 done:
     mtx_unlock(&ns->lock);
+    // The cache cannot watch namespace directories, so paths it resolved
+    // through them may now name something else.
+    if (r == ZX_OK && fdio_cache_enabled()) {
+        fdio_cache_flush();
+    }
     return r;
 }
 
@@ -618,6 +624,11 @@ zx_status_t fdio_ns_chdir(fdio_ns_t* ns) {
         return ZX_ERR_NO_MEMORY;
     }
     fdio_chdir(io, "/");
+    // Relative paths are cached by their absolute form, which now resolves
+    // within another namespace.
+    if (fdio_cache_enabled()) {
+        fdio_cache_flush();
+    }
     return ZX_OK;
 }
 
@@ -0,0 +1,46 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <fuchsia/io/c/fidl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <zircon/types.h>
+
+// Returns true if the path cache has been enabled with fdio_cache_enable.
+bool fdio_cache_enabled(void);
+
+// Places the key under which |path|, relative to |dirfd|, is cached in
+// |out|, which is PATH_MAX bytes long. Returns false if the path may not
+// be cached.
+bool fdio_cache_key(int dirfd, const char* path, char* out);
+
+// Looks up |key| in the cache:
+//
+// - ZX_OK: |key| exists, and its attributes are placed in |attr| (if
+//   non-NULL).
+// - ZX_ERR_NOT_FOUND: |key| does not exist.
+// - ZX_ERR_SHOULD_WAIT: |key| is not cached.
+// - Any other status: |key| may not be cached.
+//
+// On ZX_OK and ZX_ERR_SHOULD_WAIT, |ticket| is set to the value which
+// must be passed to fdio_cache_insert along with the result of querying
+// the server for |key|.
+zx_status_t fdio_cache_lookup(const char* key, fuchsia_io_NodeAttributes* attr,
+                              uint64_t* ticket);
+
+// Caches the result of querying the server for |key|, which is either
+// ZX_OK with the attributes in |attr|, or ZX_ERR_NOT_FOUND.
+//
+// The result is dropped if the cache may have been invalidated since
+// |ticket| was obtained from fdio_cache_lookup.
+void fdio_cache_insert(const char* key, uint64_t ticket, zx_status_t status,
+                       const fuchsia_io_NodeAttributes* attr);
+
+// Drops the entry for |key|, after it is modified by this process.
+void fdio_cache_invalidate(const char* key);
+
+// Drops every entry in the cache.
+void fdio_cache_flush(void);
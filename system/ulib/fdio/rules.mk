@@ -14,6 +14,7 @@ MODULE_COMPILEFLAGS += -fvisibility=hidden
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/bsdsocket.c \
+    $(LOCAL_DIR)/cache.c \
     $(LOCAL_DIR)/debug.c \
     $(LOCAL_DIR)/get-vmo.c \
     $(LOCAL_DIR)/namespace.c \
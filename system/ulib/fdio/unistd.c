@@ -40,6 +40,7 @@
 #include <lib/fdio/util.h>
 #include <lib/fdio/vfs.h>
 
+#include "private-cache.h"
 #include "private.h"
 #include "unistd.h"
 
@@ -446,7 +447,8 @@ zx_status_t __fdio_cleanpath(const char* in, char* out, size_t* outlen, bool* is
     return ZX_OK;
 }
 
-zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags, uint32_t mode) {
+zx_status_t __fdio_open_at_uncached(fdio_t** io, int dirfd, const char* path, int flags,
+                                    uint32_t mode) {
     if (path == NULL) {
         return ZX_ERR_INVALID_ARGS;
     }
@@ -472,6 +474,29 @@ zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags,
     return status;
 }
 
+zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags, uint32_t mode) {
+    char key[PATH_MAX];
+    uint64_t ticket;
+    bool cacheable = false;
+    if (fdio_cache_enabled() && !(flags & O_CREAT) && fdio_cache_key(dirfd, path, key)) {
+        if (flags & O_TRUNC) {
+            fdio_cache_invalidate(key);
+        } else {
+            zx_status_t status = fdio_cache_lookup(key, NULL, &ticket);
+            if (status == ZX_ERR_NOT_FOUND) {
+                return status;
+            }
+            cacheable = (status == ZX_OK || status == ZX_ERR_SHOULD_WAIT);
+        }
+    }
+
+    zx_status_t status = __fdio_open_at_uncached(io, dirfd, path, flags, mode);
+    if (cacheable && status == ZX_ERR_NOT_FOUND) {
+        fdio_cache_insert(key, ticket, status, NULL);
+    }
+    return status;
+}
+
 zx_status_t __fdio_open(fdio_t** io, const char* path, int flags, uint32_t mode) {
     return __fdio_open_at(io, AT_FDCWD, path, flags, mode);
 }
@@ -794,6 +819,10 @@ zx_status_t fdio_ns_install(fdio_ns_t* ns) {
     }
     mtx_unlock(&fdio_lock);
 
+    if (status == ZX_OK && fdio_cache_enabled()) {
+        fdio_cache_flush();
+    }
+
     if (old_root) {
         fdio_close(old_root);
         fdio_release(old_root);
@@ -897,27 +926,64 @@ zx_status_t fdio_wait_fd(int fd, uint32_t events, uint32_t* _pending, zx_time_t
     return status;
 }
 
+static void fdio_attr_to_stat(const fuchsia_io_NodeAttributes* attr, struct stat* s) {
+    memset(s, 0, sizeof(struct stat));
+    s->st_mode = attr->mode;
+    s->st_ino = attr->id;
+    s->st_size = attr->content_size;
+    s->st_blksize = VNATTR_BLKSIZE;
+    s->st_blocks = attr->storage_size / VNATTR_BLKSIZE;
+    s->st_nlink = attr->link_count;
+    s->st_ctim.tv_sec = attr->creation_time / ZX_SEC(1);
+    s->st_ctim.tv_nsec = attr->creation_time % ZX_SEC(1);
+    s->st_mtim.tv_sec = attr->modification_time / ZX_SEC(1);
+    s->st_mtim.tv_nsec = attr->modification_time % ZX_SEC(1);
+}
+
 static zx_status_t fdio_stat(fdio_t* io, struct stat* s) {
     fuchsia_io_NodeAttributes attr;
     zx_status_t status = io->ops->get_attr(io, &attr);
     if (status != ZX_OK) {
         return status;
     }
-
-    memset(s, 0, sizeof(struct stat));
-    s->st_mode = attr.mode;
-    s->st_ino = attr.id;
-    s->st_size = attr.content_size;
-    s->st_blksize = VNATTR_BLKSIZE;
-    s->st_blocks = attr.storage_size / VNATTR_BLKSIZE;
-    s->st_nlink = attr.link_count;
-    s->st_ctim.tv_sec = attr.creation_time / ZX_SEC(1);
-    s->st_ctim.tv_nsec = attr.creation_time % ZX_SEC(1);
-    s->st_mtim.tv_sec = attr.modification_time / ZX_SEC(1);
-    s->st_mtim.tv_nsec = attr.modification_time % ZX_SEC(1);
+    fdio_attr_to_stat(&attr, s);
     return ZX_OK;
 }
 
+// Opens |path| with |flags| and stats it, unless the result is cached.
+static zx_status_t fdio_stat_at(int dirfd, const char* path, int flags, struct stat* s) {
+    fuchsia_io_NodeAttributes attr;
+    char key[PATH_MAX];
+    uint64_t ticket;
+    bool cacheable = false;
+    zx_status_t status;
+    if (fdio_cache_enabled() && fdio_cache_key(dirfd, path, key)) {
+        status = fdio_cache_lookup(key, &attr, &ticket);
+        if (status == ZX_OK) {
+            fdio_attr_to_stat(&attr, s);
+            return ZX_OK;
+        } else if (status == ZX_ERR_NOT_FOUND) {
+            return status;
+        }
+        cacheable = (status == ZX_ERR_SHOULD_WAIT);
+    }
+
+    fdio_t* io;
+    if ((status = __fdio_open_at_uncached(&io, dirfd, path, flags, 0)) == ZX_OK) {
+        LOG(1, "fdio: fstatat io=%p\n", io);
+        status = io->ops->get_attr(io, &attr);
+        fdio_close(io);
+        fdio_release(io);
+    }
+    if (cacheable && (status == ZX_OK || status == ZX_ERR_NOT_FOUND)) {
+        fdio_cache_insert(key, ticket, status, &attr);
+    }
+    if (status == ZX_OK) {
+        fdio_attr_to_stat(&attr, s);
+    }
+    return status;
+}
+
 // TODO(ZX-974): determine complete correct mapping
 int fdio_status_to_errno(zx_status_t status) {
     switch (status) {
@@ -1401,6 +1467,14 @@ done:
     return status == ZX_OK ? (int) actual : ERROR(status);
 }
 
+// Drops the cached attributes of |path|, after this process modified them.
+static void fdio_stat_changed(int dirfd, const char* path) {
+    char key[PATH_MAX];
+    if (fdio_cache_enabled() && fdio_cache_key(dirfd, path, key)) {
+        fdio_cache_invalidate(key);
+    }
+}
+
 static int truncateat(int dirfd, const char* path, off_t len) {
     fdio_t* io;
     zx_status_t r;
@@ -1411,6 +1485,7 @@ static int truncateat(int dirfd, const char* path, off_t len) {
     r = io->ops->truncate(io, len);
     fdio_close(io);
     fdio_release(io);
+    fdio_stat_changed(dirfd, path);
     return STATUS(r);
 }
 
@@ -1615,18 +1690,8 @@ int fstat(int fd, struct stat* s) {
 
 __EXPORT
 int fstatat(int dirfd, const char* fn, struct stat* s, int flags) {
-    fdio_t* io;
-    zx_status_t r;
-
     LOG(1,"fdio: fstatat(%d, '%s',...)\n", dirfd, fn);
-    if ((r = __fdio_open_at(&io, dirfd, fn, O_PATH, 0)) < 0) {
-        return ERROR(r);
-    }
-    LOG(1,"fdio: fstatat io=%p\n", io);
-    r = fdio_stat(io, s);
-    fdio_close(io);
-    fdio_release(io);
-    return STATUS(r);
+    return STATUS(fdio_stat_at(dirfd, fn, O_PATH, s));
 }
 
 __EXPORT
@@ -1728,6 +1793,7 @@ int utimensat(int dirfd, const char *fn,
 
     fdio_close(io);
     fdio_release(io);
+    fdio_stat_changed(dirfd, fn);
     return STATUS(r);
 }
 
@@ -1811,16 +1877,8 @@ int faccessat(int dirfd, const char* filename, int amode, int flag) {
 
     // Since we are not tracking permissions yet, just check that the
     // file exists a la fstatat.
-    fdio_t* io;
-    zx_status_t status;
-    if ((status = __fdio_open_at(&io, dirfd, filename, 0, 0)) < 0) {
-        return ERROR(status);
-    }
     struct stat s;
-    status = fdio_stat(io, &s);
-    fdio_close(io);
-    fdio_release(io);
-    return STATUS(status);
+    return STATUS(fdio_stat_at(dirfd, filename, 0, &s));
 }
 
 __EXPORT
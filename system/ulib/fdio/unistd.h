@@ -17,6 +17,9 @@
 #define fd_to_io(n) fdio_unsafe_fd_to_io(n)
 
 zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags, uint32_t mode);
+// As __fdio_open_at, bypassing the path cache.
+zx_status_t __fdio_open_at_uncached(fdio_t** io, int dirfd, const char* path, int flags,
+                                    uint32_t mode);
 zx_status_t __fdio_open(fdio_t** io, const char* path, int flags, uint32_t mode);
 
 int fdio_status_to_errno(zx_status_t status);
@@ -92,11 +92,13 @@ extern const mount_options_t default_mount_options;
 typedef struct mkfs_options {
     uint32_t fvm_data_slices;
     bool verbose;
+    // MinFS only: map new files with extents rather than block pointers.
+    bool minfs_extents;
 } mkfs_options_t;
 
 extern const mkfs_options_t default_mkfs_options;
 
-#define NUM_MKFS_OPTIONS 2
+#define NUM_MKFS_OPTIONS 3
 
 typedef struct fsck_options {
     bool verbose;
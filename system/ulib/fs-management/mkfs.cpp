@@ -52,6 +52,9 @@ zx_status_t MkfsNativeFs(const char* binary, const char* device_path, LaunchCall
         fvm_data_slices.AppendPrintf("%u", options->fvm_data_slices);
         argv.push_back(fvm_data_slices.c_str());
     }
+    if (options->minfs_extents) {
+        argv.push_back("--extents");
+    }
     argv.push_back("mkfs");
     status = static_cast<zx_status_t>(cb(static_cast<int>(argv.size()), argv.get(), hnd, ids, n));
     return status;
@@ -100,6 +100,7 @@ zx_status_t RemoveRamdisk(const FixtureOptions& options, const fbl::String& bloc
 zx_status_t FormatDevice(const FixtureOptions& options, const fbl::String& block_device_path) {
     // Format device.
     mkfs_options_t mkfs_options = default_mkfs_options;
+    mkfs_options.minfs_extents = options.minfs_extents;
     zx_status_t result = mkfs(block_device_path.c_str(), options.fs_type,
                               launch_stdio_sync, &mkfs_options);
     if (result != ZX_OK) {
@@ -217,6 +218,10 @@ bool FixtureOptions::IsValid(fbl::String* err_description) const {
         }
     }
 
+    if (minfs_extents && fs_type != DISK_FORMAT_MINFS) {
+        buffer.Append("minfs_extents requires fs_type to be minfs.\n");
+    }
+
     *err_description = buffer.ToString();
 
     return err_description->empty();
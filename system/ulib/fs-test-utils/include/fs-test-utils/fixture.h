@@ -92,6 +92,9 @@ struct FixtureOptions {
     // Mount the device in |Fixture::fs_path()|. Format is auto detected.
     bool fs_mount = true;
 
+    // When formatting MinFS, map new files with extents rather than block pointers.
+    bool minfs_extents = false;
+
     // Seed for pseudo random number generator.
     unsigned int seed = 0;
 };
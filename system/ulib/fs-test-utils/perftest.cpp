@@ -51,6 +51,9 @@ Usage:
                                        the block device.
                                        (Options: blobfs, minfs)
 
+        --minfs_extents                MinFS will be formatted to map new
+                                       files with extents.
+
         --seed SEED                    An unsigned integer to initialize 
                                        pseudo-ramdom number generator.
 
@@ -312,6 +315,7 @@ bool ParseCommandLineArgs(int argc, const char* const* argv, FixtureOptions* fix
         {"print_statistics", no_argument, nullptr, 0},
         {"runs", required_argument, nullptr, 0},
         {"seed", required_argument, nullptr, 0},
+        {"minfs_extents", no_argument, nullptr, 0},
         {0, 0, 0, 0},
     };
     // Resets the internal state of getopt*, making this function idempotent.
@@ -379,6 +383,9 @@ bool ParseCommandLineArgs(int argc, const char* const* argv, FixtureOptions* fix
             case 12:
                 fixture_options->seed = static_cast<unsigned int>(strtoul(optarg, NULL, 0));
                 break;
+            case 13:
+                fixture_options->minfs_extents = true;
+                break;
             default:
                 break;
             }
@@ -20,11 +20,13 @@
 #define FS_TA_EXCLUDES(...) __TA_EXCLUDES(__VA_ARGS__)
 #define FS_TA_GUARDED(...) __TA_GUARDED(__VA_ARGS__)
 #define FS_TA_REQUIRES(...) __TA_REQUIRES(__VA_ARGS__)
+#define FS_TA_REQUIRES_SHARED(...) __TA_REQUIRES_SHARED(__VA_ARGS__)
 
 #else
 
 #define FS_TA_EXCLUDES(...)
 #define FS_TA_GUARDED(...)
 #define FS_TA_REQUIRES(...)
+#define FS_TA_REQUIRES_SHARED(...)
 
 #endif
@@ -0,0 +1,62 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#ifndef __Fuchsia__
+#error "Fuchsia-only header"
+#endif
+
+#include <pthread.h>
+
+#include <fbl/macros.h>
+#include <zircon/compiler.h>
+
+namespace fs {
+
+// A reader / writer lock, which may be held exclusively by a single thread, or
+// shared by any number of threads.
+class __TA_CAPABILITY("mutex") SharedMutex {
+public:
+    SharedMutex() = default;
+    ~SharedMutex() { pthread_rwlock_destroy(&lock_); }
+    DISALLOW_COPY_ASSIGN_AND_MOVE(SharedMutex);
+
+    void Acquire() __TA_ACQUIRE() { pthread_rwlock_wrlock(&lock_); }
+    void Release() __TA_RELEASE() { pthread_rwlock_unlock(&lock_); }
+
+    void AcquireShared() __TA_ACQUIRE_SHARED() { pthread_rwlock_rdlock(&lock_); }
+    void ReleaseShared() __TA_RELEASE_SHARED() { pthread_rwlock_unlock(&lock_); }
+
+private:
+    pthread_rwlock_t lock_ = PTHREAD_RWLOCK_INITIALIZER;
+};
+
+// Holds a SharedMutex exclusively for the lifetime of the object.
+class __TA_SCOPED_CAPABILITY ExclusiveLock {
+public:
+    explicit ExclusiveLock(SharedMutex* mutex) __TA_ACQUIRE(mutex) : mutex_(mutex) {
+        mutex_->Acquire();
+    }
+    ~ExclusiveLock() __TA_RELEASE() { mutex_->Release(); }
+    DISALLOW_COPY_ASSIGN_AND_MOVE(ExclusiveLock);
+
+private:
+    SharedMutex* const mutex_;
+};
+
+// Holds a SharedMutex shared for the lifetime of the object.
+class __TA_SCOPED_CAPABILITY SharedLock {
+public:
+    explicit SharedLock(SharedMutex* mutex) __TA_ACQUIRE_SHARED(mutex) : mutex_(mutex) {
+        mutex_->AcquireShared();
+    }
+    ~SharedLock() __TA_RELEASE() { mutex_->ReleaseShared(); }
+    DISALLOW_COPY_ASSIGN_AND_MOVE(SharedLock);
+
+private:
+    SharedMutex* const mutex_;
+};
+
+} // namespace fs
@@ -24,6 +24,7 @@
 #include <lib/zx/vmo.h>
 #include <fbl/mutex.h>
 #include <fs/client.h>
+#include <fs/shared-mutex.h>
 #endif // __Fuchsia__
 
 #include <fbl/function.h>
@@ -107,7 +108,15 @@ private:
 //
 // The Vfs object must outlive the Vnodes which it serves.
 //
-// This class is thread-safe.
+// This class is thread-safe. Path walks do not serialize against each other:
+// |Open| holds |vfs_lock_| shared, and only holds the lock of each directory it
+// visits (shared while looking up a component, exclusively while creating one).
+// Operations which may modify more than one directory (|Unlink|, |Link|,
+// |Rename|), and changes to the set of mount points, hold |vfs_lock_| exclusively.
+//
+// As a consequence, Vnodes served from multiple threads may see concurrent calls to
+// |Lookup| and |Readdir| on a single directory, and calls to any directory operation
+// on distinct directories.
 class Vfs {
 public:
     Vfs();
@@ -147,8 +156,8 @@ public:
                      fbl::StringPiece oldStr, fbl::StringPiece newStr) FS_TA_EXCLUDES(vfs_lock_);
     zx_status_t Rename(zx::event token, fbl::RefPtr<Vnode> oldparent,
                        fbl::StringPiece oldStr, fbl::StringPiece newStr) FS_TA_EXCLUDES(vfs_lock_);
-    // Calls readdir on the Vnode while holding the vfs_lock, preventing path
-    // modification operations for the duration of the operation.
+    // Calls readdir on the Vnode while holding its directory lock, preventing
+    // modification of the directory for the duration of the operation.
     zx_status_t Readdir(Vnode* vn, vdircookie_t* cookie,
                         void* dirents, size_t len, size_t* out_actual) FS_TA_EXCLUDES(vfs_lock_);
 
@@ -191,7 +200,7 @@ public:
 
 protected:
     // Whether this file system is read-only.
-    bool ReadonlyLocked() const FS_TA_REQUIRES(vfs_lock_) { return readonly_; }
+    bool ReadonlyLocked() const FS_TA_REQUIRES_SHARED(vfs_lock_) { return readonly_; }
 
 private:
     // Starting at vnode |vn|, walk the tree described by the path string,
@@ -202,11 +211,12 @@ private:
     // |out| is the vnode at which we stopped searching.
     // |pathout| is the remainder of the path to search.
     zx_status_t Walk(fbl::RefPtr<Vnode> vn, fbl::RefPtr<Vnode>* out,
-                     fbl::StringPiece path, fbl::StringPiece* pathout) FS_TA_REQUIRES(vfs_lock_);
+                     fbl::StringPiece path, fbl::StringPiece* pathout)
+        FS_TA_REQUIRES_SHARED(vfs_lock_);
 
     zx_status_t OpenLocked(fbl::RefPtr<Vnode> vn, fbl::RefPtr<Vnode>* out,
                            fbl::StringPiece path, fbl::StringPiece* pathout,
-                           uint32_t flags, uint32_t mode) FS_TA_REQUIRES(vfs_lock_);
+                           uint32_t flags, uint32_t mode) FS_TA_REQUIRES_SHARED(vfs_lock_);
 
     bool readonly_{};
 
@@ -239,9 +249,18 @@ private:
 
     async_dispatcher_t* dispatcher_{};
 
+    // Returns the lock guarding the entries of directory |vn|. Rather than growing
+    // every Vnode, directories are hashed onto a fixed set of locks. Since no more
+    // than one of them is ever held at a time, sharing a lock cannot deadlock.
+    SharedMutex* DirectoryLock(const Vnode* vn);
+
+    static constexpr size_t kDirectoryLockCount = 64;
+    SharedMutex directory_locks_[kDirectoryLockCount];
+
 protected:
-    // A lock which should be used to protect lookup and walk operations
-    mtx_t vfs_lock_{};
+    // Held shared by path walks, and exclusively by operations which may modify more
+    // than one directory, or the set of mount points.
+    SharedMutex vfs_lock_;
 
     // Starts tracking the lifetime of the connection.
     virtual void RegisterConnection(fbl::unique_ptr<Connection> connection) = 0;
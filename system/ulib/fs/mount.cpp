@@ -8,7 +8,6 @@
 #include <threads.h>
 
 #include <fbl/alloc_checker.h>
-#include <fbl/auto_lock.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
@@ -17,10 +16,24 @@
 #include <fuchsia/io/c/fidl.h>
 #include <lib/fdio/debug.h>
 #include <lib/fdio/vfs.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/object.h>
 
 #include <utility>
 
 namespace fs {
+namespace {
+
+zx_koid_t GetKoid(zx_handle_t h) {
+    zx_info_handle_basic_t info;
+    if (zx_object_get_info(h, ZX_INFO_HANDLE_BASIC, &info, sizeof(info),
+                           nullptr, nullptr) != ZX_OK) {
+        return ZX_KOID_INVALID;
+    }
+    return info.koid;
+}
+
+} // namespace
 
 constexpr Vfs::MountNode::MountNode() : vn_(nullptr) {}
 
@@ -63,7 +76,7 @@ zx_status_t Vfs::InstallRemote(fbl::RefPtr<Vnode> vn, MountChannel h) {
     }
     // Save this node in the list of mounted vnodes
     mount_point->SetNode(std::move(vn));
-    fbl::AutoLock lock(&vfs_lock_);
+    ExclusiveLock lock(&vfs_lock_);
     remote_list_.push_front(std::move(mount_point));
     return ZX_OK;
 }
@@ -92,7 +105,7 @@ zx_status_t Vfs::InstallRemoteLocked(fbl::RefPtr<Vnode> vn, MountChannel h) {
 
 zx_status_t Vfs::MountMkdir(fbl::RefPtr<Vnode> vn, fbl::StringPiece name, MountChannel h,
                             uint32_t flags) {
-    fbl::AutoLock lock(&vfs_lock_);
+    ExclusiveLock lock(&vfs_lock_);
     zx_status_t r = OpenLocked(vn, &vn, name, &name, ZX_FS_FLAG_CREATE |
                                ZX_FS_RIGHT_READABLE | ZX_FS_FLAG_DIRECTORY |
                                ZX_FS_FLAG_NOREMOTE, S_IFDIR);
@@ -115,23 +128,39 @@ zx_status_t Vfs::MountMkdir(fbl::RefPtr<Vnode> vn, fbl::StringPiece name, MountC
 }
 
 zx_status_t Vfs::UninstallRemote(fbl::RefPtr<Vnode> vn, zx::channel* h) {
-    fbl::AutoLock lock(&vfs_lock_);
+    ExclusiveLock lock(&vfs_lock_);
     return UninstallRemoteLocked(std::move(vn), h);
 }
 
 zx_status_t Vfs::ForwardOpenRemote(fbl::RefPtr<Vnode> vn, zx::channel channel,
                                    fbl::StringPiece path, uint32_t flags, uint32_t mode) {
-    fbl::AutoLock lock(&vfs_lock_);
-    zx_handle_t h = vn->GetRemote();
-    if (h == ZX_HANDLE_INVALID) {
-        return ZX_ERR_NOT_FOUND;
-    }
+    zx_koid_t remote_koid = ZX_KOID_INVALID;
+    zx_status_t r;
+    {
+        // Opens crossing a mount point are as common as any other, so they only
+        // prevent the remote from being uninstalled while it is in use.
+        SharedLock lock(&vfs_lock_);
+        zx_handle_t h = vn->GetRemote();
+        if (h == ZX_HANDLE_INVALID) {
+            return ZX_ERR_NOT_FOUND;
+        }
 
-    zx_status_t r = fuchsia_io_DirectoryOpen(h, flags, mode, path.data(),
-                                             path.length(), channel.release());
+        r = fuchsia_io_DirectoryOpen(h, flags, mode, path.data(), path.length(),
+                                     channel.release());
+        if (r == ZX_ERR_PEER_CLOSED) {
+            // Handle values are reused once closed, so the remote is identified by its
+            // koid when checking whether it was replaced after the lock is dropped.
+            remote_koid = GetKoid(h);
+        }
+    }
     if (r == ZX_ERR_PEER_CLOSED) {
-        zx::channel c;
-        UninstallRemoteLocked(std::move(vn), &c);
+        ExclusiveLock lock(&vfs_lock_);
+        zx_handle_t h = vn->GetRemote();
+        if (remote_koid != ZX_KOID_INVALID && h != ZX_HANDLE_INVALID &&
+            GetKoid(h) == remote_koid) {
+            zx::channel c;
+            UninstallRemoteLocked(std::move(vn), &c);
+        }
     }
     return r;
 }
@@ -158,7 +187,7 @@ zx_status_t Vfs::UninstallAll(zx_time_t deadline) {
     fbl::unique_ptr<MountNode> mount_point;
     for (;;) {
         {
-            fbl::AutoLock lock(&vfs_lock_);
+            ExclusiveLock lock(&vfs_lock_);
             mount_point = remote_list_.pop_front();
         }
         if (mount_point) {
@@ -16,7 +16,6 @@
 #ifdef __Fuchsia__
 #include <threads.h>
 
-#include <fbl/auto_lock.h>
 #include <fbl/ref_ptr.h>
 #include <fs/connection.h>
 #include <fs/remote.h>
@@ -114,7 +113,7 @@ zx_status_t Vfs::Open(fbl::RefPtr<Vnode> vndir, fbl::RefPtr<Vnode>* out,
                       fbl::StringPiece path, fbl::StringPiece* out_path, uint32_t flags,
                       uint32_t mode) {
 #ifdef __Fuchsia__
-    fbl::AutoLock lock(&vfs_lock_);
+    SharedLock lock(&vfs_lock_);
 #endif
     return OpenLocked(std::move(vndir), out, path, out_path, flags, mode);
 }
@@ -156,7 +155,13 @@ zx_status_t Vfs::OpenLocked(fbl::RefPtr<Vnode> vndir, fbl::RefPtr<Vnode>* out,
         } else if (ReadonlyLocked()) {
             return ZX_ERR_ACCESS_DENIED;
         }
-        if ((r = vndir->Create(&vn, path, mode)) < 0) {
+        {
+#ifdef __Fuchsia__
+            ExclusiveLock dir_lock(DirectoryLock(vndir.get()));
+#endif
+            r = vndir->Create(&vn, path, mode);
+        }
+        if (r < 0) {
             if ((r == ZX_ERR_ALREADY_EXISTS) && (!(flags & ZX_FS_FLAG_EXCLUSIVE))) {
                 goto try_open;
             }
@@ -172,7 +177,12 @@ zx_status_t Vfs::OpenLocked(fbl::RefPtr<Vnode> vndir, fbl::RefPtr<Vnode>* out,
 #endif
     } else {
     try_open:
-        r = vfs_lookup(std::move(vndir), &vn, path);
+        {
+#ifdef __Fuchsia__
+            SharedLock dir_lock(DirectoryLock(vndir.get()));
+#endif
+            r = vfs_lookup(std::move(vndir), &vn, path);
+        }
         if (r < 0) {
             return r;
         }
@@ -222,8 +232,10 @@ zx_status_t Vfs::Unlink(fbl::RefPtr<Vnode> vndir, fbl::StringPiece path) {
     }
 
     {
+        // Unlinking a directory also modifies the directory being removed, so it
+        // is excluded from all other directory operations.
 #ifdef __Fuchsia__
-        fbl::AutoLock lock(&vfs_lock_);
+        ExclusiveLock lock(&vfs_lock_);
 #endif
         if (ReadonlyLocked()) {
             r = ZX_ERR_ACCESS_DENIED;
@@ -245,7 +257,7 @@ zx_status_t Vfs::Unlink(fbl::RefPtr<Vnode> vndir, fbl::StringPiece path) {
 #define TOKEN_RIGHTS (ZX_RIGHTS_BASIC)
 
 void Vfs::TokenDiscard(zx::event ios_token) {
-    fbl::AutoLock lock(&vfs_lock_);
+    ExclusiveLock lock(&vfs_lock_);
     if (ios_token) {
         // The token is cleared here to prevent the following race condition:
         // 1) Open
@@ -265,7 +277,7 @@ zx_status_t Vfs::VnodeToToken(fbl::RefPtr<Vnode> vn, zx::event* ios_token,
     uint64_t vnode_cookie = reinterpret_cast<uint64_t>(vn.get());
     zx_status_t r;
 
-    fbl::AutoLock lock(&vfs_lock_);
+    ExclusiveLock lock(&vfs_lock_);
     if (ios_token->is_valid()) {
         // Token has already been set for this iostate
         if ((r = ios_token->duplicate(TOKEN_RIGHTS, out) != ZX_OK)) {
@@ -327,7 +339,7 @@ zx_status_t Vfs::Rename(zx::event token, fbl::RefPtr<Vnode> oldparent,
 
     fbl::RefPtr<fs::Vnode> newparent;
     {
-        fbl::AutoLock lock(&vfs_lock_);
+        ExclusiveLock lock(&vfs_lock_);
         if (ReadonlyLocked()) {
             return ZX_ERR_ACCESS_DENIED;
         }
@@ -348,13 +360,14 @@ zx_status_t Vfs::Rename(zx::event token, fbl::RefPtr<Vnode> oldparent,
 
 zx_status_t Vfs::Readdir(Vnode* vn, vdircookie_t* cookie,
                          void* dirents, size_t len, size_t* out_actual) {
-    fbl::AutoLock lock(&vfs_lock_);
+    SharedLock lock(&vfs_lock_);
+    SharedLock dir_lock(DirectoryLock(vn));
     return vn->Readdir(cookie, dirents, len, out_actual);
 }
 
 zx_status_t Vfs::Link(zx::event token, fbl::RefPtr<Vnode> oldparent,
                       fbl::StringPiece oldStr, fbl::StringPiece newStr) {
-    fbl::AutoLock lock(&vfs_lock_);
+    ExclusiveLock lock(&vfs_lock_);
     fbl::RefPtr<fs::Vnode> newparent;
     zx_status_t r;
     if ((r = TokenToVnode(std::move(token), &newparent)) != ZX_OK) {
@@ -431,11 +444,17 @@ zx_status_t Vfs::ServeDirectory(fbl::RefPtr<fs::Vnode> vn, zx::channel channel)
     return vn->Serve(this, std::move(channel), ZX_FS_RIGHT_ADMIN);
 }
 
+SharedMutex* Vfs::DirectoryLock(const Vnode* vn) {
+    uintptr_t key = reinterpret_cast<uintptr_t>(vn);
+    // Discard the low bits, which heap alignment leaves identical for every Vnode.
+    return &directory_locks_[(key >> 4) % kDirectoryLockCount];
+}
+
 #endif // ifdef __Fuchsia__
 
 void Vfs::SetReadonly(bool value) {
 #ifdef __Fuchsia__
-    fbl::AutoLock lock(&vfs_lock_);
+    ExclusiveLock lock(&vfs_lock_);
 #endif
     readonly_ = value;
 }
@@ -478,7 +497,13 @@ zx_status_t Vfs::Walk(fbl::RefPtr<Vnode> vn, fbl::RefPtr<Vnode>* out_vn,
 
         // Path has at least one additional segment.
         fbl::StringPiece component(path.data(), next_path - path.data());
-        if ((r = vfs_lookup(std::move(vn), &vn, component)) != ZX_OK) {
+        {
+#ifdef __Fuchsia__
+            SharedLock dir_lock(DirectoryLock(vn.get()));
+#endif
+            r = vfs_lookup(std::move(vn), &vn, component);
+        }
+        if (r != ZX_OK) {
             return r;
         }
         // Traverse to the next segment.
@@ -7,6 +7,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -27,6 +28,11 @@
 
 #define LZ4_MAX_BLOCK_SIZE 65536
 
+// Number of LZ4 blocks which may be read ahead of ReadData when decompressing in parallel.
+#define SPARSE_READER_PIPELINE_DEPTH 64
+// Maximum number of threads decompressing blocks in parallel.
+#define SPARSE_READER_MAX_WORKERS 8
+
 namespace fvm {
 
 class SparseReader {
@@ -88,12 +94,43 @@ private:
         size_t max_size;
     } buffer_t;
 
+    // A compressed block in the decompression pipeline.
+    typedef struct block {
+        // Compressed data read from the file.
+        fbl::unique_ptr<uint8_t[]> in;
+        // Size of the compressed data, with the high bit set if it is stored uncompressed.
+        uint32_t in_size;
+        // Decompressed data.
+        fbl::unique_ptr<uint8_t[]> out;
+        size_t out_size;
+        // True once |out| holds the decompressed data.
+        bool ready;
+    } block_t;
+
     static zx_status_t CreateHelper(fbl::unique_fd fd, bool verbose,
                                     fbl::unique_ptr<SparseReader>* out);
 
     SparseReader(fbl::unique_fd fd, bool verbose);
     // Read in header data, prepare buffers and decompression context if necessary
     zx_status_t ReadMetadata();
+    // Read the LZ4 frame header, and start decompressing in parallel if its blocks are
+    // independent of each other.
+    zx_status_t ReadFrameHeader();
+    // Read data decompressed by the pipeline.
+    zx_status_t ReadPipelined(uint8_t* data, size_t length, size_t* actual);
+
+    // Start the threads reading and decompressing blocks.
+    zx_status_t StartPipeline();
+    // Stop the threads started by StartPipeline.
+    void StopPipeline();
+    // Read each compressed block in turn into the pipeline.
+    static void* PipelineReader(void* arg);
+    void ReadBlocks();
+    // Decompress blocks as they are read.
+    static void* PipelineWorker(void* arg);
+    void DecompressBlocks();
+    // Fail the pipeline with |status|, unless it has already failed.
+    void FailPipeline(zx_status_t status);
     // Initialize buffer with a given |size|
     static zx_status_t InitializeBuffer(size_t size, buffer_t* out_buf);
     // Read |length| bytes of raw data from file directly into |data|. Return |actual| bytes read.
@@ -120,6 +157,36 @@ private:
     // Buffer for decompressed data
     buffer_t out_buf_;
 
+    // True if blocks are decompressed in parallel by the pipeline below rather than by dctx_.
+    bool pipelined_ = false;
+    pthread_t reader_thread_;
+    pthread_t worker_threads_[SPARSE_READER_MAX_WORKERS];
+    size_t num_workers_ = 0;
+    bool reader_started_ = false;
+
+    // The pipeline is a ring of blocks. Blocks [consumed_, decompressing_) are being
+    // decompressed, or are ready to be consumed by ReadData; blocks [decompressing_, read_)
+    // are waiting for a worker. Each counter is guarded by |pipeline_lock_|.
+    pthread_mutex_t pipeline_lock_ = PTHREAD_MUTEX_INITIALIZER;
+    // Signalled when a block is consumed, making room for the reader.
+    pthread_cond_t space_cond_ = PTHREAD_COND_INITIALIZER;
+    // Signalled when a block is read, giving work to the decompressors.
+    pthread_cond_t work_cond_ = PTHREAD_COND_INITIALIZER;
+    // Signalled when a block is ready to be consumed.
+    pthread_cond_t ready_cond_ = PTHREAD_COND_INITIALIZER;
+    block_t blocks_[SPARSE_READER_PIPELINE_DEPTH];
+    size_t read_ = 0;
+    size_t decompressing_ = 0;
+    size_t consumed_ = 0;
+    // Offset of unconsumed data in the oldest block.
+    size_t consume_offset_ = 0;
+    // Set once the reader has reached the end of the frame.
+    bool end_of_frame_ = false;
+    // Set to stop the pipeline's threads.
+    bool stopping_ = false;
+    // Any error encountered by the pipeline, reported by ReadData.
+    zx_status_t pipeline_status_ = ZX_OK;
+
 #ifdef __Fuchsia__
     // Total time spent reading/decompressing data
     zx_ticks_t total_time_ = 0;
@@ -4,9 +4,30 @@
 
 #include "fvm/sparse-reader.h"
 
+#include <lz4/lz4.h>
+
 #include <utility>
 
 namespace fvm {
+namespace {
+
+// The parts of the LZ4 frame format which determine whether its blocks may be decompressed
+// independently of each other.
+// See https://github.com/lz4/lz4/blob/dev/lz4_Frame_format.md for details.
+constexpr size_t kLz4MinHeaderSize = 7;
+constexpr size_t kLz4ContentSizeSize = 8;
+constexpr uint8_t kLz4FlagBlockIndependent = 1 << 5;
+constexpr uint8_t kLz4FlagBlockChecksum = 1 << 4;
+constexpr uint8_t kLz4FlagContentSize = 1 << 3;
+constexpr uint8_t kLz4FlagContentChecksum = 1 << 2;
+constexpr uint8_t kLz4FlagDictId = 1 << 0;
+constexpr uint8_t kLz4BlockMaxMask = 7 << 4;
+constexpr uint8_t kLz4Block64KB = 4 << 4;
+// Set in a block's size if the block is stored uncompressed.
+constexpr uint32_t kLz4BlockUncompressed = 1u << 31;
+
+} // namespace
+
 zx_status_t SparseReader::Create(fbl::unique_fd fd, fbl::unique_ptr<SparseReader>* out) {
     return SparseReader::CreateHelper(std::move(fd), true /* verbose */, out);
 }
@@ -85,44 +106,282 @@ zx_status_t SparseReader::ReadMetadata() {
             return ZX_ERR_INTERNAL;
         }
 
-        size_t src_sz = 4;
-        size_t dst_sz = 0;
-        fbl::unique_ptr<uint8_t[]> inbufptr(new (&ac) uint8_t[src_sz]);
+        // Initialize data buffers
+        zx_status_t status;
+        if ((status = InitializeBuffer(LZ4_MAX_BLOCK_SIZE, &out_buf_)) != ZX_OK) {
+            return status;
+        } else if ((status = InitializeBuffer(LZ4_MAX_BLOCK_SIZE, &in_buf_)) != ZX_OK) {
+            return status;
+        }
+
+        return ReadFrameHeader();
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t SparseReader::ReadFrameHeader() {
+    // The frame header holds the magic number, flags, block descriptor and header checksum,
+    // preceded by the content size if the flags say it is included.
+    uint8_t header[kLz4MinHeaderSize + kLz4ContentSizeSize];
+    size_t header_size = kLz4MinHeaderSize;
+    size_t actual;
+    zx_status_t status = ReadRaw(header, header_size, &actual);
+    if (status == ZX_OK && actual == header_size && (header[4] & kLz4FlagDictId)) {
+        // The frame can only be decompressed with a dictionary, which the image does not carry.
+        fprintf(stderr, "SparseReader: compressed frames with a dictionary are not supported\n");
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (status == ZX_OK && actual == header_size && (header[4] & kLz4FlagContentSize)) {
+        header_size += kLz4ContentSizeSize;
+        status = ReadRaw(header + actual, kLz4ContentSizeSize, &actual);
+        actual += kLz4MinHeaderSize;
+    }
+    if (status != ZX_OK || actual < header_size) {
+        fprintf(stderr, "SparseReader: could not read from input\n");
+        return ZX_ERR_IO;
+    }
+
+    // Let LZ4 validate the header and tell us how much it expects in the first pass.
+    // Since we are not yet decompressing any actual data, the dst_buffer is null
+    size_t src_sz = header_size;
+    size_t dst_sz = 0;
+    to_read_ = LZ4F_decompress(dctx_, nullptr, &dst_sz, header, &src_sz, NULL);
+    if (LZ4F_isError(to_read_)) {
+        fprintf(stderr, "SparseReader: could not decompress header: %s\n",
+                LZ4F_getErrorName(to_read_));
+        return ZX_ERR_INTERNAL;
+    }
+
+    if (to_read_ > LZ4_MAX_BLOCK_SIZE) {
+        to_read_ = LZ4_MAX_BLOCK_SIZE;
+    }
+
+    // Blocks which are independent of each other can be decompressed in parallel, as long as
+    // there are no checksums for LZ4F to verify along the way.
+    const uint8_t flags = header[4];
+    const uint8_t block_desc = header[5];
+    if ((flags & (kLz4FlagBlockIndependent | kLz4FlagBlockChecksum |
+                  kLz4FlagContentChecksum)) == kLz4FlagBlockIndependent &&
+        (block_desc & kLz4BlockMaxMask) == kLz4Block64KB) {
+        return StartPipeline();
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t SparseReader::StartPipeline() {
+    fbl::AllocChecker ac;
+    for (block_t& block : blocks_) {
+        // Each read of a block also picks up the size of the block after it.
+        block.in.reset(new (&ac) uint8_t[LZ4_MAX_BLOCK_SIZE + sizeof(uint32_t)]);
         if (!ac.check()) {
             return ZX_ERR_NO_MEMORY;
         }
+        block.out.reset(new (&ac) uint8_t[LZ4_MAX_BLOCK_SIZE]);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        block.ready = false;
+    }
 
-        uint8_t* inbuf = inbufptr.get();
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workers = fbl::min(static_cast<size_t>(cpus > 0 ? cpus : 1),
+                              static_cast<size_t>(SPARSE_READER_MAX_WORKERS));
 
-        // Read first 4 bytes to let LZ4 tell us how much it expects in the first pass.
-        ssize_t nr = read(fd_.get(), inbuf, src_sz);
-        if (nr < static_cast<ssize_t>(src_sz)) {
-            fprintf(stderr, "SparseReader: could not read from input\n");
-            return ZX_ERR_IO;
+    // If the threads cannot be created, blocks are decompressed serially instead.
+    while (num_workers_ < workers) {
+        if (pthread_create(&worker_threads_[num_workers_], nullptr, PipelineWorker, this) != 0) {
+            break;
         }
+        num_workers_++;
+    }
+    if (num_workers_ == 0 ||
+        pthread_create(&reader_thread_, nullptr, PipelineReader, this) != 0) {
+        StopPipeline();
+        return ZX_OK;
+    }
+    reader_started_ = true;
+    pipelined_ = true;
+    return ZX_OK;
+}
 
-        // Run decompress once to find out how much data we should read for the next decompress run
-        // Since we are not yet decompressing any actual data, the dst_buffer is null
-        to_read_ = LZ4F_decompress(dctx_, nullptr, &dst_sz, inbuf, &src_sz, NULL);
-        if (LZ4F_isError(to_read_)) {
-            fprintf(stderr, "SparseReader: could not decompress header: %s\n",
-                    LZ4F_getErrorName(to_read_));
-            return ZX_ERR_INTERNAL;
+void SparseReader::StopPipeline() {
+    pthread_mutex_lock(&pipeline_lock_);
+    stopping_ = true;
+    pthread_cond_broadcast(&space_cond_);
+    pthread_cond_broadcast(&work_cond_);
+    pthread_cond_broadcast(&ready_cond_);
+    pthread_mutex_unlock(&pipeline_lock_);
+
+    if (reader_started_) {
+        pthread_join(reader_thread_, nullptr);
+        reader_started_ = false;
+    }
+    for (size_t i = 0; i < num_workers_; i++) {
+        pthread_join(worker_threads_[i], nullptr);
+    }
+    num_workers_ = 0;
+}
+
+void* SparseReader::PipelineReader(void* arg) {
+    static_cast<SparseReader*>(arg)->ReadBlocks();
+    return nullptr;
+}
+
+void SparseReader::ReadBlocks() {
+    uint32_t size;
+    size_t actual;
+    zx_status_t status = ReadRaw(reinterpret_cast<uint8_t*>(&size), sizeof(size), &actual);
+    if (status == ZX_OK && actual < sizeof(size)) {
+        status = ZX_ERR_IO;
+    }
+
+    // A size of zero marks the end of the frame.
+    while (status == ZX_OK && size != 0) {
+        const size_t data_size = size & ~kLz4BlockUncompressed;
+        if (data_size > LZ4_MAX_BLOCK_SIZE) {
+            fprintf(stderr, "SparseReader: block size %zu is too large\n", data_size);
+            status = ZX_ERR_IO;
+            break;
         }
 
-        if (to_read_ > LZ4_MAX_BLOCK_SIZE) {
-            to_read_ = LZ4_MAX_BLOCK_SIZE;
+        pthread_mutex_lock(&pipeline_lock_);
+        while (!stopping_ && pipeline_status_ == ZX_OK &&
+               read_ - consumed_ == SPARSE_READER_PIPELINE_DEPTH) {
+            pthread_cond_wait(&space_cond_, &pipeline_lock_);
         }
+        if (stopping_ || pipeline_status_ != ZX_OK) {
+            pthread_mutex_unlock(&pipeline_lock_);
+            return;
+        }
+        block_t* block = &blocks_[read_ % SPARSE_READER_PIPELINE_DEPTH];
+        pthread_mutex_unlock(&pipeline_lock_);
 
-        // Initialize data buffers
-        zx_status_t status;
-        if ((status = InitializeBuffer(LZ4_MAX_BLOCK_SIZE, &out_buf_)) != ZX_OK) {
-            return status;
-        } else if ((status = InitializeBuffer(LZ4_MAX_BLOCK_SIZE, &in_buf_)) != ZX_OK) {
+        // Read the block along with the size of the next one.
+        const size_t read_size = data_size + sizeof(size);
+        if ((status = ReadRaw(block->in.get(), read_size, &actual)) != ZX_OK) {
+            break;
+        } else if (actual < read_size) {
+            status = ZX_ERR_IO;
+            break;
+        }
+        block->in_size = size;
+        memcpy(&size, block->in.get() + data_size, sizeof(size));
+
+        pthread_mutex_lock(&pipeline_lock_);
+        read_++;
+        pthread_cond_signal(&work_cond_);
+        pthread_mutex_unlock(&pipeline_lock_);
+    }
+
+    if (status != ZX_OK) {
+        fprintf(stderr, "SparseReader: could not read compressed block\n");
+        FailPipeline(status);
+        return;
+    }
+
+    pthread_mutex_lock(&pipeline_lock_);
+    end_of_frame_ = true;
+    pthread_cond_broadcast(&work_cond_);
+    pthread_cond_broadcast(&ready_cond_);
+    pthread_mutex_unlock(&pipeline_lock_);
+}
+
+void* SparseReader::PipelineWorker(void* arg) {
+    static_cast<SparseReader*>(arg)->DecompressBlocks();
+    return nullptr;
+}
+
+void SparseReader::DecompressBlocks() {
+    pthread_mutex_lock(&pipeline_lock_);
+    while (true) {
+        while (!stopping_ && pipeline_status_ == ZX_OK && decompressing_ == read_ &&
+               !end_of_frame_) {
+            pthread_cond_wait(&work_cond_, &pipeline_lock_);
+        }
+        if (stopping_ || pipeline_status_ != ZX_OK || decompressing_ == read_) {
+            break;
+        }
+        block_t* block = &blocks_[decompressing_++ % SPARSE_READER_PIPELINE_DEPTH];
+        pthread_mutex_unlock(&pipeline_lock_);
+
+        const size_t size = block->in_size & ~kLz4BlockUncompressed;
+        if (block->in_size & kLz4BlockUncompressed) {
+            memcpy(block->out.get(), block->in.get(), size);
+            block->out_size = size;
+        } else {
+            int r = LZ4_decompress_safe(reinterpret_cast<const char*>(block->in.get()),
+                                        reinterpret_cast<char*>(block->out.get()),
+                                        static_cast<int>(size), LZ4_MAX_BLOCK_SIZE);
+            if (r < 0) {
+                fprintf(stderr, "could not decompress input: block is corrupt\n");
+                FailPipeline(ZX_ERR_IO);
+                return;
+            }
+            block->out_size = r;
+        }
+
+        pthread_mutex_lock(&pipeline_lock_);
+        block->ready = true;
+        pthread_cond_signal(&ready_cond_);
+    }
+    pthread_mutex_unlock(&pipeline_lock_);
+}
+
+void SparseReader::FailPipeline(zx_status_t status) {
+    pthread_mutex_lock(&pipeline_lock_);
+    if (pipeline_status_ == ZX_OK) {
+        pipeline_status_ = status;
+    }
+    pthread_cond_broadcast(&space_cond_);
+    pthread_cond_broadcast(&work_cond_);
+    pthread_cond_broadcast(&ready_cond_);
+    pthread_mutex_unlock(&pipeline_lock_);
+}
+
+zx_status_t SparseReader::ReadPipelined(uint8_t* data, size_t length, size_t* actual) {
+    size_t total_size = 0;
+    pthread_mutex_lock(&pipeline_lock_);
+    while (total_size < length) {
+        // Wait for the oldest block to be decompressed, or for the end of the frame.
+        block_t* block = &blocks_[consumed_ % SPARSE_READER_PIPELINE_DEPTH];
+        while (pipeline_status_ == ZX_OK &&
+               (consumed_ == read_ ? !end_of_frame_ : !block->ready)) {
+            pthread_cond_wait(&ready_cond_, &pipeline_lock_);
+        }
+        if (pipeline_status_ != ZX_OK) {
+            zx_status_t status = pipeline_status_;
+            pthread_mutex_unlock(&pipeline_lock_);
             return status;
         }
+        if (consumed_ == read_) {
+            break;
+        }
+        pthread_mutex_unlock(&pipeline_lock_);
+
+        size_t cp = fbl::min(length - total_size, block->out_size - consume_offset_);
+        memcpy(data + total_size, block->out.get() + consume_offset_, cp);
+        total_size += cp;
+        consume_offset_ += cp;
+
+        pthread_mutex_lock(&pipeline_lock_);
+        if (consume_offset_ == block->out_size) {
+            // Hand the block back to the reader.
+            block->ready = false;
+            consume_offset_ = 0;
+            consumed_++;
+            pthread_cond_signal(&space_cond_);
+        }
     }
+    bool end = consumed_ == read_ && end_of_frame_;
+    pthread_mutex_unlock(&pipeline_lock_);
 
+    if (total_size == 0 && end) {
+        // There is no more to read
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    *actual = total_size;
     return ZX_OK;
 }
 
@@ -146,11 +405,17 @@ zx_status_t SparseReader::InitializeBuffer(size_t size, buffer_t* out_buf) {
 }
 
 SparseReader::~SparseReader() {
+    StopPipeline();
     PrintStats();
 
     if (compressed_) {
         LZ4F_freeDecompressionContext(dctx_);
     }
+
+    pthread_cond_destroy(&ready_cond_);
+    pthread_cond_destroy(&work_cond_);
+    pthread_cond_destroy(&space_cond_);
+    pthread_mutex_destroy(&pipeline_lock_);
 }
 
 fvm::sparse_image_t* SparseReader::Image() {
@@ -168,7 +433,12 @@ zx_status_t SparseReader::ReadData(uint8_t* data, size_t length, size_t* actual)
     zx_ticks_t start = zx_ticks_get();
 #endif
     size_t total_size = 0;
-    if (compressed_) {
+    if (pipelined_) {
+        zx_status_t status = ReadPipelined(data, length, &total_size);
+        if (status != ZX_OK) {
+            return status;
+        }
+    } else if (compressed_) {
         if (out_buf_.is_empty() && to_read_ == 0) {
             // There is no more to read
             return ZX_ERR_OUT_OF_RANGE;
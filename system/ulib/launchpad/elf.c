@@ -8,7 +8,9 @@
 
 #include <zircon/process.h>
 #include <zircon/syscalls.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 struct elf_load_info {
     elf_load_header_t header;
@@ -41,6 +43,25 @@ zx_status_t elf_load_start(zx_handle_t vmo, const void* hdr_buf, size_t buf_sz,
     return status;
 }
 
+zx_status_t elf_load_copy(const elf_load_info_t* info,
+                          elf_load_info_t** infop) {
+    size_t size = sizeof(*info) +
+        (size_t)info->header.e_phnum * sizeof(elf_phdr_t);
+    elf_load_info_t* copy = malloc(size);
+    if (copy == NULL)
+        return ZX_ERR_NO_MEMORY;
+    memcpy(copy, info, size);
+    *infop = copy;
+    return ZX_OK;
+}
+
+bool elf_load_same_layout(const elf_load_info_t* a, const elf_load_info_t* b) {
+    return (a->header.e_entry == b->header.e_entry &&
+            a->header.e_phnum == b->header.e_phnum &&
+            !memcmp(a->phdrs, b->phdrs,
+                    (size_t)a->header.e_phnum * sizeof(elf_phdr_t)));
+}
+
 zx_status_t elf_load_get_interp(elf_load_info_t* info, zx_handle_t vmo,
                                 char** interp, size_t* interp_len) {
     char *buffer = NULL;
@@ -69,6 +90,37 @@ zx_status_t elf_load_finish(zx_handle_t vmar, elf_load_info_t* info,
                                  segments_vmar, base, entry);
 }
 
+zx_status_t elf_load_prepare_segments(elf_load_info_t* info, zx_handle_t vmo,
+                                      zx_handle_t** data_vmos, size_t* count) {
+    size_t phnum = info->header.e_phnum;
+    zx_handle_t* handles = calloc(phnum, sizeof(zx_handle_t));
+    if (handles == NULL && phnum > 0)
+        return ZX_ERR_NO_MEMORY;
+    zx_status_t status = ZX_OK;
+    for (size_t i = 0; status == ZX_OK && i < phnum; ++i) {
+        if (info->phdrs[i].p_type == PT_LOAD)
+            status = elf_load_prepare_data(vmo, &info->phdrs[i], &handles[i]);
+    }
+    if (status != ZX_OK) {
+        zx_handle_close_many(handles, phnum);
+        free(handles);
+        return status;
+    }
+    *data_vmos = handles;
+    *count = phnum;
+    return ZX_OK;
+}
+
+zx_status_t elf_load_finish_prepared(zx_handle_t vmar, elf_load_info_t* info,
+                                     zx_handle_t vmo,
+                                     const zx_handle_t* data_vmos,
+                                     zx_handle_t* segments_vmar,
+                                     zx_vaddr_t* base, zx_vaddr_t* entry) {
+    return elf_load_map_prepared_segments(vmar, &info->header, info->phdrs,
+                                          vmo, data_vmos, segments_vmar,
+                                          base, entry);
+}
+
 size_t elf_load_get_stack_size(elf_load_info_t* info) {
     for (uint_fast16_t i = 0; i < info->header.e_phnum; ++i) {
         if (info->phdrs[i].p_type == PT_GNU_STACK)
@@ -19,6 +19,15 @@ zx_status_t elf_load_start(zx_handle_t vmo, const void* buf, size_t buf_sz,
 // Clean up and free the data structure created by elf_load_start.
 void elf_load_destroy(elf_load_info_t* info);
 
+// Make an independent copy of a data structure created by elf_load_start.
+// The copy must be passed to elf_load_destroy when finished.
+zx_status_t elf_load_copy(const elf_load_info_t* info,
+                          elf_load_info_t** infop);
+
+// Check whether two data structures created by elf_load_start describe
+// the same layout, i.e. have identical ELF and program headers.
+bool elf_load_same_layout(const elf_load_info_t* a, const elf_load_info_t* b);
+
 // Check if the ELF file has a PT_INTERP header.  On success, *interp
 // is NULL if it had none or a malloc'd string of the contents;
 // *interp_len is strlen(*interp).
@@ -37,4 +46,19 @@ zx_status_t elf_load_finish(zx_handle_t vmar, elf_load_info_t* info,
                             zx_handle_t* segments_vmar,
                             zx_vaddr_t* base, zx_vaddr_t* entry);
 
+// Make the VMOs that elf_load_finish_prepared loads the file's writable
+// segments from.  *data_vmos is a malloc'd array of *count handles, one
+// for each program header, which are ZX_HANDLE_INVALID where there's no
+// writable data.
+zx_status_t elf_load_prepare_segments(elf_load_info_t* info, zx_handle_t vmo,
+                                      zx_handle_t** data_vmos, size_t* count);
+
+// Like elf_load_finish, but each process gets a copy-on-write clone of
+// the VMOs made by elf_load_prepare_segments for its writable segments.
+zx_status_t elf_load_finish_prepared(zx_handle_t vmar, elf_load_info_t* info,
+                                     zx_handle_t vmo,
+                                     const zx_handle_t* data_vmos,
+                                     zx_handle_t* segments_vmar,
+                                     zx_vaddr_t* base, zx_vaddr_t* entry);
+
 #pragma GCC visibility pop
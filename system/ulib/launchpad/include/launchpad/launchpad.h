@@ -379,6 +379,19 @@ zx_status_t launchpad_get_vdso_vmo(zx_handle_t* out);
 // return value will be ZX_HANDLE_INVALID.
 zx_handle_t launchpad_set_vdso_vmo(zx_handle_t vmo);
 
+// Enable or disable the globally-held cache of ELF images, and return
+// the old setting.  It's disabled by default.  When enabled, launching a
+// file that launchpad has loaded before (the executable, or the dynamic
+// linker named by its PT_INTERP) gives the new process copy-on-write
+// clones of the cached VMOs for the file's writable segments, rather than
+// preparing them from the file again.  Files are recognized by the VM
+// object behind the one launchpad is given and by their ELF headers, which
+// are read for every launch; the dynamic linker is still requested from
+// the loader service every time.  Each process still gets its own
+// mappings at a randomized address.  Disabling the cache discards its
+// contents.
+bool launchpad_set_image_cache(bool enable);
+
 // Add the VM object handle for the system vDSO to the launchpad, so
 // the launched process will be able to load it into its own
 // children.  This is just shorthand for launchpad_add_handle with
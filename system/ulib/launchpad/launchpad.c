@@ -359,6 +359,180 @@ static void check_elf_stack_size(launchpad_t* lp, elf_load_info_t* elf) {
         launchpad_set_stack_size(lp, elf_stack_size);
 }
 
+// The image cache holds what launching an ELF file needs besides the
+// file itself, for files that are launched again and again: the VMOs its
+// writable segments are loaded from, with the partial page at the start
+// of each bss already cleared.  Each launch maps the read-only segments
+// straight from the file, as always, and gives the process its own
+// copy-on-write clone of each cached data VMO.  Segments are still mapped
+// at a randomized address in each process.
+//
+// Entries are keyed by the identity of the file and by its layout.  The
+// VMO a launch is given is usually a clone made for that request, so its
+// parent identifies the file.  The file's ELF headers are read for every
+// launch, and an entry is only used if they match the cached ones.
+#define IMAGE_CACHE_SIZE 8
+
+typedef struct {
+    zx_koid_t file_koid;
+    uint64_t file_size;
+    elf_load_info_t* elf;
+    zx_handle_t* data_vmos;
+    size_t count;
+} image_cache_entry_t;
+
+static mtx_t image_cache_mutex = MTX_INIT;
+static bool image_cache_enabled;
+static image_cache_entry_t image_cache[IMAGE_CACHE_SIZE];
+static size_t image_cache_next;
+
+static void image_cache_lock(void) __TA_ACQUIRE(&image_cache_mutex) {
+    mtx_lock(&image_cache_mutex);
+}
+static void image_cache_unlock(void) __TA_RELEASE(&image_cache_mutex) {
+    mtx_unlock(&image_cache_mutex);
+}
+
+static void free_data_vmos(zx_handle_t* data_vmos, size_t count) {
+    if (data_vmos != NULL) {
+        zx_handle_close_many(data_vmos, count);
+        free(data_vmos);
+    }
+}
+
+static void image_cache_clear_entry(image_cache_entry_t* entry) {
+    if (entry->elf != NULL)
+        elf_load_destroy(entry->elf);
+    free_data_vmos(entry->data_vmos, entry->count);
+    memset(entry, 0, sizeof(*entry));
+}
+
+bool launchpad_set_image_cache(bool enable) {
+    image_cache_lock();
+    bool old = image_cache_enabled;
+    image_cache_enabled = enable;
+    if (!enable) {
+        for (size_t i = 0; i < IMAGE_CACHE_SIZE; ++i)
+            image_cache_clear_entry(&image_cache[i]);
+        image_cache_next = 0;
+    }
+    image_cache_unlock();
+    return old;
+}
+
+// Identify the file behind a VMO, looking through the clone made for
+// this request.
+static zx_status_t get_file_identity(zx_handle_t vmo,
+                                     zx_koid_t* koid, uint64_t* size) {
+    zx_info_vmo_t info;
+    zx_status_t status = zx_object_get_info(vmo, ZX_INFO_VMO,
+                                            &info, sizeof(info), NULL, NULL);
+    if (status != ZX_OK)
+        return status;
+    *koid = info.parent_koid != ZX_KOID_INVALID ?
+        info.parent_koid : info.koid;
+    *size = info.size_bytes;
+    return ZX_OK;
+}
+
+// Duplicate the handles of a cached entry, for use without the lock held.
+static zx_status_t dup_data_vmos(const image_cache_entry_t* entry,
+                                 zx_handle_t** data_vmos, size_t* count) {
+    zx_handle_t* handles = calloc(entry->count, sizeof(zx_handle_t));
+    if (handles == NULL && entry->count > 0)
+        return ZX_ERR_NO_MEMORY;
+    for (size_t i = 0; i < entry->count; ++i) {
+        if (entry->data_vmos[i] == ZX_HANDLE_INVALID)
+            continue;
+        zx_status_t status = zx_handle_duplicate(entry->data_vmos[i],
+                                                 ZX_RIGHT_SAME_RIGHTS,
+                                                 &handles[i]);
+        if (status != ZX_OK) {
+            free_data_vmos(handles, entry->count);
+            return status;
+        }
+    }
+    *data_vmos = handles;
+    *count = entry->count;
+    return ZX_OK;
+}
+
+// Find the data VMOs for the file 'vmo' with headers 'elf' in the cache,
+// or make them and add them to it.  This is best-effort: on failure, the
+// segments are loaded from the file as they would be without the cache.
+static zx_status_t image_cache_get(elf_load_info_t* elf, zx_handle_t vmo,
+                                   zx_handle_t** data_vmos, size_t* count) {
+    zx_koid_t koid;
+    uint64_t size;
+    zx_status_t status = get_file_identity(vmo, &koid, &size);
+    if (status != ZX_OK)
+        return status;
+
+    image_cache_lock();
+    if (!image_cache_enabled) {
+        image_cache_unlock();
+        return ZX_ERR_NOT_FOUND;
+    }
+    for (size_t i = 0; i < IMAGE_CACHE_SIZE; ++i) {
+        image_cache_entry_t* entry = &image_cache[i];
+        if (entry->elf != NULL && entry->file_koid == koid &&
+            entry->file_size == size && elf_load_same_layout(entry->elf, elf)) {
+            status = dup_data_vmos(entry, data_vmos, count);
+            image_cache_unlock();
+            return status;
+        }
+    }
+    image_cache_unlock();
+
+    status = elf_load_prepare_segments(elf, vmo, data_vmos, count);
+    if (status != ZX_OK)
+        return status;
+
+    // Cache a copy, replacing the oldest entry.  Another launch of the
+    // same file may have raced with this one, which only costs a slot.
+    image_cache_entry_t new_entry = {
+        .file_koid = koid,
+        .file_size = size,
+    };
+    if (elf_load_copy(elf, &new_entry.elf) == ZX_OK) {
+        new_entry.data_vmos = *data_vmos;
+        new_entry.count = *count;
+        if (dup_data_vmos(&new_entry, &new_entry.data_vmos,
+                          &new_entry.count) != ZX_OK) {
+            new_entry.data_vmos = NULL;
+            image_cache_clear_entry(&new_entry);
+            return ZX_OK;
+        }
+        image_cache_lock();
+        if (image_cache_enabled) {
+            image_cache_entry_t* entry = &image_cache[image_cache_next];
+            image_cache_next = (image_cache_next + 1) % IMAGE_CACHE_SIZE;
+            image_cache_clear_entry(entry);
+            *entry = new_entry;
+        } else {
+            image_cache_clear_entry(&new_entry);
+        }
+        image_cache_unlock();
+    }
+    return ZX_OK;
+}
+
+// Load the segments of the file 'vmo' with headers 'elf' into the
+// process, using the image cache if it's enabled.
+static zx_status_t load_segments(launchpad_t* lp, elf_load_info_t* elf,
+                                 zx_handle_t vmo, zx_handle_t* segments_vmar,
+                                 zx_vaddr_t* base, zx_vaddr_t* entry) {
+    zx_handle_t* data_vmos = NULL;
+    size_t count = 0;
+    if (image_cache_get(elf, vmo, &data_vmos, &count) != ZX_OK)
+        data_vmos = NULL;
+    zx_status_t status = elf_load_finish_prepared(lp_vmar(lp), elf, vmo,
+                                                  data_vmos, segments_vmar,
+                                                  base, entry);
+    free_data_vmos(data_vmos, count);
+    return status;
+}
+
 zx_status_t launchpad_elf_load_basic(launchpad_t* lp, zx_handle_t vmo) {
     if (vmo == ZX_HANDLE_INVALID)
         return lp_error(lp, ZX_ERR_INVALID_ARGS, "elf_load: invalid vmo");
@@ -370,8 +544,8 @@ zx_status_t launchpad_elf_load_basic(launchpad_t* lp, zx_handle_t vmo) {
     if ((status = elf_load_start(vmo, NULL, 0, &elf)))
         lp_error(lp, status, "elf_load: elf_load_start() failed");
     zx_handle_t segments_vmar;
-    if ((status = elf_load_finish(lp_vmar(lp), elf, vmo,
-                                  &segments_vmar, &lp->base, &lp->entry)))
+    if ((status = load_segments(lp, elf, vmo,
+                                &segments_vmar, &lp->base, &lp->entry)))
         lp_error(lp, status, "elf_load: elf_load_finish() failed");
     check_elf_stack_size(lp, elf);
     elf_load_destroy(elf);
@@ -540,8 +714,8 @@ static zx_status_t handle_interp(launchpad_t* lp, zx_handle_t vmo,
     zx_handle_t segments_vmar;
     status = elf_load_start(interp_vmo, NULL, 0, &elf);
     if (status == ZX_OK) {
-        status = elf_load_finish(lp_vmar(lp), elf, interp_vmo,
-                                 &segments_vmar, &lp->base, &lp->entry);
+        status = load_segments(lp, elf, interp_vmo,
+                               &segments_vmar, &lp->base, &lp->entry);
         elf_load_destroy(elf);
     }
     zx_handle_close(interp_vmo);
@@ -577,8 +751,8 @@ static zx_status_t launchpad_elf_load_body(launchpad_t* lp, const char* hdr_buf,
         } else {
             if (interp == NULL) {
                 zx_handle_t segments_vmar;
-                status = elf_load_finish(lp_vmar(lp), elf, vmo, &segments_vmar,
-                                         &lp->base, &lp->entry);
+                status = load_segments(lp, elf, vmo, &segments_vmar,
+                                       &lp->base, &lp->entry);
                 if (status != ZX_OK) {
                     lp_error(lp, status, "elf_load: elf_load_finish() failed");
                 } else {
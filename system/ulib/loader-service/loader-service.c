@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <threads.h>
 #include <unistd.h>
 #include <zircon/compiler.h>
 #include <zircon/device/vfs.h>
@@ -26,6 +27,22 @@
 
 #define PREFIX_MAX 32
 
+// Maximum number of objects cached by each instance of the default
+// loader service.
+#define VMO_CACHE_MAX 64
+
+// An object previously resolved by the default loader service, and the
+// identity of the file it was read from.
+typedef struct cached_vmo {
+    // The entry of |lib_paths| in which the file was found.
+    const char* lib_path;
+    char* name;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    zx_handle_t vmo;
+} cached_vmo_t;
+
 // State of a loader service instance.
 typedef struct instance_state instance_state_t;
 struct instance_state {
@@ -33,6 +50,18 @@ struct instance_state {
   int data_sink_dir_fd;
   // NULL-terminated list of paths from which objects will loaded.
   const char* const* lib_paths;
+
+  // Every process started with this instance asks it for much the same
+  // set of libraries, so objects are cached to spare fetching a new VMO
+  // from the filesystem for each. The file is still looked up for every
+  // request, and its cached VMO used only if it is the very same file, so
+  // a library replaced or rewritten since is loaded afresh. Clients only
+  // ever receive copy-on-write clones, so none can modify what the others
+  // are given.
+  mtx_t cache_lock;
+  cached_vmo_t cache[VMO_CACHE_MAX];
+  // Index of the next entry to be replaced once the cache is full.
+  size_t cache_next;
 };
 
 // This represents an instance of the loader service. Each session in an
@@ -68,9 +97,10 @@ static void loader_service_deref(loader_service_t* svc) {
 }
 
 // When loading a library object, search in the locations provided in
-// |lib_paths|, which is required to be NULL-terminated.
+// |lib_paths|, which is required to be NULL-terminated. The entry in which
+// the object was found is returned in |lib_path_out|.
 static int open_from_lib_paths(int root_dir_fd, const char* const* lib_paths,
-                               const char* fn) {
+                               const char* fn, const char** lib_path_out) {
     int fd = -1;
     for (size_t n = 0; fd < 0 && lib_paths[n]; ++n) {
         char path[PATH_MAX];
@@ -78,6 +108,7 @@ static int open_from_lib_paths(int root_dir_fd, const char* const* lib_paths,
             return -1;
         }
         fd = openat(root_dir_fd, path, O_RDONLY);
+        *lib_path_out = lib_paths[n];
     }
     return fd;
 }
@@ -92,15 +123,110 @@ static zx_handle_t vmo_from_fd(int fd, const char* fn, zx_handle_t* out) {
     return status;
 }
 
+static zx_status_t clone_vmo(zx_handle_t vmo, uint64_t size, const char* fn, zx_handle_t* out) {
+    zx_status_t status = zx_vmo_clone(vmo, ZX_VMO_CLONE_COPY_ON_WRITE, 0, size, out);
+    if (status == ZX_OK) {
+        zx_object_set_property(*out, ZX_PROP_NAME, fn, strlen(fn));
+    }
+    return status;
+}
+
+// Whether |entry| holds the file |name|, found in |lib_path| with the
+// attributes |st|. Files are told apart by inode number, so that one
+// replaced by another of the same name is not mistaken for it, and by size
+// and modification time, so that one rewritten in place is not either.
+static bool vmo_cache_matches(const cached_vmo_t* entry, const char* lib_path,
+                              const char* name, const struct stat* st) {
+    return entry->name != NULL && entry->lib_path == lib_path &&
+           strcmp(entry->name, name) == 0 && entry->ino == st->st_ino &&
+           entry->size == st->st_size && entry->mtime.tv_sec == st->st_mtim.tv_sec &&
+           entry->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+// Returns a clone of the cached object |name| in |out|, if it was read from
+// the file found in |lib_path| with the attributes |st|.
+static zx_status_t vmo_cache_lookup(instance_state_t* state, const char* lib_path,
+                                    const char* name, const struct stat* st,
+                                    zx_handle_t* out) {
+    zx_status_t status = ZX_ERR_NOT_FOUND;
+    mtx_lock(&state->cache_lock);
+    for (size_t i = 0; i < VMO_CACHE_MAX; ++i) {
+        cached_vmo_t* entry = &state->cache[i];
+        if (vmo_cache_matches(entry, lib_path, name, st)) {
+            status = clone_vmo(entry->vmo, st->st_size, name, out);
+            break;
+        }
+    }
+    mtx_unlock(&state->cache_lock);
+    return status;
+}
+
+// Caches the object |name| newly read from the file found in |lib_path|
+// with the attributes |st|, in place of any older version of it. On
+// success, |*vmo| is kept by the cache and replaced with a clone to return
+// to the client; on failure, |*vmo| is left alone and simply not cached.
+static void vmo_cache_insert(instance_state_t* state, const char* lib_path, const char* name,
+                             const struct stat* st, zx_handle_t* vmo) {
+    zx_handle_t clone;
+    if (clone_vmo(*vmo, st->st_size, name, &clone) != ZX_OK) {
+        return;
+    }
+    char* cached_name = strdup(name);
+    if (cached_name == NULL) {
+        zx_handle_close(clone);
+        return;
+    }
+
+    mtx_lock(&state->cache_lock);
+    cached_vmo_t* entry = NULL;
+    for (size_t i = 0; i < VMO_CACHE_MAX; ++i) {
+        cached_vmo_t* stale = &state->cache[i];
+        if (stale->name != NULL && stale->lib_path == lib_path &&
+            strcmp(stale->name, name) == 0) {
+            entry = stale;
+            break;
+        }
+    }
+    if (entry == NULL) {
+        entry = &state->cache[state->cache_next];
+        state->cache_next = (state->cache_next + 1) % VMO_CACHE_MAX;
+    }
+    free(entry->name);
+    zx_handle_close(entry->vmo);
+    entry->lib_path = lib_path;
+    entry->name = cached_name;
+    entry->ino = st->st_ino;
+    entry->size = st->st_size;
+    entry->mtime = st->st_mtim;
+    entry->vmo = *vmo;
+    mtx_unlock(&state->cache_lock);
+
+    *vmo = clone;
+}
+
 static zx_status_t fd_load_object(void* ctx, const char* name, zx_handle_t* out) {
-    int root_dir_fd = ((instance_state_t*)ctx)->root_dir_fd;
-    const char* const* lib_paths = ((instance_state_t*)ctx)->lib_paths;
+    instance_state_t* instance_state = (instance_state_t*)ctx;
+    const char* lib_path;
+    int fd = open_from_lib_paths(instance_state->root_dir_fd, instance_state->lib_paths,
+                                 name, &lib_path);
+    if (fd < 0) {
+        return ZX_ERR_NOT_FOUND;
+    }
 
-    int fd = open_from_lib_paths(root_dir_fd, lib_paths, name);
-    if (fd >= 0) {
-        return vmo_from_fd(fd, name, out);
+    // Files whose filesystem cannot identify them are never cached.
+    struct stat st;
+    bool cacheable = fstat(fd, &st) == 0 && st.st_ino != (ino_t)-1;
+    if (cacheable &&
+        vmo_cache_lookup(instance_state, lib_path, name, &st, out) == ZX_OK) {
+        close(fd);
+        return ZX_OK;
     }
-    return ZX_ERR_NOT_FOUND;
+
+    zx_status_t status = vmo_from_fd(fd, name, out);
+    if (status == ZX_OK && cacheable) {
+        vmo_cache_insert(instance_state, lib_path, name, &st, out);
+    }
+    return status;
 }
 
 static zx_status_t fd_load_abspath(void* ctx, const char* path, zx_handle_t* out) {
@@ -123,6 +249,11 @@ void fd_finalizer(void* ctx) {
     int data_sink_dir_fd = instance_state->data_sink_dir_fd;
     close(root_dir_fd);
     close(data_sink_dir_fd);
+    for (size_t i = 0; i < VMO_CACHE_MAX; ++i) {
+        free(instance_state->cache[i].name);
+        zx_handle_close(instance_state->cache[i].vmo);
+    }
+    mtx_destroy(&instance_state->cache_lock);
     free(instance_state);
 }
 
@@ -307,10 +438,11 @@ zx_status_t loader_service_create_default(async_dispatcher_t* dispatcher,
                                           int data_sink_dir_fd,
                                           const char* const* lib_paths,
                                           loader_service_t** out) {
-    instance_state_t* instance_state = calloc(1, sizeof(loader_service_t));
+    instance_state_t* instance_state = calloc(1, sizeof(instance_state_t));
     if (instance_state == NULL) {
         return ZX_ERR_NO_MEMORY;
     }
+    mtx_init(&instance_state->cache_lock, mtx_plain);
     instance_state->root_dir_fd = root_dir_fd;
     instance_state->data_sink_dir_fd = data_sink_dir_fd;
     instance_state->lib_paths = lib_paths? lib_paths : fd_lib_paths;
@@ -43,6 +43,10 @@ private:
     zx_status_t ReadAndDispatchMessage(fidl::MessageBuffer* buffer, async_dispatcher_t* dispatcher);
 
     zx_status_t Connect(fidl::Message message, async_dispatcher_t* dispatcher);
+    zx_status_t ConnectWithRing(fidl::Message message, async_dispatcher_t* dispatcher);
+    zx_status_t BeginReading(zx::socket socket, async_dispatcher_t* dispatcher);
+
+    zx_status_t DrainRing();
 
     zx_status_t PrintLogMessage(const fx_log_packet_t* packet);
 
@@ -50,6 +54,9 @@ private:
 
     zx::channel channel_;
     zx::socket socket_;
+    fx_log_ring_t* ring_ = nullptr;
+    // Position of the next slot of |ring_| to read.
+    uint64_t ring_position_ = 0;
     int fd_;
     async::WaitMethod<LoggerImpl, &LoggerImpl::OnHandleReady> wait_;
     async::WaitMethod<LoggerImpl, &LoggerImpl::OnLogMessage> socket_wait_;
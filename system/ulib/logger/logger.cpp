@@ -4,10 +4,13 @@
 
 #include <lib/logger/logger.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/string_buffer.h>
 #include <fuchsia/logger/c/fidl.h>
 #include <lib/fidl/cpp/message_buffer.h>
 #include <lib/zx/channel.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
 #include <stdint.h>
 #include <lib/syslog/logger.h>
 #include <lib/syslog/wire_format.h>
@@ -21,6 +24,9 @@ namespace {
 
 static fx_log_packet_t packet;
 
+constexpr size_t kRingMappingSize = fbl::round_up(sizeof(fx_log_ring_t),
+                                                  static_cast<size_t>(PAGE_SIZE));
+
 } // namespace
 
 LoggerImpl::LoggerImpl(zx::channel channel, int out_fd)
@@ -31,6 +37,10 @@ LoggerImpl::LoggerImpl(zx::channel channel, int out_fd)
 }
 
 LoggerImpl::~LoggerImpl() {
+    if (ring_ != nullptr) {
+        __atomic_store_n(&ring_->connected, 0, __ATOMIC_SEQ_CST);
+        zx::vmar::root_self()->unmap(reinterpret_cast<uintptr_t>(ring_), kRingMappingSize);
+    }
     fsync(fd_);
 }
 
@@ -100,6 +110,14 @@ void LoggerImpl::OnLogMessage(async_dispatcher_t* dispatcher, async::WaitBase* w
         return;
     }
 
+    if (signal->observed & ZX_USER_SIGNAL_0) {
+        status = DrainRing();
+        if (status != ZX_OK) {
+            NotifyError(status);
+            return;
+        }
+    }
+
     if (signal->observed & ZX_SOCKET_READABLE) {
         memset(&packet, 0, sizeof(packet));
         status = socket_.read(0, &packet, sizeof(packet), nullptr);
@@ -117,15 +135,58 @@ void LoggerImpl::OnLogMessage(async_dispatcher_t* dispatcher, async::WaitBase* w
                 return;
             }
         }
-        status = wait->Begin(dispatcher);
-        if (status != ZX_OK) {
-            NotifyError(status);
+    } else if (signal->observed & ZX_SOCKET_PEER_CLOSED) {
+        // Read what the client left in the ring before it went away.
+        if (ring_ != nullptr) {
+            DrainRing();
         }
+        NotifyError(ZX_ERR_PEER_CLOSED);
         return;
     }
 
-    ZX_DEBUG_ASSERT(signal->observed & ZX_SOCKET_PEER_CLOSED);
-    NotifyError(ZX_ERR_PEER_CLOSED);
+    status = wait->Begin(dispatcher);
+    if (status != ZX_OK) {
+        NotifyError(status);
+    }
+}
+
+// Reads the packets written to the ring, up to one ring's worth at a time so
+// that a busy client does not starve the others.
+zx_status_t LoggerImpl::DrainRing() {
+    zx_status_t status = socket_.signal(ZX_USER_SIGNAL_0, 0);
+    if (status != ZX_OK) {
+        return status;
+    }
+    bool waiting = false;
+    size_t count = 0;
+    while (count < FX_LOG_RING_SLOTS) {
+        fx_log_ring_slot_t* slot = &ring_->slots[ring_position_ % FX_LOG_RING_SLOTS];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) != ring_position_ + 1) {
+            if (waiting) {
+                return ZX_OK;
+            }
+            // Ask writers to signal, then look once more for a packet
+            // written before they could see the request.
+            __atomic_store_n(&ring_->waiting, 1, __ATOMIC_SEQ_CST);
+            waiting = true;
+            continue;
+        }
+        size_t size = fbl::min(static_cast<size_t>(__atomic_load_n(&slot->size, __ATOMIC_RELAXED)),
+                               sizeof(packet));
+        memset(&packet, 0, sizeof(packet));
+        memcpy(&packet, &slot->packet, size);
+        __atomic_store_n(&slot->sequence, ring_position_ + FX_LOG_RING_SLOTS, __ATOMIC_RELEASE);
+        ring_position_++;
+        count++;
+
+        packet.data[sizeof(packet.data) - 1] = 0;
+        status = PrintLogMessage(&packet);
+        if (status == ZX_ERR_INVALID_ARGS) {
+            return status;
+        }
+    }
+    // Come back for the rest of the ring once other work has been done.
+    return socket_.signal(0, ZX_USER_SIGNAL_0);
 }
 
 void LoggerImpl::OnHandleReady(async_dispatcher_t* dispatcher, async::WaitBase* wait, zx_status_t status,
@@ -172,6 +233,8 @@ zx_status_t LoggerImpl::ReadAndDispatchMessage(fidl::MessageBuffer* buffer, asyn
     switch (message.ordinal()) {
     case fuchsia_logger_LogSinkConnectOrdinal:
         return Connect(std::move(message), dispatcher);
+    case fuchsia_logger_LogSinkConnectWithRingOrdinal:
+        return ConnectWithRing(std::move(message), dispatcher);
     default:
         fprintf(stderr, "logger: error: Unknown message ordinal: %d\n", message.ordinal());
         return ZX_ERR_NOT_SUPPORTED;
@@ -189,14 +252,63 @@ zx_status_t LoggerImpl::Connect(fidl::Message message, async_dispatcher_t* dispa
         return status;
     }
     auto* request = message.GetBytesAs<fuchsia_logger_LogSinkConnectRequest>();
-    socket_.reset(request->socket);
+    return BeginReading(zx::socket(request->socket), dispatcher);
+}
+
+zx_status_t LoggerImpl::ConnectWithRing(fidl::Message message, async_dispatcher_t* dispatcher) {
+    if (socket_) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    const char* error_msg = nullptr;
+    zx_status_t status = message.Decode(&fuchsia_logger_LogSinkConnectWithRingRequestTable,
+                                        &error_msg);
+    if (status != ZX_OK) {
+        fprintf(stderr, "logger: error: ConnectWithRing: %s\n", error_msg);
+        return status;
+    }
+    auto* request = message.GetBytesAs<fuchsia_logger_LogSinkConnectWithRingRequest>();
+    zx::socket socket(request->socket);
+    zx::vmo vmo(request->ring);
+    uint64_t size;
+    status = vmo.get_size(&size);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (size < sizeof(fx_log_ring_t)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    uintptr_t addr;
+    status = zx::vmar::root_self()->map(0, vmo, 0, kRingMappingSize,
+                                        ZX_VM_PERM_READ | ZX_VM_PERM_WRITE |
+                                        ZX_VM_REQUIRE_NON_RESIZABLE, &addr);
+    if (status != ZX_OK) {
+        fprintf(stderr, "logger: error: ConnectWithRing: cannot map ring: %s\n",
+                zx_status_get_string(status));
+        return status;
+    }
+    ring_ = reinterpret_cast<fx_log_ring_t*>(addr);
+    // Loggers write to the ring only once it has been accepted.
+    __atomic_store_n(&ring_->connected, 1, __ATOMIC_RELEASE);
+    return BeginReading(std::move(socket), dispatcher);
+}
+
+zx_status_t LoggerImpl::BeginReading(zx::socket socket, async_dispatcher_t* dispatcher) {
+    socket_ = std::move(socket);
     socket_wait_.set_object(socket_.get());
-    socket_wait_.set_trigger(ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED);
+    zx_signals_t trigger = ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED;
+    if (ring_ != nullptr) {
+        trigger |= ZX_USER_SIGNAL_0;
+    }
+    socket_wait_.set_trigger(trigger);
     socket_wait_.Begin(dispatcher);
     return ZX_OK;
 }
 
 void LoggerImpl::NotifyError(zx_status_t error) {
+    if (ring_ != nullptr) {
+        // Loggers go back to the socket, and find it closed.
+        __atomic_store_n(&ring_->connected, 0, __ATOMIC_SEQ_CST);
+    }
     socket_wait_.Cancel();
     wait_.Cancel();
     channel_.reset();
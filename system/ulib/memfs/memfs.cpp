@@ -13,7 +13,6 @@
 
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
-#include <fbl/auto_lock.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
 #include <lib/fdio/namespace.h>
@@ -37,12 +36,12 @@ namespace memfs {
 zx_status_t Vfs::CreateFromVmo(VnodeDir* parent, fbl::StringPiece name,
                                zx_handle_t vmo, zx_off_t off,
                                zx_off_t len) {
-    fbl::AutoLock lock(&vfs_lock_);
+    fs::ExclusiveLock lock(&vfs_lock_);
     return parent->CreateFromVmo(name, vmo, off, len);
 }
 
 void Vfs::MountSubtree(VnodeDir* parent, fbl::RefPtr<VnodeDir> subtree) {
-    fbl::AutoLock lock(&vfs_lock_);
+    fs::ExclusiveLock lock(&vfs_lock_);
     parent->MountSubtree(std::move(subtree));
 }
 
@@ -91,6 +91,7 @@ zx_status_t Allocator::Create(Bcache* bc, SuperblockManager* sb, fs::ReadTxn* tx
     blk_t pool_blocks = BitmapBlocksForSize(allocator->metadata_.PoolTotal());
 
     zx_status_t status;
+    allocator->map_.EnableSummary();
     if ((status = allocator->map_.Reset(pool_blocks * kMinfsBlockBits)) != ZX_OK) {
         return status;
     }
@@ -106,6 +107,7 @@ zx_status_t Allocator::Create(Bcache* bc, SuperblockManager* sb, fs::ReadTxn* tx
 #else
     const void* data = allocator->map_.StorageUnsafe()->GetData();
 #endif
+    // The map's summary is rebuilt by the first allocation after |txn| fills the map.
     txn->Enqueue(data, 0, allocator->metadata_.MetadataStartBlock(), pool_blocks);
     *out = std::move(allocator);
     return ZX_OK;
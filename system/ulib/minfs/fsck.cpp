@@ -48,6 +48,7 @@ private:
                                ino_t parent, uint32_t flags);
     const char* CheckDataBlock(blk_t bno);
     zx_status_t CheckFile(Inode* inode, ino_t ino);
+    zx_status_t CheckExtents(Inode* inode, ino_t ino);
 
     fbl::unique_ptr<Minfs> fs_;
     RawBitmap checked_inodes_;
@@ -292,6 +293,10 @@ const char* MinfsChecker::CheckDataBlock(blk_t bno) {
 }
 
 zx_status_t MinfsChecker::CheckFile(Inode* inode, ino_t ino) {
+    if (inode->flags & kMinfsInodeFlagExtents) {
+        return CheckExtents(inode, ino);
+    }
+
     FS_TRACE_DEBUG("Direct blocks: \n");
     for (unsigned n = 0; n < kMinfsDirect; n++) {
         FS_TRACE_DEBUG(" %d,", inode->dnum[n]);
@@ -391,6 +396,62 @@ zx_status_t MinfsChecker::CheckFile(Inode* inode, ino_t ino) {
     return ZX_OK;
 }
 
+zx_status_t MinfsChecker::CheckExtents(Inode* inode, ino_t ino) {
+    if (inode->magic != kMinfsMagicFile) {
+        FS_TRACE_WARN("check: ino#%u: only files may be extent-mapped\n", ino);
+        conforming_ = false;
+    }
+
+    const Extent* extents = GetExtents(inode);
+    uint32_t block_count = 0;
+    blk_t next_blk = 0;
+    bool used = true;
+    for (uint32_t i = 0; i < kMinfsExtents; i++) {
+        const Extent& extent = extents[i];
+        if (extent.length == 0) {
+            if (extent.file_block != 0 || extent.start != 0) {
+                FS_TRACE_WARN("check: ino#%u: extent %u is empty but not cleared\n", ino, i);
+                conforming_ = false;
+            }
+            used = false;
+            continue;
+        }
+        if (!used) {
+            FS_TRACE_WARN("check: ino#%u: extent %u follows an empty extent\n", ino, i);
+            conforming_ = false;
+        }
+        if (extent.file_block < next_blk ||
+            extent.file_block + extent.length < extent.file_block) {
+            FS_TRACE_WARN("check: ino#%u: extent %u is out of order\n", ino, i);
+            conforming_ = false;
+        }
+        for (blk_t j = 0; j < extent.length; j++) {
+            const char* msg;
+            if ((msg = CheckDataBlock(extent.start + j)) != nullptr) {
+                FS_TRACE_WARN("check: ino#%u: extent %u block %u(@%u): %s\n",
+                     ino, i, extent.file_block + j, extent.start + j, msg);
+                conforming_ = false;
+            }
+            block_count++;
+        }
+        next_blk = extent.file_block + extent.length;
+    }
+
+    if (next_blk) {
+        unsigned max_blocks = fbl::round_up(inode->size, kMinfsBlockSize) / kMinfsBlockSize;
+        if (next_blk > max_blocks) {
+            FS_TRACE_WARN("check: ino#%u: filesize too small\n", ino);
+            conforming_ = false;
+        }
+    }
+    if (block_count != inode->block_count) {
+        FS_TRACE_WARN("check: ino#%u: block count %u, actual blocks %u\n",
+             ino, inode->block_count, block_count);
+        conforming_ = false;
+    }
+    return ZX_OK;
+}
+
 void MinfsChecker::CheckReserved() {
     // Check reserved inode '0'.
     if (fs_->inodes_->inode_allocator_->map_.Get(0, 1)) {
@@ -633,7 +694,7 @@ zx_status_t MinfsChecker::Init(fbl::unique_ptr<Bcache> bc, const Superblock* inf
     return ZX_OK;
 }
 
-zx_status_t Fsck(fbl::unique_ptr<Bcache> bc) {
+zx_status_t Fsck(fbl::unique_ptr<Bcache> bc, bool replay_journal) {
     zx_status_t status;
 
     char data[kMinfsBlockSize];
@@ -642,6 +703,31 @@ zx_status_t Fsck(fbl::unique_ptr<Bcache> bc) {
         return ZX_ERR_IO;
     }
     const Superblock* info = reinterpret_cast<const Superblock*>(data);
+#ifdef __Fuchsia__
+    if (replay_journal) {
+        // Check the filesystem as it will be seen by the next mount.
+        if ((status = ReplayJournal(bc.get(), data, false)) != ZX_OK) {
+            FS_TRACE_ERROR("Fsck: journal replay failure: %d\n", status);
+            return status;
+        }
+    } else {
+        size_t pending;
+        if ((status = CheckSuperblock(info, bc.get())) != ZX_OK) {
+            FS_TRACE_ERROR("Fsck: check_info failure: %d\n", status);
+            return status;
+        } else if ((status = Journal::CountPending(bc.get(), *info, &pending)) != ZX_OK) {
+            FS_TRACE_ERROR("Fsck: journal check failure: %d\n", status);
+            return status;
+        } else if (pending != 0) {
+            // Until the journal is replayed, the metadata in place may legitimately
+            // disagree with itself.
+            DumpInfo(info);
+            FS_TRACE_WARN("Fsck: %zu journal entries not replayed; only the superblock was "
+                          "checked\n", pending);
+            return ZX_OK;
+        }
+    }
+#endif
     DumpInfo(info);
     if ((status = CheckSuperblock(info, bc.get())) != ZX_OK) {
         FS_TRACE_ERROR("Fsck: check_info failure: %d\n", status);
@@ -21,6 +21,8 @@ struct WriteRequest {
     size_t vmo_offset;
     size_t dev_offset;
     size_t length;
+    // Set for file data, which is written in place rather than through the journal.
+    bool data;
 };
 
 // A transaction consisting of enqueued VMOs to be written
@@ -38,9 +40,21 @@ public:
     }
 
     // Identify that a block should be written to disk at a later point in time.
-    void Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset, uint64_t nblocks);
+    // If a journal is in use, the block is written to it before its final location.
+    void Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset, uint64_t nblocks) {
+        EnqueueRequest(vmo, vmo_offset, dev_offset, nblocks, false);
+    }
+
+    // Identify that a block of file data should be written to disk at a later point in time.
+    // File data bypasses the journal, and is written in place before the journal entry holding
+    // the metadata which references it.
+    void EnqueueData(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
+                     uint64_t nblocks) {
+        EnqueueRequest(vmo, vmo_offset, dev_offset, nblocks, true);
+    }
 
     fbl::Vector<WriteRequest>& Requests() { return requests_; }
+    const fbl::Vector<WriteRequest>& Requests() const { return requests_; }
 
     size_t BlkCount() const;
 
@@ -52,6 +66,9 @@ protected:
     zx_status_t Flush(zx_handle_t vmo, vmoid_t vmoid);
 
 private:
+    void EnqueueRequest(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
+                        uint64_t nblocks, bool data);
+
     Bcache* bc_;
     fbl::Vector<WriteRequest> requests_;
 };
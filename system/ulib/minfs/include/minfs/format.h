@@ -32,11 +32,12 @@ typedef uint32_t ino_t;
 
 constexpr uint64_t kMinfsMagic0         = (0x002153466e694d21ULL);
 constexpr uint64_t kMinfsMagic1         = (0x385000d3d3d3d304ULL);
-constexpr uint32_t kMinfsVersion        = 0x00000007;
+constexpr uint32_t kMinfsVersion        = 0x00000008;
 
 constexpr ino_t    kMinfsRootIno        = 1;
 constexpr uint32_t kMinfsFlagClean      = 0x00000001; // Currently unused
 constexpr uint32_t kMinfsFlagFVM        = 0x00000002; // Mounted on FVM
+constexpr uint32_t kMinfsFlagExtents    = 0x00000004; // New files are extent-mapped
 constexpr uint32_t kMinfsBlockSize      = 8192;
 constexpr uint32_t kMinfsBlockBits      = (kMinfsBlockSize * 8);
 constexpr uint32_t kMinfsInodeSize      = 256;
@@ -46,6 +47,8 @@ constexpr uint32_t kMinfsDirect         = 16;
 constexpr uint32_t kMinfsIndirect       = 31;
 constexpr uint32_t kMinfsDoublyIndirect = 1;
 
+constexpr uint32_t kMinfsExtents        = 16;
+
 constexpr uint32_t kMinfsDirectPerIndirect  = (kMinfsBlockSize / sizeof(blk_t));
 constexpr uint32_t kMinfsDirectPerDindirect = kMinfsDirectPerIndirect * kMinfsDirectPerIndirect;
 // not possible to have a block at or past this one
@@ -131,14 +134,59 @@ constexpr uint64_t kMinfsDefaultInodeCount = 32768;
 
 struct JournalInfo {
     uint64_t magic;
+    uint64_t start_block; // Entry-relative block at which the oldest live entry starts.
+    uint64_t sequence;    // Sequence number expected of the entry at |start_block|.
     uint64_t reserved0;
     uint64_t reserved1;
-    uint64_t reserved2;
-    uint64_t reserved3;
 };
 
 static_assert(sizeof(JournalInfo) <= kMinfsBlockSize, "Journal info size is too large");
 
+// Notes:
+// - the journal region consists of a JournalInfo block followed by the
+//   entry area, which holds a sequence of entries starting at
+//   |JournalInfo::start_block|
+// - each entry is a JournalEntryHeader block, |num_blocks| blocks of
+//   metadata, and a JournalEntryCommit block
+// - entries are only valid if their sequence numbers increase by one from
+//   |JournalInfo::sequence| and the commit checksum matches; replay stops
+//   at the first invalid entry
+// - entries never wrap around the end of the entry area; the journal is
+//   checkpointed and restarted at zero instead
+
+constexpr uint64_t kJournalEntryHeaderMagic = (0x6d696e6a68647272ULL);
+constexpr uint64_t kJournalEntryCommitMagic = (0x6d696e6a636d6974ULL);
+
+struct JournalEntryHeader {
+    uint64_t magic;
+    uint64_t sequence;
+    uint64_t reserved;
+    uint64_t num_blocks;    // Number of metadata blocks between header and commit.
+    blk_t target_blocks[kJournalEntryHeaderMaxBlocks]; // Final location of each block.
+};
+
+static_assert(sizeof(JournalEntryHeader) == kMinfsBlockSize,
+              "Journal entry header size is wrong");
+
+struct JournalEntryCommit {
+    uint64_t magic;
+    uint64_t sequence;
+    uint32_t checksum;      // crc32 of the header block and all entry metadata blocks.
+};
+
+static_assert(sizeof(JournalEntryCommit) <= kMinfsBlockSize,
+              "Journal entry commit size is too large");
+
+constexpr uint32_t kMinfsInodeFlagExtents = 0x00000001; // Blocks are mapped by Extents
+
+// A run of |length| contiguous data blocks, starting at |start|, holding
+// blocks [file_block, file_block + length) of a file.
+struct Extent {
+    blk_t file_block;
+    blk_t start;
+    blk_t length;
+};
+
 struct Inode {
     uint32_t magic;
     uint32_t size;
@@ -151,7 +199,8 @@ struct Inode {
     uint32_t dirent_count;          // for directories
     ino_t last_inode;               // index to the previous unlinked inode
     ino_t next_inode;               // index to the next unlinked inode
-    uint32_t rsvd[3];
+    uint32_t flags;                 // kMinfsInodeFlag*
+    uint32_t rsvd[2];
     blk_t dnum[kMinfsDirect];    // direct blocks
     blk_t inum[kMinfsIndirect];  // indirect blocks
     blk_t dinum[kMinfsDoublyIndirect]; // doubly indirect blocks
@@ -159,6 +208,28 @@ struct Inode {
 
 static_assert(sizeof(Inode) == kMinfsInodeSize,
               "minfs inode size is wrong");
+static_assert(sizeof(Extent) * kMinfsExtents ==
+              sizeof(blk_t) * (kMinfsDirect + kMinfsIndirect + kMinfsDoublyIndirect),
+              "minfs extents must exactly replace the block pointers");
+
+// Extent-mapped inodes reuse the storage of the block pointers for their extents.
+inline Extent* GetExtents(Inode* inode) {
+    return reinterpret_cast<Extent*>(inode->dnum);
+}
+
+inline const Extent* GetExtents(const Inode* inode) {
+    return reinterpret_cast<const Extent*>(inode->dnum);
+}
+
+// Notes:
+// - only regular files are extent-mapped, and only when they are created on a
+//   filesystem with kMinfsFlagExtents set
+// - extent starts are relative to dat_block, like other data block numbers
+// - extents are sorted by |file_block| and do not overlap; the used extents
+//   come first, followed by unused extents with a |length| of zero
+// - file blocks which are not covered by an extent are holes
+// - an extent-mapped inode never has indirect blocks; when a file needs more
+//   than kMinfsExtents extents, it is converted to block pointers
 
 struct Dirent {
     ino_t ino;                      // inode number
@@ -213,7 +284,4 @@ static_assert(kMinfsMaxDirectorySize <= kMinfsReclenMask,
 //  4GB ->  512K blocks ->  64K bitmap (8K qword)
 // 32GB -> 4096K blocks -> 512K bitmap (64K qwords)
 
-// Block Cache (bcache.c)
-constexpr uint32_t kMinfsHashBits = (8);
-
 } // namespace minfs
@@ -24,7 +24,11 @@ zx_status_t CheckSuperblock(const Superblock* info, Bcache* bc);
 // Run fsck on an unmounted filesystem backed by |bc|.
 //
 // Invokes CheckSuperblock, but also verifies inode and block usage.
-zx_status_t Fsck(fbl::unique_ptr<Bcache> bc);
+//
+// The disk is only modified if |replay_journal| is set, in which case any
+// committed journal entries are replayed first, as by the next mount. Otherwise,
+// a filesystem with entries yet to be replayed only has its superblock checked.
+zx_status_t Fsck(fbl::unique_ptr<Bcache> bc, bool replay_journal = false);
 
 #ifndef __Fuchsia__
 // Run fsck on a sparse minfs partition
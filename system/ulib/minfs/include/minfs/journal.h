@@ -0,0 +1,125 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#ifndef __Fuchsia__
+static_assert(false, "Fuchsia only header");
+#endif
+
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <lib/fzl/owned-vmo-mapper.h>
+#include <zircon/types.h>
+
+#include <minfs/bcache.h>
+#include <minfs/block-txn.h>
+#include <minfs/format.h>
+
+namespace minfs {
+
+// Journal which persists the metadata (superblock, bitmaps, inode table, directory
+// blocks and indirect blocks) modified by a batch of transactions to a write-ahead log
+// before it is written in place. Only file data, enqueued with |WriteTxn::EnqueueData|,
+// bypasses the journal.
+//
+// The journal is driven exclusively by the writeback thread, which hands it
+// batches of WriteTxns whose blocks already reside in the writeback buffer:
+//
+// 1. |Commit| writes the file data blocks of the batch in place and flushes the
+//    device. It then writes a single journal entry (header, metadata blocks,
+//    commit) for all of the metadata in the batch, and flushes again. Once this
+//    returns, the batch is durable: a crash from here on is repaired by |Replay|.
+//
+// 2. The caller then writes the remaining (metadata) requests to their final
+//    location, exactly as it would without a journal.
+//
+// 3. Entries are only reclaimed by |Checkpoint|, which flushes the in-place
+//    metadata writes and advances the on-disk journal start past all entries.
+//    This happens lazily, when the entry area is full or on unmount, so that
+//    steady-state commits cost a single device flush, plus one for file data.
+class Journal {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Journal);
+
+    // Replays any committed entries which may not have reached their final
+    // location, then moves the journal start past them. Must be invoked before any metadata
+    // (including the superblock) is read from disk.
+    static zx_status_t Replay(Bcache* bc, const Superblock& info);
+
+    // Returns the number of committed entries which |Replay| would apply, without
+    // modifying the disk.
+    static zx_status_t CountPending(Bcache* bc, const Superblock& info, size_t* out_entries);
+
+    static zx_status_t Create(Bcache* bc, const Superblock& info,
+                              fbl::unique_ptr<Journal>* out);
+    ~Journal();
+
+    // Returns the number of blocks within |txn| which must be journaled.
+    size_t MetadataBlocks(const WriteTxn& txn) const;
+
+    // Returns the largest number of metadata blocks that a single entry may hold.
+    size_t MaxEntryBlocks() const;
+
+    // Persists the |count| transactions in |txns| as described above.
+    // |buffer| / |buffer_vmoid| are the writeback buffer holding the blocks of
+    // every transaction, as referenced by their requests.
+    //
+    // On success, the data requests are removed from each transaction, leaving
+    // only the metadata requests to be written in place. On failure, none of the
+    // metadata of the batch is durable, and none of it may be written in place:
+    // in particular, ZX_ERR_OUT_OF_RANGE is returned if the metadata of the batch
+    // cannot fit in a single entry.
+    zx_status_t Commit(WriteTxn* const* txns, size_t count, const void* buffer,
+                       vmoid_t buffer_vmoid);
+
+    // Flushes all in-place writes and marks every committed entry as reclaimed.
+    zx_status_t Checkpoint();
+
+private:
+    Journal(Bcache* bc, blk_t start_block, blk_t entry_capacity, fzl::OwnedVmoMapper mapper);
+
+    JournalInfo* GetInfo() {
+        return reinterpret_cast<JournalInfo*>(mapper_.start());
+    }
+
+    JournalEntryHeader* GetHeader() {
+        return reinterpret_cast<JournalEntryHeader*>(
+            reinterpret_cast<uintptr_t>(mapper_.start()) + kHeaderVmoBlock * kMinfsBlockSize);
+    }
+
+    JournalEntryCommit* GetCommit() {
+        return reinterpret_cast<JournalEntryCommit*>(
+            reinterpret_cast<uintptr_t>(mapper_.start()) + kCommitVmoBlock * kMinfsBlockSize);
+    }
+
+    // Writes the info block, pointing at the current |start_| and |start_sequence_|.
+    zx_status_t WriteInfo();
+
+    // Layout of the journal's own VMO, which holds every non-data block it writes.
+    static constexpr size_t kInfoVmoBlock = 0;
+    static constexpr size_t kHeaderVmoBlock = 1;
+    static constexpr size_t kCommitVmoBlock = 2;
+    static constexpr size_t kVmoBlocks = 3;
+
+    Bcache* bc_;
+    // Absolute location of the journal info block. Entries start one block later.
+    const blk_t start_block_;
+    // Number of blocks in the entry area.
+    const blk_t entry_capacity_;
+
+    fzl::OwnedVmoMapper mapper_;
+    vmoid_t vmoid_ = VMOID_INVALID;
+
+    // Entry-relative location of the oldest entry which has not been checkpointed.
+    size_t start_ = 0;
+    // Entry-relative location at which the next entry will be written.
+    size_t next_ = 0;
+    // Sequence number of the entry at |start_|, as recorded in the info block.
+    uint64_t start_sequence_ = 0;
+    // Sequence number of the next entry to be written.
+    uint64_t sequence_ = 0;
+};
+
+} // namespace minfs
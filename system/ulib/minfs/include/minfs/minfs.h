@@ -31,6 +31,14 @@ struct MountOptions {
 
     // Number of slices to preallocate for data when the filesystem is created.
     uint32_t fvm_data_slices = 1;
+
+    // Map new files with extents rather than block pointers. Only consulted when the
+    // filesystem is created.
+    bool use_extents = false;
+
+    // Allow fsck to modify the disk, by replaying any committed journal entries
+    // before checking the filesystem.
+    bool repair = false;
 };
 
 // Format the partition backed by |bc| as MinFS.
@@ -74,6 +74,11 @@ public:
     // TODO(planders): Internally break up large write requests so they fit within this constraint.
     static constexpr size_t kMaxWriteBytes = (1 << 16);
 
+    // Maximum number of indirect blocks which a single file may use. All of them may be
+    // allocated within one transaction when an extent-mapped file is converted to block pointers.
+    static constexpr blk_t kMaxIndirectBlocks = kMinfsIndirect +
+                                                kMinfsDoublyIndirect * (1 + kMinfsDirectPerIndirect);
+
     // Number of metadata blocks required for the whole journal - 1 Superblock.
     static constexpr blk_t kJournalMetadataBlocks = 1;
 
@@ -7,8 +7,10 @@
 #ifdef __Fuchsia__
 #include <fbl/auto_lock.h>
 #include <fbl/mutex.h>
+#include <fbl/vector.h>
 #include <lib/fzl/owned-vmo-mapper.h>
 #include <lib/zx/vmo.h>
+#include <minfs/journal.h>
 #endif
 
 #include <fbl/algorithm.h>
@@ -55,6 +57,13 @@ public:
     // consumed.
     size_t Complete(zx_handle_t vmo, vmoid_t vmoid);
 
+    // Discards the enqueued work without writing it to disk, signalling
+    // |status| to the closure, and resets the WritebackWork to its initial state.
+    //
+    // Returns the number of blocks of the writeback buffer that have been
+    // consumed.
+    size_t Abort(zx_status_t status);
+
     // Adds a closure to the WritebackWork, such that it will be signalled
     // when the WritebackWork is flushed to disk.
     // If no closure is set, nothing will get signalled.
@@ -127,10 +136,14 @@ private:
 
 // WritebackBuffer which manages a writeback buffer (and background thread,
 // which flushes this buffer out to disk).
+//
+// If a |journal| is provided, the background thread commits all pending
+// work to it as a single batch before writing any metadata in place.
 class WritebackBuffer {
 public:
     // Calls constructor, return an error if anything goes wrong.
     static zx_status_t Create(Bcache* bc, fzl::OwnedVmoMapper mapper,
+                              fbl::unique_ptr<Journal> journal,
                               fbl::unique_ptr<WritebackBuffer>* out);
     ~WritebackBuffer();
 
@@ -145,7 +158,7 @@ public:
     void Enqueue(fbl::unique_ptr<WritebackWork> work) __TA_EXCLUDES(writeback_lock_);
 
 private:
-    WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper);
+    WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper, fbl::unique_ptr<Journal> journal);
 
     // Blocks until |blocks| blocks of data are free for the caller.
     // Returns |ZX_OK| with the lock still held in this case.
@@ -173,6 +186,15 @@ private:
     using WorkQueue = fs::Queue<fbl::unique_ptr<WritebackWork>>;
     using ProducerQueue = fs::Queue<Waiter*>;
 
+    // Moves the pending work which may share a single journal entry into |batch|,
+    // returning the number of writeback buffer blocks it occupies.
+    size_t TakeBatchLocked(fbl::Vector<fbl::unique_ptr<WritebackWork>>* batch)
+        __TA_REQUIRES(writeback_lock_);
+
+    // Writes |batch| out to disk, through the journal if one exists.
+    void CompleteBatch(fbl::Vector<fbl::unique_ptr<WritebackWork>>* batch)
+        __TA_EXCLUDES(writeback_lock_);
+
     // Signalled when the writeback buffer can be consumed by the background
     // thread.
     cnd_t consumer_cvar_;
@@ -195,6 +217,12 @@ private:
     bool unmounting_ __TA_GUARDED(writeback_lock_){false};
     fzl::OwnedVmoMapper mapper_;
     vmoid_t buffer_vmoid_ = VMOID_INVALID;
+    // Optional. Only accessed by the writeback thread (and on destruction).
+    fbl::unique_ptr<Journal> journal_;
+    // Set once a batch fails to commit to |journal_|. Since later work may depend
+    // on the lost metadata, all of it is discarded from then on.
+    // Only accessed by the writeback thread.
+    zx_status_t journal_status_ = ZX_OK;
     // The units of all the following are "MinFS blocks".
     size_t start_ __TA_GUARDED(writeback_lock_){};
     size_t len_ __TA_GUARDED(writeback_lock_){};
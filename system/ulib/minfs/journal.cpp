@@ -0,0 +1,422 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/unique_ptr.h>
+#include <fs/block-txn.h>
+#include <fs/trace.h>
+#include <lib/cksum.h>
+#include <lib/fzl/owned-vmo-mapper.h>
+#include <trace/event.h>
+#include <zircon/types.h>
+
+#include <minfs/journal.h>
+
+#include <utility>
+
+namespace minfs {
+namespace {
+
+// Returns the total number of blocks reserved for the journal, including the info block.
+blk_t JournalBlocks(const Superblock& info) {
+    if (info.flags & kMinfsFlagFVM) {
+        return static_cast<blk_t>(info.journal_slices * (info.slice_size / kMinfsBlockSize));
+    }
+    return info.dat_block - info.journal_start_block;
+}
+
+// Issues a flush to the underlying device, ensuring all previously completed writes
+// are persistent.
+zx_status_t FlushDevice(Bcache* bc) {
+    fs::WriteTxn txn(bc);
+    txn.EnqueueFlush();
+    return txn.Transact();
+}
+
+// Returns true if |target| may be written by a journal entry: any block of the filesystem
+// outside of the journal itself.
+bool IsValidTarget(const Superblock& info, blk_t target) {
+    return target < info.journal_start_block ||
+           (target >= info.dat_block && target - info.dat_block < info.block_count);
+}
+
+// Returns true if a valid entry with |sequence| begins at entry-relative block |index|.
+// On success, |header| holds the header block of the entry.
+bool VerifyEntry(Bcache* bc, const Superblock& info, blk_t entry_start, size_t capacity,
+                 size_t index, uint64_t sequence, JournalEntryHeader* header) {
+    if (index + 2 > capacity) {
+        return false;
+    }
+    if (bc->Readblk(static_cast<blk_t>(entry_start + index), header) != ZX_OK) {
+        return false;
+    }
+    if (header->magic != kJournalEntryHeaderMagic || header->sequence != sequence) {
+        // This is the expected way for replay to terminate.
+        return false;
+    }
+    if (header->num_blocks > kJournalEntryHeaderMaxBlocks ||
+        index + header->num_blocks + 2 > capacity) {
+        FS_TRACE_ERROR("minfs: Journal entry %" PRIu64 " has invalid length\n", sequence);
+        return false;
+    }
+    for (size_t i = 0; i < header->num_blocks; i++) {
+        if (!IsValidTarget(info, header->target_blocks[i])) {
+            FS_TRACE_ERROR("minfs: Journal entry %" PRIu64 " has invalid target\n", sequence);
+            return false;
+        }
+    }
+
+    uint8_t blk[kMinfsBlockSize];
+    uint32_t checksum = crc32(0, reinterpret_cast<const uint8_t*>(header), kMinfsBlockSize);
+    for (size_t i = 0; i < header->num_blocks; i++) {
+        if (bc->Readblk(static_cast<blk_t>(entry_start + index + 1 + i), blk) != ZX_OK) {
+            return false;
+        }
+        checksum = crc32(checksum, blk, kMinfsBlockSize);
+    }
+
+    if (bc->Readblk(static_cast<blk_t>(entry_start + index + 1 + header->num_blocks),
+                    blk) != ZX_OK) {
+        return false;
+    }
+    const JournalEntryCommit* commit = reinterpret_cast<const JournalEntryCommit*>(blk);
+    if (commit->magic != kJournalEntryCommitMagic || commit->sequence != sequence) {
+        // The entry was torn by a crash before it was committed, and must not be replayed.
+        return false;
+    }
+    if (commit->checksum != checksum) {
+        FS_TRACE_ERROR("minfs: Journal entry %" PRIu64 " checksum does not match\n", sequence);
+        return false;
+    }
+    return true;
+}
+
+// Walks the committed entries following the start of the journal, whose info block is read
+// into |info_blk|. If |apply| is set, each entry is written to its final location as it is
+// found. On return, |out_index| and |out_sequence| identify the first block past the last
+// committed entry.
+zx_status_t WalkEntries(Bcache* bc, const Superblock& info, bool apply, uint8_t* info_blk,
+                        size_t* out_entries, size_t* out_index, uint64_t* out_sequence) {
+    const blk_t entry_start = info.journal_start_block + 1;
+    const size_t capacity = JournalBlocks(info) - 1;
+
+    zx_status_t status;
+    if ((status = bc->Readblk(info.journal_start_block, info_blk)) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: could not read journal block\n");
+        return status;
+    }
+    const JournalInfo* journal_info = reinterpret_cast<const JournalInfo*>(info_blk);
+    if (journal_info->magic != kJournalMagic) {
+        FS_TRACE_ERROR("minfs: invalid journal magic\n");
+        return ZX_ERR_BAD_STATE;
+    }
+
+    size_t index = journal_info->start_block;
+    uint64_t sequence = journal_info->sequence;
+    size_t total_entries = 0;
+    size_t total_blocks = 0;
+
+    JournalEntryHeader header;
+    uint8_t blk[kMinfsBlockSize];
+    while (VerifyEntry(bc, info, entry_start, capacity, index, sequence, &header)) {
+        for (size_t i = 0; apply && i < header.num_blocks; i++) {
+            if ((status = bc->Readblk(static_cast<blk_t>(entry_start + index + 1 + i),
+                                      blk)) != ZX_OK ||
+                (status = bc->Writeblk(header.target_blocks[i], blk)) != ZX_OK) {
+                // Leave the journal intact; replay may be attempted again on the next mount.
+                FS_TRACE_ERROR("minfs: Journal replay failed: %d\n", status);
+                return status;
+            }
+        }
+        total_entries++;
+        total_blocks += header.num_blocks;
+        index += header.num_blocks + 2;
+        sequence++;
+    }
+
+    if (apply && total_entries != 0) {
+        FS_TRACE_INFO("minfs: Replayed %zu journal entries (%zu blocks) from index %" PRIu64
+                      "\n", total_entries, total_blocks, journal_info->start_block);
+    }
+    *out_entries = total_entries;
+    *out_index = index;
+    *out_sequence = sequence;
+    return ZX_OK;
+}
+
+} // namespace
+
+zx_status_t Journal::Replay(Bcache* bc, const Superblock& info) {
+    TRACE_DURATION("minfs", "Journal::Replay");
+    uint8_t info_blk[kMinfsBlockSize];
+    size_t entries;
+    size_t index;
+    uint64_t sequence;
+    zx_status_t status;
+    if ((status = WalkEntries(bc, info, true, info_blk, &entries, &index, &sequence)) != ZX_OK) {
+        return status;
+    } else if (entries == 0) {
+        return ZX_OK;
+    }
+
+    // Only move the journal past the replayed entries once they are persistent.
+    if ((status = FlushDevice(bc)) != ZX_OK) {
+        return status;
+    }
+    JournalInfo* journal_info = reinterpret_cast<JournalInfo*>(info_blk);
+    journal_info->start_block = index;
+    journal_info->sequence = sequence;
+    if ((status = bc->Writeblk(info.journal_start_block, info_blk)) != ZX_OK) {
+        return status;
+    }
+    return FlushDevice(bc);
+}
+
+zx_status_t Journal::CountPending(Bcache* bc, const Superblock& info, size_t* out_entries) {
+    uint8_t info_blk[kMinfsBlockSize];
+    size_t index;
+    uint64_t sequence;
+    return WalkEntries(bc, info, false, info_blk, out_entries, &index, &sequence);
+}
+
+Journal::Journal(Bcache* bc, blk_t start_block, blk_t entry_capacity, fzl::OwnedVmoMapper mapper)
+    : bc_(bc), start_block_(start_block), entry_capacity_(entry_capacity),
+      mapper_(std::move(mapper)) {}
+
+Journal::~Journal() {
+    if (vmoid_ != VMOID_INVALID) {
+        block_fifo_request_t request;
+        request.group = bc_->BlockGroupID();
+        request.vmoid = vmoid_;
+        request.opcode = BLOCKIO_CLOSE_VMO;
+        bc_->Transaction(&request, 1);
+    }
+}
+
+zx_status_t Journal::Create(Bcache* bc, const Superblock& info, fbl::unique_ptr<Journal>* out) {
+    const blk_t journal_blocks = JournalBlocks(info);
+    // One info block, plus room for an entry holding at least a single metadata block.
+    if (journal_blocks < 4) {
+        FS_TRACE_ERROR("minfs: journal too small\n");
+        return ZX_ERR_BAD_STATE;
+    }
+
+    zx_status_t status;
+    fzl::OwnedVmoMapper mapper;
+    if ((status = mapper.CreateAndMap(kVmoBlocks * kMinfsBlockSize, "minfs-journal")) != ZX_OK) {
+        return status;
+    }
+
+    fbl::unique_ptr<Journal> journal(new Journal(bc, info.journal_start_block,
+                                                 journal_blocks - 1, std::move(mapper)));
+    if ((status = bc->AttachVmo(journal->mapper_.vmo(), &journal->vmoid_)) != ZX_OK) {
+        return status;
+    }
+
+    JournalInfo* journal_info = journal->GetInfo();
+    if ((status = bc->Readblk(info.journal_start_block, journal_info)) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: could not read journal block\n");
+        return status;
+    }
+    if (journal_info->magic != kJournalMagic) {
+        FS_TRACE_ERROR("minfs: invalid journal magic\n");
+        return ZX_ERR_BAD_STATE;
+    }
+
+    journal->start_ = journal_info->start_block;
+    journal->start_sequence_ = journal_info->sequence;
+    if (journal->start_ >= journal->entry_capacity_) {
+        // Entries never start at the end of the entry area; wrap to the front.
+        journal->start_ = 0;
+    }
+    journal->next_ = journal->start_;
+    journal->sequence_ = journal->start_sequence_;
+
+    *out = std::move(journal);
+    return ZX_OK;
+}
+
+size_t Journal::MetadataBlocks(const WriteTxn& txn) const {
+    size_t blocks = 0;
+    const auto& requests = txn.Requests();
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (!requests[i].data) {
+            blocks += requests[i].length;
+        }
+    }
+    return blocks;
+}
+
+size_t Journal::MaxEntryBlocks() const {
+    return fbl::min(static_cast<size_t>(kJournalEntryHeaderMaxBlocks),
+                    static_cast<size_t>(entry_capacity_ - 2));
+}
+
+zx_status_t Journal::Commit(WriteTxn* const* txns, size_t count, const void* buffer,
+                            vmoid_t buffer_vmoid) {
+    TRACE_DURATION("minfs", "Journal::Commit");
+    size_t metadata_blocks = 0;
+    for (size_t i = 0; i < count; i++) {
+        metadata_blocks += MetadataBlocks(*txns[i]);
+    }
+
+    if (metadata_blocks == 0) {
+        // Nothing to journal; the caller writes the data in place.
+        return ZX_OK;
+    } else if (metadata_blocks > MaxEntryBlocks()) {
+        // Writing this batch in place without an entry could leave it half-applied
+        // after a crash, so it is refused instead.
+        FS_TRACE_ERROR("minfs: %zu metadata blocks too large for journal entry\n",
+                       metadata_blocks);
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    zx_status_t status;
+    const size_t entry_blocks = metadata_blocks + 2;
+    if (next_ + entry_blocks > entry_capacity_) {
+        // Restart the entry area from the front, once every entry in it is reclaimed.
+        next_ = 0;
+        if ((status = Checkpoint()) != ZX_OK) {
+            return status;
+        }
+    }
+
+    // File data is written in place, and must be persistent before the entry which references
+    // it is committed. Otherwise, replaying the entry could expose whatever the data blocks
+    // held before.
+    fs::WriteTxn data_txn(bc_);
+    bool has_data = false;
+    for (size_t i = 0; i < count; i++) {
+        const auto& requests = txns[i]->Requests();
+        for (size_t j = 0; j < requests.size(); j++) {
+            if (requests[j].data) {
+                data_txn.Enqueue(buffer_vmoid, requests[j].vmo_offset, requests[j].dev_offset,
+                                 requests[j].length);
+                has_data = true;
+            }
+        }
+    }
+    if (has_data) {
+        if ((status = data_txn.Transact()) != ZX_OK) {
+            FS_TRACE_ERROR("minfs: Failed to write file data: %d\n", status);
+            return status;
+        }
+        if ((status = FlushDevice(bc_)) != ZX_OK) {
+            FS_TRACE_ERROR("minfs: Failed to flush file data: %d\n", status);
+            return status;
+        }
+    }
+
+    JournalEntryHeader* header = GetHeader();
+    memset(header, 0, kMinfsBlockSize);
+    header->magic = kJournalEntryHeaderMagic;
+    header->sequence = sequence_;
+    header->num_blocks = metadata_blocks;
+
+    const size_t entry_start = start_block_ + 1 + next_;
+    fs::WriteTxn txn(bc_);
+    txn.Enqueue(vmoid_, kHeaderVmoBlock, entry_start, 1);
+
+    size_t entry_block = 1;
+    for (size_t i = 0; i < count; i++) {
+        const auto& requests = txns[i]->Requests();
+        for (size_t j = 0; j < requests.size(); j++) {
+            const WriteRequest& request = requests[j];
+            if (request.data) {
+                continue;
+            }
+            for (size_t k = 0; k < request.length; k++) {
+                header->target_blocks[entry_block - 1 + k] =
+                    static_cast<blk_t>(request.dev_offset + k);
+            }
+            txn.Enqueue(buffer_vmoid, request.vmo_offset, entry_start + entry_block,
+                        request.length);
+            entry_block += request.length;
+        }
+    }
+    ZX_DEBUG_ASSERT(entry_block == metadata_blocks + 1);
+
+    uint32_t checksum = crc32(0, reinterpret_cast<const uint8_t*>(header), kMinfsBlockSize);
+    for (size_t i = 0; i < count; i++) {
+        const auto& requests = txns[i]->Requests();
+        for (size_t j = 0; j < requests.size(); j++) {
+            if (requests[j].data) {
+                continue;
+            }
+            const uint8_t* data = static_cast<const uint8_t*>(buffer) +
+                                  requests[j].vmo_offset * kMinfsBlockSize;
+            checksum = crc32(checksum, data, requests[j].length * kMinfsBlockSize);
+        }
+    }
+
+    JournalEntryCommit* commit = GetCommit();
+    memset(commit, 0, kMinfsBlockSize);
+    commit->magic = kJournalEntryCommitMagic;
+    commit->sequence = sequence_;
+    commit->checksum = checksum;
+    txn.Enqueue(vmoid_, kCommitVmoBlock, entry_start + entry_block, 1);
+
+    // The commit checksum covers the entry, so a torn entry is detected on replay
+    // without requiring a separate flush between the entry and its commit block.
+    if ((status = txn.Transact()) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: Failed to write journal entry: %d\n", status);
+        return status;
+    }
+    if ((status = FlushDevice(bc_)) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: Failed to flush journal entry: %d\n", status);
+        return status;
+    }
+
+    next_ += entry_blocks;
+    sequence_++;
+
+    // Only the metadata is left to be written to its final location.
+    for (size_t i = 0; i < count; i++) {
+        auto& requests = txns[i]->Requests();
+        for (size_t j = requests.size(); j > 0; j--) {
+            if (requests[j - 1].data) {
+                requests.erase(j - 1);
+            }
+        }
+    }
+    return ZX_OK;
+}
+
+zx_status_t Journal::Checkpoint() {
+    TRACE_DURATION("minfs", "Journal::Checkpoint");
+    if (start_ == next_ && start_sequence_ == sequence_) {
+        return ZX_OK;
+    }
+
+    // Every entry between |start_| and |next_| has been written in place; once
+    // those writes are persistent, the entries are no longer needed.
+    zx_status_t status;
+    if ((status = FlushDevice(bc_)) != ZX_OK) {
+        return status;
+    }
+    start_ = next_;
+    start_sequence_ = sequence_;
+    return WriteInfo();
+}
+
+zx_status_t Journal::WriteInfo() {
+    JournalInfo* info = GetInfo();
+    info->start_block = start_;
+    info->sequence = start_sequence_;
+
+    fs::WriteTxn txn(bc_);
+    txn.Enqueue(vmoid_, kInfoVmoBlock, start_block_, 1);
+    zx_status_t status;
+    if ((status = txn.Transact()) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: Failed to write journal info: %d\n", status);
+        return status;
+    }
+    return FlushDevice(bc_);
+}
+
+} // namespace minfs
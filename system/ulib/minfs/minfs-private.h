@@ -23,7 +23,7 @@
 
 #include <fbl/algorithm.h>
 #include <fbl/function.h>
-#include <fbl/intrusive_hash_table.h>
+#include <fbl/intrusive_resizable_hash_table.h>
 #include <fbl/intrusive_single_list.h>
 #include <fbl/macros.h>
 #include <fbl/ref_ptr.h>
@@ -34,10 +34,10 @@
 #include <fs/trace.h>
 #include <fs/vfs.h>
 #include <fs/vnode.h>
-#include <lib/zircon-internal/fnv1hash.h>
 #include <minfs/allocator.h>
 #include <minfs/format.h>
 #include <minfs/inode-manager.h>
+#include <minfs/minfs.h>
 #include <minfs/superblock.h>
 #include <minfs/transaction-limits.h>
 #include <minfs/writeback.h>
@@ -196,6 +196,12 @@ public:
 
     void CommitTransaction(fbl::unique_ptr<Transaction> state);
 
+#ifdef __Fuchsia__
+    // Commits the work accumulated so far in |state|, which then continues with a fresh
+    // WritebackWork. Used by operations too large for a single journal entry.
+    void CommitTransactionPart(Transaction* state);
+#endif
+
 #ifdef __Fuchsia__
     void SetUnmountCallback(fbl::Closure closure) { on_unmount_ = std::move(closure); }
     void Shutdown(fs::Vfs::ShutdownCallback cb) final;
@@ -203,7 +209,7 @@ public:
     // Returns a unique identifier for this instance.
     uint64_t GetFsId() const { return fs_id_; }
 
-    // Signals the completion object as soon as...
+    // Flushes the dirty data of every vnode, then signals the completion object as soon as...
     // (1) A sync probe has entered and exited the writeback queue, and
     // (2) The block cache has sync'd with the underlying block device.
     void Sync(SyncCallback closure);
@@ -266,7 +272,7 @@ public:
 private:
     // Fsck can introspect Minfs
     friend class MinfsChecker;
-    using HashTable = fbl::HashTable<ino_t, VnodeMinfs*>;
+    using HashTable = fbl::ResizableHashTable<ino_t, VnodeMinfs*>;
 
 #ifdef __Fuchsia__
     Minfs(fbl::unique_ptr<Bcache> bc, fbl::unique_ptr<SuperblockManager> sb,
@@ -359,15 +365,26 @@ public:
     static zx_status_t Recreate(Minfs* fs, ino_t ino, fbl::RefPtr<VnodeMinfs>* out);
 
     bool IsDirectory() const { return inode_.magic == kMinfsMagicDir; }
+    bool IsExtentMapped() const { return (inode_.flags & kMinfsInodeFlagExtents) != 0; }
     bool IsUnlinked() const { return inode_.link_count == 0; }
     zx_status_t CanUnlink() const;
 
     const Inode* GetInode() const { return &inode_; }
 
+#ifdef __Fuchsia__
+    // Returns true if file data has been written to the VMO, but not yet allocated
+    // or enqueued for writeback.
+    bool IsDirty() const { return dirty_state_ != nullptr; }
+
+    // Allocates the blocks of any dirty data, and enqueues them for writeback in
+    // a single transaction.
+    zx_status_t FlushDirty();
+#endif
+
     ino_t GetKey() const { return ino_; }
     // Should only be called once for the VnodeMinfs lifecycle.
     void SetIno(ino_t ino);
-    static size_t GetHash(ino_t key) { return fnv1a_tiny(key, kMinfsHashBits); }
+    static size_t GetHash(ino_t key) { return key; }
 
     // fs::Vnode interface (invoked publicly).
 #ifdef __Fuchsia__
@@ -497,6 +514,8 @@ private:
         kRead,
         kWrite,
         kDelete,
+        // Maps each block to the (already allocated) block passed in |bnos|.
+        kSet,
     };
 
     struct BlockOpArgs {
@@ -521,6 +540,8 @@ private:
 
         BlockOp GetOp() const { return op_; }
         blk_t GetBno(blk_t index) const { return array_[index]; }
+        // Returns the block which kSet maps at |index|.
+        blk_t GetSetBno(blk_t index) const { return bnos_[index]; }
         void SetBno(blk_t index, blk_t value) {
             ZX_DEBUG_ASSERT(index < GetCount());
 
@@ -624,6 +645,20 @@ private:
     // bnos
     zx_status_t BlocksShrink(Transaction* state, blk_t start);
 
+    // Extent-mapped counterparts of BlockGet and BlocksShrink.
+    zx_status_t ExtentGet(Transaction* state, blk_t n, blk_t* bno);
+    zx_status_t ExtentsShrink(Transaction* state, blk_t start);
+    // Returns the number of extents in use.
+    uint32_t ExtentCount() const;
+
+    // Ensures that the extents of an extent-mapped inode have room for every block a
+    // write of |len| bytes at |off| may allocate, converting the inode to block
+    // pointers if they do not.
+    zx_status_t ReserveExtents(size_t off, size_t len);
+    // Maps every block held by the inode's extents with block pointers instead, in
+    // a transaction of its own.
+    zx_status_t ConvertToBlockMap();
+
     // Update the vnode's inode and write it to disk.
     void InodeSync(WritebackWork* wb, uint32_t flags);
 
@@ -641,6 +676,16 @@ private:
     zx_status_t InitVmo();
     zx_status_t InitIndirectVmo();
 
+    // Prepares to delay the allocation of a write of |len| bytes at |off|, flushing any
+    // dirty data it cannot be merged with. Sets |out_delayed| if the write may only
+    // update the VMO, or false if it must allocate its blocks immediately (in which
+    // case, the vnode is no longer dirty).
+    zx_status_t PrepareDirty(size_t off, size_t len, bool* out_delayed);
+
+    // Initializes the indirect VMO, and grows it to hold the indirect blocks mapping
+    // block |n| of the file.
+    zx_status_t InitIndirectVmoForBlock(blk_t n);
+
     // Loads indirect blocks up to and including the doubly indirect block at |index|.
     zx_status_t LoadIndirectWithinDoublyIndirect(uint32_t index);
 
@@ -657,6 +702,11 @@ private:
     // Assumes that vmo_indirect_ has already been initialized
     void ClearIndirectVmoBlock(uint32_t offset);
 
+    // Enqueues block |n| of the vnode's VMO to be written to data block |bno| within |wb|.
+    // Directory blocks are journaled along with the rest of the metadata, while file data is
+    // written in place.
+    void EnqueueDataBlock(WritebackWork* wb, blk_t n, blk_t bno);
+
     // Use the watcher container to implement a directory watcher
     void Notify(fbl::StringPiece name, unsigned event) final;
     zx_status_t WatchDir(fs::Vfs* vfs, uint32_t mask, uint32_t options, zx::channel watcher) final;
@@ -692,6 +742,17 @@ private:
     vmoid_t vmoid_{};
     vmoid_t vmoid_indirect_{};
 
+    // Writes to files are allocated lazily: blocks [dirty_start_, dirty_end_) of |vmo_| have
+    // been written, but are not necessarily allocated or written back. |dirty_state_| holds
+    // a transaction reserving enough blocks to flush any dirty range within
+    // [dirty_base_, dirty_base_ + kMaxDirtyBlocks).
+    fbl::unique_ptr<Transaction> dirty_state_;
+    blk_t dirty_base_ = 0;
+    blk_t dirty_start_ = 0;
+    blk_t dirty_end_ = 0;
+    // Size of the file before it became dirty, which is persisted until it is flushed.
+    uint32_t dirty_size_ = 0;
+
     fs::RemoteContainer remoter_{};
     fs::WatcherContainer watcher_{};
 #endif
@@ -735,8 +796,18 @@ void DumpInfo(const Superblock* info);
 void DumpInode(const Inode* inode, ino_t ino);
 void InitializeDirectory(void* bdata, ino_t ino_self, ino_t ino_parent);
 
+#ifdef __Fuchsia__
+// Replays the journal of the filesystem whose superblock is held in |info_blk|,
+// refreshing |info_blk| afterwards in case the superblock was replayed.
+//
+// If |readonly|, the disk is left untouched, and ZX_ERR_BAD_STATE is returned
+// if the journal holds any entries which have yet to be replayed.
+zx_status_t ReplayJournal(Bcache* bc, void* info_blk, bool readonly);
+#endif
+
 // Given an input bcache, initialize the filesystem and return a reference to the
 // root node.
-zx_status_t Mount(fbl::unique_ptr<minfs::Bcache> bc, fbl::RefPtr<VnodeMinfs>* root_out);
+zx_status_t Mount(fbl::unique_ptr<minfs::Bcache> bc, const MountOptions& options,
+                  fbl::RefPtr<VnodeMinfs>* root_out);
 
 } // namespace minfs
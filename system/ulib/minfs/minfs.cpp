@@ -22,6 +22,7 @@
 
 #ifdef __Fuchsia__
 #include <fbl/auto_lock.h>
+#include <fbl/vector.h>
 #include <lib/async/cpp/task.h>
 #include <lib/zx/event.h>
 #endif
@@ -79,6 +80,7 @@ void DumpInfo(const Superblock* info) {
     FS_TRACE_DEBUG("minfs: inode table  @ %10u\n", info->ino_block);
     FS_TRACE_DEBUG("minfs: data blocks  @ %10u\n", info->dat_block);
     FS_TRACE_DEBUG("minfs: FVM-aware: %s\n", (info->flags & kMinfsFlagFVM) ? "YES" : "NO");
+    FS_TRACE_DEBUG("minfs: Extents: %s\n", (info->flags & kMinfsFlagExtents) ? "YES" : "NO");
 }
 
 void DumpInode(const Inode* inode, ino_t ino) {
@@ -280,7 +282,8 @@ zx_status_t Minfs::BeginTransaction(size_t reserve_inodes, size_t reserve_blocks
     ZX_DEBUG_ASSERT(reserve_inodes <= TransactionLimits::kMaxInodeBitmapBlocks);
 #ifdef __Fuchsia__
     // TODO(planders): Once we are splitting up write transactions, assert this on host as well.
-    ZX_DEBUG_ASSERT(reserve_blocks <= limits_.GetMaximumDataBlocks());
+    ZX_DEBUG_ASSERT(reserve_blocks <= fbl::max(limits_.GetMaximumDataBlocks(),
+                                               TransactionLimits::kMaxIndirectBlocks));
 #endif
     fbl::unique_ptr<WritebackWork> work(new WritebackWork(bc_.get()));
     fbl::unique_ptr<AllocatorPromise> inode_promise;
@@ -314,10 +317,42 @@ void Minfs::CommitTransaction(fbl::unique_ptr<Transaction> state) {
 }
 
 #ifdef __Fuchsia__
+void Minfs::CommitTransactionPart(Transaction* state) {
+    ZX_DEBUG_ASSERT(state->GetWork()->BlkCount() <= limits_.GetMaximumEntryDataBlocks());
+    writeback_->Enqueue(state->RemoveWork());
+    state->SetWork(fbl::unique_ptr<WritebackWork>(new WritebackWork(bc_.get())));
+}
+
 void Minfs::Sync(SyncCallback closure) {
+    fbl::Vector<fbl::RefPtr<VnodeMinfs>> dirty;
+    {
+        // Avoid releasing a reference to any vnode while holding |hash_lock_|.
+        fbl::AutoLock lock(&hash_lock_);
+        for (auto& vn : vnode_hash_) {
+            if (!vn.IsDirty()) {
+                continue;
+            }
+            fbl::RefPtr<VnodeMinfs> ref = fbl::MakeRefPtrUpgradeFromRaw(&vn, hash_lock_);
+            if (ref != nullptr) {
+                dirty.push_back(std::move(ref));
+            }
+        }
+    }
+    // Data which could not be flushed is reported to the caller, once everything else
+    // has been written back.
+    zx_status_t flush_status = ZX_OK;
+    for (auto& vn : dirty) {
+        zx_status_t status = vn->FlushDirty();
+        if (flush_status == ZX_OK) {
+            flush_status = status;
+        }
+    }
+
     fbl::unique_ptr<Transaction> state;
     ZX_ASSERT(BeginTransaction(0, 0, &state) == ZX_OK);
-    state->GetWork()->SetClosure(std::move(closure));
+    state->GetWork()->SetClosure([flush_status, cb = std::move(closure)](zx_status_t status) {
+        cb(status != ZX_OK ? status : flush_status);
+    });
     CommitTransaction(std::move(state));
 }
 #endif
@@ -358,6 +393,21 @@ zx_status_t Minfs::InoFree(VnodeMinfs* vn, WritebackWork* wb) {
     inodes_->Free(wb, vn->ino_);
     uint32_t block_count = vn->inode_.block_count;
 
+    if (vn->IsExtentMapped()) {
+        // Extent-mapped inodes have no indirect blocks.
+        const Extent* extents = GetExtents(&vn->inode_);
+        for (unsigned n = 0; n < vn->ExtentCount(); n++) {
+            for (blk_t i = 0; i < extents[n].length; i++) {
+                ValidateBno(extents[n].start + i);
+                block_count--;
+                block_allocator_->Free(wb, extents[n].start + i);
+            }
+        }
+        ZX_DEBUG_ASSERT(block_count == 0);
+        ZX_DEBUG_ASSERT(vn->IsUnlinked());
+        return ZX_OK;
+    }
+
     // release all direct blocks
     for (unsigned n = 0; n < kMinfsDirect; n++) {
         if (vn->inode_.dnum[n] == 0) {
@@ -805,8 +855,15 @@ zx_status_t Minfs::Create(fbl::unique_ptr<Bcache> bc, const Superblock* info,
         return status;
     }
 
+    fbl::unique_ptr<Journal> journal;
+    if ((status = Journal::Create(bc.get(), sb->Info(), &journal)) != ZX_OK) {
+        FS_TRACE_ERROR("Minfs::Create failed to initialize journal: %d\n", status);
+        return status;
+    }
+
     fbl::unique_ptr<WritebackBuffer> writeback;
-    status = WritebackBuffer::Create(bc.get(), std::move(mapper), &writeback);
+    status = WritebackBuffer::Create(bc.get(), std::move(mapper), std::move(journal),
+                                     &writeback);
     if (status != ZX_OK) {
         return status;
     }
@@ -834,7 +891,41 @@ zx_status_t Minfs::Create(fbl::unique_ptr<Bcache> bc, const Superblock* info,
     return ZX_OK;
 }
 
-zx_status_t Mount(fbl::unique_ptr<minfs::Bcache> bc, fbl::RefPtr<VnodeMinfs>* root_out) {
+#ifdef __Fuchsia__
+zx_status_t ReplayJournal(Bcache* bc, void* info_blk, bool readonly) {
+    const Superblock* info = reinterpret_cast<const Superblock*>(info_blk);
+    zx_status_t status;
+    if ((status = CheckSuperblock(info, bc)) != ZX_OK) {
+        return status;
+    }
+    if (readonly) {
+        // The metadata in place is only consistent once the journal is replayed,
+        // which would modify the disk.
+        size_t pending;
+        if ((status = Journal::CountPending(bc, *info, &pending)) != ZX_OK) {
+            return status;
+        } else if (pending != 0) {
+            FS_TRACE_ERROR("minfs: %zu journal entries must be replayed by a writable mount\n",
+                           pending);
+            return ZX_ERR_BAD_STATE;
+        }
+        return ZX_OK;
+    }
+    if ((status = Journal::Replay(bc, *info)) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: failed to replay journal: %d\n", status);
+        return status;
+    }
+    // The superblock itself may have been updated by the journal.
+    if ((status = bc->Readblk(0, info_blk)) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: could not read info block\n");
+        return status;
+    }
+    return ZX_OK;
+}
+#endif
+
+zx_status_t Mount(fbl::unique_ptr<minfs::Bcache> bc, const MountOptions& options,
+                  fbl::RefPtr<VnodeMinfs>* root_out) {
     TRACE_DURATION("minfs", "minfs_mount");
     zx_status_t status;
 
@@ -845,6 +936,12 @@ zx_status_t Mount(fbl::unique_ptr<minfs::Bcache> bc, fbl::RefPtr<VnodeMinfs>* ro
     }
     const Superblock* info = reinterpret_cast<Superblock*>(blk);
 
+#ifdef __Fuchsia__
+    if ((status = ReplayJournal(bc.get(), blk, options.readonly)) != ZX_OK) {
+        return status;
+    }
+#endif
+
     fbl::unique_ptr<Minfs> fs;
     if ((status = Minfs::Create(std::move(bc), info, &fs)) != ZX_OK) {
         FS_TRACE_ERROR("minfs: mount failed\n");
@@ -870,7 +967,7 @@ zx_status_t MountAndServe(const MountOptions* options, async_dispatcher_t* dispa
     TRACE_DURATION("minfs", "MountAndServe");
 
     fbl::RefPtr<VnodeMinfs> vn;
-    zx_status_t status = Mount(std::move(bc), &vn);
+    zx_status_t status = Mount(std::move(bc), *options, &vn);
     if (status != ZX_OK) {
         return status;
     }
@@ -919,6 +1016,9 @@ zx_status_t Mkfs(const MountOptions& options, fbl::unique_ptr<Bcache> bc) {
     info.magic1 = kMinfsMagic1;
     info.version = kMinfsVersion;
     info.flags = kMinfsFlagClean;
+    if (options.use_extents) {
+        info.flags |= kMinfsFlagExtents;
+    }
     info.block_size = kMinfsBlockSize;
     info.inode_size = kMinfsInodeSize;
 
@@ -23,7 +23,8 @@ COMMON_SRCS := \
 
 # minfs implementation
 MODULE_SRCS := \
-    $(COMMON_SRCS)
+    $(COMMON_SRCS) \
+    $(LOCAL_DIR)/journal.cpp \
 
 MODULE_STATIC_LIBS := \
     system/ulib/async \
@@ -43,6 +44,7 @@ MODULE_STATIC_LIBS := \
     system/ulib/zircon-internal \
     system/ulib/zx \
     system/ulib/zxcpp \
+    third_party/ulib/cksum \
 
 MODULE_LIBS := \
     system/ulib/async.default \
@@ -72,6 +72,10 @@ zx_status_t NextDirent(Dirent* de, DirectoryOffset* offs) {
 
 #ifdef __Fuchsia__
 
+// Largest number of file blocks which may be dirty (written to a vnode's VMO, but not yet
+// allocated or written back) at once. Flushing them must fit within a single transaction.
+constexpr blk_t kMaxDirtyBlocks = TransactionLimits::kMaxWriteBytes / kMinfsBlockSize;
+
 // MinfsConnection overrides the base Connection class to allow Minfs to
 // dispatch its own ordinals.
 class MinfsConnection : public fs::Connection {
@@ -130,6 +134,16 @@ void VnodeMinfs::InodeSync(WritebackWork* wb, uint32_t flags) {
         }
     }
 
+#ifdef __Fuchsia__
+    if (IsDirty()) {
+        // The dirty blocks may not be allocated yet, so persist the size the file had
+        // before they were written. The full size is persisted once they are flushed.
+        Inode inode = inode_;
+        inode.size = dirty_size_;
+        fs_->InodeUpdate(wb, ino_, &inode);
+        return;
+    }
+#endif
     fs_->InodeUpdate(wb, ino_, &inode_);
 }
 
@@ -137,6 +151,10 @@ void VnodeMinfs::InodeSync(WritebackWork* wb, uint32_t flags) {
 // the file. Does not update mtime/atime.
 zx_status_t VnodeMinfs::BlocksShrink(Transaction* state, blk_t start) {
     ZX_DEBUG_ASSERT(state != nullptr);
+    if (IsExtentMapped()) {
+        return ExtentsShrink(state, start);
+    }
+
     BlockOpArgs op_args(start, static_cast<blk_t>(kMinfsMaxFileBlock - start), nullptr);
     zx_status_t status;
     if ((status = ApplyOperation(state, BlockOp::kDelete, &op_args)) != ZX_OK) {
@@ -279,6 +297,22 @@ zx_status_t VnodeMinfs::InitVmo() {
                                ticker.End());
     });
 
+    if (IsExtentMapped()) {
+        // Each extent is read with a single request.
+        const Extent* extents = GetExtents(&inode_);
+        const uint32_t count = ExtentCount();
+        for (uint32_t i = 0; i < count; i++) {
+            fs_->ValidateBno(extents[i].start);
+            fs_->ValidateBno(extents[i].start + extents[i].length - 1);
+            dnum_count++;
+            txn.Enqueue(vmoid_, extents[i].file_block, extents[i].start + fs_->Info().dat_block,
+                        extents[i].length);
+        }
+        status = txn.Transact();
+        ValidateVmoTail();
+        return status;
+    }
+
     // Initialize all direct blocks
     blk_t bno;
     for (uint32_t d = 0; d < kMinfsDirect; d++) {
@@ -413,6 +447,14 @@ zx_status_t VnodeMinfs::BlockOpDirect(Transaction* state, DirectArgs* params) {
                 params->SetBno(i, bno);
                 break;
             }
+            case BlockOp::kSet: {
+                ZX_DEBUG_ASSERT(state != nullptr);
+                ZX_DEBUG_ASSERT(bno == 0);
+                bno = params->GetSetBno(i);
+                fs_->ValidateBno(bno);
+                params->SetBno(i, bno);
+                break;
+            }
             default: {
                 return ZX_ERR_NOT_SUPPORTED;
             }
@@ -427,7 +469,7 @@ zx_status_t VnodeMinfs::BlockOpIndirect(Transaction* state, IndirectArgs* params
     zx_status_t status;
 
 #ifdef __Fuchsia__
-    if (params->GetOp() == BlockOp::kRead || params->GetOp() == BlockOp::kWrite) {
+    if (params->GetOp() != BlockOp::kDelete) {
         ValidateVmoSize(vmo_indirect_->vmo().get(), params->GetOffset() + params->GetCount());
     }
 #endif
@@ -441,6 +483,7 @@ zx_status_t VnodeMinfs::BlockOpIndirect(Transaction* state, IndirectArgs* params
             case BlockOp::kRead:
                 return ZX_OK;
             case BlockOp::kWrite:
+            case BlockOp::kSet:
                 AllocateIndirect(state, i, params);
                 break;
             default:
@@ -490,7 +533,7 @@ zx_status_t VnodeMinfs::BlockOpDindirect(Transaction* state, DindirectArgs* para
     zx_status_t status;
 
 #ifdef __Fuchsia__
-    if (params->GetOp() == BlockOp::kRead || params->GetOp() == BlockOp::kWrite) {
+    if (params->GetOp() != BlockOp::kDelete) {
         ValidateVmoSize(vmo_indirect_->vmo().get(), params->GetOffset() + params->GetCount());
     }
 #endif
@@ -505,6 +548,7 @@ zx_status_t VnodeMinfs::BlockOpDindirect(Transaction* state, DindirectArgs* para
             case BlockOp::kRead:
                 return ZX_OK;
             case BlockOp::kWrite:
+            case BlockOp::kSet:
                 AllocateIndirect(state, i, params);
                 break;
             default:
@@ -565,6 +609,14 @@ void VnodeMinfs::ClearIndirectVmoBlock(uint32_t offset) {
     ValidateVmoSize(vmo_indirect_->vmo().get(), offset);
     memset(reinterpret_cast<void*>(addr + kMinfsBlockSize * offset), 0, kMinfsBlockSize);
 }
+
+void VnodeMinfs::EnqueueDataBlock(WritebackWork* wb, blk_t n, blk_t bno) {
+    if (IsDirectory()) {
+        wb->Enqueue(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
+    } else {
+        wb->EnqueueData(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
+    }
+}
 #else
 void VnodeMinfs::ReadIndirectBlock(blk_t bno, uint32_t* entry) {
     fs_->bc_->Readblk(bno + fs_->Info().dat_block, entry);
@@ -680,8 +732,8 @@ zx_status_t VnodeMinfs::ApplyOperation(Transaction* state, BlockOp op, BlockOpAr
     return found == op_args->count ? ZX_OK : ZX_ERR_OUT_OF_RANGE;
 }
 
-zx_status_t VnodeMinfs::BlockGet(Transaction* state, blk_t n, blk_t* bno) {
 #ifdef __Fuchsia__
+zx_status_t VnodeMinfs::InitIndirectVmoForBlock(blk_t n) {
     if (n >= kMinfsDirect) {
         zx_status_t status;
         // If the vmo_indirect_ vmo has not been created, make it now.
@@ -704,12 +756,327 @@ zx_status_t VnodeMinfs::BlockGet(Transaction* state, blk_t n, blk_t* bno) {
             }
         }
     }
+    return ZX_OK;
+}
+#endif
+
+zx_status_t VnodeMinfs::BlockGet(Transaction* state, blk_t n, blk_t* bno) {
+    if (IsExtentMapped()) {
+        return ExtentGet(state, n, bno);
+    }
+
+#ifdef __Fuchsia__
+    zx_status_t status;
+    if ((status = InitIndirectVmoForBlock(n)) != ZX_OK) {
+        return status;
+    }
 #endif
 
     BlockOpArgs op_args(n, 1, bno);
     return ApplyOperation(state, state ? BlockOp::kWrite : BlockOp::kRead, &op_args);
 }
 
+uint32_t VnodeMinfs::ExtentCount() const {
+    const Extent* extents = GetExtents(&inode_);
+    uint32_t count = 0;
+    while (count < kMinfsExtents && extents[count].length != 0) {
+        count++;
+    }
+    return count;
+}
+
+zx_status_t VnodeMinfs::ExtentGet(Transaction* state, blk_t n, blk_t* bno) {
+    Extent* extents = GetExtents(&inode_);
+    uint32_t count = ExtentCount();
+
+    // Find the first extent which starts past |n|. Only the extent before it may hold |n|.
+    uint32_t next = 0;
+    while (next < count && extents[next].file_block <= n) {
+        next++;
+    }
+    Extent* prev = (next > 0) ? &extents[next - 1] : nullptr;
+    if (prev != nullptr && n - prev->file_block < prev->length) {
+        *bno = prev->start + (n - prev->file_block);
+        fs_->ValidateBno(*bno);
+        return ZX_OK;
+    }
+
+    if (state == nullptr) {
+        // Unmapped blocks read as zeroes.
+        *bno = 0;
+        return ZX_OK;
+    }
+
+    blk_t new_bno;
+    fs_->BlockNew(state, &new_bno);
+    fs_->ValidateBno(new_bno);
+    inode_.block_count++;
+
+    if (prev != nullptr && prev->file_block + prev->length == n &&
+        prev->start + prev->length == new_bno) {
+        // The file is growing into the blocks which follow it; this is the common case.
+        prev->length++;
+        if (next < count && extents[next].file_block == n + 1 &&
+            extents[next].start == new_bno + 1) {
+            // The block filled the gap between two extents, which may now be merged.
+            prev->length += extents[next].length;
+            memmove(&extents[next], &extents[next + 1], (count - next - 1) * sizeof(Extent));
+            memset(&extents[count - 1], 0, sizeof(Extent));
+        }
+    } else if (next < count && extents[next].file_block == n + 1 &&
+               extents[next].start == new_bno + 1) {
+        extents[next].file_block = n;
+        extents[next].start = new_bno;
+        extents[next].length++;
+    } else {
+        // ReserveExtents ensures there is room for every block of a write.
+        ZX_ASSERT(count < kMinfsExtents);
+        memmove(&extents[next + 1], &extents[next], (count - next) * sizeof(Extent));
+        extents[next].file_block = n;
+        extents[next].start = new_bno;
+        extents[next].length = 1;
+    }
+
+    InodeSync(state->GetWork(), kMxFsSyncDefault);
+    *bno = new_bno;
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::ExtentsShrink(Transaction* state, blk_t start) {
+    Extent* extents = GetExtents(&inode_);
+    bool dirty = false;
+
+    // Extents are sorted, so only a suffix of them may hold blocks at or past |start|.
+    for (uint32_t i = ExtentCount(); i > 0; i--) {
+        Extent* extent = &extents[i - 1];
+        if (extent->file_block + extent->length <= start) {
+            break;
+        }
+
+        blk_t keep = (extent->file_block < start) ? start - extent->file_block : 0;
+        for (blk_t j = keep; j < extent->length; j++) {
+            fs_->ValidateBno(extent->start + j);
+            fs_->BlockFree(state->GetWork(), extent->start + j);
+            inode_.block_count--;
+        }
+        if (keep == 0) {
+            memset(extent, 0, sizeof(Extent));
+        } else {
+            extent->length = keep;
+        }
+        dirty = true;
+    }
+
+    if (dirty) {
+        InodeSync(state->GetWork(), kMxFsSyncDefault);
+    }
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::ReserveExtents(size_t off, size_t len) {
+    ZX_DEBUG_ASSERT(IsExtentMapped());
+    if (len == 0 || off >= kMinfsMaxFileSize) {
+        return ZX_OK;
+    }
+
+    // In the worst case, every block which the write allocates needs an extent of its own.
+    blk_t first = static_cast<blk_t>(off / kMinfsBlockSize);
+    blk_t last = static_cast<blk_t>(fbl::min(off + len - 1, kMinfsMaxFileSize - 1) /
+                                    kMinfsBlockSize);
+    uint32_t unmapped = 0;
+    for (blk_t n = first; n <= last; n++) {
+        blk_t bno;
+        ExtentGet(nullptr, n, &bno);
+        if (bno == 0) {
+            unmapped++;
+        }
+    }
+
+    if (ExtentCount() + unmapped <= kMinfsExtents) {
+        return ZX_OK;
+    }
+    return ConvertToBlockMap();
+}
+
+zx_status_t VnodeMinfs::ConvertToBlockMap() {
+    TRACE_DURATION("minfs", "VnodeMinfs::ConvertToBlockMap", "ino", ino_);
+    ZX_DEBUG_ASSERT(IsExtentMapped());
+    const Inode extent_inode = inode_;
+    const Extent* extents = GetExtents(&extent_inode);
+    const uint32_t count = ExtentCount();
+
+    // Reserve every indirect block which may be needed to map the file.
+    zx_status_t status;
+    blk_t reserve_blocks = 0;
+    if (count > 0) {
+        const blk_t end = extents[count - 1].file_block + extents[count - 1].length;
+        if ((status = GetRequiredBlockCount(0, static_cast<size_t>(end) * kMinfsBlockSize,
+                                            &reserve_blocks)) != ZX_OK) {
+            return status;
+        }
+        reserve_blocks -= end;
+#ifdef __Fuchsia__
+        // The indirect VMO only grows, so this covers every block mapped below.
+        if ((status = InitIndirectVmoForBlock(end - 1)) != ZX_OK) {
+            return status;
+        }
+#endif
+    }
+
+    fbl::unique_ptr<Transaction> state;
+    if ((status = fs_->BeginTransaction(0, reserve_blocks, &state)) != ZX_OK) {
+        return status;
+    }
+
+    // The inode is never left half-converted in memory: on failure it is restored.
+    //
+    // Mapping a large file may dirty more indirect blocks than a single journal entry
+    // can hold. The new indirect blocks are then persisted over several transactions,
+    // in each of which the inode keeps its extents on disk; only the final transaction
+    // switches it to the block pointers. A crash part way through can leak the new
+    // indirect blocks, but never loses data.
+#ifdef __Fuchsia__
+    const size_t max_blocks = fs_->Limits().GetMaximumEntryDataBlocks();
+    // A single block may dirty an indirect block, a doubly indirect block, the bitmap
+    // blocks allocating them, and the inode.
+    constexpr size_t kMaxBlocksPerMapping = 5;
+#endif
+
+    memset(GetExtents(&inode_), 0, sizeof(Extent) * kMinfsExtents);
+    inode_.flags &= ~kMinfsInodeFlagExtents;
+    for (uint32_t i = 0; i < count; i++) {
+        for (blk_t j = 0; j < extents[i].length; j++) {
+#ifdef __Fuchsia__
+            if (state->GetWork()->BlkCount() + kMaxBlocksPerMapping > max_blocks) {
+                Inode converted = inode_;
+                inode_ = extent_inode;
+                InodeSync(state->GetWork(), kMxFsSyncDefault);
+                inode_ = converted;
+                state->GetWork()->PinVnode(fbl::WrapRefPtr(this));
+                fs_->CommitTransactionPart(state.get());
+            }
+#endif
+
+            blk_t bno;
+            BlockOpArgs op_args(extents[i].file_block + j, 1, &bno);
+            // kSet reads |bnos|, which BlockOpArgs clears.
+            bno = extents[i].start + j;
+            if ((status = ApplyOperation(state.get(), BlockOp::kSet, &op_args)) != ZX_OK) {
+                // Any parts already committed still describe the extents on disk.
+                inode_ = extent_inode;
+                return status;
+            }
+        }
+    }
+
+    InodeSync(state->GetWork(), kMxFsSyncDefault);
+    state->GetWork()->PinVnode(fbl::WrapRefPtr(this));
+    fs_->CommitTransaction(std::move(state));
+    return ZX_OK;
+}
+
+#ifdef __Fuchsia__
+zx_status_t VnodeMinfs::PrepareDirty(size_t off, size_t len, bool* out_delayed) {
+    *out_delayed = false;
+    if (len == 0 || off + len > kMinfsMaxFileSize) {
+        return FlushDirty();
+    }
+    const blk_t start = static_cast<blk_t>(off / kMinfsBlockSize);
+    const blk_t end = static_cast<blk_t>(fbl::round_up(off + len, kMinfsBlockSize) /
+                                         kMinfsBlockSize);
+
+    if (IsDirty()) {
+        // The write may join the dirty range if it stays contiguous, and within the
+        // blocks reserved by |dirty_state_|.
+        if (start <= dirty_end_ && end >= dirty_start_ && start >= dirty_base_ &&
+            end <= dirty_base_ + kMaxDirtyBlocks) {
+            *out_delayed = true;
+            return ZX_OK;
+        }
+        zx_status_t status = FlushDirty();
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+
+    if (end - start > kMaxDirtyBlocks) {
+        return ZX_OK;
+    }
+
+    // Reserve enough blocks to flush any dirty range starting at |start|. If they are not
+    // available, the write is allocated immediately instead, reserving only what it needs.
+    blk_t reserve_blocks;
+    zx_status_t status = GetRequiredBlockCount(off - off % kMinfsBlockSize,
+                                               TransactionLimits::kMaxWriteBytes,
+                                               &reserve_blocks);
+    if (status != ZX_OK) {
+        return ZX_OK;
+    }
+    fbl::unique_ptr<Transaction> state;
+    if (fs_->BeginTransaction(0, reserve_blocks, &state) != ZX_OK) {
+        return ZX_OK;
+    }
+
+    dirty_state_ = std::move(state);
+    dirty_base_ = start;
+    dirty_start_ = start;
+    dirty_end_ = start;
+    dirty_size_ = inode_.size;
+    *out_delayed = true;
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::FlushDirty() {
+    if (!IsDirty()) {
+        return ZX_OK;
+    }
+    TRACE_DURATION("minfs", "VnodeMinfs::FlushDirty", "ino", ino_,
+                   "blocks", dirty_end_ - dirty_start_);
+
+    // On failure, the range stays dirty so that it may be flushed again later; the inode
+    // never persists a size covering blocks which were not written back.
+    zx_status_t status = ZX_OK;
+    if (dirty_end_ > dirty_start_) {
+        if (IsExtentMapped()) {
+            status = ReserveExtents(dirty_start_ * kMinfsBlockSize,
+                                    (dirty_end_ - dirty_start_) * kMinfsBlockSize);
+        }
+        if (status == ZX_OK && !IsExtentMapped()) {
+            status = InitIndirectVmoForBlock(dirty_end_ - 1);
+        }
+        if (status != ZX_OK) {
+            FS_TRACE_ERROR("minfs: Failed to flush dirty blocks of ino %u: %d\n", ino_, status);
+            return status;
+        }
+    }
+
+    for (blk_t n = dirty_start_; n < dirty_end_; n++) {
+        blk_t bno;
+        if ((status = BlockGet(dirty_state_.get(), n, &bno)) != ZX_OK) {
+            FS_TRACE_ERROR("minfs: Failed to flush dirty blocks of ino %u: %d\n", ino_, status);
+            // Persist the blocks allocated so far, which the inode may already point to.
+            // The inode keeps the size it had before the range was written.
+            InodeSync(dirty_state_->GetWork(), kMxFsSyncDefault);
+            dirty_state_->GetWork()->PinVnode(fbl::WrapRefPtr(this));
+            fs_->CommitTransactionPart(dirty_state_.get());
+            return status;
+        }
+        ZX_DEBUG_ASSERT(bno != 0);
+        // Missing blocks are allocated in order, so the range is usually
+        // merged into a single request.
+        EnqueueDataBlock(dirty_state_->GetWork(), n, bno);
+    }
+
+    fbl::unique_ptr<Transaction> state = std::move(dirty_state_);
+    dirty_start_ = 0;
+    dirty_end_ = 0;
+    InodeSync(state->GetWork(), kMxFsSyncDefault);
+    state->GetWork()->PinVnode(fbl::WrapRefPtr(this));
+    fs_->CommitTransaction(std::move(state));
+    return ZX_OK;
+}
+#endif
+
 zx_status_t VnodeMinfs::ReadExactInternal(void* data, size_t len, size_t off) {
     size_t actual;
     zx_status_t status = ReadInternal(data, len, off, &actual);
@@ -1161,7 +1528,7 @@ void VnodeMinfs::Purge(WritebackWork* wb) {
     fs_->VnodeRelease(this);
 #ifdef __Fuchsia__
     // TODO(smklein): Only init indirect vmo if it's needed
-    if (InitIndirectVmo() == ZX_OK) {
+    if (IsExtentMapped() || InitIndirectVmo() == ZX_OK) {
         fs_->InoFree(this, wb);
     } else {
         FS_TRACE_ERROR("minfs: Failed to Init Indirect VMO while purging %u\n", ino_);
@@ -1177,11 +1544,27 @@ zx_status_t VnodeMinfs::Close() {
 
     if (fd_count_ == 0 && IsUnlinked()) {
         fbl::unique_ptr<Transaction> state;
-        ZX_ASSERT(fs_->BeginTransaction(0, 0, &state) == ZX_OK);
+#ifdef __Fuchsia__
+        // Dirty data of an unlinked file is never written back; it is purged along
+        // with the inode.
+        state = std::move(dirty_state_);
+        dirty_start_ = 0;
+        dirty_end_ = 0;
+#endif
+        if (state == nullptr) {
+            ZX_ASSERT(fs_->BeginTransaction(0, 0, &state) == ZX_OK);
+        }
         fs_->RemoveUnlinked(state->GetWork(), this);
         Purge(state->GetWork());
         fs_->CommitTransaction(std::move(state));
+        return ZX_OK;
+    }
+#ifdef __Fuchsia__
+    if (fd_count_ == 0) {
+        // Write back any dirty data once the last fd is closed.
+        return FlushDirty();
     }
+#endif
     return ZX_OK;
 }
 
@@ -1279,10 +1662,34 @@ zx_status_t VnodeMinfs::Write(const void* data, size_t len, size_t offset,
         fs_->UpdateWriteMetrics(*out_actual, ticker.End());
     });
 
+    zx_status_t status;
+#ifdef __Fuchsia__
+    // Unless the write is too large (or the filesystem too full) for its allocation to be
+    // delayed, it only updates the VMO; the blocks are allocated when flushed.
+    bool delayed;
+    if ((status = PrepareDirty(offset, len, &delayed)) != ZX_OK) {
+        return status;
+    }
+    if (delayed) {
+        if ((status = WriteInternal(nullptr, data, len, offset, out_actual)) != ZX_OK) {
+            return status;
+        }
+        const blk_t start = static_cast<blk_t>(offset / kMinfsBlockSize);
+        const blk_t end = static_cast<blk_t>(fbl::round_up(offset + *out_actual,
+                                                           kMinfsBlockSize) / kMinfsBlockSize);
+        dirty_start_ = fbl::min(dirty_start_, start);
+        dirty_end_ = fbl::max(dirty_end_, end);
+        inode_.modify_time = GetTimeUTC();  // Successful writes updates mtime
+        return ZX_OK;
+    }
+#endif
+
     blk_t reserve_blocks;
     // Calculate maximum number of blocks to reserve for this write operation.
-    zx_status_t status = GetRequiredBlockCount(offset, len, &reserve_blocks);
-    if (status != ZX_OK) {
+    if ((status = GetRequiredBlockCount(offset, len, &reserve_blocks)) != ZX_OK) {
+        return status;
+    }
+    if (IsExtentMapped() && (status = ReserveExtents(offset, len)) != ZX_OK) {
         return status;
     }
     fbl::unique_ptr<Transaction> state;
@@ -1310,6 +1717,8 @@ zx_status_t VnodeMinfs::Append(const void* data, size_t len, size_t* out_end,
 }
 
 // Internal write. Usable on directories.
+// On Fuchsia, a null |state| only updates the VMO, leaving the blocks to be
+// allocated and written back by |FlushDirty|.
 zx_status_t VnodeMinfs::WriteInternal(Transaction* state, const void* data,
                                       size_t len, size_t off, size_t* actual) {
     if (len == 0) {
@@ -1355,13 +1764,15 @@ zx_status_t VnodeMinfs::WriteInternal(Transaction* state, const void* data,
             break;
         }
 
-        // Update this block on-disk
-        blk_t bno;
-        if ((status = BlockGet(state, n, &bno))) {
-            break;
+        // Update this block on-disk, unless its allocation is delayed.
+        if (state != nullptr) {
+            blk_t bno;
+            if ((status = BlockGet(state, n, &bno))) {
+                break;
+            }
+            ZX_DEBUG_ASSERT(bno != 0);
+            EnqueueDataBlock(state->GetWork(), n, bno);
         }
-        ZX_DEBUG_ASSERT(bno != 0);
-        state->GetWork()->Enqueue(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
 #else
         blk_t bno;
         if ((status = BlockGet(state, n, &bno))) {
@@ -1583,6 +1994,9 @@ void VnodeMinfs::Allocate(Minfs* fs, uint32_t type, fbl::RefPtr<VnodeMinfs>* out
     (*out)->inode_.magic = MinfsMagic(type);
     (*out)->inode_.create_time = (*out)->inode_.modify_time = GetTimeUTC();
     (*out)->inode_.link_count = (type == kMinfsTypeDir ? 2 : 1);
+    if (type == kMinfsTypeFile && (fs->Info().flags & kMinfsFlagExtents)) {
+        (*out)->inode_.flags = kMinfsInodeFlagExtents;
+    }
 }
 
 zx_status_t VnodeMinfs::Recreate(Minfs* fs, ino_t ino, fbl::RefPtr<VnodeMinfs>* out) {
@@ -1771,10 +2185,17 @@ zx_status_t VnodeMinfs::Truncate(size_t len) {
         fs_->UpdateTruncateMetrics(ticker.End());
     });
 
+    zx_status_t status;
+#ifdef __Fuchsia__
+    if ((status = FlushDirty()) != ZX_OK) {
+        return status;
+    }
+#endif
+
     fbl::unique_ptr<Transaction> state;
     // Since we will only edit existing blocks, no new blocks are required.
     ZX_ASSERT(fs_->BeginTransaction(0, 0, &state) == ZX_OK);
-    zx_status_t status = TruncateInternal(state.get(), len);
+    status = TruncateInternal(state.get(), len);
     if (status == ZX_OK) {
         // Successful truncates update inode
         InodeSync(state->GetWork(), kMxFsSyncMtime);
@@ -1843,7 +2264,7 @@ zx_status_t VnodeMinfs::TruncateInternal(Transaction* state, size_t len) {
                     FS_TRACE_ERROR("minfs: Truncate failed to write last block: %d\n", r);
                     return ZX_ERR_IO;
                 }
-                state->GetWork()->Enqueue(vmo_.get(), rel_bno, bno + fs_->Info().dat_block, 1);
+                EnqueueDataBlock(state->GetWork(), rel_bno, bno);
 #else
                 if (fs_->bc_->Readblk(bno + fs_->Info().dat_block, bdata)) {
                     return ZX_ERR_IO;
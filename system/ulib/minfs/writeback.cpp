@@ -30,11 +30,11 @@ namespace minfs {
 
 #ifdef __Fuchsia__
 
-void WriteTxn::Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
-                       uint64_t nblocks) {
+void WriteTxn::EnqueueRequest(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
+                              uint64_t nblocks, bool data) {
     ValidateVmoSize(vmo, static_cast<blk_t>(vmo_offset));
     for (size_t i = 0; i < requests_.size(); i++) {
-        if (requests_[i].vmo != vmo) {
+        if (requests_[i].vmo != vmo || requests_[i].data != data) {
             continue;
         }
 
@@ -59,6 +59,7 @@ void WriteTxn::Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset
     request.vmo_offset = vmo_offset;
     request.dev_offset = dev_offset;
     request.length = nblocks;
+    request.data = data;
     requests_.push_back(std::move(request));
 }
 
@@ -128,6 +129,16 @@ size_t WritebackWork::Complete(zx_handle_t vmo, vmoid_t vmoid) {
     return blk_count;
 }
 
+size_t WritebackWork::Abort(zx_status_t status) {
+    size_t blk_count = BlkCount();
+    Requests().reset();
+    if (closure_) {
+        closure_(status);
+    }
+    Reset();
+    return blk_count;
+}
+
 void WritebackWork::SetClosure(SyncCallback closure) {
     ZX_DEBUG_ASSERT(!closure_);
     closure_ = std::move(closure);
@@ -155,8 +166,10 @@ void WritebackWork::PinVnode(fbl::RefPtr<VnodeMinfs> vn) {
 #ifdef __Fuchsia__
 
 zx_status_t WritebackBuffer::Create(Bcache* bc, fzl::OwnedVmoMapper mapper,
+                                    fbl::unique_ptr<Journal> journal,
                                     fbl::unique_ptr<WritebackBuffer>* out) {
-    fbl::unique_ptr<WritebackBuffer> wb(new WritebackBuffer(bc, std::move(mapper)));
+    fbl::unique_ptr<WritebackBuffer> wb(new WritebackBuffer(bc, std::move(mapper),
+                                                            std::move(journal)));
     if (wb->mapper_.size() % kMinfsBlockSize != 0) {
         return ZX_ERR_INVALID_ARGS;
     } else if (cnd_init(&wb->consumer_cvar_) != thrd_success) {
@@ -177,8 +190,9 @@ zx_status_t WritebackBuffer::Create(Bcache* bc, fzl::OwnedVmoMapper mapper,
     return ZX_OK;
 }
 
-WritebackBuffer::WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper) :
-    bc_(bc), unmounting_(false), mapper_(std::move(mapper)),
+WritebackBuffer::WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper,
+                                 fbl::unique_ptr<Journal> journal) :
+    bc_(bc), unmounting_(false), mapper_(std::move(mapper)), journal_(std::move(journal)),
     cap_(mapper_.size() / kMinfsBlockSize) {}
 
 WritebackBuffer::~WritebackBuffer() {
@@ -191,6 +205,12 @@ WritebackBuffer::~WritebackBuffer() {
     int r;
     thrd_join(writeback_thrd_, &r);
 
+    // Leave the journal empty, so the next mount has nothing to replay.
+    if (journal_ != nullptr && journal_->Checkpoint() != ZX_OK) {
+        FS_TRACE_ERROR("minfs: Failed to checkpoint journal on unmount\n");
+    }
+    journal_ = nullptr;
+
     if (buffer_vmoid_ != VMOID_INVALID) {
         block_fifo_request_t request;
         request.group = bc_->BlockGroupID();
@@ -272,6 +292,7 @@ void WritebackBuffer::CopyToBufferLocked(WriteTxn* txn) {
             request.vmo_offset = 0;
             request.dev_offset = dev_offset;
             request.length = wb_len;
+            request.data = reqs[i].data;
             i++;
             reqs.insert(i, request);
         }
@@ -312,24 +333,73 @@ void WritebackBuffer::Enqueue(fbl::unique_ptr<WritebackWork> work) {
     cnd_signal(&consumer_cvar_);
 }
 
+size_t WritebackBuffer::TakeBatchLocked(fbl::Vector<fbl::unique_ptr<WritebackWork>>* batch) {
+    size_t blocks = 0;
+    size_t journal_blocks = 0;
+    do {
+        if (journal_ != nullptr) {
+            // Stop once the next unit of work would overflow a single journal entry.
+            size_t next_blocks = journal_->MetadataBlocks(work_queue_.front());
+            if (!batch->is_empty() &&
+                journal_blocks + next_blocks > journal_->MaxEntryBlocks()) {
+                break;
+            }
+            journal_blocks += next_blocks;
+        }
+        auto work = work_queue_.pop();
+        blocks += work->BlkCount();
+        batch->push_back(std::move(work));
+    } while (journal_ != nullptr && !work_queue_.is_empty());
+    return blocks;
+}
+
+void WritebackBuffer::CompleteBatch(fbl::Vector<fbl::unique_ptr<WritebackWork>>* batch) {
+    if (journal_ != nullptr) {
+        WriteTxn* txns[batch->size()];
+        for (size_t i = 0; i < batch->size(); i++) {
+            txns[i] = (*batch)[i].get();
+        }
+        if (journal_status_ == ZX_OK) {
+            journal_status_ = journal_->Commit(txns, batch->size(), mapper_.start(),
+                                               buffer_vmoid_);
+            if (journal_status_ != ZX_OK) {
+                FS_TRACE_ERROR("minfs: Failed to commit journal entry: %d\n", journal_status_);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < batch->size(); i++) {
+        WritebackWork* work = (*batch)[i].get();
+        if (journal_status_ != ZX_OK) {
+            // Writing the batch in place without a committed entry could leave the
+            // metadata inconsistent after a crash.
+            work->Abort(journal_status_);
+            TRACE_FLOW_END("minfs", "writeback", reinterpret_cast<trace_flow_id_t>(work));
+            continue;
+        }
+        // TODO(smklein): We could add additional validation that the blocks
+        // in "work" are contiguous and in the range of [start_, len_) (including
+        // wraparound).
+        work->Complete(mapper_.vmo().get(), buffer_vmoid_);
+        TRACE_FLOW_END("minfs", "writeback", reinterpret_cast<trace_flow_id_t>(work));
+    }
+    batch->reset();
+}
+
 int WritebackBuffer::WritebackThread(void* arg) {
     WritebackBuffer* b = reinterpret_cast<WritebackBuffer*>(arg);
 
     b->writeback_lock_.Acquire();
     while (true) {
         while (!b->work_queue_.is_empty()) {
-            auto work = b->work_queue_.pop();
+            fbl::Vector<fbl::unique_ptr<WritebackWork>> batch;
+            size_t blks_consumed = b->TakeBatchLocked(&batch);
             TRACE_DURATION("minfs", "WritebackBuffer::WritebackThread");
 
             // Stay unlocked while processing a unit of work
             b->writeback_lock_.Release();
 
-            // TODO(smklein): We could add additional validation that the blocks
-            // in "work" are contiguous and in the range of [start_, len_) (including
-            // wraparound).
-            size_t blks_consumed = work->Complete(b->mapper_.vmo().get(), b->buffer_vmoid_);
-            TRACE_FLOW_END("minfs", "writeback", reinterpret_cast<trace_flow_id_t>(work.get()));
-            work = nullptr;
+            b->CompleteBatch(&batch);
 
             // Relock before checking the state of the queue
             b->writeback_lock_.Acquire();
@@ -9,6 +9,14 @@
 #include <zircon/status.h>
 #include <zircon/syscalls.h>
 
+static zx_status_t init(void** out_ctx) {
+    // The same few executables and dynamic linkers are launched over and
+    // over, so keep their prepared segments rather than redoing the work.
+    launchpad_set_image_cache(true);
+    *out_ctx = nullptr;
+    return ZX_OK;
+}
+
 static zx_status_t connect(void* ctx, async_dispatcher_t* dispatcher, const char* service_name,
                            zx_handle_t request) {
     if (!strcmp(service_name, fuchsia_process_Launcher_Name)) {
@@ -38,7 +46,7 @@ static constexpr const char* launcher_services[] = {
 };
 
 static constexpr zx_service_ops_t launcher_ops = {
-    .init = nullptr,
+    .init = init,
     .connect = connect,
     .release = nullptr,
 };
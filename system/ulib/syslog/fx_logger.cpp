@@ -5,6 +5,7 @@
 #include <fbl/algorithm.h>
 #include <fbl/auto_lock.h>
 #include <fbl/string_buffer.h>
+#include <lib/zx/vmar.h>
 #include <zircon/assert.h>
 
 #include <lib/syslog/logger.h>
@@ -30,6 +31,14 @@ zx_koid_t GetCurrentThreadKoid() {
 
 } // namespace
 
+fx_logger::~fx_logger() {
+    if (ring_ != nullptr) {
+        zx::vmar::root_self()->unmap(reinterpret_cast<uintptr_t>(ring_),
+                                     fbl::round_up(sizeof(fx_log_ring_t),
+                                                   static_cast<size_t>(PAGE_SIZE)));
+    }
+}
+
 void fx_logger::ActivateFallback(int fallback_fd) {
     fbl::AutoLock lock(&fallback_mutex_);
     if (logger_fd_.load(std::memory_order_relaxed) != -1) {
@@ -115,6 +124,9 @@ zx_status_t fx_logger::VLogWriteToSocket(fx_log_severity_t severity,
     }
     auto size = sizeof(packet.metadata) + msg_pos + count + 1;
     ZX_DEBUG_ASSERT(size <= sizeof(packet));
+    if (ring_ != nullptr && WriteToRing(&packet, size)) {
+        return ZX_OK;
+    }
     auto status = socket_.write(0, &packet, size, nullptr);
     if (status == ZX_ERR_BAD_STATE || status == ZX_ERR_PEER_CLOSED) {
         ActivateFallback(-1);
@@ -127,6 +139,47 @@ zx_status_t fx_logger::VLogWriteToSocket(fx_log_severity_t severity,
     return status;
 }
 
+// Claims the next slot of the ring unless the log service has yet to read
+// it, in which case the ring is full.
+bool fx_logger::WriteToRing(const fx_log_packet_t* packet, size_t size) {
+    if (!__atomic_load_n(&ring_->connected, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    uint64_t pos = __atomic_load_n(&ring_->write_position, __ATOMIC_RELAXED);
+    fx_log_ring_slot_t* slot;
+    for (;;) {
+        slot = &ring_->slots[pos % FX_LOG_RING_SLOTS];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = static_cast<int64_t>(sequence - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring_->write_position, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring_->write_position, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(&slot->packet, packet, size);
+    slot->size = static_cast<uint32_t>(size);
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_SEQ_CST);
+
+    // The log service sets |waiting| before it checks the ring for the last
+    // time, so either it sees this packet or this sees |waiting|.
+    if (__atomic_load_n(&ring_->waiting, __ATOMIC_SEQ_CST) &&
+        __atomic_exchange_n(&ring_->waiting, 0, __ATOMIC_SEQ_CST) &&
+        socket_.signal_peer(0, ZX_USER_SIGNAL_0) == ZX_ERR_PEER_CLOSED) {
+        return false;
+    }
+    // If the log service stopped reading the ring meanwhile, the packet may
+    // not have been read, so it is written to the socket as well; writes to
+    // the socket then fail and activate the fallback.
+    return __atomic_load_n(&ring_->connected, __ATOMIC_SEQ_CST);
+}
+
 zx_status_t fx_logger::VLogWriteToFd(int fd, fx_log_severity_t severity,
                                      const char* tag, const char* msg,
                                      va_list args, bool perform_format) {
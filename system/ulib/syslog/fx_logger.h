@@ -6,6 +6,7 @@
 #define ZIRCON_SYSTEM_ULIB_SYSLOG_FX_LOGGER_H_
 
 #include <lib/syslog/logger.h>
+#include <lib/syslog/wire_format.h>
 
 #include <fbl/mutex.h>
 #include <fbl/string.h>
@@ -50,7 +51,7 @@ public:
         dropped_logs_.store(0, std::memory_order_relaxed);
     }
 
-    ~fx_logger() = default;
+    ~fx_logger();
 
     zx_status_t VLogWrite(fx_log_severity_t severity, const char* tag,
                           const char* format, va_list args) {
@@ -73,6 +74,12 @@ public:
 
     void ActivateFallback(int fallback_fd);
 
+    // Takes ownership of |ring|, a mapping of a log ring shared with the
+    // log service through the peer of the logger's socket.
+    void SetRing(fx_log_ring_t* ring) {
+        ring_ = ring;
+    }
+
 private:
     zx_status_t VLogWrite(fx_log_severity_t severity, const char* tag,
                           const char* format, va_list args, bool perform_format);
@@ -80,6 +87,8 @@ private:
     zx_status_t VLogWriteToSocket(fx_log_severity_t severity, const char* tag,
                                   const char* msg, va_list args, bool perform_format);
 
+    bool WriteToRing(const fx_log_packet_t* packet, size_t size);
+
     zx_status_t VLogWriteToFd(int fd, fx_log_severity_t severity, const char* tag,
                               const char* msg, va_list args, bool perform_format);
 
@@ -90,6 +99,7 @@ private:
     std::atomic<uint32_t> dropped_logs_;
     std::atomic<int> logger_fd_;
     zx::socket socket_;
+    fx_log_ring_t* ring_ = nullptr;
     fbl::Vector<fbl::String> tags_;
 
     // This field is just used to close fd when
@@ -44,6 +44,22 @@ zx_status_t fx_log_init_with_config(const fx_logger_config_t* config) {
     return ZX_OK;
 }
 
+zx_status_t fx_log_init_with_ring(const fx_logger_config_t* config) {
+    if (config == nullptr) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (g_logger_ptr.get()) {
+        return ZX_ERR_BAD_STATE;
+    }
+    fx_logger_t* logger = NULL;
+    auto status = fx_logger_create_with_ring(config, ZX_HANDLE_INVALID, &logger);
+    if (status != ZX_OK) {
+        return status;
+    }
+    g_logger_ptr.reset(logger);
+    return ZX_OK;
+}
+
 // This is here to force a definition to be included here for C99.
 extern inline bool fx_log_is_enabled(fx_log_severity_t severity);
 
@@ -33,6 +33,11 @@ static inline bool fx_log_is_enabled(fx_log_severity_t severity) {
 // global logger would be deallocated once program ends.
 zx_status_t fx_log_init_with_config(const fx_logger_config_t* config);
 
+// Initializes the logging infrastructure like fx_log_init_with_config(), but
+// connects to the log service through a ring of shared memory. See
+// fx_logger_create_with_ring().
+zx_status_t fx_log_init_with_ring(const fx_logger_config_t* config);
+
 // Initializes the logging infrastructure for this process using default
 // parameters. Returns |ZX_ERR_BAD_STATE| if logging has already been
 // initialized.
@@ -67,6 +67,22 @@ typedef struct fx_logger fx_logger_t;
 zx_status_t fx_logger_create(const fx_logger_config_t* config,
                              fx_logger_t** out_logger);
 
+// Creates a logger object like fx_logger_create(), which connects to the log
+// service through |log_sink|, a channel to the fuchsia.logger.LogSink service,
+// or, if |log_sink| is ZX_HANDLE_INVALID, the one in the process's namespace.
+//
+// Messages are written to a ring of memory shared with the log service, which
+// reads them in batches, so that writing a message does not need a system
+// call while the log service keeps up. Messages are written to the log
+// service's socket while the ring is full.
+//
+// This will return ZX_ERR_INVALID_ARGS if |console_fd| or
+// |log_service_channel| is valid in |config|. Messages are written to stderr
+// if the log service cannot be reached.
+zx_status_t fx_logger_create_with_ring(const fx_logger_config_t* config,
+                                       zx_handle_t log_sink,
+                                       fx_logger_t** out_logger);
+
 // Destroys a logger object.
 //
 // This closes |console_fd| or |log_service_channel| which were passed in
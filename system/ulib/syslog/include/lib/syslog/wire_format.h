@@ -35,4 +35,48 @@ typedef struct fx_log_packet {
     char data[FX_LOG_MAX_DATAGRAM_LEN - sizeof(fx_log_metadata_t)];
 } fx_log_packet_t;
 
+// Number of packets held by a log ring.
+#define FX_LOG_RING_SLOTS (64)
+
+// Slot of a log ring.
+typedef struct fx_log_ring_slot {
+    // The slot at position |n| of the ring, counting every packet ever
+    // written, is free for writing while |sequence| is |n|, and holds a
+    // packet once |sequence| is |n| + 1. The log service sets |sequence|
+    // to |n| + FX_LOG_RING_SLOTS once it has read the packet.
+    uint64_t sequence;
+
+    // Bytes of |packet| in use.
+    uint32_t size;
+    uint32_t reserved;
+
+    fx_log_packet_t packet;
+} fx_log_ring_slot_t;
+
+// Ring of packets in a VMO shared between a logger and the log service,
+// which a logger writes to without a system call. Messages are written to
+// the logger's socket while the ring is full, and may be read out of order
+// with those in the ring.
+//
+// The fields are accessed atomically. A logger initializes |sequence| of
+// each slot to its index and |waiting| to 1 before sharing the ring.
+typedef struct fx_log_ring {
+    // Position of the next slot to be written.
+    uint64_t write_position;
+
+    // Set by the log service once it has read every packet in the ring. A
+    // logger which writes a packet while it is set clears it, and raises
+    // ZX_USER_SIGNAL_0 on the peer of its socket.
+    uint32_t waiting;
+
+    // Set by the log service once it has mapped the ring, and cleared before
+    // it stops reading it. A logger only writes to the ring while it is set,
+    // so that a log service which does not accept the ring, or has gone away,
+    // still receives packets through the socket.
+    uint32_t connected;
+    uint32_t reserved[12];
+
+    fx_log_ring_slot_t slots[FX_LOG_RING_SLOTS];
+} fx_log_ring_t;
+
 #endif // LIB_SYSLOG_WIRE_FORMAT_H_
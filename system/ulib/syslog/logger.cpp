@@ -2,10 +2,14 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <fbl/algorithm.h>
 #include <lib/fdio/util.h>
 #include <lib/zx/channel.h>
 #include <lib/zx/socket.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
 #include <lib/syslog/logger.h>
+#include <lib/syslog/wire_format.h>
 
 // TODO: Remove this hack once FIDL-182  is fixed.
 typedef zx_handle_t fuchsia_logger_LogListener;
@@ -15,8 +19,8 @@ typedef zx_handle_t fuchsia_logger_LogListener;
 
 namespace {
 
-zx::socket connect_to_logger() {
-    zx::socket invalid;
+zx::channel connect_to_log_sink() {
+    zx::channel invalid;
     zx::channel logger, logger_request;
     if (zx::channel::create(0, &logger, &logger_request) != ZX_OK) {
         return invalid;
@@ -24,6 +28,15 @@ zx::socket connect_to_logger() {
     if (fdio_service_connect("/svc/fuchsia.logger.LogSink", logger_request.release()) != ZX_OK) {
         return invalid;
     }
+    return logger;
+}
+
+zx::socket connect_to_logger() {
+    zx::socket invalid;
+    zx::channel logger = connect_to_log_sink();
+    if (!logger.is_valid()) {
+        return invalid;
+    }
     zx::socket local, remote;
     if (zx::socket::create(ZX_SOCKET_DATAGRAM, &local, &remote) != ZX_OK) {
         return invalid;
@@ -40,6 +53,59 @@ zx::socket connect_to_logger() {
     return local;
 }
 
+constexpr size_t kRingMappingSize = fbl::round_up(sizeof(fx_log_ring_t),
+                                                  static_cast<size_t>(PAGE_SIZE));
+
+// Creates a log ring, and maps it at |*out_ring|.
+zx_status_t create_log_ring(zx::vmo* out_vmo, fx_log_ring_t** out_ring) {
+    zx::vmo vmo;
+    zx_status_t status = zx::vmo::create(sizeof(fx_log_ring_t), ZX_VMO_NON_RESIZABLE, &vmo);
+    if (status != ZX_OK) {
+        return status;
+    }
+    uintptr_t addr;
+    status = zx::vmar::root_self()->map(0, vmo, 0, kRingMappingSize,
+                                        ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, &addr);
+    if (status != ZX_OK) {
+        return status;
+    }
+    auto ring = reinterpret_cast<fx_log_ring_t*>(addr);
+    ring->waiting = 1;
+    for (uint64_t i = 0; i < FX_LOG_RING_SLOTS; i++) {
+        ring->slots[i].sequence = i;
+    }
+    *out_vmo = std::move(vmo);
+    *out_ring = ring;
+    return ZX_OK;
+}
+
+// Connects to the log service through |logger|, sharing a log ring with it.
+zx::socket connect_to_logger_with_ring(zx::channel logger, fx_log_ring_t** out_ring) {
+    zx::socket invalid;
+    zx::vmo vmo;
+    fx_log_ring_t* ring;
+    if (create_log_ring(&vmo, &ring) != ZX_OK) {
+        return invalid;
+    }
+    zx::socket local, remote;
+    if (zx::socket::create(ZX_SOCKET_DATAGRAM, &local, &remote) != ZX_OK) {
+        zx::vmar::root_self()->unmap(reinterpret_cast<uintptr_t>(ring), kRingMappingSize);
+        return invalid;
+    }
+    fuchsia_logger_LogSinkConnectWithRingRequest req;
+    memset(&req, 0, sizeof(req));
+    req.hdr.ordinal = fuchsia_logger_LogSinkConnectWithRingOrdinal;
+    req.socket = FIDL_HANDLE_PRESENT;
+    req.ring = FIDL_HANDLE_PRESENT;
+    zx_handle_t handles[2] = {remote.release(), vmo.release()};
+    if (logger.write(0, &req, sizeof(req), handles, 2) != ZX_OK) {
+        zx::vmar::root_self()->unmap(reinterpret_cast<uintptr_t>(ring), kRingMappingSize);
+        return invalid;
+    }
+    *out_ring = ring;
+    return local;
+}
+
 } // namespace
 zx_status_t fx_logger_logf(fx_logger_t* logger, fx_log_severity_t severity,
                            const char* tag, const char* format, ...) {
@@ -112,3 +178,34 @@ zx_status_t fx_logger_create(const fx_logger_config_t* config,
 void fx_logger_destroy(fx_logger_t* logger) {
     delete logger;
 }
+
+zx_status_t fx_logger_create_with_ring(const fx_logger_config_t* config,
+                                       zx_handle_t log_sink,
+                                       fx_logger_t** out_logger) {
+    zx::channel logger(log_sink);
+    if (config->num_tags > FX_LOG_MAX_TAGS || config->console_fd != -1 ||
+        config->log_service_channel != ZX_HANDLE_INVALID) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (!logger.is_valid()) {
+        logger = connect_to_log_sink();
+    }
+    fx_log_ring_t* ring = nullptr;
+    zx::socket sock;
+    if (logger.is_valid()) {
+        sock = connect_to_logger_with_ring(std::move(logger), &ring);
+    }
+    fx_logger_config_t c = *config;
+    if (sock.is_valid()) {
+        c.log_service_channel = sock.release();
+    } else {
+        int newfd = dup(STDERR_FILENO);
+        if (newfd < 0) {
+            return ZX_ERR_INTERNAL;
+        }
+        c.console_fd = newfd;
+    }
+    *out_logger = new fx_logger(&c);
+    (*out_logger)->SetRing(ring);
+    return ZX_OK;
+}
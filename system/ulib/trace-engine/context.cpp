@@ -70,12 +70,31 @@
 // Note that the handler is free to save buffers at whatever rate it can
 // manage. The protocol allows for records to be dropped if buffers can't be
 // saved fast enough.
+//
+// Thread buffers
+// --------------
+//
+// When the rolling buffers are large, each thread writes its non-durable
+// records into a small buffer of its own, and copies them into the rolling
+// buffer with a single allocation when that fills. Every thread would
+// otherwise bump the same atomic offset for every record it writes.
+// Whenever the engine is asked to save a rolling buffer, it also copies out
+// the records each thread has completed so far, so that an idle thread's
+// records are saved along with the next buffer. The records still left in
+// thread buffers are copied out when tracing stops, once all references to
+// the context have been released. Records therefore reach
+// the rolling buffer in per-thread batches: they remain in order for each
+// thread, but records of different threads are interleaved less finely.
+// Durable records in oneshot mode skip the thread buffer (after flushing
+// it) so that they precede any record which refers to them.
 
 #include "context_impl.h"
 
 #include <assert.h>
 #include <inttypes.h>
+#include <string.h>
 
+#include <fbl/alloc_checker.h>
 #include <fbl/auto_lock.h>
 #include <trace-engine/fields.h>
 #include <trace-engine/handler.h>
@@ -91,6 +110,9 @@ std::atomic<uint32_t> g_next_generation{1u};
 } // namespace
 } // namespace trace
 
+thread_local trace_context::ThreadBuffer* trace_context::tls_thread_buffer_;
+thread_local uint32_t trace_context::tls_thread_buffer_generation_;
+
 trace_context::trace_context(void* buffer, size_t buffer_num_bytes,
                              trace_buffering_mode_t buffering_mode,
                              trace_handler_t* handler)
@@ -104,11 +126,121 @@ trace_context::trace_context(void* buffer, size_t buffer_num_bytes,
     ZX_DEBUG_ASSERT(buffer_num_bytes <= kMaxPhysicalBufferSize);
     ZX_DEBUG_ASSERT(generation_ != 0u);
     ComputeBufferSizes();
+    use_thread_buffers_ = rolling_buffer_size_ >= kMinThreadBufferedRollingBufferSize;
 }
 
-trace_context::~trace_context() = default;
+trace_context::~trace_context() {
+    fbl::AutoLock lock(&thread_buffers_mutex_);
+    while (thread_buffers_) {
+        ThreadBuffer* next = thread_buffers_->next;
+        delete thread_buffers_;
+        thread_buffers_ = next;
+    }
+}
 
 uint64_t* trace_context::AllocRecord(size_t num_bytes) {
+    ZX_DEBUG_ASSERT((num_bytes & 7) == 0);
+    if (use_thread_buffers_ && num_bytes <= kThreadBufferSize) {
+        ThreadBuffer* thread_buffer = GetThreadBuffer();
+        if (likely(thread_buffer)) {
+            // The thread has finished writing its previous record.
+            thread_buffer->committed.store(
+                PackThreadBufferCount(thread_buffer->num_bytes, thread_buffer->num_records),
+                std::memory_order_release);
+            if (unlikely(thread_buffer->num_bytes + num_bytes > kThreadBufferSize))
+                FlushThreadBuffer(thread_buffer);
+            uint64_t* ptr = thread_buffer->data + thread_buffer->num_bytes / sizeof(uint64_t);
+            thread_buffer->num_bytes += num_bytes;
+            thread_buffer->num_records++;
+            return ptr;
+        }
+    }
+    return AllocUnbufferedRecord(num_bytes);
+}
+
+uint64_t* trace_context::AllocUnbufferedRecord(size_t num_bytes) {
+    // Keep the records of this thread in the order they were written.
+    if (use_thread_buffers_ && tls_thread_buffer_generation_ == generation_)
+        FlushThreadBuffer(tls_thread_buffer_);
+    return AllocRollingRecord(num_bytes);
+}
+
+trace_context::ThreadBuffer* trace_context::GetThreadBuffer() {
+    if (likely(tls_thread_buffer_generation_ == generation_))
+        return tls_thread_buffer_;
+
+    fbl::AllocChecker ac;
+    auto thread_buffer = new (&ac) ThreadBuffer;
+    if (!ac.check())
+        return nullptr;
+    {
+        fbl::AutoLock lock(&thread_buffers_mutex_);
+        if (thread_buffers_tail_) {
+            thread_buffers_tail_->next = thread_buffer;
+        } else {
+            thread_buffers_ = thread_buffer;
+        }
+        thread_buffers_tail_ = thread_buffer;
+    }
+    tls_thread_buffer_ = thread_buffer;
+    tls_thread_buffer_generation_ = generation_;
+    return thread_buffer;
+}
+
+void trace_context::FlushThreadBuffer(ThreadBuffer* thread_buffer) {
+    if (thread_buffer->num_bytes == 0u)
+        return;
+
+    fbl::AutoLock lock(&thread_buffer->mutex);
+    CopyThreadRecordsLocked(thread_buffer, thread_buffer->num_bytes,
+                            thread_buffer->num_records);
+    thread_buffer->num_bytes = 0u;
+    thread_buffer->num_records = 0u;
+    thread_buffer->committed.store(0u, std::memory_order_relaxed);
+    thread_buffer->flushed_bytes = 0u;
+    thread_buffer->flushed_records = 0u;
+}
+
+void trace_context::CopyThreadRecordsLocked(ThreadBuffer* thread_buffer,
+                                            size_t num_bytes, size_t num_records) {
+    if (num_bytes <= thread_buffer->flushed_bytes)
+        return;
+
+    size_t copy_bytes = num_bytes - thread_buffer->flushed_bytes;
+    size_t copy_records = num_records - thread_buffer->flushed_records;
+    uint64_t* ptr = AllocRollingRecord(copy_bytes);
+    if (likely(ptr)) {
+        memcpy(ptr, thread_buffer->data + thread_buffer->flushed_bytes / sizeof(uint64_t),
+               copy_bytes);
+    } else {
+        // AllocRollingRecord() has accounted for one of the dropped records.
+        num_records_dropped_.fetch_add(copy_records - 1u, std::memory_order_relaxed);
+    }
+    thread_buffer->flushed_bytes = num_bytes;
+    thread_buffer->flushed_records = num_records;
+}
+
+void trace_context::FlushThreadBuffers() {
+    fbl::AutoLock lock(&thread_buffers_mutex_);
+    for (ThreadBuffer* thread_buffer = thread_buffers_; thread_buffer;
+         thread_buffer = thread_buffer->next) {
+        fbl::AutoLock buffer_lock(&thread_buffer->mutex);
+        uint64_t committed = thread_buffer->committed.load(std::memory_order_acquire);
+        CopyThreadRecordsLocked(thread_buffer, committed & 0xffffffffu, committed >> 32);
+    }
+}
+
+void trace_context::FlushThreadBuffersAfterStopped() {
+    fbl::AutoLock lock(&thread_buffers_mutex_);
+    for (ThreadBuffer* thread_buffer = thread_buffers_; thread_buffer;
+         thread_buffer = thread_buffer->next) {
+        fbl::AutoLock buffer_lock(&thread_buffer->mutex);
+        CopyThreadRecordsLocked(thread_buffer, thread_buffer->num_bytes,
+                                thread_buffer->num_records);
+    }
+}
+
+uint64_t* trace_context::AllocRollingRecord(size_t num_bytes) {
     ZX_DEBUG_ASSERT((num_bytes & 7) == 0);
     if (unlikely(num_bytes > TRACE_ENCODED_RECORD_MAX_LENGTH))
         return nullptr;
@@ -567,6 +699,12 @@ void trace_context::HandleSaveRollingBufferRequest(uint32_t wrapped_count,
     // provide callers with a way to wait, and have trace_release_context()
     // check for waiters and if any are present send a signal like it does
     // for SIGNAL_CONTEXT_RELEASED.
+
+    // Records which threads have completed since the last save would
+    // otherwise stay in their buffers until those fill, or tracing stops.
+    // They go into the buffer now being written, and are saved with it.
+    if (use_thread_buffers_)
+        FlushThreadBuffers();
     handler_->ops->notify_buffer_full(handler_, wrapped_count,
                                       durable_data_end);
 }
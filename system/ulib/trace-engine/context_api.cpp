@@ -284,6 +284,8 @@ public:
     explicit Payload(trace_context_t* context, bool rqst_durable, size_t num_bytes)
         : ptr_(rqst_durable && context->UsingDurableBuffer()
                ? context->AllocDurableRecord(num_bytes)
+               : rqst_durable
+               ? context->AllocUnbufferedRecord(num_bytes)
                : context->AllocRecord(num_bytes)) {}
 
     explicit operator bool() const {
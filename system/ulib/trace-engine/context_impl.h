@@ -91,6 +91,7 @@ struct trace_context {
     void UpdateBufferHeaderAfterStopped();
 
     uint64_t* AllocRecord(size_t num_bytes);
+    uint64_t* AllocUnbufferedRecord(size_t num_bytes);
     uint64_t* AllocDurableRecord(size_t num_bytes);
     bool AllocThreadIndex(trace_thread_index_t* out_index);
     bool AllocStringIndex(trace_string_index_t* out_index);
@@ -105,7 +106,66 @@ struct trace_context {
     void HandleSaveRollingBufferRequest(uint32_t wrapped_count,
                                         uint64_t durable_data_end);
 
+    // Copies the complete records held in every thread buffer into the
+    // rolling buffer. This is called from the engine whenever it saves a
+    // rolling buffer, so that records aren't held back until tracing stops.
+    // A thread's latest record only counts as complete once that thread
+    // allocates another.
+    void FlushThreadBuffers();
+
+    // Copies all records held in every thread buffer into the rolling
+    // buffer. This is only called from the engine once all references to
+    // the context have been released, so no thread is writing to them.
+    void FlushThreadBuffersAfterStopped();
+
 private:
+    // The space for records in each thread's buffer.
+    // This must be no more than |TRACE_ENCODED_RECORD_MAX_LENGTH| so that
+    // its contents can be copied with a single allocation.
+    static constexpr size_t kThreadBufferSize = 4096;
+
+    // Thread buffers are only used when each rolling buffer is at least this
+    // big. When a thread buffer is copied, up to |kThreadBufferSize| bytes
+    // at the end of a rolling buffer may be left unused, and records only
+    // reach the rolling buffer in batches, which would make small buffers
+    // fill and wrap unpredictably.
+    static constexpr size_t kMinThreadBufferedRollingBufferSize =
+        64 * kThreadBufferSize;
+
+    // Records written by a thread are collected in a buffer private to that
+    // thread, and copied into the rolling buffer with one allocation when it
+    // fills. This keeps threads from contending on |rolling_buffer_current_|
+    // for every record.
+    //
+    // Only the owning thread writes records, but any thread may copy out
+    // those which the owner has completed, under |mutex|.
+    struct ThreadBuffer {
+        // The next buffer in |thread_buffers_|.
+        ThreadBuffer* next = nullptr;
+        // The number of bytes, and records, written to |data| by the owning
+        // thread. Only accessed by that thread.
+        size_t num_bytes = 0u;
+        size_t num_records = 0u;
+        // The number of bytes and records at the start of |data| which hold
+        // complete records, as packed by |PackThreadBufferCount()|. Stored by
+        // the owning thread when it starts its next record.
+        std::atomic<uint64_t> committed{0u};
+        // Guards copying records out of |data|, and resetting it.
+        fbl::Mutex mutex;
+        // The number of bytes, and records, at the start of |data| which
+        // another thread has already copied out.
+        size_t flushed_bytes __TA_GUARDED(mutex) = 0u;
+        size_t flushed_records __TA_GUARDED(mutex) = 0u;
+        uint64_t data[kThreadBufferSize / sizeof(uint64_t)];
+    };
+
+    static uint64_t PackThreadBufferCount(size_t num_bytes, size_t num_records) {
+        return (static_cast<uint64_t>(num_records) << 32) | num_bytes;
+    }
+
+    static_assert(kThreadBufferSize <= TRACE_ENCODED_RECORD_MAX_LENGTH, "");
+
+
     // The maximum rolling buffer size in bits.
     static constexpr size_t kRollingBufferSizeBits = 32;
 
@@ -253,6 +313,27 @@ private:
         num_records_dropped_.fetch_add(1, std::memory_order_relaxed);
     }
 
+    uint64_t* AllocRollingRecord(size_t num_bytes);
+
+    // Returns the calling thread's buffer, or nullptr if it doesn't have
+    // one and one can't be allocated.
+    ThreadBuffer* GetThreadBuffer();
+
+    // Called by the owning thread of |thread_buffer| only, in between
+    // records: copies out all of its records and empties it.
+    void FlushThreadBuffer(ThreadBuffer* thread_buffer);
+
+    // Copies the records in [flushed, |num_bytes|) of |thread_buffer| into
+    // the rolling buffer.
+    void CopyThreadRecordsLocked(ThreadBuffer* thread_buffer,
+                                 size_t num_bytes, size_t num_records)
+        __TA_REQUIRES(thread_buffer->mutex);
+
+    // The calling thread's buffer, and the generation of the context it
+    // belongs to. A buffer left over from a previous context is ignored.
+    static thread_local ThreadBuffer* tls_thread_buffer_;
+    static thread_local uint32_t tls_thread_buffer_generation_;
+
     void NotifyRollingBufferFullLocked(uint32_t wrapped_count,
                                        uint64_t durable_data_end)
         __TA_REQUIRES(buffer_switch_mutex_);
@@ -345,4 +426,17 @@ private:
     // The next string table index to be assigned.
     std::atomic<trace_string_index_t> next_string_index_{
         TRACE_ENCODED_STRING_REF_MIN_INDEX};
+
+    // True if records are collected in per-thread buffers.
+    // See |kMinThreadBufferedRollingBufferSize|.
+    bool use_thread_buffers_ = false;
+
+    // Guards the list of thread buffers. Only taken when a thread writes its
+    // first record, and when the buffers are flushed.
+    fbl::Mutex thread_buffers_mutex_;
+
+    // The buffers of all threads which have written records, in the order
+    // they were allocated, and the last of them.
+    ThreadBuffer* thread_buffers_ __TA_GUARDED(thread_buffers_mutex_) = nullptr;
+    ThreadBuffer* thread_buffers_tail_ __TA_GUARDED(thread_buffers_mutex_) = nullptr;
 };
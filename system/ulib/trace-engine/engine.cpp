@@ -530,6 +530,7 @@ void handle_context_released(async_dispatcher_t* dispatcher) {
         ZX_DEBUG_ASSERT(g_context != nullptr);
 
         // Update final buffer state.
+        g_context->FlushThreadBuffersAfterStopped();
         g_context->UpdateBufferHeaderAfterStopped();
 
         // Get final disposition.
@@ -9,7 +9,7 @@
 #include <lib/async/cpp/wait.h>
 #include <lib/zx/fifo.h>
 #include <lib/zx/vmo.h>
-#include <fbl/intrusive_hash_table.h>
+#include <fbl/intrusive_resizable_hash_table.h>
 #include <fbl/macros.h>
 #include <fbl/string.h>
 #include <fbl/unique_ptr.h>
@@ -85,11 +85,10 @@ private:
         }
     };
 
-    using StringSet = fbl::HashTable<const char*,
+    using StringSet = fbl::ResizableHashTable<const char*,
         fbl::unique_ptr<StringSetEntry>,
         fbl::SinglyLinkedList<fbl::unique_ptr<StringSetEntry>>, // default
         size_t, // default
-        37, // default
         CategoryStringKeyTraits>;
     StringSet enabled_category_set_;
 
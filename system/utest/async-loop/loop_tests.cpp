@@ -3,6 +3,9 @@
 // found in the LICENSE file.
 
 #include <atomic>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <threads.h>
 #include <utility>
 
@@ -18,9 +21,11 @@
 #include <lib/async/time.h>
 #include <lib/async/wait.h>
 
+#include <fbl/alloc_checker.h>
 #include <fbl/auto_lock.h>
 #include <fbl/function.h>
 #include <fbl/mutex.h>
+#include <fbl/unique_ptr.h>
 #include <lib/zx/event.h>
 #include <unittest/unittest.h>
 #include <zircon/status.h>
@@ -822,6 +827,72 @@ bool task_shutdown_test() {
     END_TEST;
 }
 
+// Records the deadlines of the tasks it runs, in order.
+class OrderedTask : public async_task_t {
+public:
+    OrderedTask()
+        : async_task_t{{ASYNC_STATE_INIT}, &OrderedTask::CallHandler, ZX_TIME_INFINITE} {}
+
+    static zx_time_t last_deadline;
+    static uint32_t run_count;
+    static bool ordered;
+
+private:
+    static void CallHandler(async_dispatcher_t* dispatcher, async_task_t* task, zx_status_t status) {
+        ordered = ordered && status == ZX_OK && task->deadline >= last_deadline;
+        last_deadline = task->deadline;
+        run_count++;
+    }
+};
+
+zx_time_t OrderedTask::last_deadline;
+uint32_t OrderedTask::run_count;
+bool OrderedTask::ordered;
+
+bool task_performance_test() {
+    BEGIN_TEST;
+
+    constexpr uint32_t kTaskCount = 1000000u;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<OrderedTask[]> tasks(new (&ac) OrderedTask[kTaskCount]);
+    ASSERT_TRUE(ac.check());
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    OrderedTask::last_deadline = 0;
+    OrderedTask::run_count = 0u;
+    OrderedTask::ordered = true;
+
+    // Post tasks which are all due, in random order, then cancel a quarter of them.
+    zx::time start_time = async::Now(loop.dispatcher()) - zx::sec(1);
+    unsigned int seed = 1u;
+    zx_time_t post_time = zx_clock_get_monotonic();
+    for (uint32_t i = 0; i < kTaskCount; i++) {
+        tasks[i].deadline = (start_time + zx::usec(rand_r(&seed) % 1000000)).get();
+        ASSERT_EQ(ZX_OK, async_post_task(loop.dispatcher(), &tasks[i]));
+    }
+    post_time = zx_clock_get_monotonic() - post_time;
+
+    zx_time_t cancel_time = zx_clock_get_monotonic();
+    for (uint32_t i = 0; i < kTaskCount; i += 4u) {
+        ASSERT_EQ(ZX_OK, async_cancel_task(loop.dispatcher(), &tasks[i]));
+    }
+    cancel_time = zx_clock_get_monotonic() - cancel_time;
+
+    zx_time_t run_time = zx_clock_get_monotonic();
+    EXPECT_EQ(ZX_OK, loop.RunUntilIdle());
+    run_time = zx_clock_get_monotonic() - run_time;
+
+    EXPECT_EQ(kTaskCount - kTaskCount / 4u, OrderedTask::run_count);
+    EXPECT_TRUE(OrderedTask::ordered, "tasks dispatched in deadline order");
+
+    printf("\ntook %" PRIu64 " nsec to post %u tasks\n", post_time, kTaskCount);
+    printf("took %" PRIu64 " nsec to cancel %u tasks\n", cancel_time, kTaskCount / 4u);
+    printf("took %" PRIu64 " nsec to dispatch %u tasks\n", run_time,
+           kTaskCount - kTaskCount / 4u);
+
+    END_TEST;
+}
+
 bool receiver_test() {
     const zx_packet_user_t data1{.u64 = {11, 12, 13, 14}};
     const zx_packet_user_t data2{.u64 = {21, 22, 23, 24}};
@@ -1381,6 +1452,7 @@ RUN_TEST(wait_unwaitable_handle_test)
 RUN_TEST(wait_shutdown_test)
 RUN_TEST(task_test)
 RUN_TEST(task_shutdown_test)
+RUN_TEST_PERFORMANCE(task_performance_test)
 RUN_TEST(receiver_test)
 RUN_TEST(receiver_shutdown_test)
 RUN_TEST(exception_test)
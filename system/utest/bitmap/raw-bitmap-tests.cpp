@@ -5,9 +5,12 @@
 #include <bitmap/raw-bitmap.h>
 #include <bitmap/storage.h>
 
+#include <stdio.h>
+
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <unittest/unittest.h>
+#include <zircon/syscalls.h>
 
 namespace bitmap {
 namespace tests {
@@ -550,6 +553,132 @@ template <typename RawBitmap> static bool GrowFailure(void) {
     END_TEST;
 }
 
+// A small deterministic generator for the randomized tests.
+static uint64_t NextRandom(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+template <typename RawBitmap> static bool SummaryMatchesScan(void) {
+    BEGIN_TEST;
+
+    // Span several summary groups, and end part way through a word.
+    constexpr size_t kSize = 6 * 4096 + 77;
+    RawBitmap plain;
+    RawBitmap summarized;
+    ASSERT_EQ(plain.Reset(kSize), ZX_OK);
+    ASSERT_EQ(summarized.Reset(kSize), ZX_OK);
+    summarized.EnableSummary();
+    // The summary is not used until it is built from the bitmap.
+    ASSERT_FALSE(summarized.HasSummary());
+    summarized.RebuildSummary();
+    ASSERT_TRUE(summarized.HasSummary());
+
+    uint64_t state = 0x2545F4914F6CDD1D;
+    for (size_t op = 0; op < 2000; op++) {
+        size_t bitoff = NextRandom(&state) % kSize;
+        size_t len = NextRandom(&state) % ((op % 8 == 0) ? 5000 : 100);
+        size_t bitmax = fbl::min(bitoff + len, kSize);
+        if (NextRandom(&state) % 5 < 3) {
+            ASSERT_EQ(plain.Set(bitoff, bitmax), ZX_OK);
+            ASSERT_EQ(summarized.Set(bitoff, bitmax), ZX_OK);
+        } else {
+            ASSERT_EQ(plain.Clear(bitoff, bitmax), ZX_OK);
+            ASSERT_EQ(summarized.Clear(bitoff, bitmax), ZX_OK);
+        }
+        ASSERT_TRUE(summarized.HasSummary());
+
+        for (size_t query = 0; query < 4; query++) {
+            bitoff = NextRandom(&state) % kSize;
+            bitmax = bitoff + 1 + NextRandom(&state) % (kSize - bitoff);
+            size_t run_len = 1 + NextRandom(&state) % ((query % 2) ? 64 : 2000);
+
+            size_t expected = kSize;
+            size_t actual = kSize;
+            ASSERT_EQ(plain.Find(false, bitoff, bitmax, run_len, &expected),
+                      summarized.Find(false, bitoff, bitmax, run_len, &actual));
+            ASSERT_EQ(expected, actual);
+
+            expected = kSize;
+            actual = kSize;
+            ASSERT_EQ(plain.Scan(bitoff, bitmax, true, &expected),
+                      summarized.Scan(bitoff, bitmax, true, &actual));
+            ASSERT_EQ(expected, actual);
+        }
+    }
+
+    // The summary is rebuilt after the bitmap is resized.
+    ASSERT_EQ(plain.Shrink(kSize - 4096), ZX_OK);
+    ASSERT_EQ(summarized.Shrink(kSize - 4096), ZX_OK);
+    for (size_t run_len = 1; run_len <= 4096; run_len *= 4) {
+        size_t expected = kSize;
+        size_t actual = kSize;
+        ASSERT_EQ(plain.Find(false, 0, kSize - 4096, run_len, &expected),
+                  summarized.Find(false, 0, kSize - 4096, run_len, &actual));
+        ASSERT_EQ(expected, actual);
+    }
+    size_t bitoff_start;
+    ASSERT_EQ(summarized.Reset(kSize), ZX_OK);
+    EXPECT_EQ(summarized.Find(false, 0, kSize, kSize, &bitoff_start), ZX_OK);
+    EXPECT_EQ(bitoff_start, 0);
+
+    END_TEST;
+}
+
+// Measures finding free runs in a large, nearly full and fragmented bitmap,
+// as the filesystem allocators do.
+template <typename RawBitmap> static bool FindPerformance(void) {
+    BEGIN_TEST;
+
+    constexpr size_t kSize = 1 << 22;
+    constexpr size_t kIterations = 100;
+    RawBitmap plain;
+    RawBitmap summarized;
+    ASSERT_EQ(plain.Reset(kSize), ZX_OK);
+    ASSERT_EQ(summarized.Reset(kSize), ZX_OK);
+    summarized.EnableSummary();
+
+    // Fill the bitmap, then free short runs in its last tenth, with one
+    // longer run at the very end.
+    uint64_t state = 0x2545F4914F6CDD1D;
+    RawBitmap* bitmaps[] = {&plain, &summarized};
+    for (RawBitmap* bitmap : bitmaps) {
+        ASSERT_EQ(bitmap->Set(0, kSize), ZX_OK);
+    }
+    for (size_t bit = kSize - kSize / 10; bit < kSize - 256; bit += 64) {
+        size_t start = bit + NextRandom(&state) % 56;
+        size_t len = 1 + NextRandom(&state) % 8;
+        for (RawBitmap* bitmap : bitmaps) {
+            ASSERT_EQ(bitmap->Clear(start, start + len), ZX_OK);
+        }
+    }
+    for (RawBitmap* bitmap : bitmaps) {
+        ASSERT_EQ(bitmap->Clear(kSize - 256, kSize), ZX_OK);
+    }
+    ASSERT_TRUE(summarized.HasSummary());
+
+    printf("\n");
+    const size_t run_lens[] = {1, 16, 256};
+    for (size_t run_len : run_lens) {
+        zx_duration_t durations[2];
+        for (size_t i = 0; i < fbl::count_of(bitmaps); i++) {
+            zx_time_t start = zx_clock_get_monotonic();
+            for (size_t iter = 0; iter < kIterations; iter++) {
+                size_t bitoff_start;
+                ASSERT_EQ(bitmaps[i]->Find(false, 0, kSize, run_len, &bitoff_start), ZX_OK);
+            }
+            durations[i] = zx_clock_get_monotonic() - start;
+        }
+        printf("find %3zu free bits in %zu: scan %8.1f us, summary %8.1f us\n", run_len,
+               kSize, static_cast<double>(durations[0]) / kIterations / 1000,
+               static_cast<double>(durations[1]) / kIterations / 1000);
+    }
+
+    END_TEST;
+}
+
 #define RUN_TEMPLATIZED_TEST(test, specialization) RUN_TEST(test<specialization>)
 #define ALL_TESTS(specialization)                                                                  \
     RUN_TEMPLATIZED_TEST(InitializedEmpty, specialization)                                         \
@@ -562,7 +691,8 @@ template <typename RawBitmap> static bool GrowFailure(void) {
     RUN_TEMPLATIZED_TEST(ClearSubrange, specialization)                                            \
     RUN_TEMPLATIZED_TEST(BoundaryArguments, specialization)                                        \
     RUN_TEMPLATIZED_TEST(ClearAll, specialization)                                                 \
-    RUN_TEMPLATIZED_TEST(SetOutOfOrder, specialization)
+    RUN_TEMPLATIZED_TEST(SetOutOfOrder, specialization)                                            \
+    RUN_TEMPLATIZED_TEST(SummaryMatchesScan, specialization)
 
 BEGIN_TEST_CASE(raw_bitmap_tests)
 ALL_TESTS(RawBitmapGeneric<DefaultStorage>)
@@ -572,6 +702,7 @@ RUN_TEST(MoveAssignmentTest<RawBitmapGeneric<VmoStorage>>)
 RUN_TEST(GrowAcrossPage<RawBitmapGeneric<VmoStorage>>)
 RUN_TEST(GrowShrink<RawBitmapGeneric<VmoStorage>>)
 RUN_TEST(GrowFailure<RawBitmapGeneric<DefaultStorage>>)
+RUN_TEST_PERFORMANCE(FindPerformance<RawBitmapGeneric<VmoStorage>>)
 END_TEST_CASE(raw_bitmap_tests);
 
 } // namespace tests
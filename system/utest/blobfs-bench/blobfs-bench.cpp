@@ -179,21 +179,9 @@ public:
     bool ApiTest(perftest::RepeatState* state, Fixture* fixture) {
         BEGIN_HELPER;
 
-        // How many blobs do we need to add.
-        fbl::unique_ptr<BlobInfo> new_blob;
-
-        for (int64_t curr = 0; curr < info_.blob_count; ++curr) {
-            MakeBlob(fixture->fs_path(), info_.blob_size, fixture->mutable_seed(), &new_blob);
-            fbl::unique_fd fd(open(new_blob->path.c_str(), O_CREAT | O_RDWR));
-            ASSERT_TRUE(fd, strerror(errno));
-            ASSERT_EQ(ftruncate(fd.get(), info_.blob_size), 0, strerror(errno));
-            ASSERT_EQ(StreamAll(write, fd.get(), new_blob->data.get(), new_blob->size_data), 0,
-                      strerror(errno));
-            info_.paths.push_back(new_blob->path);
-            info_.path_index.push_back(curr);
-            new_blob.reset();
-        }
+        ASSERT_TRUE(AddBlobs(fixture));
 
+        fbl::unique_ptr<BlobInfo> new_blob;
         fbl::AllocChecker ac;
         fbl::unique_ptr<char[]> buffer(new (&ac) char[info_.blob_size]);
         ASSERT_TRUE(ac.check());
@@ -279,7 +267,52 @@ public:
         END_HELPER;
     }
 
+    // Measure how long it takes to remount a filesystem holding |info_.blob_count| blobs.
+    // Mount time should not grow with the number of blobs that are never opened.
+    bool MountTest(perftest::RepeatState* state, Fixture* fixture) {
+        BEGIN_HELPER;
+        ASSERT_TRUE(AddBlobs(fixture));
+
+        state->DeclareStep("unmount");
+        state->DeclareStep("mount");
+        state->DeclareStep("lookup");
+
+        uint64_t current = 0;
+        while (state->KeepRunning()) {
+            ASSERT_EQ(fixture->Umount(), ZX_OK);
+            state->NextStep();
+
+            ASSERT_EQ(fixture->Mount(), ZX_OK);
+            state->NextStep();
+
+            // The first open of a blob after mount is the one which must instantiate it.
+            fbl::unique_fd fd(open(info_.paths[current % info_.paths.size()].c_str(), O_RDONLY));
+            ASSERT_TRUE(fd);
+            ++current;
+        }
+        END_HELPER;
+    }
+
 private:
+    // Fills the filesystem with |info_.blob_count| blobs, recording their paths.
+    bool AddBlobs(Fixture* fixture) {
+        BEGIN_HELPER;
+        fbl::unique_ptr<BlobInfo> new_blob;
+
+        for (int64_t curr = 0; curr < info_.blob_count; ++curr) {
+            MakeBlob(fixture->fs_path(), info_.blob_size, fixture->mutable_seed(), &new_blob);
+            fbl::unique_fd fd(open(new_blob->path.c_str(), O_CREAT | O_RDWR));
+            ASSERT_TRUE(fd, strerror(errno));
+            ASSERT_EQ(ftruncate(fd.get(), info_.blob_size), 0, strerror(errno));
+            ASSERT_EQ(StreamAll(write, fd.get(), new_blob->data.get(), new_blob->size_data), 0,
+                      strerror(errno));
+            info_.paths.push_back(new_blob->path);
+            info_.path_index.push_back(curr);
+            new_blob.reset();
+        }
+        END_HELPER;
+    }
+
     void SortPathsByOrder(ReadOrder order, unsigned int* seed) {
         switch (order) {
         case ReadOrder::kSequentialForward:
@@ -315,6 +348,8 @@ bool RunBenchmark(int argc, char** argv) {
     PerformanceTestOptions p_opts;
     // 30 Samples for each operation at each stage.
     constexpr uint32_t kSampleCount = 100;
+    // Each mount sample requires a full unmount and remount.
+    constexpr uint32_t kMountSampleCount = 10;
     const size_t blob_sizes[] = {
         128,         // 128 b
         128 * 1024,  // 128 Kb
@@ -386,6 +421,38 @@ bool RunBenchmark(int argc, char** argv) {
         }
     }
 
+    // Mounting is measured separately, with small blobs, so that very large blob counts remain
+    // practical to generate.
+    constexpr size_t kMountBlobSize = 128;
+    const size_t mount_blob_counts[] = {
+        1000,
+        10000,
+        100000,
+    };
+    for (auto blob_count : mount_blob_counts) {
+        BlobfsInfo fs_info;
+        fs_info.blob_count = (p_opts.is_unittest) ? 1 : blob_count;
+        fs_info.blob_size = kMountBlobSize;
+        blobfs_tests.push_back(std::move(fs_info));
+        TestCaseInfo testcase;
+        testcase.teardown = false;
+        testcase.sample_count = kMountSampleCount;
+
+        TestInfo mount_test;
+        mount_test.name =
+            fbl::StringPrintf("%s/%s/%luBlobs/Mount", disk_format_string_[f_opts.fs_type],
+                              GetNameForSize(kMountBlobSize).c_str(), blob_count);
+        mount_test.required_disk_space =
+            blob_count * (kMountBlobSize + 2 * MerkleTree::kNodeSize + blobfs::kBlobfsInodeSize);
+        mount_test.test_fn = [test_index, &blobfs_tests](perftest::RepeatState* state,
+                                                         fs_test_utils::Fixture* fixture) {
+            return blobfs_tests[test_index].MountTest(state, fixture);
+        };
+        testcase.tests.push_back(std::move(mount_test));
+        testcases.push_back(std::move(testcase));
+        ++test_index;
+    }
+
     return fs_test_utils::RunTestCases(f_opts, p_opts, testcases);
 }
 
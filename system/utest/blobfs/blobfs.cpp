@@ -14,7 +14,9 @@
 #include <utility>
 #include <utime.h>
 
+#include <blobfs/blobfs.h>
 #include <blobfs/format.h>
+#include <blobfs/fsck.h>
 #include <blobfs/journal.h>
 #include <blobfs/lz4.h>
 #include <digest/digest.h>
@@ -2400,6 +2402,126 @@ static bool CorruptAtMount(BlobfsTest* blobfsTest) {
     END_HELPER;
 }
 
+typedef struct fsck_args {
+    int fd;
+    blobfs::FsckOptions options;
+    zx_status_t status;
+} fsck_args_t;
+
+int fsck_thread(void* arg) {
+    fsck_args_t* args = static_cast<fsck_args_t*>(arg);
+    fbl::unique_ptr<blobfs::Blobfs> fs;
+    args->status = blobfs::Initialize(fbl::unique_fd(dup(args->fd)), blobfs::MountOptions(),
+                                      &fs);
+    if (args->status == ZX_OK) {
+        args->status = blobfs::Fsck(std::move(fs), args->options);
+    }
+    return 0;
+}
+
+// Checks the unmounted blobfs on |fd| in-process, so that |options| may be chosen.
+// Threads keep the block transaction group assigned to them by the first Blobfs they use,
+// so each check runs on a thread of its own.
+static bool CheckBlobfs(int fd, const blobfs::FsckOptions& options, zx_status_t* out) {
+    BEGIN_HELPER;
+    fsck_args_t args = {fd, options, ZX_ERR_INTERNAL};
+    thrd_t thread;
+    ASSERT_EQ(thrd_create(&thread, fsck_thread, &args), thrd_success);
+    ASSERT_EQ(thrd_join(thread, nullptr), thrd_success);
+    *out = args.status;
+    END_HELPER;
+}
+
+// Fsck verifies the contents of every blob, several at a time, unless asked to check
+// only the metadata.
+static bool FsckVerifiesBlobs(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    constexpr size_t kBlobCount = 32;
+    fbl::unique_ptr<blob_info_t> infos[kBlobCount];
+    for (size_t i = 0; i < kBlobCount; i++) {
+        ASSERT_TRUE(GenerateRandomBlob(1 << (10 + i % 8), &infos[i]));
+        fbl::unique_fd fd;
+        ASSERT_TRUE(MakeBlob(infos[i].get(), &fd));
+    }
+    ASSERT_EQ(umount(MOUNT_PATH), ZX_OK);
+
+    fbl::unique_fd fd(blobfsTest->GetFd());
+    ASSERT_TRUE(fd, "Could not open ramdisk");
+    zx_status_t status;
+    ASSERT_TRUE(CheckBlobfs(fd.get(), blobfs::FsckOptions(), &status));
+    ASSERT_EQ(status, ZX_OK);
+
+    // Find the first block of the first and last blobs written, which holds either their
+    // data or their merkle tree.
+    uint64_t blocks[2];
+    size_t found = 0;
+    {
+        fbl::unique_ptr<blobfs::Blobfs> fs;
+        ASSERT_EQ(blobfs::Initialize(fbl::unique_fd(dup(fd.get())), blobfs::MountOptions(),
+                                     &fs), ZX_OK);
+        for (uint32_t n = 0; n < fs->Info().inode_count && found < 2; n++) {
+            const blobfs::Inode* inode = fs->GetNode(n);
+            if (!inode->header.IsAllocated() || inode->header.IsExtentContainer()) {
+                continue;
+            }
+            char name[Digest::kLength * 2 + 1];
+            Digest(inode->merkle_root_hash).ToString(name, sizeof(name));
+            for (const size_t i : {size_t{0}, kBlobCount - 1}) {
+                if (strcmp(name, infos[i]->path + strlen(MOUNT_PATH "/")) == 0) {
+                    blocks[found++] = fs->DataStart() + inode->extents[0].Start();
+                }
+            }
+        }
+    }
+    ASSERT_EQ(found, 2);
+
+    // Corrupt both blocks, and put them back however the test ends.
+    char saved[2][blobfs::kBlobfsBlockSize];
+    for (size_t i = 0; i < 2; i++) {
+        off_t offset = static_cast<off_t>(blocks[i] * blobfs::kBlobfsBlockSize);
+        ASSERT_EQ(pread(fd.get(), saved[i], sizeof(saved[i]), offset),
+                  static_cast<ssize_t>(sizeof(saved[i])));
+    }
+    auto restore = fbl::MakeAutoCall([&]() {
+        for (size_t i = 0; i < 2; i++) {
+            off_t offset = static_cast<off_t>(blocks[i] * blobfs::kBlobfsBlockSize);
+            pwrite(fd.get(), saved[i], sizeof(saved[i]), offset);
+        }
+    });
+    for (size_t i = 0; i < 2; i++) {
+        char corrupt[blobfs::kBlobfsBlockSize];
+        for (size_t j = 0; j < sizeof(corrupt); j++) {
+            corrupt[j] = static_cast<char>(~saved[i][j]);
+        }
+        off_t offset = static_cast<off_t>(blocks[i] * blobfs::kBlobfsBlockSize);
+        ASSERT_EQ(pwrite(fd.get(), corrupt, sizeof(corrupt), offset),
+                  static_cast<ssize_t>(sizeof(corrupt)));
+    }
+
+    // The metadata is still consistent.
+    blobfs::FsckOptions options;
+    options.verify_blobs = false;
+    ASSERT_TRUE(CheckBlobfs(fd.get(), options, &status));
+    ASSERT_EQ(status, ZX_OK);
+
+    // But the blobs are not.
+    ASSERT_TRUE(CheckBlobfs(fd.get(), blobfs::FsckOptions(), &status));
+    ASSERT_EQ(status, ZX_ERR_BAD_STATE);
+
+    restore.call();
+    ASSERT_TRUE(CheckBlobfs(fd.get(), blobfs::FsckOptions(), &status));
+    ASSERT_EQ(status, ZX_OK);
+
+    ASSERT_TRUE(blobfsTest->ForceRemount());
+    for (size_t i = 0; i < kBlobCount; i++) {
+        fd.reset(open(infos[i]->path, O_RDONLY));
+        ASSERT_TRUE(fd, "Failed to open blob");
+        ASSERT_TRUE(VerifyContents(fd.get(), infos[i]->data.get(), infos[i]->size_data));
+        ASSERT_EQ(unlink(infos[i]->path), 0);
+    }
+    END_HELPER;
+}
+
 typedef struct reopen_data {
     char path[PATH_MAX];
     std::atomic_bool complete;
@@ -2758,6 +2880,7 @@ RUN_TESTS(MEDIUM, QueryDevicePath)
 RUN_TESTS(MEDIUM, TestReadOnly)
 RUN_TEST_FVM(MEDIUM, ResizePartition)
 RUN_TEST_FVM(MEDIUM, CorruptAtMount)
+RUN_TESTS(MEDIUM, FsckVerifiesBlobs)
 RUN_TESTS(LARGE, CreateWriteReopen)
 RUN_TEST_MEDIUM(TestCreateFailure)
 RUN_TEST_MEDIUM(TestExtendFailure)
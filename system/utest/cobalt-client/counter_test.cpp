@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <threads.h>
 #include <unistd.h>
@@ -365,6 +366,85 @@ bool TestFlushMultithread() {
     END_TEST;
 }
 
+// Number of increments each thread performs when measuring the cost of an increment.
+constexpr uint64_t kPerformanceIncrements = 1 << 20;
+
+struct PerformanceArgs {
+    // Sharded counter to be incremented.
+    BaseCounter<uint64_t>* counter;
+
+    // Single atomic to be incremented, to compare against.
+    std::atomic<uint64_t>* atomic;
+
+    // Wait for main thread to signal before we start.
+    sync_completion_t* start;
+};
+
+int ShardedIncrementFn(void* args) {
+    PerformanceArgs* performance_args = static_cast<PerformanceArgs*>(args);
+    sync_completion_wait(performance_args->start, zx::sec(20).get());
+    for (uint64_t i = 0; i < kPerformanceIncrements; ++i) {
+        performance_args->counter->Increment();
+    }
+    return thrd_success;
+}
+
+int AtomicIncrementFn(void* args) {
+    PerformanceArgs* performance_args = static_cast<PerformanceArgs*>(args);
+    sync_completion_wait(performance_args->start, zx::sec(20).get());
+    for (uint64_t i = 0; i < kPerformanceIncrements; ++i) {
+        performance_args->atomic->fetch_add(1, std::memory_order_relaxed);
+    }
+    return thrd_success;
+}
+
+// Runs |fn| on |thread_count| threads at once, and sets |duration| to the time they take.
+bool TimeIncrements(thrd_start_t fn, uint32_t thread_count, PerformanceArgs* args,
+                    zx::duration* duration) {
+    BEGIN_HELPER;
+    sync_completion_t start;
+    args->start = &start;
+    fbl::Vector<thrd_t> thread_ids;
+    thread_ids.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        thread_ids.push_back({});
+        ASSERT_EQ(thrd_create(&thread_ids[i], fn, args), thrd_success);
+    }
+
+    zx::time begin = zx::clock::get_monotonic();
+    sync_completion_signal(&start);
+    for (const auto& thread_id : thread_ids) {
+        thrd_join(thread_id, nullptr);
+    }
+    *duration = zx::clock::get_monotonic() - begin;
+    END_HELPER;
+}
+
+// Reports the cost of an increment as 1 to 32 threads update the same counter, for a sharded
+// counter and for a single atomic.
+bool TestIncrementPerformance() {
+    BEGIN_TEST;
+    printf("\n%8s %16s %16s\n", "threads", "sharded ns/inc", "atomic ns/inc");
+    for (uint32_t thread_count = 1; thread_count <= 32; thread_count *= 2) {
+        BaseCounter<uint64_t> counter;
+        std::atomic<uint64_t> atomic(0);
+        PerformanceArgs args = {&counter, &atomic, nullptr};
+        zx::duration sharded;
+        zx::duration unsharded;
+        ASSERT_TRUE(TimeIncrements(ShardedIncrementFn, thread_count, &args, &sharded));
+        ASSERT_TRUE(TimeIncrements(AtomicIncrementFn, thread_count, &args, &unsharded));
+        ASSERT_EQ(counter.Load(), thread_count * kPerformanceIncrements);
+        ASSERT_EQ(atomic.load(), thread_count * kPerformanceIncrements);
+
+        // Threads increment in parallel, so each increment costs a thread the wall time over the
+        // number of increments it performs.
+        printf("%8u %16.2f %16.2f\n", thread_count,
+               static_cast<double>(sharded.get()) / kPerformanceIncrements,
+               static_cast<double>(unsharded.get()) / kPerformanceIncrements);
+    }
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(BaseCounterTest)
 RUN_TEST(TestIncrement)
 RUN_TEST(TestIncrementByVal)
@@ -372,6 +452,7 @@ RUN_TEST(TestExchange)
 RUN_TEST(TestExchangeByVal)
 RUN_TEST(TestIncrementMultiThread)
 RUN_TEST(TestExchangeMultiThread)
+RUN_TEST_PERFORMANCE(TestIncrementPerformance)
 END_TEST_CASE(BaseCounterTest)
 
 BEGIN_TEST_CASE(RemoteCounterTest)
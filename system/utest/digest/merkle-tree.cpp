@@ -5,12 +5,18 @@
 #include <digest/merkle-tree.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <digest/digest.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_ptr.h>
 #include <zircon/assert.h>
 #include <zircon/status.h>
 #include <unittest/unittest.h>
 
+#include "merkle-nodes.h"
+
 namespace {
 
 ////////////////
@@ -378,6 +384,79 @@ bool CreateByteByByte(void) {
     END_TEST;
 }
 
+// Large inputs are hashed many nodes at a time, and possibly by several
+// threads.  Compare against a tree built half a node at a time, which always
+// hashes nodes individually.
+bool CreateLargeMatchesIncremental(void) {
+    BEGIN_TEST_WITH_RC;
+    const size_t data_len = (8 << 20) + (kNodeSize / 2) + 1;
+    const size_t tree_len = MerkleTree::GetTreeLength(data_len);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[data_len]);
+    ASSERT_TRUE(ac.check());
+    fbl::unique_ptr<uint8_t[]> tree1(new (&ac) uint8_t[tree_len]);
+    ASSERT_TRUE(ac.check());
+    fbl::unique_ptr<uint8_t[]> tree2(new (&ac) uint8_t[tree_len]);
+    ASSERT_TRUE(ac.check());
+    for (size_t i = 0; i < data_len; ++i) {
+        data[i] = static_cast<uint8_t>(rand());
+    }
+
+    Digest expected;
+    MerkleTree merkleTree;
+    ASSERT_OK(merkleTree.CreateInit(data_len, tree_len));
+    for (size_t i = 0; i < data_len; i += kNodeSize / 2) {
+        size_t chunk = fbl::min(kNodeSize / 2, data_len - i);
+        ASSERT_OK(merkleTree.CreateUpdate(data.get() + i, chunk, tree2.get()));
+    }
+    ASSERT_OK(merkleTree.CreateFinal(tree2.get(), &expected));
+
+    Digest actual;
+    ASSERT_OK(MerkleTree::Create(data.get(), data_len, tree1.get(), tree_len, &actual));
+    ASSERT_TRUE(actual == expected, "Incorrect root digest");
+    ASSERT_EQ(0, memcmp(tree1.get(), tree2.get(), tree_len), "Incorrect tree");
+    ASSERT_OK(MerkleTree::Verify(data.get(), data_len, tree1.get(), tree_len, 0, data_len,
+                                 actual));
+    END_TEST;
+}
+
+// The multi-lane hash must match the digest of each node computed on its own,
+// for every lane and for localities at any offset and level.
+bool HashNodesMatchesScalar(void) {
+    BEGIN_TEST_WITH_RC;
+    if (!digest::internal::CanHashNodes()) {
+        unittest_printf("multi-lane node hashing is unsupported; skipping\n");
+        END_TEST;
+    }
+    constexpr size_t kLanes = digest::internal::kNodeLanes;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[kLanes * kNodeSize]);
+    ASSERT_TRUE(ac.check());
+    for (size_t i = 0; i < kLanes * kNodeSize; ++i) {
+        data[i] = static_cast<uint8_t>(rand());
+    }
+
+    const uint64_t localities[] = {
+        0, kNodeSize * 24 | 1, (1ull << 40) | 3, UINT64_MAX - kLanes * kNodeSize,
+    };
+    for (uint64_t locality : localities) {
+        uint8_t actual[kLanes * Digest::kLength];
+        digest::internal::HashNodes(data.get(), locality, actual);
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            uint64_t lane_locality = locality + lane * kNodeSize;
+            uint32_t len32 = static_cast<uint32_t>(kNodeSize);
+            Digest expected;
+            ASSERT_OK(expected.Init());
+            expected.Update(&lane_locality, sizeof(lane_locality));
+            expected.Update(&len32, sizeof(len32));
+            expected.Update(data.get() + lane * kNodeSize, kNodeSize);
+            expected.Final();
+            EXPECT_TRUE(expected == actual + lane * Digest::kLength, "Incorrect node digest");
+        }
+    }
+    END_TEST;
+}
+
 bool CreateMissingData(void) {
     BEGIN_TEST_WITH_RC;
     size_t tree_len = MerkleTree::GetTreeLength(kSmall);
@@ -719,6 +798,8 @@ RUN_TEST(CreateAll)
 RUN_TEST(CreateFinalCAll)
 RUN_TEST(CreateCAll)
 RUN_TEST(CreateByteByByte)
+RUN_TEST(CreateLargeMatchesIncremental)
+RUN_TEST(HashNodesMatchesScalar)
 RUN_TEST(CreateMissingData)
 RUN_TEST(CreateMissingTree)
 RUN_TEST(CreateTreeTooSmall)
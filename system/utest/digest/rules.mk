@@ -15,6 +15,9 @@ MODULE_SRCS += \
 
 MODULE_NAME := digest-test
 
+# merkle-tree.cpp tests the private multi-lane node hashing directly.
+MODULE_COMPILEFLAGS += -Isystem/ulib/digest
+
 MODULE_LIBS := \
     system/ulib/unittest \
     system/ulib/digest \
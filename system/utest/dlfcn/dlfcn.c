@@ -13,7 +13,9 @@
 
 #include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <unittest/unittest.h>
@@ -154,6 +156,103 @@ bool loader_service_test(void) {
     END_TEST;
 }
 
+// Asks the loader service |svc| for the object |name|, and checks that it
+// holds |expected|.
+static bool load_object_helper(zx_handle_t svc, const char* name, const char* expected,
+                               zx_handle_t* out) {
+    BEGIN_HELPER;
+
+    ldmsg_req_t req;
+    memset(&req.header, 0, sizeof(req.header));
+    req.header.ordinal = LDMSG_OP_LOAD_OBJECT;
+    size_t req_len;
+    ASSERT_EQ(ldmsg_req_encode(&req, &req_len, name, strlen(name)), ZX_OK, "");
+
+    ldmsg_rsp_t rsp;
+    memset(&rsp, 0, sizeof(rsp));
+    zx_handle_t vmo = ZX_HANDLE_INVALID;
+    const zx_channel_call_args_t call = {
+        .wr_bytes = &req,
+        .wr_num_bytes = req_len,
+        .rd_bytes = &rsp,
+        .rd_num_bytes = sizeof(rsp),
+        .rd_handles = &vmo,
+        .rd_num_handles = 1,
+    };
+    uint32_t reply_size;
+    uint32_t handle_count;
+    ASSERT_EQ(zx_channel_call(svc, 0, ZX_TIME_INFINITE, &call, &reply_size, &handle_count),
+              ZX_OK, "");
+    ASSERT_EQ(rsp.rv, ZX_OK, "load object");
+    ASSERT_EQ(handle_count, 1u, "");
+
+    char actual[32];
+    memset(actual, 0, sizeof(actual));
+    EXPECT_EQ(zx_vmo_read(vmo, actual, 0, strlen(expected)), ZX_OK, "");
+    EXPECT_EQ(memcmp(actual, expected, strlen(expected)), 0, "unexpected object contents");
+    *out = vmo;
+
+    END_HELPER;
+}
+
+static bool write_file_helper(const char* path, const char* contents) {
+    BEGIN_HELPER;
+    int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    ASSERT_GE(fd, 0, "");
+    EXPECT_EQ(write(fd, contents, strlen(contents)), (ssize_t)strlen(contents), "");
+    EXPECT_EQ(close(fd), 0, "");
+    END_HELPER;
+}
+
+// The default loader service caches the objects it loads, but must never
+// hand out a cached object once the file it was read from is replaced.
+bool default_loader_cache_test(void) {
+    BEGIN_TEST;
+
+    char root[] = "/tmp/dlfcn-cache-XXXXXX";
+    ASSERT_NONNULL(mkdtemp(root), "");
+    char lib[sizeof(root) + 4];
+    snprintf(lib, sizeof(lib), "%s/lib", root);
+    ASSERT_EQ(mkdir(lib, 0755), 0, "");
+    char path[sizeof(lib) + 16];
+    snprintf(path, sizeof(path), "%s/libcached.so", lib);
+    char new_path[sizeof(lib) + 16];
+    snprintf(new_path, sizeof(new_path), "%s/libcached.new", lib);
+    ASSERT_TRUE(write_file_helper(path, "first version"), "");
+
+    int root_fd = open(root, O_RDONLY | O_DIRECTORY);
+    ASSERT_GE(root_fd, 0, "");
+    loader_service_t* svc = NULL;
+    ASSERT_EQ(loader_service_create_fd(NULL, root_fd, -1, &svc), ZX_OK, "");
+    zx_handle_t channel = ZX_HANDLE_INVALID;
+    ASSERT_EQ(loader_service_connect(svc, &channel), ZX_OK, "");
+
+    // The second request is served from the cache, and neither client can
+    // modify what the other is given.
+    zx_handle_t first;
+    ASSERT_TRUE(load_object_helper(channel, "libcached.so", "first version", &first), "");
+    EXPECT_EQ(zx_vmo_write(first, "FIRST", 0, 5), ZX_OK, "");
+    zx_handle_t hit;
+    ASSERT_TRUE(load_object_helper(channel, "libcached.so", "first version", &hit), "");
+    zx_handle_close(first);
+    zx_handle_close(hit);
+
+    // Replace the file, as an update would.
+    ASSERT_TRUE(write_file_helper(new_path, "second version"), "");
+    ASSERT_EQ(rename(new_path, path), 0, "");
+    zx_handle_t replaced;
+    ASSERT_TRUE(load_object_helper(channel, "libcached.so", "second version", &replaced), "");
+    zx_handle_close(replaced);
+
+    zx_handle_close(channel);
+    EXPECT_EQ(loader_service_release(svc), ZX_OK, "");
+    EXPECT_EQ(unlink(path), 0, "");
+    EXPECT_EQ(rmdir(lib), 0, "");
+    EXPECT_EQ(rmdir(root), 0, "");
+
+    END_TEST;
+}
+
 bool clone_test(void) {
     BEGIN_TEST;
 
@@ -186,6 +285,7 @@ static bool dladdr_main_test(void) {
 BEGIN_TEST_CASE(dlfcn_tests)
 RUN_TEST(dlopen_vmo_test);
 RUN_TEST(loader_service_test);
+RUN_TEST(default_loader_cache_test);
 RUN_TEST(clone_test);
 RUN_TEST(dladdr_main_test);
 END_TEST_CASE(dlfcn_tests)
@@ -127,6 +127,85 @@ void do_one_test(const fbl::unique_ptr<IsolatedDevmgr>& devmgr, const zx::channe
     fuchsia_device_test_DeviceDestroy(test_channel.get());
 }
 
+// Number of devices published by enumeration_benchmark().
+constexpr size_t kBenchmarkDevices = 200;
+
+// Times the publication of a batch of devices, each of which devmgr offers
+// to the drivers that may bind to it, as it does while enumerating devices
+// during boot.
+void enumeration_benchmark(const fbl::unique_ptr<IsolatedDevmgr>& devmgr,
+                           const zx::channel& test_root) {
+    const char* kDevPrefix = "/dev/";
+    char devpath[fuchsia_device_test_MAX_DEVICE_PATH_LEN+1];
+    size_t count = 0;
+
+    zx::time start = zx::clock::get_monotonic();
+    while (count < kBenchmarkDevices) {
+        char name[fuchsia_device_test_MAX_DEVICE_NAME_LEN+1];
+        snprintf(name, sizeof(name), "enumerate-%zu", count);
+        size_t devpath_count;
+        zx_status_t call_status;
+        zx_status_t status = fuchsia_device_test_RootDeviceCreateDevice(
+                test_root.get(), name, strlen(name),
+                &call_status, devpath, sizeof(devpath) - 1, &devpath_count);
+        if (status == ZX_OK) {
+            status = call_status;
+        }
+        if (status != ZX_OK) {
+            printf("driver-tests: error %s creating device %s\n", zx_status_get_string(status),
+                   name);
+            break;
+        }
+        devpath[devpath_count] = 0;
+        count++;
+    }
+    if (count == 0 || strncmp(devpath, kDevPrefix, strlen(kDevPrefix))) {
+        return;
+    }
+
+    // Devices are bound in the order they are published, so once the last
+    // one can be opened devmgr has offered every one of them to its drivers.
+    fbl::unique_fd fd;
+    zx_status_t status = devmgr_integration_test::RecursiveWaitForFile(
+            devmgr->devfs_root(), devpath + strlen(kDevPrefix),
+            zx::deadline_after(zx::sec(5)), &fd);
+    zx::duration elapsed = zx::clock::get_monotonic() - start;
+    if (status != ZX_OK) {
+        printf("driver-tests: failed to open %s\n", devpath);
+    } else {
+        printf("driver-tests: enumerated %zu devices in %.3f ms (%.1f us per device)\n",
+               count, static_cast<double>(elapsed.to_usecs()) / 1000,
+               static_cast<double>(elapsed.to_nsecs()) / 1000 / static_cast<double>(count));
+    }
+    fd.reset();
+
+    for (size_t i = 0; i < count; i++) {
+        char relative_devpath[PATH_MAX];
+        snprintf(relative_devpath, sizeof(relative_devpath), "%s/enumerate-%zu",
+                 fuchsia_device_test_CONTROL_DEVICE + strlen(kDevPrefix), i);
+        fd.reset(openat(devmgr->devfs_root().get(), relative_devpath, O_RDWR));
+        if (!fd.is_valid()) {
+            continue;
+        }
+        zx::channel channel;
+        if (fdio_get_service_handle(fd.release(), channel.reset_and_get_address()) == ZX_OK) {
+            fuchsia_device_test_DeviceDestroy(channel.get());
+        }
+    }
+}
+
+// Returns true if enumeration_benchmark() should run, which it does only when
+// asked for with --benchmark or when runtests is asked for performance tests.
+bool benchmark_requested(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--benchmark") == 0) {
+            return true;
+        }
+    }
+    const char* test_type = getenv(TEST_ENV_NAME);
+    return test_type != nullptr && (strtoul(test_type, nullptr, 10) & TEST_PERFORMANCE) != 0;
+}
+
 int output_thread(void* arg) {
     zx::socket h(static_cast<zx_handle_t>(reinterpret_cast<uintptr_t>(arg)));
     char buf[1024];
@@ -228,6 +307,10 @@ int main(int argc, char** argv) {
         final_report.failure_count += one_report.failure_count;
     }
 
+    if (benchmark_requested(argc, argv)) {
+        enumeration_benchmark(devmgr, test_root);
+    }
+
     // close this handle before thrd_join to get PEER_CLOSED in output thread
     remote_socket.reset();
 
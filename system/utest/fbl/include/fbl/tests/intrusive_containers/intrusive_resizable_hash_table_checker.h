@@ -0,0 +1,65 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <unittest/unittest.h>
+#include <fbl/intrusive_resizable_hash_table.h>
+#include <fbl/tests/intrusive_containers/intrusive_doubly_linked_list_checker.h>
+#include <fbl/tests/intrusive_containers/intrusive_singly_linked_list_checker.h>
+#include <fbl/tests/intrusive_containers/test_environment_utils.h>
+
+namespace fbl {
+namespace tests {
+namespace intrusive_containers {
+
+// The resizable hash table sanity checker implementation is shared across
+// ResizableHashTables of all bucket types.
+class ResizableHashTableChecker {
+public:
+    template <typename ContainerType>
+    static bool SanityCheck(const ContainerType& container) {
+        using BucketType    = typename ContainerType::BucketType;
+        using BucketChecker = typename BucketType::CheckerType;
+        using KeyTraits     = typename ContainerType::KeyTraits;
+
+        BEGIN_TEST;
+
+        // The current bucket array is never smaller than the inline array, and
+        // the old one only exists while it still has buckets left to move.
+        ASSERT_GE(static_cast<size_t>(1) << container.shift_, ContainerType::kMinBuckets, "");
+        if (container.old_buckets_ != nullptr) {
+            ASSERT_EQ(container.old_shift_ + 1, container.shift_, "");
+            ASSERT_LT(container.migrate_ndx_, container.OldBucketCount(), "");
+        }
+
+        // Demand that every bucket pass its sanity check.  Keep a running total
+        // of the total size of the table in the process.
+        size_t total_size = 0;
+        for (size_t i = 0; i < container.BucketCount(); ++i) {
+            const BucketType& bucket = container.GetBucket(i);
+            ASSERT_TRUE(BucketChecker::SanityCheck(bucket), "");
+            total_size += SizeUtils<BucketType>::size(bucket);
+
+            // Old buckets which have already been moved must be empty.
+            if (i < container.migrate_ndx_) {
+                ASSERT_TRUE(bucket.is_empty(), "");
+            }
+
+            // For every element in the bucket, make sure that the bucket index
+            // matches the location of the element's key.
+            for (const auto& obj : bucket) {
+                ASSERT_EQ(container.Locate(KeyTraits::GetKey(obj)), i, "");
+            }
+        }
+
+        EXPECT_EQ(container.size(), total_size, "");
+
+        END_TEST;
+    }
+};
+
+}  // namespace intrusive_containers
+}  // namespace tests
+}  // namespace fbl
@@ -0,0 +1,93 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/intrusive_hash_table.h>
+#include <fbl/intrusive_resizable_hash_table.h>
+#include <fbl/intrusive_single_list.h>
+#include <fbl/unique_ptr.h>
+#include <unittest/unittest.h>
+#include <zircon/syscalls.h>
+
+namespace {
+
+// Keys are spaced like the addresses of small objects, which is what most
+// of the hash tables in the system are keyed by.
+struct BenchObj : public fbl::SinglyLinkedListable<BenchObj*> {
+    uint64_t key = 0;
+
+    uint64_t GetKey() const { return key; }
+    static size_t GetHash(uint64_t key) { return static_cast<size_t>(key >> 3); }
+};
+
+using FixedTable = fbl::HashTable<uint64_t, BenchObj*>;
+using ResizableTable = fbl::ResizableHashTable<uint64_t, BenchObj*>;
+
+constexpr size_t kLookups = 10000;
+
+// Lookups in a fixed size table walk chains proportional to its size, so it
+// is only measured up to this many elements.
+constexpr size_t kMaxFixedTableSize = 100000;
+
+template <typename TableType>
+bool BenchTable(const char* name, BenchObj* objs, size_t count) {
+    BEGIN_HELPER;
+
+    TableType table;
+    zx_time_t start = zx_clock_get_monotonic();
+    for (size_t i = 0; i < count; ++i)
+        table.insert(&objs[i]);
+    zx_duration_t insert = zx_clock_get_monotonic() - start;
+
+    // Visit the keys in an order which jumps around the table.
+    start = zx_clock_get_monotonic();
+    for (size_t i = 0; i < kLookups; ++i) {
+        ASSERT_TRUE(table.find(objs[(i * 7919) % count].key).IsValid(), "");
+    }
+    zx_duration_t find = zx_clock_get_monotonic() - start;
+
+    start = zx_clock_get_monotonic();
+    for (size_t i = 0; i < kLookups; ++i) {
+        ASSERT_FALSE(table.find(objs[(i * 7919) % count].key + 1).IsValid(), "");
+    }
+    zx_duration_t miss = zx_clock_get_monotonic() - start;
+
+    printf("%-9s %8zu elements: insert %8.1f ns, find %10.1f ns, miss %10.1f ns\n",
+           name, count, static_cast<double>(insert) / static_cast<double>(count),
+           static_cast<double>(find) / kLookups, static_cast<double>(miss) / kLookups);
+
+    table.clear_unsafe();
+
+    END_HELPER;
+}
+
+bool HashTablePerformanceTest() {
+    BEGIN_TEST;
+
+    static constexpr size_t kMaxCount = 1000000;
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<BenchObj[]> objs(new (&ac) BenchObj[kMaxCount]);
+    ASSERT_TRUE(ac.check(), "");
+    for (size_t i = 0; i < kMaxCount; ++i)
+        objs[i].key = 0x100000 + (i * 16);
+
+    printf("\n");
+    for (size_t count = 10; count <= kMaxCount; count *= 10) {
+        if (count <= kMaxFixedTableSize) {
+            ASSERT_TRUE(BenchTable<FixedTable>("fixed", objs.get(), count), "");
+        }
+        ASSERT_TRUE(BenchTable<ResizableTable>("resizable", objs.get(), count), "");
+    }
+
+    END_TEST;
+}
+
+}  // namespace
+
+BEGIN_TEST_CASE(hashtable_benchmarks)
+RUN_TEST_PERFORMANCE(HashTablePerformanceTest)
+END_TEST_CASE(hashtable_benchmarks);
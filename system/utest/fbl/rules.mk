@@ -19,6 +19,7 @@ fbl_common_tests := \
     $(LOCAL_DIR)/intrusive_doubly_linked_list_tests.cpp \
     $(LOCAL_DIR)/intrusive_hash_table_dll_tests.cpp \
     $(LOCAL_DIR)/intrusive_hash_table_sll_tests.cpp \
+    $(LOCAL_DIR)/intrusive_resizable_hash_table_tests.cpp \
     $(LOCAL_DIR)/intrusive_singly_linked_list_tests.cpp \
     $(LOCAL_DIR)/intrusive_wavl_tree_tests.cpp \
     $(LOCAL_DIR)/main.c \
@@ -38,7 +39,7 @@ fbl_common_tests := \
 
 fbl_device_tests := $(fbl_common_tests)
 
-# These tests won't run on the host. There are two primary reasons for this.
+# These tests won't run on the host. There are three primary reasons for this.
 #
 # First, Some of these tests (ref_counted_upgradeable and slab_allocator) need
 # fbl::Mutex which currently isn't supported on the host.
@@ -47,10 +48,13 @@ fbl_device_tests := $(fbl_common_tests)
 # certain actions result in program termination.  Again, this is not currently
 # suppoted in the host test environment.
 #
+# Third, the hash table benchmarks need the monotonic clock.
+#
 # See: TODO(ZX-1053)
 #
 fbl_device_tests += \
     $(LOCAL_DIR)/condition_variable_tests.cpp \
+    $(LOCAL_DIR)/intrusive_hash_table_benchmarks.cpp \
     $(LOCAL_DIR)/ref_counted_tests.cpp \
     $(LOCAL_DIR)/ref_counted_upgradeable_tests.cpp \
     $(LOCAL_DIR)/slab_allocator_tests.cpp \
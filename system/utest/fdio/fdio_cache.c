@@ -0,0 +1,135 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lib/fdio/cache.h>
+#include <lib/fdio/namespace.h>
+#include <zircon/time.h>
+
+#include <unittest/unittest.h>
+
+#define DIR_PATH "/tmp/fdio-cache-test"
+#define FILE_PATH DIR_PATH "/file"
+#define OTHER_PATH DIR_PATH "/other"
+#define BIND_PATH "/fdio-cache-test"
+
+static bool create_file(const char* path) {
+    BEGIN_HELPER;
+    int fd = open(path, O_CREAT | O_RDWR, 0644);
+    ASSERT_GE(fd, 0, "");
+    ASSERT_EQ(close(fd), 0, "");
+    END_HELPER;
+}
+
+static bool cache_missing_test(void) {
+    BEGIN_TEST;
+
+    ASSERT_EQ(mkdir(DIR_PATH, 0755), 0, "");
+    ASSERT_EQ(fdio_cache_enable(0), ZX_OK, "");
+
+    // Repeated lookups of a missing path are answered by the cache, and
+    // stop being answered once the path is created.
+    struct stat s;
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(stat(FILE_PATH, &s), -1, "");
+        ASSERT_EQ(errno, ENOENT, "");
+        ASSERT_EQ(open(FILE_PATH, O_RDONLY), -1, "");
+        ASSERT_EQ(errno, ENOENT, "");
+    }
+    ASSERT_TRUE(create_file(FILE_PATH), "");
+    ASSERT_EQ(stat(FILE_PATH, &s), 0, "");
+    ASSERT_EQ(access(FILE_PATH, F_OK), 0, "");
+
+    ASSERT_EQ(unlink(FILE_PATH), 0, "");
+    ASSERT_EQ(stat(FILE_PATH, &s), -1, "");
+    ASSERT_EQ(errno, ENOENT, "");
+
+    fdio_cache_disable();
+    ASSERT_EQ(rmdir(DIR_PATH), 0, "");
+
+    END_TEST;
+}
+
+static bool cache_attributes_test(void) {
+    BEGIN_TEST;
+
+    ASSERT_EQ(mkdir(DIR_PATH, 0755), 0, "");
+    ASSERT_TRUE(create_file(FILE_PATH), "");
+    ASSERT_EQ(fdio_cache_enable(ZX_SEC(60)), ZX_OK, "");
+
+    struct stat s;
+    ASSERT_EQ(stat(FILE_PATH, &s), 0, "");
+    ASSERT_EQ(s.st_size, 0, "");
+
+    // Modifying the file by path drops its cached attributes.
+    ASSERT_EQ(truncate(FILE_PATH, 10), 0, "");
+    ASSERT_EQ(stat(FILE_PATH, &s), 0, "");
+    ASSERT_EQ(s.st_size, 10, "");
+
+    // Renames are reported by the server for both names.
+    ASSERT_EQ(stat(OTHER_PATH, &s), -1, "");
+    ASSERT_EQ(rename(FILE_PATH, OTHER_PATH), 0, "");
+    ASSERT_EQ(stat(FILE_PATH, &s), -1, "");
+    ASSERT_EQ(errno, ENOENT, "");
+    ASSERT_EQ(stat(OTHER_PATH, &s), 0, "");
+    ASSERT_EQ(s.st_size, 10, "");
+
+    // A directory replaced beneath cached paths drops them too.
+    ASSERT_EQ(unlink(OTHER_PATH), 0, "");
+    ASSERT_EQ(rmdir(DIR_PATH), 0, "");
+    ASSERT_EQ(stat(OTHER_PATH, &s), -1, "");
+    ASSERT_EQ(errno, ENOENT, "");
+    ASSERT_EQ(mkdir(DIR_PATH, 0755), 0, "");
+    ASSERT_TRUE(create_file(OTHER_PATH), "");
+    ASSERT_EQ(stat(OTHER_PATH, &s), 0, "");
+    ASSERT_EQ(s.st_size, 0, "");
+
+    fdio_cache_disable();
+    ASSERT_EQ(unlink(OTHER_PATH), 0, "");
+    ASSERT_EQ(rmdir(DIR_PATH), 0, "");
+
+    END_TEST;
+}
+
+static bool cache_namespace_test(void) {
+    BEGIN_TEST;
+
+    ASSERT_EQ(mkdir(DIR_PATH, 0755), 0, "");
+    ASSERT_TRUE(create_file(FILE_PATH), "");
+    ASSERT_EQ(fdio_cache_enable(ZX_SEC(60)), ZX_OK, "");
+
+    // Namespace directories cannot be watched, so binding a path within the
+    // namespace drops what the cache knows of it.
+    struct stat s;
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(stat(BIND_PATH "/file", &s), -1, "");
+        ASSERT_EQ(stat(BIND_PATH, &s), -1, "");
+        ASSERT_EQ(errno, ENOENT, "");
+    }
+    fdio_ns_t* ns;
+    ASSERT_EQ(fdio_ns_get_installed(&ns), ZX_OK, "");
+    int fd = open(DIR_PATH, O_RDONLY | O_DIRECTORY);
+    ASSERT_GE(fd, 0, "");
+    ASSERT_EQ(fdio_ns_bind_fd(ns, BIND_PATH, fd), ZX_OK, "");
+    ASSERT_EQ(close(fd), 0, "");
+    ASSERT_EQ(stat(BIND_PATH, &s), 0, "");
+    ASSERT_EQ(stat(BIND_PATH "/file", &s), 0, "");
+
+    fdio_cache_disable();
+    ASSERT_EQ(unlink(FILE_PATH), 0, "");
+    ASSERT_EQ(rmdir(DIR_PATH), 0, "");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(fdio_cache_test)
+RUN_TEST(cache_missing_test)
+RUN_TEST(cache_attributes_test)
+RUN_TEST(cache_namespace_test)
+END_TEST_CASE(fdio_cache_test)
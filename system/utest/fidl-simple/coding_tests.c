@@ -0,0 +1,408 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fidl/test/fakesocket/c/coding.h>
+#include <fidl/test/fakesocket/c/fidl.h>
+#include <fidl/test/spaceship/c/coding.h>
+#include <fidl/test/spaceship/c/fidl.h>
+#include <lib/fidl/coding.h>
+#include <stdio.h>
+#include <string.h>
+#include <zircon/syscalls.h>
+
+#include <unittest/unittest.h>
+
+static const int kIterations = 1000000;
+
+typedef fidl_test_spaceship_SpaceShipSetDefenseConditionRequest request_t;
+
+static bool specialized_coding_test(void) {
+    BEGIN_TEST;
+
+    // SetDefenseCondition carries no handles or out-of-line data, so its
+    // specialized functions must accept and reject exactly the messages the
+    // coding tables do.
+    const fidl_type_t* type = &fidl_test_spaceship_SpaceShipSetDefenseConditionRequestTable;
+    const uint32_t sizes[] = {0u, sizeof(fidl_message_header_t), sizeof(request_t),
+                              sizeof(request_t) + 8u};
+    for (size_t i = 0; i < countof(sizes); i++) {
+        uint8_t bytes[sizeof(request_t) + 8u] __ALIGNED(FIDL_ALIGNMENT) = {};
+        uint32_t num_bytes = sizes[i];
+        uint32_t actual_handles = 0u;
+
+        zx_status_t expected = fidl_encode(type, bytes, num_bytes, NULL, 0u, &actual_handles, NULL);
+        EXPECT_EQ(expected, fidl_test_spaceship_SpaceShipSetDefenseConditionRequestEncode(
+                                bytes, num_bytes, NULL, 0u, &actual_handles, NULL), "");
+
+        expected = fidl_decode(type, bytes, num_bytes, NULL, 0u, NULL);
+        EXPECT_EQ(expected, fidl_test_spaceship_SpaceShipSetDefenseConditionRequestDecode(
+                                bytes, num_bytes, NULL, 0u, NULL), "");
+
+        expected = fidl_validate(type, bytes, num_bytes, 1u, NULL);
+        EXPECT_EQ(expected, fidl_test_spaceship_SpaceShipSetDefenseConditionRequestValidate(
+                                bytes, num_bytes, 1u, NULL), "");
+        expected = fidl_validate(type, bytes, num_bytes, 0u, NULL);
+        EXPECT_EQ(expected, fidl_test_spaceship_SpaceShipSetDefenseConditionRequestValidate(
+                                bytes, num_bytes, 0u, NULL), "");
+    }
+
+    const char* error = NULL;
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS, fidl_test_spaceship_SpaceShipSetDefenseConditionRequestDecode(
+                                       NULL, sizeof(request_t), NULL, 0u, &error), "");
+    EXPECT_STR_EQ("Cannot decode null bytes", error, "");
+
+    END_TEST;
+}
+
+typedef fidl_test_spaceship_SpaceShipReportAstrologicalDataRequest union_request_t;
+
+static bool specialized_union_coding_test(void) {
+    BEGIN_TEST;
+
+    // ReportAstrologicalData carries no handles or out-of-line data either,
+    // but the coding tables also reject its union's unknown tags.
+    const fidl_type_t* type = &fidl_test_spaceship_SpaceShipReportAstrologicalDataRequestTable;
+    const fidl_union_tag_t tags[] = {fidl_test_spaceship_AstrologicalDataTag_star,
+                                     fidl_test_spaceship_AstrologicalDataTag_planet, 2u,
+                                     0xffffffffu};
+    for (size_t i = 0; i < countof(tags); i++) {
+        union_request_t request;
+        memset(&request, 0, sizeof(request));
+        request.hdr.ordinal = fidl_test_spaceship_SpaceShipReportAstrologicalDataOrdinal;
+        request.data.tag = tags[i];
+        zx_status_t expected = i < 2 ? ZX_OK : ZX_ERR_INVALID_ARGS;
+        uint32_t actual_handles = 0u;
+
+        EXPECT_EQ(expected, fidl_encode(type, &request, sizeof(request), NULL, 0u,
+                                        &actual_handles, NULL), "");
+        EXPECT_EQ(expected, fidl_test_spaceship_SpaceShipReportAstrologicalDataRequestEncode(
+                                &request, sizeof(request), NULL, 0u, &actual_handles, NULL), "");
+
+        EXPECT_EQ(expected, fidl_decode(type, &request, sizeof(request), NULL, 0u, NULL), "");
+        EXPECT_EQ(expected, fidl_test_spaceship_SpaceShipReportAstrologicalDataRequestDecode(
+                                &request, sizeof(request), NULL, 0u, NULL), "");
+
+        EXPECT_EQ(expected, fidl_validate(type, &request, sizeof(request), 0u, NULL), "");
+        EXPECT_EQ(expected, fidl_test_spaceship_SpaceShipReportAstrologicalDataRequestValidate(
+                                &request, sizeof(request), 0u, NULL), "");
+    }
+
+    END_TEST;
+}
+
+// Messages of each shape the specialized functions unroll: flat, vectors,
+// handles, nullable structs, unions and strings.
+#define kBufferSize 256u
+
+typedef struct coding_case {
+    const char* name;
+    const fidl_type_t* type;
+    zx_status_t (*encode)(void* bytes, uint32_t num_bytes, zx_handle_t* handles,
+                          uint32_t max_handles, uint32_t* out_actual_handles,
+                          const char** out_error_msg);
+    zx_status_t (*decode)(void* bytes, uint32_t num_bytes, const zx_handle_t* handles,
+                          uint32_t num_handles, const char** out_error_msg);
+    zx_status_t (*validate)(const void* bytes, uint32_t num_bytes, uint32_t num_handles,
+                            const char** out_error_msg);
+    // Builds the message, in its decoded form, in |buffer| and returns its
+    // size. Messages with a handle are given |handle|.
+    uint32_t (*build)(uint8_t* buffer, zx_handle_t handle);
+} coding_case_t;
+
+#define CODING_CASE(library, message, build)                                     \
+    {                                                                             \
+        #message, &library##message##Table, library##message##Encode,            \
+            library##message##Decode, library##message##Validate, build,        \
+    }
+
+static uint32_t build_defense_condition(uint8_t* buffer, zx_handle_t handle) {
+    request_t* request = (request_t*)buffer;
+    request->hdr.ordinal = fidl_test_spaceship_SpaceShipSetDefenseConditionOrdinal;
+    request->alert = fidl_test_spaceship_Alert_RED;
+    return sizeof(*request);
+}
+
+static uint32_t build_adjust_heading(uint8_t* buffer, zx_handle_t handle) {
+    fidl_test_spaceship_SpaceShipAdjustHeadingRequest* request =
+        (fidl_test_spaceship_SpaceShipAdjustHeadingRequest*)buffer;
+    request->hdr.ordinal = fidl_test_spaceship_SpaceShipAdjustHeadingOrdinal;
+    uint32_t* stars = (uint32_t*)(buffer + sizeof(*request));
+    stars[0] = 1u;
+    stars[1] = 2u;
+    stars[2] = 3u;
+    request->stars.count = 3u;
+    request->stars.data = stars;
+    return sizeof(*request) + FIDL_ALIGN(3u * sizeof(uint32_t));
+}
+
+static uint32_t build_astrometrics_listener(uint8_t* buffer, zx_handle_t handle) {
+    fidl_test_spaceship_SpaceShipSetAstrometricsListenerRequest* request =
+        (fidl_test_spaceship_SpaceShipSetAstrometricsListenerRequest*)buffer;
+    request->hdr.ordinal = fidl_test_spaceship_SpaceShipSetAstrometricsListenerOrdinal;
+    request->listener = handle;
+    return sizeof(*request);
+}
+
+static uint32_t build_fuel_remaining(uint8_t* buffer, zx_handle_t handle) {
+    fidl_test_spaceship_SpaceShipGetFuelRemainingResponse* response =
+        (fidl_test_spaceship_SpaceShipGetFuelRemainingResponse*)buffer;
+    response->hdr.ordinal = fidl_test_spaceship_SpaceShipGetFuelRemainingOrdinal;
+    response->status = ZX_OK;
+    response->level = (fidl_test_spaceship_FuelLevel*)(buffer + sizeof(*response));
+    response->level->reaction_mass = 1729u;
+    return sizeof(*response) + FIDL_ALIGN(sizeof(fidl_test_spaceship_FuelLevel));
+}
+
+static uint32_t build_add_fuel_tank(uint8_t* buffer, zx_handle_t handle) {
+    fidl_test_spaceship_SpaceShipAddFuelTankRequest* request =
+        (fidl_test_spaceship_SpaceShipAddFuelTankRequest*)buffer;
+    request->hdr.ordinal = fidl_test_spaceship_SpaceShipAddFuelTankOrdinal;
+    request->level = NULL;
+    return sizeof(*request);
+}
+
+static uint32_t build_astrological_data(uint8_t* buffer, zx_handle_t handle) {
+    union_request_t* request = (union_request_t*)buffer;
+    request->hdr.ordinal = fidl_test_spaceship_SpaceShipReportAstrologicalDataOrdinal;
+    request->data.tag = fidl_test_spaceship_AstrologicalDataTag_planet;
+    return sizeof(*request);
+}
+
+static uint32_t build_bind(uint8_t* buffer, zx_handle_t handle) {
+    fidl_test_fakesocket_ControlBindRequest* request =
+        (fidl_test_fakesocket_ControlBindRequest*)buffer;
+    request->hdr.ordinal = fidl_test_fakesocket_ControlBindOrdinal;
+    char* addr = (char*)(buffer + sizeof(*request));
+    memcpy(addr, "127.0.0.1", 9u);
+    request->addr.size = 9u;
+    request->addr.data = addr;
+    return sizeof(*request) + FIDL_ALIGN(9u);
+}
+
+static const coding_case_t kCodingCases[] = {
+    CODING_CASE(fidl_test_spaceship_, SpaceShipSetDefenseConditionRequest,
+                build_defense_condition),
+    CODING_CASE(fidl_test_spaceship_, SpaceShipAdjustHeadingRequest, build_adjust_heading),
+    CODING_CASE(fidl_test_spaceship_, SpaceShipSetAstrometricsListenerRequest,
+                build_astrometrics_listener),
+    CODING_CASE(fidl_test_spaceship_, SpaceShipGetFuelRemainingResponse, build_fuel_remaining),
+    CODING_CASE(fidl_test_spaceship_, SpaceShipAddFuelTankRequest, build_add_fuel_tank),
+    CODING_CASE(fidl_test_spaceship_, SpaceShipReportAstrologicalDataRequest,
+                build_astrological_data),
+    CODING_CASE(fidl_test_fakesocket_, ControlBindRequest, build_bind),
+};
+
+// Checks that the specialized functions rejected a message with the status
+// and error message the coding tables gave.
+static bool check_same_error(const char* name, zx_status_t expected, const char* expected_error,
+                             zx_status_t status, const char* error) {
+    BEGIN_HELPER;
+
+    ASSERT_NE(ZX_OK, expected, name);
+    ASSERT_EQ(expected, status, name);
+    ASSERT_NONNULL(expected_error, name);
+    ASSERT_NONNULL(error, name);
+    EXPECT_STR_EQ(expected_error, error, name);
+
+    END_HELPER;
+}
+
+// Encodes, validates and decodes a valid message in place, once with the
+// coding tables and once with the specialized functions, and checks that
+// both leave the same bytes and handles at each step.
+static bool check_valid_message(const coding_case_t* c, uint8_t* buffer, uint32_t num_bytes) {
+    BEGIN_HELPER;
+
+    uint8_t decoded[kBufferSize];
+    memcpy(decoded, buffer, num_bytes);
+
+    zx_handle_t table_handles[4] = {};
+    uint32_t table_actual_handles = 0u;
+    ASSERT_EQ(ZX_OK, fidl_encode(c->type, buffer, num_bytes, table_handles,
+                                 countof(table_handles), &table_actual_handles, NULL), c->name);
+    uint8_t encoded[kBufferSize];
+    memcpy(encoded, buffer, num_bytes);
+
+    memcpy(buffer, decoded, num_bytes);
+    zx_handle_t handles[4] = {};
+    uint32_t actual_handles = 0u;
+    ASSERT_EQ(ZX_OK, c->encode(buffer, num_bytes, handles, countof(handles), &actual_handles,
+                               NULL), c->name);
+    EXPECT_EQ(table_actual_handles, actual_handles, c->name);
+    EXPECT_BYTES_EQ(encoded, buffer, num_bytes, c->name);
+    EXPECT_BYTES_EQ((uint8_t*)table_handles, (uint8_t*)handles, sizeof(handles), c->name);
+
+    EXPECT_EQ(ZX_OK, c->validate(buffer, num_bytes, actual_handles, NULL), c->name);
+    EXPECT_EQ(fidl_validate(c->type, buffer, num_bytes, actual_handles + 1u, NULL),
+              c->validate(buffer, num_bytes, actual_handles + 1u, NULL), c->name);
+
+    ASSERT_EQ(ZX_OK, c->decode(buffer, num_bytes, handles, actual_handles, NULL), c->name);
+    EXPECT_BYTES_EQ(decoded, buffer, num_bytes, c->name);
+
+    END_HELPER;
+}
+
+static bool specialized_coding_shapes_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t handle;
+    ASSERT_EQ(ZX_OK, zx_event_create(0u, &handle), "");
+
+    for (size_t i = 0; i < countof(kCodingCases); i++) {
+        const coding_case_t* c = &kCodingCases[i];
+        uint8_t buffer[kBufferSize] __ALIGNED(FIDL_ALIGNMENT) = {};
+        uint32_t num_bytes = c->build(buffer, handle);
+        ASSERT_TRUE(check_valid_message(c, buffer, num_bytes), c->name);
+
+        // Messages with bytes left over, or missing, are rejected alike.
+        uint32_t sizes[] = {num_bytes + FIDL_ALIGNMENT, num_bytes - FIDL_ALIGNMENT};
+        for (size_t j = 0; j < countof(sizes); j++) {
+            memset(buffer, 0, sizeof(buffer));
+            c->build(buffer, ZX_HANDLE_INVALID);
+            const char* table_error = NULL;
+            uint32_t actual_handles = 0u;
+            zx_status_t expected = fidl_encode(c->type, buffer, sizes[j], NULL, 0u,
+                                               &actual_handles, &table_error);
+            memset(buffer, 0, sizeof(buffer));
+            c->build(buffer, ZX_HANDLE_INVALID);
+            const char* error = NULL;
+            zx_status_t status = c->encode(buffer, sizes[j], NULL, 0u, &actual_handles, &error);
+            EXPECT_TRUE(check_same_error(c->name, expected, table_error, status, error), "");
+        }
+    }
+
+    ASSERT_EQ(ZX_OK, zx_handle_close(handle), "");
+
+    END_TEST;
+}
+
+static bool specialized_out_of_line_coding_test(void) {
+    BEGIN_TEST;
+
+    // Out-of-line data which the coding tables reject is rejected alike,
+    // with the same error.
+    const coding_case_t* adjust_heading = &kCodingCases[1];
+    const coding_case_t* bind = &kCodingCases[6];
+    for (int i = 0; i < 4; i++) {
+        uint8_t tables[kBufferSize] __ALIGNED(FIDL_ALIGNMENT) = {};
+        uint8_t specialized[kBufferSize] __ALIGNED(FIDL_ALIGNMENT) = {};
+        const coding_case_t* c = i < 2 ? adjust_heading : bind;
+        uint32_t num_bytes = c->build(tables, ZX_HANDLE_INVALID);
+        c->build(specialized, ZX_HANDLE_INVALID);
+        fidl_vector_t* vectors[] = {(fidl_vector_t*)(tables + sizeof(fidl_message_header_t)),
+                                    (fidl_vector_t*)(specialized + sizeof(fidl_message_header_t))};
+        for (size_t j = 0; j < countof(vectors); j++) {
+            switch (i) {
+            case 0:
+                vectors[j]->count = fidl_test_spaceship_MaxStarsAdjustHeading + 1u;
+                break;
+            case 1:
+            case 3:
+                vectors[j]->data = NULL;
+                break;
+            case 2:
+                vectors[j]->count = 65u;
+                break;
+            }
+        }
+
+        const char* table_error = NULL;
+        const char* error = NULL;
+        uint32_t actual_handles = 0u;
+        zx_status_t expected = fidl_encode(c->type, tables, num_bytes, NULL, 0u, &actual_handles,
+                                           &table_error);
+        zx_status_t status = c->encode(specialized, num_bytes, NULL, 0u, &actual_handles, &error);
+        EXPECT_TRUE(check_same_error(c->name, expected, table_error, status, error), "");
+    }
+
+    END_TEST;
+}
+
+static bool specialized_handle_coding_test(void) {
+    BEGIN_TEST;
+
+    // An absent handle in place of a non-nullable one is rejected alike.
+    const coding_case_t* c = &kCodingCases[2];
+    uint8_t buffer[kBufferSize] __ALIGNED(FIDL_ALIGNMENT) = {};
+    uint32_t num_bytes = c->build(buffer, ZX_HANDLE_INVALID);
+    const char* table_error = NULL;
+    const char* error = NULL;
+    uint32_t actual_handles = 0u;
+    zx_status_t expected = fidl_encode(c->type, buffer, num_bytes, NULL, 0u, &actual_handles,
+                                       &table_error);
+    zx_status_t status = c->encode(buffer, num_bytes, NULL, 0u, &actual_handles, &error);
+    EXPECT_TRUE(check_same_error(c->name, expected, table_error, status, error), "");
+
+    // So is a present handle which is not among the handles given.
+    c->build(buffer, ZX_HANDLE_INVALID);
+    ((fidl_test_spaceship_SpaceShipSetAstrometricsListenerRequest*)buffer)->listener =
+        FIDL_HANDLE_PRESENT;
+    expected = fidl_decode(c->type, buffer, num_bytes, NULL, 0u, &table_error);
+    status = c->decode(buffer, num_bytes, NULL, 0u, &error);
+    EXPECT_TRUE(check_same_error(c->name, expected, table_error, status, error), "");
+    EXPECT_EQ(fidl_validate(c->type, buffer, num_bytes, 0u, NULL),
+              c->validate(buffer, num_bytes, 0u, NULL), "");
+
+    // The handles of a message which fails to decode are closed.
+    zx_handle_t handle;
+    ASSERT_EQ(ZX_OK, zx_event_create(0u, &handle), "");
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS, c->decode(buffer, num_bytes - FIDL_ALIGNMENT, &handle, 1u,
+                                             NULL), "");
+    EXPECT_EQ(ZX_ERR_BAD_HANDLE, zx_handle_close(handle), "");
+
+    END_TEST;
+}
+
+static bool specialized_coding_performance_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t handle;
+    ASSERT_EQ(ZX_OK, zx_event_create(0u, &handle), "");
+
+    printf("\n");
+    for (size_t i = 0; i < countof(kCodingCases); i++) {
+        const coding_case_t* c = &kCodingCases[i];
+        uint8_t buffer[kBufferSize] __ALIGNED(FIDL_ALIGNMENT) = {};
+        uint32_t num_bytes = c->build(buffer, handle);
+        zx_handle_t handles[1];
+        uint32_t actual_handles = 0u;
+
+        // Each iteration encodes the message and decodes it back into the
+        // same form, so handles are moved out of the message and back.
+        zx_time_t start = zx_clock_get_monotonic();
+        for (int j = 0; j < kIterations; j++) {
+            ASSERT_EQ(ZX_OK, fidl_encode(c->type, buffer, num_bytes, handles, countof(handles),
+                                         &actual_handles, NULL), c->name);
+            ASSERT_EQ(ZX_OK, fidl_decode(c->type, buffer, num_bytes, handles, actual_handles,
+                                         NULL), c->name);
+        }
+        zx_duration_t tables = zx_clock_get_monotonic() - start;
+
+        start = zx_clock_get_monotonic();
+        for (int j = 0; j < kIterations; j++) {
+            ASSERT_EQ(ZX_OK, c->encode(buffer, num_bytes, handles, countof(handles),
+                                       &actual_handles, NULL), c->name);
+            ASSERT_EQ(ZX_OK, c->decode(buffer, num_bytes, handles, actual_handles, NULL),
+                      c->name);
+        }
+        zx_duration_t specialized = zx_clock_get_monotonic() - start;
+
+        printf("encode and decode of %s (%u bytes): tables %.1f ns, specialized %.1f ns\n",
+               c->name, num_bytes, (double)tables / kIterations,
+               (double)specialized / kIterations);
+    }
+
+    ASSERT_EQ(ZX_OK, zx_handle_close(handle), "");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(coding_tests)
+RUN_TEST(specialized_coding_test)
+RUN_TEST(specialized_union_coding_test)
+RUN_TEST(specialized_coding_shapes_test)
+RUN_TEST(specialized_out_of_line_coding_test)
+RUN_TEST(specialized_handle_coding_test)
+RUN_TEST_PERFORMANCE(specialized_coding_performance_test)
+END_TEST_CASE(coding_tests);
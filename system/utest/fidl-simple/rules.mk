@@ -42,6 +42,7 @@ MODULE_TYPE := usertest
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/client_tests.c \
+    $(LOCAL_DIR)/coding_tests.c \
     $(LOCAL_DIR)/fakesocket_tests.cpp \
     $(LOCAL_DIR)/ldsvc_tests.c \
     $(LOCAL_DIR)/main.c \
@@ -6,17 +6,29 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <threads.h>
+#include <unistd.h>
 
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_call.h>
 #include <fbl/function.h>
 #include <fbl/string.h>
 #include <fbl/string_buffer.h>
 #include <fbl/string_printf.h>
 #include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
 #include <fs-management/mount.h>
 #include <fs-test-utils/fixture.h>
 #include <fs-test-utils/perftest.h>
+#include <lib/async-loop/cpp/loop.h>
+#include <lib/fdio/cache.h>
+#include <lib/fdio/util.h>
+#include <lib/memfs/memfs.h>
+#include <lib/sync/completion.h>
 #include <perftest/perftest.h>
 #include <unittest/unittest.h>
+#include <zircon/processargs.h>
 
 #include <utility>
 
@@ -31,6 +43,36 @@ using fs_test_utils::TestInfo;
 
 constexpr int kWriteReadCycles = 3;
 
+// Size of the file used to measure sequential throughput.
+constexpr size_t kSequentialFileSize = 1ul << 30;
+// Size of each read or write issued against the sequential file.
+constexpr size_t kSequentialIoSize = 1 << 20;
+// Number of times the sequential file is written and read.
+constexpr int kSequentialSampleCount = 5;
+
+// Number of files which are appended to concurrently.
+constexpr int kAppendFileCount = 4;
+// Size of each append.
+constexpr size_t kAppendSize = 512;
+// Size which each appended file grows to.
+constexpr size_t kAppendFileSize = 4 << 20;
+// Number of times the appended files are built and read.
+constexpr int kAppendSampleCount = 5;
+
+// Number of files which are opened and stat'd in each run of the parallel lookup tests,
+// across all threads.
+constexpr int kParallelLookupFiles = 256;
+// Number of runs of each parallel lookup test.
+constexpr int kParallelLookupSampleCount = 100;
+
+// Number of existing files, and of missing paths, which are stat'd in each run of the
+// stat tests.
+constexpr int kStatPaths = 64;
+// Number of runs of each stat test.
+constexpr int kStatSampleCount = 100;
+// How long attributes may be cached while the fdio cache is enabled.
+constexpr zx_duration_t kStatCacheTtl = ZX_SEC(1);
+
 fbl::String GetBigFilePath(const Fixture& fixture) {
     fbl::String path = fbl::StringPrintf("%s/bigfile.txt", fixture.fs_path().c_str());
     return path;
@@ -70,6 +112,245 @@ bool ReadBigFile(ssize_t data_size, perftest::RepeatState* state, Fixture* fixtu
     END_HELPER;
 }
 
+fbl::String GetSequentialFilePath(const Fixture& fixture) {
+    return fbl::StringPrintf("%s/sequentialfile.txt", fixture.fs_path().c_str());
+}
+
+// Writes the whole sequential file in each run, and waits for it to reach the disk.
+bool WriteSequentialFile(size_t file_size, perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+
+    fbl::unique_fd fd(open(GetSequentialFilePath(*fixture).c_str(), O_CREAT | O_WRONLY));
+    ASSERT_TRUE(fd);
+    state->SetBytesProcessedPerRun(file_size);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[kSequentialIoSize]);
+    ASSERT_TRUE(ac.check());
+    uint8_t pattern = static_cast<uint8_t>(rand_r(fixture->mutable_seed()) % (1 << 8));
+    memset(data.get(), pattern, kSequentialIoSize);
+
+    while (state->KeepRunning()) {
+        ASSERT_EQ(lseek(fd.get(), 0, SEEK_SET), 0);
+        for (size_t offset = 0; offset < file_size; offset += kSequentialIoSize) {
+            ASSERT_EQ(write(fd.get(), data.get(), kSequentialIoSize),
+                      static_cast<ssize_t>(kSequentialIoSize));
+        }
+        ASSERT_EQ(fsync(fd.get()), 0);
+    }
+
+    END_HELPER;
+}
+
+// Reads the whole sequential file in each run, reopening it so that it is read from the disk.
+bool ReadSequentialFile(size_t file_size, perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+
+    state->SetBytesProcessedPerRun(file_size);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[kSequentialIoSize]);
+    ASSERT_TRUE(ac.check());
+    uint8_t pattern = static_cast<uint8_t>(rand_r(fixture->mutable_seed()) % (1 << 8));
+
+    while (state->KeepRunning()) {
+        fbl::unique_fd fd(open(GetSequentialFilePath(*fixture).c_str(), O_RDONLY));
+        ASSERT_TRUE(fd);
+        for (size_t offset = 0; offset < file_size; offset += kSequentialIoSize) {
+            ASSERT_EQ(read(fd.get(), data.get(), kSequentialIoSize),
+                      static_cast<ssize_t>(kSequentialIoSize));
+            ASSERT_EQ(data[0], pattern);
+        }
+    }
+
+    END_HELPER;
+}
+
+fbl::String GetAppendFilePath(const Fixture& fixture, int index) {
+    return fbl::StringPrintf("%s/appendfile-%d.txt", fixture.fs_path().c_str(), index);
+}
+
+// Builds |kAppendFileCount| files of |file_size| bytes in each run, appending |kAppendSize|
+// bytes to each of them in turn, and waits for them to reach the disk.
+bool AppendFiles(size_t file_size, perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+
+    state->SetBytesProcessedPerRun(file_size * kAppendFileCount);
+    uint8_t data[kAppendSize];
+    uint8_t pattern = static_cast<uint8_t>(rand_r(fixture->mutable_seed()) % (1 << 8));
+    memset(data, pattern, kAppendSize);
+
+    while (state->KeepRunning()) {
+        fbl::unique_fd fds[kAppendFileCount];
+        for (int i = 0; i < kAppendFileCount; i++) {
+            fds[i].reset(open(GetAppendFilePath(*fixture, i).c_str(),
+                              O_CREAT | O_TRUNC | O_WRONLY | O_APPEND));
+            ASSERT_TRUE(fds[i]);
+        }
+        for (size_t offset = 0; offset < file_size; offset += kAppendSize) {
+            for (int i = 0; i < kAppendFileCount; i++) {
+                ASSERT_EQ(write(fds[i].get(), data, kAppendSize),
+                          static_cast<ssize_t>(kAppendSize));
+            }
+        }
+        for (int i = 0; i < kAppendFileCount; i++) {
+            ASSERT_EQ(fsync(fds[i].get()), 0);
+        }
+    }
+
+    END_HELPER;
+}
+
+// Reads back each of the appended files. Since they were written concurrently, the read
+// throughput reflects how fragmented their blocks are.
+bool ReadAppendedFiles(size_t file_size, perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+
+    state->SetBytesProcessedPerRun(file_size * kAppendFileCount);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[kSequentialIoSize]);
+    ASSERT_TRUE(ac.check());
+    uint8_t pattern = static_cast<uint8_t>(rand_r(fixture->mutable_seed()) % (1 << 8));
+
+    while (state->KeepRunning()) {
+        for (int i = 0; i < kAppendFileCount; i++) {
+            fbl::unique_fd fd(open(GetAppendFilePath(*fixture, i).c_str(), O_RDONLY));
+            ASSERT_TRUE(fd);
+            for (size_t offset = 0; offset < file_size; offset += kSequentialIoSize) {
+                size_t length = fbl::min(kSequentialIoSize, file_size - offset);
+                ASSERT_EQ(read(fd.get(), data.get(), length), static_cast<ssize_t>(length));
+                ASSERT_EQ(data[0], pattern);
+            }
+        }
+    }
+
+    END_HELPER;
+}
+
+// Opens and stats |count| files within |dir|, relative to |root_fd|. Returns 0 on success.
+int LookupFiles(int root_fd, const char* dir, int count) {
+    for (int i = 0; i < count; i++) {
+        fbl::String path = fbl::StringPrintf("%s/file-%d", dir, i);
+        struct stat buf;
+        if (fstatat(root_fd, path.c_str(), &buf, 0) != 0) {
+            return -1;
+        }
+        fbl::unique_fd fd(openat(root_fd, path.c_str(), O_RDONLY));
+        if (!fd) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+struct LookupThreadArgs {
+    int root_fd;
+    fbl::String dir;
+    int count;
+};
+
+int LookupThread(void* arg) {
+    LookupThreadArgs* args = static_cast<LookupThreadArgs*>(arg);
+    return LookupFiles(args->root_fd, args->dir.c_str(), args->count);
+}
+
+// Opens and stats |kParallelLookupFiles| files in each run, split evenly across
+// |thread_count| client threads which each work within a directory of their own. Since
+// every run does the same amount of work, comparing runs with different thread counts
+// shows how well path walks proceed in parallel.
+//
+// The filesystem under test is served from a single thread, so the clients use a memfs
+// of their own, dispatched from as many threads as there are clients.
+bool ParallelLookup(int thread_count, perftest::RepeatState* state) {
+    BEGIN_HELPER;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    for (int t = 0; t < thread_count; t++) {
+        ASSERT_EQ(loop.StartThread(), ZX_OK);
+    }
+    memfs_filesystem_t* vfs;
+    zx_handle_t root;
+    ASSERT_EQ(memfs_create_filesystem(loop.dispatcher(), &vfs, &root), ZX_OK);
+    auto free_vfs = fbl::MakeAutoCall([vfs]() {
+        sync_completion_t unmounted;
+        memfs_free_filesystem(vfs, &unmounted);
+        sync_completion_wait(&unmounted, ZX_TIME_INFINITE);
+    });
+    uint32_t type = PA_FDIO_REMOTE;
+    int raw_root_fd;
+    ASSERT_EQ(fdio_create_fd(&root, &type, 1, &raw_root_fd), ZX_OK);
+    fbl::unique_fd root_fd(raw_root_fd);
+
+    const int count = kParallelLookupFiles / thread_count;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<LookupThreadArgs[]> args(new (&ac) LookupThreadArgs[thread_count]);
+    ASSERT_TRUE(ac.check());
+    for (int t = 0; t < thread_count; t++) {
+        args[t].root_fd = root_fd.get();
+        args[t].dir = fbl::StringPrintf("lookup-%d", t);
+        args[t].count = count;
+        ASSERT_EQ(mkdirat(root_fd.get(), args[t].dir.c_str(), 0666), 0);
+        for (int i = 0; i < count; i++) {
+            fbl::String path = fbl::StringPrintf("%s/file-%d", args[t].dir.c_str(), i);
+            fbl::unique_fd fd(openat(root_fd.get(), path.c_str(), O_CREAT | O_RDWR));
+            ASSERT_TRUE(fd);
+        }
+    }
+
+    while (state->KeepRunning()) {
+        thrd_t threads[thread_count];
+        int started = 0;
+        for (; started < thread_count; started++) {
+            if (thrd_create(&threads[started], LookupThread, &args[started]) != thrd_success) {
+                break;
+            }
+        }
+        bool success = (started == thread_count);
+        for (int t = 0; t < started; t++) {
+            int result;
+            success &= (thrd_join(threads[t], &result) == thrd_success) && (result == 0);
+        }
+        ASSERT_TRUE(success);
+    }
+
+    END_HELPER;
+}
+
+// Stats |kStatPaths| files, and as many missing paths, in each run, as build tools do
+// when checking outputs and probing search paths. If |cached| is set, the fdio cache
+// answers repeated lookups.
+bool StatPaths(bool cached, perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+
+    fbl::String dir = fbl::StringPrintf("%s/stat-%s", fixture->fs_path().c_str(),
+                                        cached ? "cached" : "uncached");
+    ASSERT_EQ(mkdir(dir.c_str(), 0666), 0);
+    for (int i = 0; i < kStatPaths; i++) {
+        fbl::String path = fbl::StringPrintf("%s/file-%d", dir.c_str(), i);
+        fbl::unique_fd fd(open(path.c_str(), O_CREAT | O_RDWR));
+        ASSERT_TRUE(fd);
+    }
+
+    if (cached) {
+        ASSERT_EQ(fdio_cache_enable(kStatCacheTtl), ZX_OK);
+    }
+    auto disable_cache = fbl::MakeAutoCall([cached]() {
+        if (cached) {
+            fdio_cache_disable();
+        }
+    });
+
+    while (state->KeepRunning()) {
+        for (int i = 0; i < kStatPaths; i++) {
+            struct stat buf;
+            fbl::String path = fbl::StringPrintf("%s/file-%d", dir.c_str(), i);
+            ASSERT_EQ(stat(path.c_str(), &buf), 0);
+            path = fbl::StringPrintf("%s/missing-%d", dir.c_str(), i);
+            ASSERT_EQ(stat(path.c_str(), &buf), -1);
+        }
+    }
+
+    END_HELPER;
+}
+
 constexpr char kBaseComponent[] = "/aaa";
 
 constexpr size_t kComponentLength = fbl::constexpr_strlen(kBaseComponent);
@@ -206,6 +487,113 @@ bool RunBenchmark(int argc, char** argv) {
         testcases.push_back(std::move(testcase));
     }
 
+    // Sequential throughput tests. Keep the file small for unittest mode.
+    const size_t sequential_file_size =
+        (p_opts.is_unittest) ? kSequentialIoSize : kSequentialFileSize;
+    {
+        TestCaseInfo testcase;
+        testcase.sample_count = kSequentialSampleCount;
+        testcase.name = fbl::StringPrintf("%s/SequentialFile/%zuMbytes",
+                                          disk_format_string_[f_opts.fs_type],
+                                          sequential_file_size >> 20);
+        testcase.teardown = false;
+
+        TestInfo write_test, read_test;
+        write_test.name = fbl::StringPrintf("%s/Write", testcase.name.c_str());
+        write_test.test_fn = [sequential_file_size](perftest::RepeatState* state,
+                                                    Fixture* fixture) {
+            return WriteSequentialFile(sequential_file_size, state, fixture);
+        };
+        write_test.required_disk_space = sequential_file_size;
+        testcase.tests.push_back(std::move(write_test));
+
+        read_test.name = fbl::StringPrintf("%s/Read", testcase.name.c_str());
+        read_test.test_fn = [sequential_file_size](perftest::RepeatState* state,
+                                                   Fixture* fixture) {
+            return ReadSequentialFile(sequential_file_size, state, fixture);
+        };
+        read_test.required_disk_space = sequential_file_size;
+        testcase.tests.push_back(std::move(read_test));
+        testcases.push_back(std::move(testcase));
+    }
+
+    // Small append tests. Keep the files small for unittest mode.
+    const size_t append_file_size = (p_opts.is_unittest) ? (64 << 10) : kAppendFileSize;
+    {
+        TestCaseInfo testcase;
+        testcase.sample_count = kAppendSampleCount;
+        testcase.name = fbl::StringPrintf("%s/SmallAppend/%zubytes/%d-Files",
+                                          disk_format_string_[f_opts.fs_type], kAppendSize,
+                                          kAppendFileCount);
+        testcase.teardown = false;
+
+        TestInfo append_test, read_test;
+        append_test.name = fbl::StringPrintf("%s/Append", testcase.name.c_str());
+        append_test.test_fn = [append_file_size](perftest::RepeatState* state,
+                                                 Fixture* fixture) {
+            return AppendFiles(append_file_size, state, fixture);
+        };
+        append_test.required_disk_space = append_file_size * kAppendFileCount;
+        testcase.tests.push_back(std::move(append_test));
+
+        read_test.name = fbl::StringPrintf("%s/Read", testcase.name.c_str());
+        read_test.test_fn = [append_file_size](perftest::RepeatState* state,
+                                               Fixture* fixture) {
+            return ReadAppendedFiles(append_file_size, state, fixture);
+        };
+        read_test.required_disk_space = append_file_size * kAppendFileCount;
+        testcase.tests.push_back(std::move(read_test));
+        testcases.push_back(std::move(testcase));
+    }
+
+    // Parallel lookup tests.
+    const int parallel_lookup_thread_counts[] = {
+        1,
+        2,
+        4,
+        8,
+    };
+
+    for (int thread_count : parallel_lookup_thread_counts) {
+        TestCaseInfo testcase;
+        testcase.name = fbl::StringPrintf("memfs/ParallelLookup/%d-Files/%d-Threads",
+                                          kParallelLookupFiles, thread_count);
+        testcase.sample_count = kParallelLookupSampleCount;
+        testcase.teardown = false;
+
+        TestInfo lookup_test;
+        lookup_test.name = fbl::StringPrintf("%s/OpenStat", testcase.name.c_str());
+        lookup_test.test_fn = [thread_count](perftest::RepeatState* state, Fixture* fixture) {
+            return ParallelLookup(thread_count, state);
+        };
+        testcase.tests.push_back(std::move(lookup_test));
+        testcases.push_back(std::move(testcase));
+    }
+
+    // Stat tests.
+    {
+        TestCaseInfo testcase;
+        testcase.name = fbl::StringPrintf("%s/StatPaths/%d-Paths",
+                                          disk_format_string_[f_opts.fs_type], 2 * kStatPaths);
+        testcase.sample_count = kStatSampleCount;
+        testcase.teardown = false;
+
+        TestInfo uncached_test;
+        uncached_test.name = fbl::StringPrintf("%s/Uncached", testcase.name.c_str());
+        uncached_test.test_fn = [](perftest::RepeatState* state, Fixture* fixture) {
+            return StatPaths(false, state, fixture);
+        };
+        testcase.tests.push_back(std::move(uncached_test));
+
+        TestInfo cached_test;
+        cached_test.name = fbl::StringPrintf("%s/Cached", testcase.name.c_str());
+        cached_test.test_fn = [](perftest::RepeatState* state, Fixture* fixture) {
+            return StatPaths(true, state, fixture);
+        };
+        testcase.tests.push_back(std::move(cached_test));
+        testcases.push_back(std::move(testcase));
+    }
+
     // Path walk tests.
     const int path_walk_sample_counts[] = {
         125,
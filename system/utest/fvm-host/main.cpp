@@ -11,6 +11,7 @@
 
 #include <fvm/sparse-reader.h>
 
+#include <time.h>
 #include <utility>
 
 #define DEFAULT_SLICE_SIZE (8lu * (1 << 20))  // 8 mb
@@ -701,6 +702,51 @@ bool TestPave() {
     END_TEST;
 }
 
+static double SecondsSince(const struct timespec& start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<double>(now.tv_sec - start.tv_sec) +
+           static_cast<double>(now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Reports the rate at which a compressed sparse image is decompressed, and at which it is paved
+// to a file-backed FVM.
+bool TestPavePerformance() {
+    BEGIN_TEST;
+    ASSERT_TRUE(CreateSparse(fvm::kSparseFlagLz4, DEFAULT_SLICE_SIZE, false /* enable_data */));
+
+    fbl::unique_fd fd(open(sparse_lz4_path, O_RDONLY));
+    ASSERT_TRUE(fd);
+    fbl::unique_ptr<fvm::SparseReader> reader;
+    ASSERT_EQ(fvm::SparseReader::CreateSilent(std::move(fd), &reader), ZX_OK);
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[DEFAULT_SLICE_SIZE]);
+    size_t total = 0;
+    size_t actual;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    zx_status_t status;
+    while ((status = reader->ReadData(data.get(), DEFAULT_SLICE_SIZE, &actual)) == ZX_OK) {
+        total += actual;
+    }
+    double seconds = SecondsSince(start);
+    ASSERT_EQ(status, ZX_ERR_OUT_OF_RANGE);
+    reader.reset();
+    printf("\ndecompressed %zu bytes in %.3f s: %.1f MB/s\n", total, seconds,
+           static_cast<double>(total) / seconds / 1e6);
+
+    SparseContainer sparseContainer(sparse_lz4_path, 0, 0);
+    size_t disk_size = sparseContainer.CalculateDiskSize();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ASSERT_EQ(sparseContainer.Pave(fvm_path, 0, 0), ZX_OK);
+    seconds = SecondsSince(start);
+    printf("paved %zu bytes in %.3f s: %.1f MB/s\n", disk_size, seconds,
+           static_cast<double>(disk_size) / seconds / 1e6);
+
+    ASSERT_TRUE(DestroyFvm());
+    ASSERT_TRUE(DestroySparse(fvm::kSparseFlagLz4));
+    END_TEST;
+}
+
 // Paving an FVM with a data partition will fail since we zxcrypt is not currently implemented on
 // host.
 // TODO(planders): Once we are able to create zxcrypt'd FVM images on host, remove this test.
@@ -820,6 +866,7 @@ RUN_TEST_MEDIUM(TestBlobfsCompressor)
 RUN_ALL_PAVE(8192)
 RUN_ALL_PAVE(DEFAULT_SLICE_SIZE)
 RUN_TEST_MEDIUM(TestPaveZxcryptFail)
+RUN_TEST_PERFORMANCE(TestPavePerformance)
 END_TEST_CASE(fvm_host_tests)
 
 int main(int argc, char** argv) {
@@ -7,9 +7,16 @@
 #include <fuchsia/logger/c/fidl.h>
 #include <lib/async-loop/cpp/loop.h>
 #include <lib/syslog/global.h>
+#include <lib/syslog/wire_format.h>
+#include <lib/zx/handle.h>
+#include <lib/zx/socket.h>
+#include <lib/zx/time.h>
 #include <unittest/unittest.h>
 
 #include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
 
 #include <utility>
 
@@ -96,6 +103,39 @@ public:
         return true;
     }
 
+    bool CreateRingLogger(fx_logger_t** out_logger) {
+        ASSERT_TRUE(logger_handle_);
+        fx_logger_config_t config = {.min_severity = FX_LOG_INFO,
+                                     .console_fd = -1,
+                                     .log_service_channel = ZX_HANDLE_INVALID,
+                                     .tags = nullptr,
+                                     .num_tags = 0};
+        ASSERT_EQ(ZX_OK, fx_logger_create_with_ring(&config, logger_handle_.release(),
+                                                    out_logger));
+        return true;
+    }
+
+    bool CreateSocketLogger(fx_logger_t** out_logger) {
+        ASSERT_TRUE(socket_);
+        fx_logger_config_t config = {.min_severity = FX_LOG_INFO,
+                                     .console_fd = -1,
+                                     .log_service_channel = socket_.release(),
+                                     .tags = nullptr,
+                                     .num_tags = 0};
+        ASSERT_EQ(ZX_OK, fx_logger_create(&config, out_logger));
+        return true;
+    }
+
+    bool StartLoopThread() {
+        ASSERT_EQ(ZX_OK, loop_.StartThread("logger-test-loop"));
+        return true;
+    }
+
+    void StopLoopThread() {
+        loop_.Quit();
+        loop_.JoinThreads();
+    }
+
     bool FullSetup() {
         ASSERT_TRUE(CreateLogger());
         ASSERT_TRUE(ConnectToLogger());
@@ -235,6 +275,144 @@ bool TestLoggerDiesWithChannelWhenNoConnectCalled(void) {
     END_TEST;
 }
 
+bool TestLogWithRing(void) {
+    BEGIN_TEST;
+    Fixture fixture;
+    ASSERT_TRUE(fixture.CreateLogger());
+    fx_logger_t* logger;
+    ASSERT_TRUE(fixture.CreateRingLogger(&logger));
+    fixture.RunLoop();
+    fx_logger_log(logger, FX_LOG_INFO, "tag", "test_message");
+    fixture.RunLoop();
+    const char* out = fixture.read_buffer();
+    EXPECT_TRUE(ends_with(out, "[tag] INFO: test_message\n"), out);
+    fx_logger_destroy(logger);
+    END_TEST;
+}
+
+bool TestLogWhenRingIsFull(void) {
+    BEGIN_TEST;
+    Fixture fixture;
+    ASSERT_TRUE(fixture.CreateLogger());
+    fx_logger_t* logger;
+    ASSERT_TRUE(fixture.CreateRingLogger(&logger));
+    fixture.RunLoop();
+    // Messages which do not fit in the ring go through the socket.
+    constexpr int kMessages = FX_LOG_RING_SLOTS + 2;
+    for (int i = 0; i < kMessages; i++) {
+        fx_logger_logf(logger, FX_LOG_INFO, nullptr, "%d", i);
+    }
+    fixture.RunLoop();
+    const char* out = fixture.read_buffer();
+    int lines = 0;
+    for (const char* p = out; *p != '\0'; p++) {
+        lines += (*p == '\n');
+    }
+    EXPECT_EQ(kMessages, lines, out);
+    fx_logger_destroy(logger);
+    END_TEST;
+}
+
+bool TestLogBeforeRingIsAccepted(void) {
+    BEGIN_TEST;
+    Fixture fixture;
+    ASSERT_TRUE(fixture.CreateLogger());
+    fx_logger_t* logger;
+    ASSERT_TRUE(fixture.CreateRingLogger(&logger));
+    // The log service has yet to map the ring, so this goes through the
+    // socket.
+    fx_logger_log(logger, FX_LOG_INFO, "tag", "test_message");
+    fixture.RunLoop();
+    const char* out = fixture.read_buffer();
+    EXPECT_TRUE(ends_with(out, "[tag] INFO: test_message\n"), out);
+    fx_logger_destroy(logger);
+    END_TEST;
+}
+
+bool TestLogWhenRingIsNotAccepted(void) {
+    BEGIN_TEST;
+    // Stand in for a log service which takes the socket but never maps the
+    // ring.
+    zx::channel sink, sink_request;
+    ASSERT_EQ(ZX_OK, zx::channel::create(0, &sink, &sink_request));
+    fx_logger_config_t config = {.min_severity = FX_LOG_INFO,
+                                 .console_fd = -1,
+                                 .log_service_channel = ZX_HANDLE_INVALID,
+                                 .tags = nullptr,
+                                 .num_tags = 0};
+    fx_logger_t* logger;
+    ASSERT_EQ(ZX_OK, fx_logger_create_with_ring(&config, sink.release(), &logger));
+
+    fuchsia_logger_LogSinkConnectWithRingRequest req;
+    zx_handle_t handles[2];
+    uint32_t actual_bytes, actual_handles;
+    ASSERT_EQ(ZX_OK, sink_request.read(0, &req, sizeof(req), &actual_bytes, handles, 2,
+                                       &actual_handles));
+    ASSERT_EQ(2u, actual_handles);
+    zx::socket socket(handles[0]);
+    zx::handle ring(handles[1]);
+
+    fx_logger_log(logger, FX_LOG_INFO, "tag", "test_message");
+    fx_log_packet_t packet;
+    size_t actual;
+    ASSERT_EQ(ZX_OK, socket.read(0, &packet, sizeof(packet), &actual));
+    const char kMessage[] = "test_message";
+    EXPECT_NONNULL(memmem(packet.data, actual - sizeof(packet.metadata), kMessage,
+                          sizeof(kMessage)));
+    fx_logger_destroy(logger);
+    END_TEST;
+}
+
+constexpr int kBenchmarkMessages = 20000;
+constexpr int kMaxBenchmarkThreads = 4;
+
+int LogMessages(void* arg) {
+    auto logger = static_cast<fx_logger_t*>(arg);
+    for (int i = 0; i < kBenchmarkMessages; i++) {
+        fx_logger_logf(logger, FX_LOG_INFO, nullptr, "benchmark message %d", i);
+    }
+    return 0;
+}
+
+// Returns the number of messages per second each of |num_threads| threads
+// writes to |logger|.
+double MessagesPerSecond(fx_logger_t* logger, int num_threads) {
+    thrd_t threads[kMaxBenchmarkThreads];
+    zx::time start = zx::clock::get_monotonic();
+    for (int i = 0; i < num_threads; i++) {
+        thrd_create(&threads[i], LogMessages, logger);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        thrd_join(threads[i], nullptr);
+    }
+    zx::duration elapsed = zx::clock::get_monotonic() - start;
+    return kBenchmarkMessages / (static_cast<double>(elapsed.to_nsecs()) / ZX_SEC(1));
+}
+
+bool TestLogPerformance(void) {
+    BEGIN_TEST;
+    for (int ring = 0; ring < 2; ring++) {
+        Fixture fixture;
+        ASSERT_TRUE(fixture.CreateLogger());
+        fx_logger_t* logger;
+        if (ring) {
+            ASSERT_TRUE(fixture.CreateRingLogger(&logger));
+        } else {
+            ASSERT_TRUE(fixture.ConnectToLogger());
+            ASSERT_TRUE(fixture.CreateSocketLogger(&logger));
+        }
+        ASSERT_TRUE(fixture.StartLoopThread());
+        for (int threads = 1; threads <= kMaxBenchmarkThreads; threads *= 2) {
+            printf("\n%s, %d threads: %.0f messages/sec per thread",
+                   ring ? "ring" : "socket", threads, MessagesPerSecond(logger, threads));
+        }
+        fixture.StopLoopThread();
+        fx_logger_destroy(logger);
+    }
+    printf("\n");
+    END_TEST;
+}
+
 } // namespace
 
 BEGIN_TEST_CASE(logger_tests)
@@ -246,6 +424,11 @@ RUN_TEST(TestLogWithMultipleTags)
 RUN_TEST(TestLogWhenLoggerHandleDies)
 RUN_TEST(TestLoggerDiesWithSocket)
 RUN_TEST(TestLoggerDiesWithChannelWhenNoConnectCalled)
+RUN_TEST(TestLogWithRing)
+RUN_TEST(TestLogWhenRingIsFull)
+RUN_TEST(TestLogBeforeRingIsAccepted)
+RUN_TEST(TestLogWhenRingIsNotAccepted)
+RUN_TEST_PERFORMANCE(TestLogPerformance)
 END_TEST_CASE(logger_tests)
 
 int main(int argc, char** argv) {
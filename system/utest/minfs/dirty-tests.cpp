@@ -0,0 +1,118 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Tests for writes whose allocation MinFS delays until they are flushed, when the
+// filesystem runs out of space. The fixture checks the filesystem with fsck after each test.
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/string.h>
+#include <fbl/string_buffer.h>
+#include <fbl/unique_fd.h>
+#include <fs-test-utils/fixture.h>
+#include <fs-test-utils/unittest.h>
+#include <minfs/format.h>
+#include <unittest/unittest.h>
+
+namespace minfs {
+namespace {
+
+// Small enough to fill quickly: most of it holds the inode table and the journal.
+constexpr size_t kRamdiskBlocks = 1 << 15;
+
+fs_test_utils::FixtureOptions SmallOptions() {
+    fs_test_utils::FixtureOptions options =
+        fs_test_utils::FixtureOptions::Default(DISK_FORMAT_MINFS);
+    options.ramdisk_block_count = kRamdiskBlocks;
+    return options;
+}
+
+fs_test_utils::FixtureOptions SmallExtentOptions() {
+    fs_test_utils::FixtureOptions options = SmallOptions();
+    options.minfs_extents = true;
+    return options;
+}
+
+fbl::String FilePath(fs_test_utils::Fixture* fixture, const char* name) {
+    fbl::StringBuffer<PATH_MAX> path;
+    path.AppendPrintf("%s/%s", fixture->fs_path().c_str(), name);
+    return path.ToString();
+}
+
+void FillBlock(uint8_t seed, blk_t n, uint8_t* block) {
+    for (size_t i = 0; i < kMinfsBlockSize; i++) {
+        block[i] = static_cast<uint8_t>(seed + n + i);
+    }
+}
+
+// Writes one block at a time to two files, so that both are fragmented, until the
+// filesystem is full. Flushing them may then fail as well, but must never persist a size
+// which covers blocks that were not written back.
+bool TestFillDiskWhileDelayed(fs_test_utils::Fixture* fixture) {
+    BEGIN_TEST;
+    fbl::String paths[2] = {FilePath(fixture, "a"), FilePath(fixture, "b")};
+    fbl::unique_fd fds[2];
+    for (uint8_t f = 0; f < 2; f++) {
+        fds[f].reset(open(paths[f].c_str(), O_CREAT | O_RDWR));
+        ASSERT_TRUE(fds[f]);
+    }
+
+    uint8_t block[kMinfsBlockSize];
+    blk_t written[2] = {0, 0};
+    bool full = false;
+    for (blk_t n = 0; !full; n++) {
+        ASSERT_LT(n, kRamdiskBlocks, "the filesystem never filled up");
+        for (uint8_t f = 0; f < 2 && !full; f++) {
+            FillBlock(f, n, block);
+            if (pwrite(fds[f].get(), block, sizeof(block), static_cast<off_t>(n) * sizeof(block))
+                != static_cast<ssize_t>(sizeof(block))) {
+                full = true;
+            } else {
+                written[f] = n + 1;
+            }
+        }
+    }
+    for (uint8_t f = 0; f < 2; f++) {
+        // Either may fail with the filesystem full.
+        fsync(fds[f].get());
+        fds[f].reset();
+    }
+
+    ASSERT_EQ(fixture->Remount(), ZX_OK);
+    uint8_t actual[kMinfsBlockSize];
+    for (uint8_t f = 0; f < 2; f++) {
+        fds[f].reset(open(paths[f].c_str(), O_RDONLY));
+        ASSERT_TRUE(fds[f]);
+        struct stat s;
+        ASSERT_EQ(fstat(fds[f].get(), &s), 0);
+        ASSERT_LE(s.st_size, static_cast<off_t>(written[f] + 1) * kMinfsBlockSize);
+        const blk_t blocks = fbl::min(written[f],
+                                      static_cast<blk_t>(s.st_size / kMinfsBlockSize));
+        for (blk_t n = 0; n < blocks; n++) {
+            FillBlock(f, n, block);
+            ASSERT_EQ(pread(fds[f].get(), actual, sizeof(actual),
+                            static_cast<off_t>(n) * sizeof(actual)),
+                      static_cast<ssize_t>(sizeof(actual)));
+            ASSERT_EQ(memcmp(block, actual, sizeof(actual)), 0, "lost a written block");
+        }
+        fds[f].reset();
+        ASSERT_EQ(unlink(paths[f].c_str()), 0);
+    }
+    END_TEST;
+}
+
+BEGIN_FS_TEST_CASE(minfs_dirty_tests, SmallOptions)
+RUN_FS_TEST_F(TestFillDiskWhileDelayed)
+END_FS_TEST_CASE(minfs_dirty_tests, SmallOptions)
+
+BEGIN_FS_TEST_CASE(minfs_dirty_tests, SmallExtentOptions)
+RUN_FS_TEST_F(TestFillDiskWhileDelayed)
+END_FS_TEST_CASE(minfs_dirty_tests, SmallExtentOptions)
+
+} // namespace
+} // namespace minfs
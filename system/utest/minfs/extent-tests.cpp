@@ -0,0 +1,150 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Tests for files which MinFS maps with extents, and their conversion to block pointers.
+// The fixture checks the filesystem with fsck after each test.
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/string.h>
+#include <fbl/string_buffer.h>
+#include <fbl/unique_fd.h>
+#include <fs-test-utils/fixture.h>
+#include <fs-test-utils/unittest.h>
+#include <minfs/format.h>
+#include <unittest/unittest.h>
+
+namespace minfs {
+namespace {
+
+fs_test_utils::FixtureOptions ExtentOptions() {
+    fs_test_utils::FixtureOptions options =
+        fs_test_utils::FixtureOptions::Default(DISK_FORMAT_MINFS);
+    options.minfs_extents = true;
+    options.ramdisk_block_count = 1 << 16;
+    return options;
+}
+
+fbl::String FilePath(fs_test_utils::Fixture* fixture, const char* name) {
+    fbl::StringBuffer<PATH_MAX> path;
+    path.AppendPrintf("%s/%s", fixture->fs_path().c_str(), name);
+    return path.ToString();
+}
+
+void FillBlock(uint8_t seed, blk_t n, uint8_t* block) {
+    for (size_t i = 0; i < kMinfsBlockSize; i++) {
+        block[i] = static_cast<uint8_t>(seed + n + i);
+    }
+}
+
+bool WriteBlock(int fd, uint8_t seed, blk_t n) {
+    BEGIN_HELPER;
+    uint8_t block[kMinfsBlockSize];
+    FillBlock(seed, n, block);
+    ASSERT_EQ(pwrite(fd, block, sizeof(block), static_cast<off_t>(n) * kMinfsBlockSize),
+              static_cast<ssize_t>(sizeof(block)));
+    END_HELPER;
+}
+
+bool VerifyBlock(int fd, uint8_t seed, blk_t n) {
+    BEGIN_HELPER;
+    uint8_t expected[kMinfsBlockSize];
+    uint8_t actual[kMinfsBlockSize];
+    FillBlock(seed, n, expected);
+    ASSERT_EQ(pread(fd, actual, sizeof(actual), static_cast<off_t>(n) * kMinfsBlockSize),
+              static_cast<ssize_t>(sizeof(actual)));
+    ASSERT_EQ(memcmp(expected, actual, sizeof(actual)), 0, "unexpected file contents");
+    END_HELPER;
+}
+
+// Interleaving the writes of two files fragments both of them, so that each needs more
+// extents than the inode can hold.
+bool TestFragmentedFilesConvert(fs_test_utils::Fixture* fixture) {
+    BEGIN_TEST;
+    constexpr blk_t kBlocks = kMinfsExtents * 3;
+    fbl::String paths[2] = {FilePath(fixture, "a"), FilePath(fixture, "b")};
+    fbl::unique_fd fds[2];
+    for (uint8_t f = 0; f < 2; f++) {
+        fds[f].reset(open(paths[f].c_str(), O_CREAT | O_RDWR));
+        ASSERT_TRUE(fds[f]);
+    }
+
+    for (blk_t n = 0; n < kBlocks; n++) {
+        for (uint8_t f = 0; f < 2; f++) {
+            ASSERT_TRUE(WriteBlock(fds[f].get(), f, n));
+        }
+    }
+    for (uint8_t f = 0; f < 2; f++) {
+        ASSERT_EQ(fsync(fds[f].get()), 0);
+        for (blk_t n = 0; n < kBlocks; n++) {
+            ASSERT_TRUE(VerifyBlock(fds[f].get(), f, n));
+        }
+        fds[f].reset();
+    }
+
+    ASSERT_EQ(fixture->Remount(), ZX_OK);
+    for (uint8_t f = 0; f < 2; f++) {
+        fds[f].reset(open(paths[f].c_str(), O_RDONLY));
+        ASSERT_TRUE(fds[f]);
+        for (blk_t n = 0; n < kBlocks; n++) {
+            ASSERT_TRUE(VerifyBlock(fds[f].get(), f, n));
+        }
+        ASSERT_EQ(unlink(paths[f].c_str()), 0);
+    }
+    END_TEST;
+}
+
+// Each block of a sparse file lands in a different indirect block once converted, and the
+// last ones in the doubly indirect range, so the conversion dirties more blocks than fit
+// within a single journal entry.
+bool TestSparseFileConvertsInParts(fs_test_utils::Fixture* fixture) {
+    BEGIN_TEST;
+    constexpr blk_t kStride = 4000;
+    constexpr blk_t kWrites = kMinfsExtents + 4;
+    static_assert(kStride * (kWrites - 1) >
+                  kMinfsDirect + kMinfsIndirect * kMinfsDirectPerIndirect,
+                  "The file should reach the doubly indirect blocks");
+    constexpr uint8_t kSeed = 7;
+    fbl::String path = FilePath(fixture, "sparse");
+    fbl::unique_fd fd(open(path.c_str(), O_CREAT | O_RDWR));
+    ASSERT_TRUE(fd);
+
+    for (blk_t i = 0; i < kWrites; i++) {
+        ASSERT_TRUE(WriteBlock(fd.get(), kSeed, i * kStride));
+    }
+    ASSERT_EQ(fsync(fd.get()), 0);
+    for (blk_t i = 0; i < kWrites; i++) {
+        ASSERT_TRUE(VerifyBlock(fd.get(), kSeed, i * kStride));
+    }
+    fd.reset();
+
+    ASSERT_EQ(fixture->Remount(), ZX_OK);
+    fd.reset(open(path.c_str(), O_RDWR));
+    ASSERT_TRUE(fd);
+    for (blk_t i = 0; i < kWrites; i++) {
+        ASSERT_TRUE(VerifyBlock(fd.get(), kSeed, i * kStride));
+    }
+
+    // The holes between the blocks still read back as zeroes.
+    uint8_t zeroes[kMinfsBlockSize] = {};
+    uint8_t actual[kMinfsBlockSize];
+    ASSERT_EQ(pread(fd.get(), actual, sizeof(actual), kMinfsBlockSize),
+              static_cast<ssize_t>(sizeof(actual)));
+    ASSERT_EQ(memcmp(zeroes, actual, sizeof(actual)), 0);
+
+    ASSERT_EQ(ftruncate(fd.get(), 0), 0);
+    fd.reset();
+    ASSERT_EQ(unlink(path.c_str()), 0);
+    END_TEST;
+}
+
+BEGIN_FS_TEST_CASE(minfs_extent_tests, ExtentOptions)
+RUN_FS_TEST_F(TestFragmentedFilesConvert)
+RUN_FS_TEST_F(TestSparseFileConvertsInParts)
+END_FS_TEST_CASE(minfs_extent_tests, ExtentOptions)
+
+} // namespace
+} // namespace minfs
@@ -0,0 +1,332 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Tests for the MinFS metadata journal, driven directly against a ramdisk.
+
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <fs-management/ramdisk.h>
+#include <lib/fzl/owned-vmo-mapper.h>
+#include <minfs/bcache.h>
+#include <minfs/block-txn.h>
+#include <minfs/format.h>
+#include <minfs/fsck.h>
+#include <minfs/journal.h>
+#include <minfs/minfs.h>
+#include <unittest/unittest.h>
+
+#include <utility>
+
+namespace minfs {
+namespace {
+
+constexpr uint64_t kDeviceBlockSize = 512;
+constexpr uint64_t kDeviceBlockCount = 1 << 16;
+constexpr size_t kBufferBlocks = 256;
+
+// A WriteTxn which may be issued directly, as the writeback thread would.
+class TestTxn : public WriteTxn {
+public:
+    explicit TestTxn(Bcache* bc) : WriteTxn(bc) {}
+
+    // Writes the remaining requests to their final location.
+    zx_status_t Write(zx_handle_t vmo, vmoid_t vmoid) { return Flush(vmo, vmoid); }
+
+    // Drops the remaining requests, as if the device lost power before they were written.
+    void Drop() { Requests().reset(); }
+};
+
+// A freshly formatted ramdisk, along with a writeback-style buffer attached to it.
+class JournalTest {
+public:
+    ~JournalTest() {
+        journal_.reset();
+        bc_.reset();
+        if (ramdisk_path_[0] != '\0') {
+            destroy_ramdisk(ramdisk_path_);
+        }
+    }
+
+    bool Init() {
+        BEGIN_HELPER;
+        ASSERT_EQ(create_ramdisk(kDeviceBlockSize, kDeviceBlockCount, ramdisk_path_), ZX_OK);
+        fbl::unique_ptr<Bcache> bc;
+        ASSERT_TRUE(OpenBcache(&bc));
+        ASSERT_EQ(Mkfs(std::move(bc)), ZX_OK);
+        ASSERT_EQ(buffer_.CreateAndMap(kBufferBlocks * kMinfsBlockSize, "journal-test"), ZX_OK);
+        ASSERT_TRUE(Reopen());
+        END_HELPER;
+    }
+
+    // Discards the current journal and block cache without checkpointing, as a crash
+    // would, then reads the filesystem back from disk.
+    bool Reopen() {
+        BEGIN_HELPER;
+        journal_.reset();
+        bc_.reset();
+        ASSERT_TRUE(OpenBcache(&bc_));
+        ASSERT_EQ(bc_->Readblk(0, &info_), ZX_OK);
+        ASSERT_EQ(Journal::Create(bc_.get(), info_, &journal_), ZX_OK);
+        ASSERT_EQ(bc_->AttachVmo(buffer_.vmo(), &vmoid_), ZX_OK);
+        END_HELPER;
+    }
+
+    // Closes the block cache, handing the device to |Fsck|.
+    bool TakeBcache(fbl::unique_ptr<Bcache>* out) {
+        BEGIN_HELPER;
+        journal_.reset();
+        bc_.reset();
+        ASSERT_TRUE(OpenBcache(out));
+        END_HELPER;
+    }
+
+    void* Block(size_t vmo_block) {
+        return static_cast<uint8_t*>(buffer_.start()) + vmo_block * kMinfsBlockSize;
+    }
+
+    // Fills |count| blocks of the buffer, starting at |vmo_block|, with |value|.
+    void Fill(size_t vmo_block, size_t count, uint8_t value) {
+        memset(Block(vmo_block), value, count * kMinfsBlockSize);
+    }
+
+    // Asserts that every byte of blocks [|bno|, |bno| + |count|) on disk holds |value|.
+    bool ExpectBlocks(blk_t bno, size_t count, uint8_t value) {
+        BEGIN_HELPER;
+        uint8_t expected[kMinfsBlockSize];
+        memset(expected, value, sizeof(expected));
+        for (size_t i = 0; i < count; i++) {
+            uint8_t blk[kMinfsBlockSize];
+            ASSERT_EQ(bc_->Readblk(static_cast<blk_t>(bno + i), blk), ZX_OK);
+            ASSERT_EQ(memcmp(blk, expected, sizeof(blk)), 0);
+        }
+        END_HELPER;
+    }
+
+    bool ExpectPending(size_t expected) {
+        BEGIN_HELPER;
+        size_t pending;
+        ASSERT_EQ(Journal::CountPending(bc_.get(), info_, &pending), ZX_OK);
+        ASSERT_EQ(pending, expected);
+        END_HELPER;
+    }
+
+    zx_status_t Commit(TestTxn* txn) {
+        WriteTxn* txns[] = {txn};
+        return journal_->Commit(txns, 1, buffer_.start(), vmoid_);
+    }
+
+    // Inode table blocks past the root inode, which a fresh filesystem leaves zeroed.
+    blk_t MetadataTarget() const { return info_.ino_block + 1; }
+
+    Bcache* bc() { return bc_.get(); }
+    Journal* journal() { return journal_.get(); }
+    const Superblock& info() const { return info_; }
+    zx_handle_t vmo() const { return buffer_.vmo().get(); }
+    vmoid_t vmoid() const { return vmoid_; }
+
+private:
+    bool OpenBcache(fbl::unique_ptr<Bcache>* out) {
+        BEGIN_HELPER;
+        fbl::unique_fd fd(open(ramdisk_path_, O_RDWR));
+        ASSERT_TRUE(fd);
+        uint32_t blocks = static_cast<uint32_t>(kDeviceBlockCount * kDeviceBlockSize /
+                                                kMinfsBlockSize);
+        ASSERT_EQ(Bcache::Create(out, std::move(fd), blocks), ZX_OK);
+        END_HELPER;
+    }
+
+    char ramdisk_path_[PATH_MAX] = {};
+    fbl::unique_ptr<Bcache> bc_;
+    fbl::unique_ptr<Journal> journal_;
+    Superblock info_;
+    fzl::OwnedVmoMapper buffer_;
+    vmoid_t vmoid_ = VMOID_INVALID;
+};
+
+bool TestReplayCommittedEntry() {
+    BEGIN_TEST;
+    JournalTest test;
+    ASSERT_TRUE(test.Init());
+    const blk_t target = test.MetadataTarget();
+    const blk_t data = test.info().dat_block + 100;
+
+    test.Fill(0, 4, 0xab);
+    test.Fill(4, 1, 0xcd);
+    TestTxn txn(test.bc());
+    txn.Enqueue(test.vmo(), 0, target, 4);
+    txn.EnqueueData(test.vmo(), 4, data, 1);
+    ASSERT_EQ(test.Commit(&txn), ZX_OK);
+
+    // File data goes straight to its final location; only metadata is left to the caller.
+    ASSERT_EQ(txn.Requests().size(), 1u);
+    ASSERT_TRUE(test.ExpectBlocks(data, 1, 0xcd));
+    ASSERT_TRUE(test.ExpectBlocks(target, 4, 0));
+    txn.Drop();
+
+    ASSERT_TRUE(test.Reopen());
+    ASSERT_TRUE(test.ExpectPending(1));
+    ASSERT_EQ(Journal::Replay(test.bc(), test.info()), ZX_OK);
+    ASSERT_TRUE(test.ExpectBlocks(target, 4, 0xab));
+    ASSERT_TRUE(test.ExpectPending(0));
+
+    // Replaying an empty journal is a no-op.
+    ASSERT_EQ(Journal::Replay(test.bc(), test.info()), ZX_OK);
+    ASSERT_TRUE(test.ExpectBlocks(target, 4, 0xab));
+    END_TEST;
+}
+
+bool TestDataRegionMetadataJournaled() {
+    BEGIN_TEST;
+    JournalTest test;
+    ASSERT_TRUE(test.Init());
+    // Directory and indirect blocks live in the data region, but are metadata all the same.
+    const blk_t directory = test.info().dat_block + 100;
+
+    test.Fill(0, 1, 0x42);
+    TestTxn txn(test.bc());
+    txn.Enqueue(test.vmo(), 0, directory, 1);
+    ASSERT_EQ(test.Commit(&txn), ZX_OK);
+
+    // The block is only written to the journal, and left to the caller to write in place.
+    ASSERT_EQ(txn.BlkCount(), 1u);
+    ASSERT_TRUE(test.ExpectBlocks(directory, 1, 0));
+    txn.Drop();
+
+    ASSERT_TRUE(test.Reopen());
+    ASSERT_TRUE(test.ExpectPending(1));
+    ASSERT_EQ(Journal::Replay(test.bc(), test.info()), ZX_OK);
+    ASSERT_TRUE(test.ExpectBlocks(directory, 1, 0x42));
+    END_TEST;
+}
+
+bool TestTornEntryNotReplayed() {
+    BEGIN_TEST;
+    JournalTest test;
+    ASSERT_TRUE(test.Init());
+    const blk_t first = test.MetadataTarget();
+    const blk_t second = first + 1;
+
+    test.Fill(0, 1, 0x11);
+    TestTxn first_txn(test.bc());
+    first_txn.Enqueue(test.vmo(), 0, first, 1);
+    ASSERT_EQ(test.Commit(&first_txn), ZX_OK);
+    first_txn.Drop();
+
+    test.Fill(1, 1, 0x22);
+    TestTxn second_txn(test.bc());
+    second_txn.Enqueue(test.vmo(), 1, second, 1);
+    ASSERT_EQ(test.Commit(&second_txn), ZX_OK);
+    second_txn.Drop();
+
+    // Tear the second entry (header, block, commit) by corrupting its metadata block,
+    // so that it no longer matches the commit checksum.
+    uint8_t garbage[kMinfsBlockSize];
+    memset(garbage, 0x5a, sizeof(garbage));
+    const blk_t second_entry = test.info().journal_start_block + 1 + 3;
+    ASSERT_EQ(test.bc()->Writeblk(second_entry + 1, garbage), ZX_OK);
+
+    ASSERT_TRUE(test.Reopen());
+    ASSERT_TRUE(test.ExpectPending(1));
+    ASSERT_EQ(Journal::Replay(test.bc(), test.info()), ZX_OK);
+    ASSERT_TRUE(test.ExpectBlocks(first, 1, 0x11));
+    ASSERT_TRUE(test.ExpectBlocks(second, 1, 0));
+    ASSERT_TRUE(test.ExpectPending(0));
+    END_TEST;
+}
+
+bool TestWraparound() {
+    BEGIN_TEST;
+    JournalTest test;
+    ASSERT_TRUE(test.Init());
+    const blk_t target = test.MetadataTarget();
+
+    // Commit enough entries to wrap the entry area several times, writing each to its
+    // final location except the last.
+    constexpr size_t kEntryBlocks = 32;
+    const size_t entries_per_pass = (test.info().dat_block - test.info().journal_start_block - 1) /
+                                    (kEntryBlocks + 2);
+    ASSERT_GT(entries_per_pass, 0);
+    const size_t kEntries = entries_per_pass * 3 + 1;
+    for (size_t i = 1; i <= kEntries; i++) {
+        const uint8_t value = static_cast<uint8_t>(i);
+        test.Fill(0, kEntryBlocks, value);
+        TestTxn txn(test.bc());
+        txn.Enqueue(test.vmo(), 0, target, kEntryBlocks);
+        ASSERT_EQ(test.Commit(&txn), ZX_OK);
+        if (i == kEntries) {
+            txn.Drop();
+        } else {
+            ASSERT_EQ(txn.Write(test.vmo(), test.vmoid()), ZX_OK);
+        }
+    }
+
+    ASSERT_TRUE(test.Reopen());
+    ASSERT_TRUE(test.ExpectBlocks(target, kEntryBlocks, static_cast<uint8_t>(kEntries - 1)));
+    ASSERT_EQ(Journal::Replay(test.bc(), test.info()), ZX_OK);
+    ASSERT_TRUE(test.ExpectBlocks(target, kEntryBlocks, static_cast<uint8_t>(kEntries)));
+    ASSERT_TRUE(test.ExpectPending(0));
+    END_TEST;
+}
+
+bool TestOversizedEntryRefused() {
+    BEGIN_TEST;
+    JournalTest test;
+    ASSERT_TRUE(test.Init());
+    const blk_t target = test.MetadataTarget();
+    const size_t blocks = test.journal()->MaxEntryBlocks() + 1;
+    ASSERT_LE(blocks, kBufferBlocks);
+
+    test.Fill(0, blocks, 0xee);
+    TestTxn txn(test.bc());
+    txn.Enqueue(test.vmo(), 0, target, blocks);
+    ASSERT_EQ(test.Commit(&txn), ZX_ERR_OUT_OF_RANGE);
+
+    // Nothing was written, and the batch is left for the caller to discard.
+    ASSERT_EQ(txn.BlkCount(), blocks);
+    ASSERT_TRUE(test.ExpectBlocks(target, blocks, 0));
+    ASSERT_TRUE(test.ExpectPending(0));
+    txn.Drop();
+    END_TEST;
+}
+
+bool TestFsckReplaysOnlyOnRequest() {
+    BEGIN_TEST;
+    JournalTest test;
+    ASSERT_TRUE(test.Init());
+
+    // Journal an unmodified copy of the superblock, so the filesystem stays consistent.
+    ASSERT_EQ(test.bc()->Readblk(0, test.Block(0)), ZX_OK);
+    TestTxn txn(test.bc());
+    txn.Enqueue(test.vmo(), 0, 0, 1);
+    ASSERT_EQ(test.Commit(&txn), ZX_OK);
+    txn.Drop();
+
+    fbl::unique_ptr<Bcache> bc;
+    ASSERT_TRUE(test.TakeBcache(&bc));
+    ASSERT_EQ(Fsck(std::move(bc)), ZX_OK);
+    ASSERT_TRUE(test.Reopen());
+    ASSERT_TRUE(test.ExpectPending(1));
+
+    ASSERT_TRUE(test.TakeBcache(&bc));
+    ASSERT_EQ(Fsck(std::move(bc), true), ZX_OK);
+    ASSERT_TRUE(test.Reopen());
+    ASSERT_TRUE(test.ExpectPending(0));
+    END_TEST;
+}
+
+} // namespace
+} // namespace minfs
+
+BEGIN_TEST_CASE(minfs_journal_tests)
+RUN_TEST(minfs::TestReplayCommittedEntry)
+RUN_TEST(minfs::TestDataRegionMetadataJournaled)
+RUN_TEST(minfs::TestTornEntryNotReplayed)
+RUN_TEST(minfs::TestWraparound)
+RUN_TEST(minfs::TestOversizedEntryRefused)
+RUN_TEST(minfs::TestFsckReplaysOnlyOnRequest)
+END_TEST_CASE(minfs_journal_tests)
@@ -0,0 +1,62 @@
+# Copyright 2018 The Fuchsia Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+MODULE := $(LOCAL_DIR)
+
+MODULE_TYPE := usertest
+
+MODULE_USERTEST_GROUP := fs
+
+MODULE_NAME := minfs-unit-test
+
+MODULE_SRCS := \
+    $(LOCAL_DIR)/dirty-tests.cpp \
+    $(LOCAL_DIR)/extent-tests.cpp \
+    $(LOCAL_DIR)/journal-tests.cpp \
+    $(LOCAL_DIR)/main.cpp \
+
+MODULE_STATIC_LIBS := \
+    system/ulib/async \
+    system/ulib/async.cpp \
+    system/ulib/async-loop \
+    system/ulib/async-loop.cpp \
+    system/ulib/bitmap \
+    system/ulib/block-client \
+    system/ulib/digest \
+    system/ulib/fbl \
+    system/ulib/fidl \
+    system/ulib/fidl-async \
+    system/ulib/fidl-utils \
+    system/ulib/fs \
+    system/ulib/fs-test-utils \
+    system/ulib/fvm \
+    system/ulib/fzl \
+    system/ulib/gpt \
+    system/ulib/memfs \
+    system/ulib/memfs.cpp \
+    system/ulib/minfs \
+    system/ulib/perftest \
+    system/ulib/sync \
+    system/ulib/trace \
+    system/ulib/zircon-internal \
+    system/ulib/zx \
+    system/ulib/zxcpp \
+    third_party/ulib/cksum \
+
+MODULE_LIBS := \
+    system/ulib/async.default \
+    system/ulib/c \
+    system/ulib/fdio \
+    system/ulib/fs-management \
+    system/ulib/trace-engine \
+    system/ulib/unittest \
+    system/ulib/zircon \
+
+MODULE_FIDL_LIBS := \
+    system/fidl/fuchsia-io \
+    system/fidl/fuchsia-minfs \
+
+include make/module.mk
@@ -0,0 +1,50 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <digest/digest.h>
+#include <digest/merkle-tree.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <perftest/perftest.h>
+
+namespace {
+
+// Test performance of creating the Merkle tree for |size| bytes of data, as
+// blobfs does when a blob is written.
+bool MerkleTreeCreateTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    size_t tree_len = digest::MerkleTree::GetTreeLength(size);
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    fbl::unique_ptr<uint8_t[]> tree(new uint8_t[tree_len]);
+    memset(data.get(), 0x5a, size);
+
+    digest::Digest digest;
+    while (state->KeepRunning()) {
+        if (digest::MerkleTree::Create(data.get(), size, tree.get(), tree_len, &digest) !=
+            ZX_OK) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RegisterTests() {
+    // Each test is run many times, so the sizes are kept modest.  The larger
+    // sizes are hashed using several threads.
+    static const size_t kSizesMiB[] = {
+        1,
+        4,
+        16,
+    };
+    for (auto size : kSizesMiB) {
+        auto name = fbl::StringPrintf("MerkleTree/Create/%zuMiB", size);
+        perftest::RegisterTest(name.c_str(), MerkleTreeCreateTest, size << 20);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -13,17 +13,28 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/handle-creation-test.cpp \
     $(LOCAL_DIR)/malloc-test.cpp \
     $(LOCAL_DIR)/memcpy-test.cpp \
+    $(LOCAL_DIR)/merkle-tree-test.cpp \
     $(LOCAL_DIR)/mutex-test.cpp \
     $(LOCAL_DIR)/null-test.cpp \
     $(LOCAL_DIR)/process-test.cpp \
     $(LOCAL_DIR)/results-test.cpp \
     $(LOCAL_DIR)/runner-test.cpp \
     $(LOCAL_DIR)/sleep-test.cpp \
+    $(LOCAL_DIR)/string-generic.c \
+    $(LOCAL_DIR)/string-test.cpp \
     $(LOCAL_DIR)/syscalls-test.cpp \
     $(LOCAL_DIR)/timer-test.cpp \
 
 MODULE_NAME := perf-test
 
+# string-generic.c builds musl's generic string functions, with the flags
+# musl itself uses.
+MODULE_CFLAGS := \
+    -I. \
+    -Ithird_party/ulib/musl/src/internal \
+    -Wno-sign-compare \
+    -ffreestanding \
+
 MODULE_STATIC_LIBS := \
     system/ulib/async \
     system/ulib/async-loop \
@@ -39,6 +50,7 @@ MODULE_STATIC_LIBS := \
 MODULE_LIBS := \
     system/ulib/async.default \
     system/ulib/c \
+    system/ulib/digest \
     system/ulib/fdio \
     system/ulib/launchpad \
     system/ulib/trace-engine \
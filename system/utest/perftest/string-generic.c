@@ -0,0 +1,35 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// The generic C versions of the musl string functions which libc replaces
+// with SSE2 versions on x86-64, built under private names so that
+// string-test.cpp can compare the two.
+
+#define strlen generic_strlen
+#define memchr generic_memchr
+#define memcmp generic_memcmp
+#define __strchrnul generic_strchrnul
+
+#include "third_party/ulib/musl/src/string/memcmp.c"
+
+#include "third_party/ulib/musl/src/string/strlen.c"
+#undef ALIGN
+#undef ONES
+#undef HIGHS
+#undef HASZERO
+
+#include "third_party/ulib/musl/src/string/memchr.c"
+#undef SS
+#undef ALIGN
+#undef ONES
+#undef HIGHS
+#undef HASZERO
+
+// strchrnul.c also defines strchrnul as a weak alias of __strchrnul, which
+// is not wanted here.
+#include "libc.h"
+#undef weak_alias
+#define weak_alias(old, new)
+
+#include "third_party/ulib/musl/src/string/strchrnul.c"
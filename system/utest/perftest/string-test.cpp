@@ -0,0 +1,125 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <perftest/perftest.h>
+
+// The generic C versions of the functions which libc implements with SSE2
+// on x86-64, from string-generic.c.
+extern "C" {
+size_t generic_strlen(const char* s);
+void* generic_memchr(const void* src, int c, size_t n);
+char* generic_strchrnul(const char* s, int c);
+int generic_memcmp(const void* vl, const void* vr, size_t n);
+}
+
+namespace {
+
+// Functions which scan |size| bytes of |buf| and report the result, so
+// that they can be tested on the same data.
+using ScanFunc = size_t (*)(const char* buf, size_t size);
+
+size_t Strlen(const char* buf, size_t size) {
+    return strlen(buf);
+}
+
+size_t GenericStrlen(const char* buf, size_t size) {
+    return generic_strlen(buf);
+}
+
+size_t Strnlen(const char* buf, size_t size) {
+    return strnlen(buf, size + 1);
+}
+
+size_t Memchr(const char* buf, size_t size) {
+    return static_cast<const char*>(memchr(buf, 0, size + 1)) - buf;
+}
+
+size_t GenericMemchr(const char* buf, size_t size) {
+    return static_cast<const char*>(generic_memchr(buf, 0, size + 1)) - buf;
+}
+
+size_t Strchr(const char* buf, size_t size) {
+    return strchr(buf, 'b') - buf;
+}
+
+// strchr() is a wrapper around __strchrnul().
+size_t GenericStrchr(const char* buf, size_t size) {
+    return generic_strchrnul(buf, 'b') - buf;
+}
+
+size_t Memcmp(const char* buf, size_t size) {
+    // Compare the two halves of the string, which differ only in their
+    // final byte.
+    return memcmp(buf, buf + size / 2, size / 2);
+}
+
+size_t GenericMemcmp(const char* buf, size_t size) {
+    return generic_memcmp(buf, buf + size / 2, size / 2);
+}
+
+// Test performance of |func| on a string of |size| bytes, starting
+// |offset| bytes into an aligned buffer.
+bool ScanTest(perftest::RepeatState* state, ScanFunc func, size_t size, size_t offset) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> buf(new char[offset + size + 1]);
+    char* str = buf.get() + offset;
+    memset(str, 'a', size);
+    // Make the string's halves compare differently, and place the byte
+    // strchr() looks for at the end.
+    if (size > 0) {
+        str[size - 1] = 'b';
+    }
+    str[size] = '\0';
+
+    while (state->KeepRunning()) {
+        size_t result = func(str, size);
+        // Stop the compiler from optimizing away the call.
+        perftest::DoNotOptimize(result);
+        perftest::DoNotOptimize(str);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const struct {
+        const char* name;
+        ScanFunc func;
+    } kFuncs[] = {
+        {"Strlen", Strlen},
+        {"GenericStrlen", GenericStrlen},
+        {"Strnlen", Strnlen},
+        {"Memchr", Memchr},
+        {"GenericMemchr", GenericMemchr},
+        {"Strchr", Strchr},
+        {"GenericStrchr", GenericStrchr},
+        {"Memcmp", Memcmp},
+        {"GenericMemcmp", GenericMemcmp},
+    };
+    static const size_t kSizesBytes[] = {
+        16,
+        256,
+        4096,
+        65536,
+    };
+    static const size_t kOffsets[] = {
+        0,
+        7,
+    };
+    for (const auto& func : kFuncs) {
+        for (auto size : kSizesBytes) {
+            for (auto offset : kOffsets) {
+                auto name = fbl::StringPrintf("%s/%zubytes/%zuoffset", func.name, size, offset);
+                perftest::RegisterTest(name.c_str(), ScanTest, func.func, size, offset);
+            }
+        }
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -17,11 +17,27 @@ MODULE_NAME := spawn-test
 MODULE_SRCS := \
     $(LOCAL_DIR)/spawn.cpp \
 
+MODULE_FIDL_LIBS := \
+    system/fidl/fuchsia-process \
+
+MODULE_HEADER_DEPS := \
+    system/ulib/svc \
+
 MODULE_STATIC_LIBS := \
+    system/ulib/process-launcher \
+    system/ulib/async-loop.cpp \
+    system/ulib/async-loop \
+    system/ulib/async.cpp \
+    system/ulib/async \
+    system/ulib/fbl \
+    system/ulib/fidl \
+    system/ulib/zxcpp \
     system/ulib/zx \
 
 MODULE_LIBS := \
+    system/ulib/async.default \
     system/ulib/fdio \
+    system/ulib/launchpad \
     system/ulib/unittest \
     system/ulib/c \
     system/ulib/zircon \
@@ -5,15 +5,23 @@
 #include <unittest/unittest.h>
 
 #include <fcntl.h>
+#include <fuchsia/process/c/fidl.h>
+#include <launchpad/launchpad.h>
+#include <lib/async-loop/cpp/loop.h>
 #include <lib/fdio/io.h>
 #include <lib/fdio/spawn.h>
 #include <lib/fdio/util.h>
+#include <lib/process-launcher/launcher.h>
 #include <lib/zx/channel.h>
 #include <lib/zx/job.h>
 #include <lib/zx/process.h>
 #include <lib/zx/socket.h>
+#include <lib/zx/vmo.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <zircon/dlfcn.h>
 #include <zircon/limits.h>
 #include <zircon/processargs.h>
 #include <zircon/syscalls/policy.h>
@@ -600,6 +608,148 @@ static bool spawn_vmo_test(void) {
     END_TEST;
 }
 
+// Measures the time to launch a process and run it to completion. Much of
+// this is spent loading the child's shared libraries through the loader
+// service.
+static bool spawn_launch_performance_test(void) {
+    BEGIN_TEST;
+
+    constexpr int kIterations = 100;
+    const char* argv[] = {kSpawnChild, nullptr};
+    zx::process process;
+
+    zx_time_t start = zx_clock_get_monotonic();
+    for (int i = 0; i < kIterations; i++) {
+        zx_status_t status = fdio_spawn(ZX_HANDLE_INVALID, FDIO_SPAWN_CLONE_ALL, kSpawnChild,
+                                        argv, process.reset_and_get_address());
+        ASSERT_EQ(ZX_OK, status);
+        ASSERT_EQ(43, join(process));
+    }
+    zx_duration_t elapsed = zx_clock_get_monotonic() - start;
+
+    printf("\nlaunched %s in %.1f us on average\n", kSpawnChild,
+           static_cast<double>(elapsed) / kIterations / 1000.0);
+
+    END_TEST;
+}
+
+// Launches |executable| through |launcher| as fdio_spawn would, with
+// only a loader service, so that the child sees no arguments.
+static bool launch_with_launcher(const zx::channel& launcher, const zx::vmo& executable,
+                                 zx::process* process) {
+    BEGIN_HELPER;
+
+    struct {
+        FIDL_ALIGNDECL
+        fuchsia_process_LauncherAddHandlesRequest req;
+        fuchsia_process_HandleInfo info;
+    } handles_msg;
+    memset(&handles_msg, 0, sizeof(handles_msg));
+    handles_msg.req.hdr.ordinal = fuchsia_process_LauncherAddHandlesOrdinal;
+    handles_msg.req.handles.count = 1;
+    handles_msg.req.handles.data = reinterpret_cast<void*>(FIDL_ALLOC_PRESENT);
+    handles_msg.info.handle = FIDL_HANDLE_PRESENT;
+    handles_msg.info.id = PA_LDSVC_LOADER;
+    zx_handle_t ldsvc;
+    ASSERT_EQ(ZX_OK, dl_clone_loader_service(&ldsvc));
+    ASSERT_EQ(ZX_OK, launcher.write(0, &handles_msg, sizeof(handles_msg), &ldsvc, 1));
+
+    struct {
+        FIDL_ALIGNDECL
+        fuchsia_process_LauncherLaunchRequest req;
+        uint8_t name[FIDL_ALIGN(sizeof(kSpawnChild) - 1)];
+    } launch_msg;
+    memset(&launch_msg, 0, sizeof(launch_msg));
+    launch_msg.req.hdr.ordinal = fuchsia_process_LauncherLaunchOrdinal;
+    launch_msg.req.info.executable = FIDL_HANDLE_PRESENT;
+    launch_msg.req.info.job = FIDL_HANDLE_PRESENT;
+    launch_msg.req.info.name.size = sizeof(kSpawnChild) - 1;
+    launch_msg.req.info.name.data = reinterpret_cast<char*>(FIDL_ALLOC_PRESENT);
+    memcpy(launch_msg.name, kSpawnChild, sizeof(kSpawnChild) - 1);
+    zx::vmo vmo;
+    ASSERT_EQ(ZX_OK, executable.duplicate(ZX_RIGHT_SAME_RIGHTS, &vmo));
+    zx::job job;
+    ASSERT_EQ(ZX_OK, zx::job::default_job()->duplicate(ZX_RIGHT_SAME_RIGHTS, &job));
+    zx_handle_t launch_handles[] = {vmo.release(), job.release()};
+
+    struct {
+        FIDL_ALIGNDECL
+        fuchsia_process_LauncherLaunchResponse rsp;
+        uint8_t error_message[256];
+    } reply;
+    zx_channel_call_args_t args;
+    args.wr_bytes = &launch_msg;
+    args.wr_handles = launch_handles;
+    args.rd_bytes = &reply;
+    args.rd_handles = process->reset_and_get_address();
+    args.wr_num_bytes = sizeof(launch_msg);
+    args.wr_num_handles = 2;
+    args.rd_num_bytes = sizeof(reply);
+    args.rd_num_handles = 1;
+    uint32_t actual_bytes, actual_handles;
+    ASSERT_EQ(ZX_OK, launcher.call(0, zx::time::infinite(), &args,
+                                   &actual_bytes, &actual_handles));
+    ASSERT_EQ(ZX_OK, reply.rsp.result.status);
+    ASSERT_EQ(1u, actual_handles);
+
+    END_HELPER;
+}
+
+// Launches |kSpawnChild| |iterations| times through a process launcher
+// service running in this process, which uses the same launchpad as this
+// test, and returns the average time taken to launch the process and run
+// it to completion.
+static bool launcher_launch_time(int iterations, double* average_us) {
+    BEGIN_HELPER;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    ASSERT_EQ(ZX_OK, loop.StartThread());
+    zx::channel launcher, request;
+    ASSERT_EQ(ZX_OK, zx::channel::create(0, &launcher, &request));
+    const zx_service_provider_t* provider = launcher_get_service_provider();
+    ASSERT_EQ(ZX_OK, provider->ops->connect(nullptr, loop.dispatcher(),
+                                            fuchsia_process_Launcher_Name,
+                                            request.release()));
+
+    int fd = open(kSpawnChild, O_RDONLY);
+    ASSERT_GE(fd, 0);
+    zx::vmo executable;
+    ASSERT_EQ(ZX_OK, fdio_get_vmo_clone(fd, executable.reset_and_get_address()));
+    close(fd);
+
+    zx::process process;
+    zx_time_t start = zx_clock_get_monotonic();
+    for (int i = 0; i < iterations; i++) {
+        ASSERT_TRUE(launch_with_launcher(launcher, executable, &process));
+        ASSERT_EQ(42, join(process));
+    }
+    zx_duration_t elapsed = zx_clock_get_monotonic() - start;
+    *average_us = static_cast<double>(elapsed) / iterations / 1000.0;
+
+    END_HELPER;
+}
+
+// Compares launch times through the process launcher service with and
+// without launchpad's image cache, which the service enables.
+static bool launcher_image_cache_performance_test(void) {
+    BEGIN_TEST;
+
+    constexpr int kIterations = 100;
+    double uncached_us;
+    double cached_us;
+
+    bool old = launchpad_set_image_cache(false);
+    ASSERT_TRUE(launcher_launch_time(kIterations, &uncached_us));
+    launchpad_set_image_cache(true);
+    ASSERT_TRUE(launcher_launch_time(kIterations, &cached_us));
+    launchpad_set_image_cache(old);
+
+    printf("\nprocess launcher launched %s in %.1f us on average (%.1f us with image cache)\n",
+           kSpawnChild, uncached_us, cached_us);
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(spawn_tests)
 RUN_TEST(spawn_control_test)
 RUN_TEST(spawn_launcher_test)
@@ -612,6 +762,8 @@ RUN_TEST(spawn_actions_h_test)
 RUN_TEST(spawn_actions_name_test)
 RUN_TEST(spawn_errors_test)
 RUN_TEST(spawn_vmo_test)
+RUN_TEST_PERFORMANCE(spawn_launch_performance_test)
+RUN_TEST_PERFORMANCE(launcher_image_cache_performance_test)
 END_TEST_CASE(spawn_tests)
 
 int main(int argc, char** argv) {
@@ -0,0 +1,31 @@
+# Copyright 2018 The Fuchsia Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+MODULE := $(LOCAL_DIR)
+
+MODULE_TYPE := hosttest
+
+MODULE_NAME := zbi-tool-test
+
+MODULE_SRCS += \
+    $(LOCAL_DIR)/zbi-tool.cpp \
+
+# The test runs the zbi tool built for the host.
+MODULE_SRCDEPS += $(ZBI)
+MODULE_DEFINES := ZBI_TOOL=\"$(abspath $(ZBI))\"
+
+MODULE_COMPILEFLAGS := \
+    -Ithird_party/ulib/lz4/include \
+    -Isystem/ulib/fbl/include \
+    -Isystem/ulib/unittest/include \
+
+MODULE_HOST_LIBS := \
+    third_party/ulib/lz4.hostlib \
+    system/ulib/fbl.hostlib \
+    system/ulib/pretty.hostlib \
+    system/ulib/unittest.hostlib \
+
+include make/module.mk
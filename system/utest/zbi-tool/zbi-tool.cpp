@@ -0,0 +1,300 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <fbl/unique_fd.h>
+#include <lz4/lz4frame.h>
+#include <zircon/boot/image.h>
+
+#include <unittest/unittest.h>
+
+extern char** environ;
+
+namespace {
+
+// Enough input for several 1MiB frames, ending partway through a block.
+constexpr size_t kRamdiskSize = (3 << 20) + 12345;
+constexpr size_t kSmallSize = 1000;
+
+// An item of a ZBI file, with its payload decompressed.
+struct ZbiItem {
+    zbi_header_t header;
+    std::string payload;
+    std::string decompressed;
+    size_t frames = 0;
+};
+
+// Text with enough repetition to compress well, but not trivially.
+std::string MakeInput(size_t size, uint32_t seed) {
+    static const char* const kWords[] = {
+        "zircon ", "kernel ", "bootfs ", "ramdisk ", "frame ", "block ",
+        "compress ", "lz4 ", "\n",
+    };
+    std::string input;
+    while (input.size() < size) {
+        seed = seed * 1103515245 + 12345;
+        input.append(kWords[(seed >> 16) % countof(kWords)]);
+        if ((seed >> 8) % 7 == 0) {
+            input.append(std::to_string(seed));
+        }
+    }
+    input.resize(size);
+    return input;
+}
+
+class TempDir {
+public:
+    TempDir() {
+        const char* tmpdir = getenv("TMPDIR");
+        path_ = std::string(tmpdir ? tmpdir : "/tmp") + "/zbi-tool-test.XXXXXX";
+        if (!mkdtemp(&path_[0])) {
+            path_.clear();
+        }
+    }
+
+    ~TempDir() {
+        for (const auto& file : files_) {
+            unlink(file.c_str());
+        }
+        if (!path_.empty()) {
+            rmdir(path_.c_str());
+        }
+    }
+
+    bool ok() const { return !path_.empty(); }
+
+    std::string File(const char* name) {
+        files_.push_back(path_ + "/" + name);
+        return files_.back();
+    }
+
+private:
+    std::string path_;
+    std::vector<std::string> files_;
+};
+
+bool WriteFile(const std::string& path, const std::string& contents) {
+    fbl::unique_fd fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666));
+    return fd && write(fd.get(), contents.data(), contents.size()) ==
+                     static_cast<ssize_t>(contents.size());
+}
+
+bool ReadFile(const std::string& path, std::string* contents) {
+    fbl::unique_fd fd(open(path.c_str(), O_RDONLY));
+    struct stat st;
+    if (!fd || fstat(fd.get(), &st) != 0) {
+        return false;
+    }
+    contents->resize(st.st_size);
+    return read(fd.get(), &(*contents)[0], contents->size()) == st.st_size;
+}
+
+// Runs the zbi tool with |args| and returns its exit status.
+int RunZbi(std::vector<std::string> args) {
+    args.insert(args.begin(), ZBI_TOOL);
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+    pid_t pid;
+    if (posix_spawn(&pid, ZBI_TOOL, nullptr, nullptr, argv.data(), environ) != 0) {
+        return -1;
+    }
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+// Decompresses a series of LZ4 frames, counting them.
+bool Decompress(const std::string& compressed, std::string* out, size_t* frames) {
+    LZ4F_decompressionContext_t ctx;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION))) {
+        return false;
+    }
+    const char* src = compressed.data();
+    size_t src_left = compressed.size();
+    char buffer[64 << 10];
+    bool ok = true;
+    *frames = 0;
+    while (ok && src_left > 0) {
+        size_t dst_size = sizeof(buffer), src_size = src_left;
+        size_t hint = LZ4F_decompress(ctx, buffer, &dst_size, src, &src_size, nullptr);
+        if (LZ4F_isError(hint)) {
+            ok = false;
+            break;
+        }
+        out->append(buffer, dst_size);
+        src += src_size;
+        src_left -= src_size;
+        if (hint == 0) {
+            // The end of a frame.
+            ++*frames;
+        } else if (src_size == 0 && dst_size == 0) {
+            // The last frame is truncated.
+            ok = false;
+        }
+    }
+    LZ4F_freeDecompressionContext(ctx);
+    return ok;
+}
+
+bool ReadZbi(const std::string& path, std::vector<ZbiItem>* items) {
+    BEGIN_HELPER;
+
+    std::string contents;
+    ASSERT_TRUE(ReadFile(path, &contents));
+    ASSERT_GE(contents.size(), sizeof(zbi_header_t));
+    zbi_header_t container;
+    memcpy(&container, contents.data(), sizeof(container));
+    ASSERT_EQ(ZBI_TYPE_CONTAINER, container.type);
+    ASSERT_EQ(contents.size(), sizeof(container) + container.length);
+
+    size_t pos = sizeof(container);
+    while (pos < contents.size()) {
+        ZbiItem item;
+        ASSERT_GE(contents.size() - pos, sizeof(item.header));
+        memcpy(&item.header, contents.data() + pos, sizeof(item.header));
+        pos += sizeof(item.header);
+        ASSERT_GE(contents.size() - pos, item.header.length);
+        item.payload = contents.substr(pos, item.header.length);
+        pos += ZBI_ALIGN(item.header.length);
+        if (item.header.flags & ZBI_FLAG_STORAGE_COMPRESSED) {
+            ASSERT_TRUE(Decompress(item.payload, &item.decompressed, &item.frames));
+            ASSERT_EQ(item.header.extra, item.decompressed.size());
+        }
+        items->push_back(std::move(item));
+    }
+
+    END_HELPER;
+}
+
+// Compresses |input| in a single frame, with the settings of the zbi tool.
+std::string CompressSerially(const std::string& input) {
+    LZ4F_preferences_t prefs = {};
+    prefs.frameInfo.blockSizeID = LZ4F_max64KB;
+    prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+    prefs.frameInfo.contentSize = input.size();
+    prefs.compressionLevel = 4;
+    std::string output(LZ4F_compressFrameBound(input.size(), &prefs), '\0');
+    size_t size = LZ4F_compressFrame(&output[0], output.size(),
+                                     input.data(), input.size(), &prefs);
+    output.resize(LZ4F_isError(size) ? 0 : size);
+    return output;
+}
+
+// The default output, in which the items are compressed on several threads,
+// is just what compressing each of them serially would produce.
+bool CompressedOutputMatchesSerialTest() {
+    BEGIN_TEST;
+
+    TempDir dir;
+    ASSERT_TRUE(dir.ok());
+    const std::string inputs[] = {MakeInput(kRamdiskSize, 1), MakeInput(kSmallSize, 2)};
+    std::vector<std::string> args = {"-o", dir.File("out.zbi")};
+    for (size_t i = 0; i < countof(inputs); ++i) {
+        std::string name = dir.File(i == 0 ? "ramdisk0" : "ramdisk1");
+        ASSERT_TRUE(WriteFile(name, inputs[i]));
+        args.insert(args.end(), {"-T", "ramdisk", name});
+    }
+    ASSERT_EQ(0, RunZbi(args));
+
+    std::vector<ZbiItem> items;
+    ASSERT_TRUE(ReadZbi(args[1], &items));
+    ASSERT_EQ(countof(inputs), items.size());
+    for (size_t i = 0; i < countof(inputs); ++i) {
+        EXPECT_EQ(ZBI_TYPE_STORAGE_RAMDISK, items[i].header.type);
+        EXPECT_EQ(1u, items[i].frames);
+        EXPECT_TRUE(items[i].decompressed == inputs[i]);
+        const std::string serial = CompressSerially(inputs[i]);
+        ASSERT_EQ(serial.size(), items[i].payload.size());
+        EXPECT_BYTES_EQ(reinterpret_cast<const uint8_t*>(serial.data()),
+                        reinterpret_cast<const uint8_t*>(items[i].payload.data()),
+                        serial.size(), "");
+    }
+
+    END_TEST;
+}
+
+// With --multi-frame each payload is split into 1MiB frames, which
+// decompress to the same bytes as the default single frame.
+bool MultiFrameOutputDecompressesTest() {
+    BEGIN_TEST;
+
+    TempDir dir;
+    ASSERT_TRUE(dir.ok());
+    const std::string input = MakeInput(kRamdiskSize, 3);
+    const std::string ramdisk = dir.File("ramdisk");
+    ASSERT_TRUE(WriteFile(ramdisk, input));
+
+    const std::string single = dir.File("single.zbi");
+    const std::string multi = dir.File("multi.zbi");
+    ASSERT_EQ(0, RunZbi({"-o", single, "-T", "ramdisk", ramdisk}));
+    ASSERT_EQ(0, RunZbi({"-M", "-o", multi, "-T", "ramdisk", ramdisk}));
+
+    std::vector<ZbiItem> single_items, multi_items;
+    ASSERT_TRUE(ReadZbi(single, &single_items));
+    ASSERT_TRUE(ReadZbi(multi, &multi_items));
+    ASSERT_EQ(1u, single_items.size());
+    ASSERT_EQ(1u, multi_items.size());
+    EXPECT_EQ(1u, single_items[0].frames);
+    EXPECT_EQ((kRamdiskSize + (1 << 20) - 1) >> 20, multi_items[0].frames);
+    EXPECT_TRUE(multi_items[0].decompressed == input);
+    EXPECT_TRUE(multi_items[0].decompressed == single_items[0].decompressed);
+
+    END_TEST;
+}
+
+// The last of --multi-frame and --single-frame applies to the output.
+bool LastFrameSwitchWinsTest() {
+    BEGIN_TEST;
+
+    TempDir dir;
+    ASSERT_TRUE(dir.ok());
+    const std::string ramdisk = dir.File("ramdisk");
+    ASSERT_TRUE(WriteFile(ramdisk, MakeInput(kRamdiskSize, 4)));
+
+    const std::string single = dir.File("single.zbi");
+    const std::string multi = dir.File("multi.zbi");
+    ASSERT_EQ(0, RunZbi({"-o", single, "-T", "ramdisk", ramdisk}));
+    ASSERT_EQ(0, RunZbi({"-M", "-S", "-o", multi, "-T", "ramdisk", ramdisk}));
+    std::string single_contents, multi_contents;
+    ASSERT_TRUE(ReadFile(single, &single_contents));
+    ASSERT_TRUE(ReadFile(multi, &multi_contents));
+    EXPECT_TRUE(single_contents == multi_contents);
+
+    ASSERT_EQ(0, RunZbi({"-S", "-o", multi, "-T", "ramdisk", ramdisk, "-M"}));
+    std::vector<ZbiItem> items;
+    ASSERT_TRUE(ReadZbi(multi, &items));
+    ASSERT_EQ(1u, items.size());
+    EXPECT_GT(items[0].frames, 1u);
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(zbi_tool_tests)
+RUN_TEST(CompressedOutputMatchesSerialTest)
+RUN_TEST(MultiFrameOutputDecompressesTest)
+RUN_TEST(LastFrameSwitchWinsTest)
+END_TEST_CASE(zbi_tool_tests)
+
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
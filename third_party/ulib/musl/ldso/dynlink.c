@@ -44,6 +44,9 @@ static void early_init(void);
 static void error(const char*, ...);
 static void debugmsg(const char*, ...);
 static zx_status_t get_library_vmo(const char* name, zx_handle_t* vmo);
+static struct dso* prefetch_library_vmos(struct dso* p);
+static bool take_prefetched_vmo(const char* name, zx_handle_t* vmo);
+static void drop_prefetched_vmos(void);
 static void loader_svc_config(const char* config);
 
 #define MAXP2(a, b) (-(-(a) & -(b)))
@@ -1123,11 +1126,16 @@ static size_t count_syms(struct dso* p) {
     return nsym;
 }
 
+__NO_SAFESTACK static bool dso_has_name(const struct dso* p,
+                                         const char* name) {
+    return (!strcmp(p->l_map.l_name, name) ||
+            (p->soname != NULL && !strcmp(p->soname, name)));
+}
+
 __NO_SAFESTACK static struct dso* find_library_in(struct dso* p,
                                                   const char* name) {
     while (p != NULL) {
-        if (!strcmp(p->l_map.l_name, name) ||
-            (p->soname != NULL && !strcmp(p->soname, name))) {
+        if (dso_has_name(p, name)) {
             ++p->refcnt;
             break;
         }
@@ -1136,6 +1144,20 @@ __NO_SAFESTACK static struct dso* find_library_in(struct dso* p,
     return p;
 }
 
+// Returns true if find_library would find |name|, without otherwise
+// affecting any state.
+__NO_SAFESTACK static bool library_is_loaded(const char* name) {
+    for (struct dso* p = head; p != NULL; p = dso_next(p)) {
+        if (dso_has_name(p, name))
+            return true;
+    }
+    for (struct dso* p = detached_head; p != NULL; p = dso_next(p)) {
+        if (dso_has_name(p, name))
+            return true;
+    }
+    return false;
+}
+
 __NO_SAFESTACK static struct dso* find_library(const char* name) {
     // First see if it's in the general list.
     struct dso* p = find_library_in(head, name);
@@ -1419,7 +1441,9 @@ __NO_SAFESTACK static zx_status_t load_library(const char* name, int rtld_mode,
         return ZX_OK;
 
     zx_handle_t vmo;
-    zx_status_t status = get_library_vmo(name, &vmo);
+    zx_status_t status = ZX_OK;
+    if (!take_prefetched_vmo(name, &vmo))
+        status = get_library_vmo(name, &vmo);
     if (status == ZX_OK) {
         status = load_library_vmo(vmo, name, rtld_mode, needed_by, loaded);
         _zx_handle_close(vmo);
@@ -1429,7 +1453,17 @@ __NO_SAFESTACK static zx_status_t load_library(const char* name, int rtld_mode,
 }
 
 __NO_SAFESTACK static void load_deps(struct dso* p) {
+    // The last DSO whose dependencies have all been requested already.
+    struct dso* prefetched_through = NULL;
     for (; p; p = dso_next(p)) {
+        if (prefetched_through == NULL) {
+            // Ask the loader service for everything this DSO and the
+            // ones after it need in one go, rather than one round trip
+            // per library.  Whatever those load is appended to the list
+            // and requested in the next batch.
+            drop_prefetched_vmos();
+            prefetched_through = prefetch_library_vmos(p);
+        }
         struct dso** deps = NULL;
         // The two preallocated DSOs don't get space allocated for ->deps.
         if (runtime && p->deps == NULL && p != &ldso && p != &vdso)
@@ -1443,13 +1477,18 @@ __NO_SAFESTACK static void load_deps(struct dso* p) {
             if (status != ZX_OK) {
                 error("Error loading shared library %s: %s (needed by %s)",
                       name, _zx_status_get_string(status), p->l_map.l_name);
-                if (runtime)
+                if (runtime) {
+                    drop_prefetched_vmos();
                     longjmp(*rtld_fail, 1);
+                }
             } else if (deps != NULL) {
                 *deps++ = dep;
             }
         }
+        if (p == prefetched_through)
+            prefetched_through = NULL;
     }
+    drop_prefetched_vmos();
 }
 
 __NO_SAFESTACK NO_ASAN static void reloc_all(struct dso* p) {
@@ -2391,6 +2430,46 @@ __attribute__((__visibility__("hidden"))) void __dl_vseterr(const char*, va_list
 
 #define LOADER_SVC_MSG_MAX 1024
 
+// Validates a loader service reply to a request of type |ordinal|.  Any
+// handle received with a malformed or failed reply is closed.
+__NO_SAFESTACK static zx_status_t loader_svc_check_reply(
+    uint32_t ordinal, ldmsg_rsp_t* rsp, uint32_t reply_size,
+    uint32_t handle_count, zx_handle_t* result) {
+    zx_status_t status = ZX_OK;
+    size_t expected_reply_size = ldmsg_rsp_get_size(rsp);
+    if (reply_size != expected_reply_size) {
+        error("loader service reply %u bytes != %u",
+              reply_size, expected_reply_size);
+        status = ZX_ERR_INVALID_ARGS;
+        goto err;
+    }
+    if (rsp->header.ordinal != ordinal) {
+        error("loader service reply opcode %u != %u",
+              rsp->header.ordinal, ordinal);
+        status = ZX_ERR_INVALID_ARGS;
+        goto err;
+    }
+    if (rsp->rv != ZX_OK) {
+        // |result| is non-null if |handle_count| > 0, because
+        // |handle_count| <= |rd_num_handles|.
+        if (handle_count > 0 && *result != ZX_HANDLE_INVALID) {
+            error("loader service error %d reply contains handle %#x",
+                  rsp->rv, *result);
+            status = ZX_ERR_INVALID_ARGS;
+            goto err;
+        }
+        status = rsp->rv;
+    }
+    return status;
+
+err:
+    if (handle_count > 0) {
+        _zx_handle_close(*result);
+        *result = ZX_HANDLE_INVALID;
+    }
+    return status;
+}
+
 __NO_SAFESTACK static zx_status_t loader_svc_rpc(uint32_t ordinal,
                                                  const void* data, size_t len,
                                                  zx_handle_t request_handle,
@@ -2442,38 +2521,8 @@ __NO_SAFESTACK static zx_status_t loader_svc_rpc(uint32_t ordinal,
         return status;
     }
 
-    size_t expected_reply_size = ldmsg_rsp_get_size(&rsp);
-    if (reply_size != expected_reply_size) {
-        error("loader service reply %u bytes != %u",
-              reply_size, expected_reply_size);
-        status = ZX_ERR_INVALID_ARGS;
-        goto err;
-    }
-    if (rsp.header.ordinal != ordinal) {
-        error("loader service reply opcode %u != %u",
-              rsp.header.ordinal, ordinal);
-        status = ZX_ERR_INVALID_ARGS;
-        goto err;
-    }
-    if (rsp.rv != ZX_OK) {
-        // |result| is non-null if |handle_count| > 0, because
-        // |handle_count| <= |rd_num_handles|.
-        if (handle_count > 0 && *result != ZX_HANDLE_INVALID) {
-            error("loader service error %d reply contains handle %#x",
-                  rsp.rv, *result);
-            status = ZX_ERR_INVALID_ARGS;
-            goto err;
-        }
-        status = rsp.rv;
-    }
-    return status;
-
-err:
-    if (handle_count > 0) {
-        _zx_handle_close(*result);
-        *result = ZX_HANDLE_INVALID;
-    }
-    return status;
+    return loader_svc_check_reply(ordinal, &rsp, reply_size,
+                                  handle_count, result);
 }
 
 __NO_SAFESTACK static void loader_svc_config(const char* config) {
@@ -2495,6 +2544,178 @@ __NO_SAFESTACK static zx_status_t get_library_vmo(const char* name,
                           ZX_HANDLE_INVALID, result);
 }
 
+// Several LDMSG_OP_LOAD_OBJECT requests can be written to the loader
+// service channel before reading any of the replies.  load_deps uses
+// this to look up a whole batch of dependencies for the price of a
+// single round trip.  The service may answer the requests of a batch in
+// any order, so each reply is matched to its request by txid.  These
+// use small txids of their own, which cannot collide with the ones the
+// kernel assigns to _zx_channel_call (which always have the high bit
+// set); all other loader service traffic from this process uses the
+// latter.  Each batch takes fresh txids, so that a late reply to an
+// earlier batch is never mistaken for one in the current batch.
+// Batches are only issued from load_deps, which (like every other user
+// of these) is serialized by the caller.
+#define LOADER_SVC_BATCH_MAX 32
+#define LOADER_SVC_BATCH_TXID_LIMIT 0x80000000u
+
+static struct {
+    const char* name;
+    zx_handle_t vmo;
+    // ZX_ERR_SHOULD_WAIT until the reply has been read.
+    zx_status_t status;
+} prefetched[LOADER_SVC_BATCH_MAX];
+static size_t prefetched_count;
+// The txid of prefetched[0]; prefetched[i] uses prefetched_txid + i.
+static zx_txid_t prefetched_txid;
+
+__NO_SAFESTACK static bool is_prefetching(const char* name) {
+    for (size_t i = 0; i < prefetched_count; ++i) {
+        if (!strcmp(prefetched[i].name, name))
+            return true;
+    }
+    return false;
+}
+
+// Reads the next reply on the channel, whichever request it answers.
+// The request's txid is stored in |txid|, and its result in
+// |reply_status| and |result|.  Returns an error only if no reply could
+// be read at all.
+__NO_SAFESTACK static zx_status_t loader_svc_read_reply(uint32_t ordinal,
+                                                        zx_txid_t* txid,
+                                                        zx_status_t* reply_status,
+                                                        zx_handle_t* result) {
+    *result = ZX_HANDLE_INVALID;
+    zx_status_t status = _zx_object_wait_one(
+        loader_svc, ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+        ZX_TIME_INFINITE, NULL);
+    if (status != ZX_OK)
+        return status;
+
+    ldmsg_rsp_t rsp;
+    memset(&rsp, 0, sizeof(rsp));
+    uint32_t reply_size;
+    uint32_t handle_count;
+    status = _zx_channel_read(loader_svc, 0, &rsp, result, sizeof(rsp), 1,
+                              &reply_size, &handle_count);
+    if (status != ZX_OK) {
+        error("reading loader service reply: %d (%s)",
+              status, _zx_status_get_string(status));
+        return status;
+    }
+    *txid = rsp.header.txid;
+    *reply_status = loader_svc_check_reply(ordinal, &rsp, reply_size,
+                                           handle_count, result);
+    return ZX_OK;
+}
+
+// Requests the VMOs for the DT_NEEDED entries of |p| and each DSO
+// after it which are not already loaded, as far as they fit in one
+// batch.  Returns the last DSO whose dependencies were all requested.
+__NO_SAFESTACK static struct dso* prefetch_library_vmos(struct dso* p) {
+    struct dso* last = p;
+    if (loader_svc == ZX_HANDLE_INVALID)
+        return last;
+
+    for (struct dso* q = p; q != NULL; q = dso_next(q)) {
+        for (size_t i = 0; q->l_map.l_ld[i].d_tag; i++) {
+            if (q->l_map.l_ld[i].d_tag != DT_NEEDED)
+                continue;
+            const char* name = q->strings + q->l_map.l_ld[i].d_un.d_val;
+            if (!*name || library_is_loaded(name) || is_prefetching(name))
+                continue;
+            if (prefetched_count == LOADER_SVC_BATCH_MAX)
+                goto send;
+            prefetched[prefetched_count].name = name;
+            prefetched[prefetched_count].vmo = ZX_HANDLE_INVALID;
+            prefetched[prefetched_count].status = ZX_ERR_SHOULD_WAIT;
+            prefetched_count++;
+        }
+        last = q;
+    }
+
+send:
+    // Move past the txids of the previous batch.
+    prefetched_txid += LOADER_SVC_BATCH_MAX;
+    if (prefetched_txid == 0 ||
+        prefetched_txid > LOADER_SVC_BATCH_TXID_LIMIT - LOADER_SVC_BATCH_MAX)
+        prefetched_txid = 1;
+
+    size_t outstanding = 0;
+    for (size_t i = 0; i < prefetched_count; ++i) {
+        ldmsg_req_t req;
+        memset(&req.header, 0, sizeof(req.header));
+        req.header.txid = prefetched_txid + (zx_txid_t)i;
+        req.header.ordinal = LDMSG_OP_LOAD_OBJECT;
+        size_t req_len;
+        const char* name = prefetched[i].name;
+        if (ldmsg_req_encode(&req, &req_len, name, strlen(name)) != ZX_OK ||
+            _zx_channel_write(loader_svc, 0, &req, req_len, NULL, 0) != ZX_OK) {
+            // Whatever could not be sent is requested synchronously
+            // by load_library instead.
+            prefetched_count = i;
+            break;
+        }
+        ++outstanding;
+    }
+
+    while (outstanding > 0) {
+        zx_txid_t txid;
+        zx_status_t reply_status;
+        zx_handle_t vmo;
+        if (loader_svc_read_reply(LDMSG_OP_LOAD_OBJECT, &txid,
+                                  &reply_status, &vmo) != ZX_OK) {
+            // Whatever is still outstanding is requested synchronously
+            // by load_library instead.
+            break;
+        }
+        size_t i = (size_t)(txid - prefetched_txid);
+        if (txid < prefetched_txid || i >= prefetched_count ||
+            prefetched[i].status != ZX_ERR_SHOULD_WAIT) {
+            // A late reply to an earlier batch, or a duplicate.
+            if (vmo != ZX_HANDLE_INVALID)
+                _zx_handle_close(vmo);
+            continue;
+        }
+        prefetched[i].status = reply_status;
+        prefetched[i].vmo = vmo;
+        --outstanding;
+    }
+
+    return last;
+}
+
+// If |name| was successfully fetched by prefetch_library_vmos, hands
+// over its VMO.  Returns false if it was not requested, or if the
+// request failed or went unanswered, in which case the caller should
+// request it synchronously.
+__NO_SAFESTACK static bool take_prefetched_vmo(const char* name,
+                                               zx_handle_t* vmo) {
+    for (size_t i = 0; i < prefetched_count; ++i) {
+        if (prefetched[i].name != NULL && !strcmp(prefetched[i].name, name)) {
+            bool fetched = prefetched[i].status == ZX_OK;
+            if (fetched)
+                *vmo = prefetched[i].vmo;
+            else if (prefetched[i].vmo != ZX_HANDLE_INVALID)
+                _zx_handle_close(prefetched[i].vmo);
+            prefetched[i].name = NULL;
+            prefetched[i].vmo = ZX_HANDLE_INVALID;
+            return fetched;
+        }
+    }
+    return false;
+}
+
+// Discards any prefetched VMOs that went unused, e.g. because the
+// library turned out to be loaded under another name.
+__NO_SAFESTACK static void drop_prefetched_vmos(void) {
+    for (size_t i = 0; i < prefetched_count; ++i) {
+        if (prefetched[i].vmo != ZX_HANDLE_INVALID)
+            _zx_handle_close(prefetched[i].vmo);
+    }
+    prefetched_count = 0;
+}
+
 __NO_SAFESTACK zx_status_t dl_clone_loader_service(zx_handle_t* out) {
     if (loader_svc == ZX_HANDLE_INVALID) {
         return ZX_ERR_UNAVAILABLE;